@@ -0,0 +1,44 @@
+#!/usr/bin/env python
+
+import json, sys
+
+if len(sys.argv) < 3 or len(sys.argv) > 4:
+    print('rbenchcompare.py: Compare two reports written by "mtsutil rbench"')
+    print('Syntax: rbenchcompare.py <baseline.json> <current.json> [max. slowdown in percent]')
+    sys.exit(1)
+
+def load(filename):
+    with open(filename) as f:
+        report = json.load(f)
+    return report, dict((s['name'], s) for s in report['scenes'])
+
+baseline, baselineScenes = load(sys.argv[1])
+current, currentScenes = load(sys.argv[2])
+maxSlowdown = float(sys.argv[3]) if len(sys.argv) == 4 else None
+
+for key in ['precision', 'spectrumSamples', 'cores', 'seed']:
+    if baseline.get(key) != current.get(key):
+        print('Warning: the reports differ in "%s" (%s vs %s)' % (key, baseline.get(key), current.get(key)))
+
+def rmse(scene):
+    if scene.get('relativeRmse') is None:
+        return '-'
+    return '%.4f' % scene['relativeRmse']
+
+print('%-16s %10s %10s %8s %10s %10s' % ('Scene', 'Before', 'After', 'Change', 'RelRMSE', 'Status'))
+regressions = 0
+for name in sorted(currentScenes.keys()):
+    new = currentScenes[name]
+    old = baselineScenes.get(name)
+    if old is None or old['status'] != 'ok' or new['status'] != 'ok':
+        print('%-16s %10s %10s %8s %10s %10s' % (name, '-', '-', '-', rmse(new), new['status']))
+        continue
+    change = 100.0 * (new['renderTime'] / old['renderTime'] - 1)
+    status = 'ok'
+    if maxSlowdown is not None and change > maxSlowdown:
+        status = 'slower'
+        regressions += 1
+    print('%-16s %9.3fs %9.3fs %+7.1f%% %10s %10s' % (name, old['renderTime'],
+        new['renderTime'], change, rmse(new), status))
+
+sys.exit(1 if regressions > 0 else 0)
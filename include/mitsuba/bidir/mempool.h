@@ -30,14 +30,24 @@ class MemoryPool {
 public:
     /// Create a new memory pool with aninitial set of 128 entries
     MemoryPool(size_t nEntries = 128)
-        : m_vertexPool(nEntries), m_edgePool(nEntries) { }
+        : m_vertexPool(nEntries), m_edgePool(nEntries), m_arena(NULL) { }
+
+    /**
+     * \brief Create a memory pool that takes its entries from a memory arena
+     *
+     * Releasing entries is a no-op in this case. Instead, the caller
+     * reclaims the storage of all vertices and edges of a sample at once
+     * by rewinding the arena (see \ref MemoryArena::Scope).
+     */
+    MemoryPool(MemoryArena *arena)
+        : m_vertexPool(0), m_edgePool(0), m_arena(arena) { }
 
     /// Destruct the memory pool and release all entries
     ~MemoryPool() { }
 
     /// Acquire an edge
     inline PathEdge *allocEdge() {
-        PathEdge *edge = m_edgePool.alloc();
+        PathEdge *edge = m_arena ? m_arena->alloc<PathEdge>() : m_edgePool.alloc();
         #if defined(MTS_BD_DEBUG_HEAVY)
         memset(edge, 0xFF, sizeof(PathEdge));
         #endif
@@ -46,7 +56,7 @@ public:
 
     /// Acquire an vertex
     inline PathVertex *allocVertex() {
-        PathVertex *vertex = m_vertexPool.alloc();
+        PathVertex *vertex = m_arena ? m_arena->alloc<PathVertex>() : m_vertexPool.alloc();
         #if defined(MTS_BD_DEBUG_HEAVY)
         memset(vertex, 0xFF, sizeof(PathVertex));
         #endif
@@ -55,12 +65,14 @@ public:
 
     /// Release an edge
     inline void release(PathEdge *edge) {
-        m_edgePool.release(edge);
+        if (!m_arena)
+            m_edgePool.release(edge);
     }
 
     /// Release an entry
     inline void release(PathVertex *vertex) {
-        m_vertexPool.release(vertex);
+        if (!m_arena)
+            m_vertexPool.release(vertex);
     }
 
     /// Check if every entry has been released
@@ -91,6 +103,7 @@ public:
 private:
     BasicMemoryPool<PathVertex> m_vertexPool;
     BasicMemoryPool<PathEdge> m_edgePool;
+    MemoryArena *m_arena;
 };
 
 MTS_NAMESPACE_END
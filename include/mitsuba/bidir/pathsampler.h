@@ -259,7 +259,7 @@ struct PathSeed {
  * MLT work unit -- wraps a \ref PathSeed into a
  * \ref WorkUnit instance.
  */
-class SeedWorkUnit : public WorkUnit {
+class MTS_EXPORT_BIDIR SeedWorkUnit : public WorkUnit {
 public:
     inline void set(const WorkUnit *wu) {
         m_seed = static_cast<const SeedWorkUnit *>(wu)->m_seed;
@@ -0,0 +1,244 @@
+/*
+    This file is part of Mitsuba, a physically based rendering system.
+
+    Copyright (c) 2007-2014 by Wenzel Jakob and others.
+
+    Mitsuba is free software; you can redistribute it and/or modify
+    it under the terms of the GNU General Public License Version 3
+    as published by the Free Software Foundation.
+
+    Mitsuba is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program. If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#pragma once
+#if !defined(__MITSUBA_CORE_ARENA_H_)
+#define __MITSUBA_CORE_ARENA_H_
+
+#include <mitsuba/mitsuba.h>
+#include <limits>
+
+MTS_NAMESPACE_BEGIN
+
+/// Default size of a memory arena block (256 KiB)
+#define MTS_ARENA_BLOCK_SIZE (256 * 1024)
+
+/// Alignment of all allocations handed out by a \ref MemoryArena
+#define MTS_ARENA_ALIGNMENT 16
+
+/**
+ * \brief Bump allocator for short-lived temporary allocations
+ *
+ * A memory arena hands out memory by advancing a pointer within a list of
+ * large, aligned blocks. Individual allocations are never released;
+ * instead, the entire arena is reset at once (or rewound to a previously
+ * recorded position, see \ref MemoryArena::Scope). This makes it suitable
+ * for data that lives at most as long as a single sample or work unit,
+ * e.g. temporary vectors of intersection records in integrators.
+ *
+ * Each thread has its own arena, which can be obtained using
+ * \ref getThreadArena(). The scheduler resets the arena of a worker
+ * thread after every call to \ref WorkProcessor::process(), hence memory
+ * obtained from it must never be retained across work units.
+ *
+ * \ingroup libcore
+ */
+class MTS_EXPORT_CORE MemoryArena {
+public:
+    /// Position within the arena, used to rewind it (see \ref Scope)
+    struct Marker {
+        size_t block;
+        size_t offset;
+    };
+
+    /**
+     * \brief Scoped arena marker
+     *
+     * Records the current position of an arena on construction and
+     * rewinds to it on destruction, which releases all memory allocated
+     * in between. Used to bound the footprint of per-sample allocations
+     * within a long-running work unit. Each scope is counted as one sample
+     * by the "Heap allocations per sample" statistic.
+     */
+    class Scope {
+    public:
+        inline Scope(MemoryArena *arena = MemoryArena::getThreadArena())
+            : m_arena(arena), m_marker(arena->getMarker()) { ++arena->m_scopeCount; }
+        inline ~Scope() { m_arena->rewind(m_marker); }
+        inline MemoryArena *getArena() const { return m_arena; }
+    private:
+        Scope(const Scope &);
+        Scope &operator=(const Scope &);
+    private:
+        MemoryArena *m_arena;
+        Marker m_marker;
+    };
+
+    /// Create a new memory arena with the specified block size
+    MemoryArena(size_t blockSize = MTS_ARENA_BLOCK_SIZE);
+
+    /// Release all blocks
+    ~MemoryArena();
+
+    /// Allocate \c size bytes with an alignment of \ref MTS_ARENA_ALIGNMENT
+    inline void *alloc(size_t size) {
+        size = (size + MTS_ARENA_ALIGNMENT - 1) & ~((size_t) MTS_ARENA_ALIGNMENT - 1);
+        ++m_allocCount;
+        if (EXPECT_TAKEN(m_offset + size <= m_blockSize)) {
+            void *result = m_current + m_offset;
+            m_offset += size;
+            return result;
+        }
+        return allocSlow(size);
+    }
+
+    /// Allocate uninitialized storage for \c count instances of type \c T
+    template <typename T> inline T *alloc(size_t count = 1) {
+        return static_cast<T *>(alloc(sizeof(T) * count));
+    }
+
+    /// Return the current position of the arena
+    inline Marker getMarker() const {
+        Marker marker;
+        marker.block = m_block;
+        marker.offset = m_offset;
+        return marker;
+    }
+
+    /// Rewind the arena to a previously recorded position
+    inline void rewind(const Marker &marker) {
+        if (marker.block != m_block) {
+            m_block = marker.block;
+            m_current = m_blocks[m_block].ptr;
+            m_blockSize = m_blocks[m_block].size;
+        }
+        m_offset = marker.offset;
+    }
+
+    /**
+     * \brief Release all allocations at once
+     *
+     * The underlying blocks are kept for reuse; this function also
+     * reports the usage of the finished work unit to the statistics
+     * subsystem.
+     */
+    void reset();
+
+    /// Release all allocations and free the underlying memory
+    void clear();
+
+    /// Return the number of bytes currently handed out by the arena
+    size_t getUsedBytes() const;
+
+    /// Return the total amount of memory held by the arena
+    size_t getCapacity() const;
+
+    /// Return the arena associated with the current thread
+    static MemoryArena *getThreadArena();
+
+    /**
+     * \brief Record a heap allocation made while rendering a sample
+     *
+     * Called by allocators that fall back to the heap in performance-critical
+     * code (e.g. when a \ref BasicMemoryPool grows). Together with the
+     * arena's own block allocations, these are reported per \ref Scope
+     * (i.e. per sample) when the arena of a worker thread is reset.
+     * Does nothing when called from a thread that was not registered
+     * with Mitsuba (see \ref Thread::registerUnmanagedThread()).
+     */
+    static void recordHeapAllocation();
+
+    /// Return a human-readable description
+    std::string toString() const;
+
+protected:
+    /// Allocate from a subsequent block, creating it if necessary
+    void *allocSlow(size_t size);
+
+private:
+    MemoryArena(const MemoryArena &);
+    MemoryArena &operator=(const MemoryArena &);
+
+    struct Block {
+        uint8_t *ptr;
+        size_t size;
+    };
+
+    std::vector<Block> m_blocks;
+    uint8_t *m_current;
+    size_t m_block, m_offset;
+    size_t m_blockSize, m_defaultBlockSize;
+    size_t m_peakUsage, m_allocCount;
+    size_t m_heapAllocCount, m_scopeCount;
+};
+
+/**
+ * \brief STL-compatible allocator adapter for \ref MemoryArena
+ *
+ * Deallocation is a no-op; the storage is reclaimed when the arena is
+ * reset or rewound. A default-constructed allocator refers to the arena
+ * of the calling thread.
+ *
+ * \code
+ * MemoryArena::Scope scope;
+ * std::vector<Intersection, ArenaAllocator<Intersection> > path;
+ * \endcode
+ *
+ * \ingroup libcore
+ */
+template <typename T> class ArenaAllocator {
+public:
+    typedef T              value_type;
+    typedef T *            pointer;
+    typedef const T *      const_pointer;
+    typedef T &            reference;
+    typedef const T &      const_reference;
+    typedef std::size_t    size_type;
+    typedef std::ptrdiff_t difference_type;
+
+    template <typename U> struct rebind {
+        typedef ArenaAllocator<U> other;
+    };
+
+    inline ArenaAllocator() : m_arena(MemoryArena::getThreadArena()) { }
+    inline ArenaAllocator(MemoryArena *arena) : m_arena(arena) { }
+    template <typename U> inline ArenaAllocator(const ArenaAllocator<U> &other)
+        : m_arena(other.getArena()) { }
+
+    inline pointer allocate(size_type n, const void * = 0) {
+        return m_arena->alloc<T>(n);
+    }
+
+    inline void deallocate(pointer, size_type) { }
+
+    inline void construct(pointer p, const T &value) { new (p) T(value); }
+    inline void destroy(pointer p) { p->~T(); }
+
+    inline pointer address(reference r) const { return &r; }
+    inline const_pointer address(const_reference r) const { return &r; }
+
+    inline size_type max_size() const {
+        return std::numeric_limits<size_type>::max() / sizeof(T);
+    }
+
+    inline MemoryArena *getArena() const { return m_arena; }
+
+    template <typename U> inline bool operator==(const ArenaAllocator<U> &other) const {
+        return m_arena == other.getArena();
+    }
+
+    template <typename U> inline bool operator!=(const ArenaAllocator<U> &other) const {
+        return m_arena != other.getArena();
+    }
+private:
+    MemoryArena *m_arena;
+};
+
+MTS_NAMESPACE_END
+
+#endif /* __MITSUBA_CORE_ARENA_H_ */
@@ -24,6 +24,7 @@
 #include <mitsuba/core/stream.h>
 #include <mitsuba/core/rfilter.h>
 #include <mitsuba/core/half.h>
+#include <boost/scoped_ptr.hpp>
 
 MTS_NAMESPACE_BEGIN
 
@@ -1236,6 +1237,15 @@ public:
     /// Run static initialization code (sets up OpenEXR for multithreading)
     static void staticInitialization();
 
+    /**
+     * \brief Create the thread pool that OpenEXR uses to read/write files
+     *
+     * This is deferred until the first OpenEXR file is accessed through a
+     * \ref Bitmap. Code that uses the OpenEXR API directly should call
+     * this function beforehand.
+     */
+    static void initializeOpenEXRThreads();
+
     /// Release any resources allocated in \ref staticInitialization
     static void staticShutdown();
 
@@ -1414,6 +1424,113 @@ private:
     static ConverterMap m_converters;
 };
 
+/**
+ * \brief Incremental reader for scanline-based OpenEXR images
+ *
+ * In contrast to \ref Bitmap, which always loads an entire image into
+ * memory, this class decodes a file in horizontal bands of scanlines.
+ * This allows image utilities to process files that do not fit into
+ * main memory.
+ *
+ * Bands are exchanged as \ref Bitmap::EMultiChannel single precision
+ * bitmaps whose width matches the image and which contain one channel
+ * per entry of \ref getChannelNames(). OpenEXR takes care of converting
+ * the stored pixel type to single precision.
+ *
+ * \ingroup libcore
+ */
+class MTS_EXPORT_CORE EXRScanlineReader : public Object {
+public:
+    /// Open an OpenEXR image and read its header
+    EXRScanlineReader(Stream *stream);
+
+    /// Return the resolution of the image
+    const Vector2i &getSize() const;
+
+    /// Return the (alphabetically sorted) names of all channels
+    const std::vector<std::string> &getChannelNames() const;
+
+    /// Return the number of channels
+    inline int getChannelCount() const { return (int) getChannelNames().size(); }
+
+    /// Return the component format used to store the image on disk
+    Bitmap::EComponentFormat getComponentFormat() const;
+
+    /// Return the metadata stored in the image header (see \ref Bitmap::getMetadata())
+    const Properties &getMetadata() const;
+
+    /// Return the index of the next scanline that will be read
+    int getPosition() const;
+
+    /**
+     * \brief Read the next band of scanlines
+     *
+     * The number of scanlines is given by the height of \c band, which
+     * must be an \ref Bitmap::EFloat32 bitmap with matching width and
+     * channel count. Returns the number of scanlines that were actually
+     * read, which is less than the band height near the end of the image.
+     */
+    int read(Bitmap *band);
+
+    MTS_DECLARE_CLASS()
+protected:
+    /// Virtual destructor
+    virtual ~EXRScanlineReader();
+private:
+    struct EXRScanlineReaderPrivate;
+    boost::scoped_ptr<EXRScanlineReaderPrivate> d;
+};
+
+/**
+ * \brief Incremental writer for scanline-based OpenEXR images
+ *
+ * Counterpart of \ref EXRScanlineReader: the image is written from top
+ * to bottom in bands of single precision \ref Bitmap::EMultiChannel
+ * bitmaps, and the file is finalized when the writer is released.
+ *
+ * \ingroup libcore
+ */
+class MTS_EXPORT_CORE EXRScanlineWriter : public Object {
+public:
+    /**
+     * \brief Create a new OpenEXR image
+     *
+     * \param size
+     *    Resolution of the image
+     * \param channelNames
+     *    Names of the channels in the order used by the bands
+     * \param componentFormat
+     *    Component format used to store the image (must be float16,
+     *    float32, or uint32)
+     * \param metadata
+     *    Metadata that should be stored in the image header
+     */
+    EXRScanlineWriter(Stream *stream, const Vector2i &size,
+        const std::vector<std::string> &channelNames,
+        Bitmap::EComponentFormat componentFormat = Bitmap::EFloat16,
+        const Properties &metadata = Properties());
+
+    /// Return the index of the next scanline that will be written
+    int getPosition() const;
+
+    /**
+     * \brief Append a band of scanlines
+     *
+     * \param rows
+     *    Number of scanlines of \c band that should be written. The
+     *    default (-1) writes the entire band.
+     */
+    void write(const Bitmap *band, int rows = -1);
+
+    MTS_DECLARE_CLASS()
+protected:
+    /// Virtual destructor
+    virtual ~EXRScanlineWriter();
+private:
+    struct EXRScanlineWriterPrivate;
+    boost::scoped_ptr<EXRScanlineWriterPrivate> d;
+};
+
 //! \cond
 namespace detail {
     template <typename T> inline Bitmap::EComponentFormat cfmt() { return Bitmap::EInvalid; }
@@ -166,16 +166,12 @@ protected:
     /// Release all memory
     virtual ~ChiSquare();
 
-    /// Functor to evaluate the pdf values in parallel using OpenMP
+    /// Evaluate the pdf (times the spherical Jacobian) at a single point
     static void integrand(
         const boost::function<Float (const Vector &, EMeasure)> &pdfFn,
-            size_t nPts, const Float *in, Float *out) {
-        #if defined(MTS_OPENMP)
-        #pragma omp parallel for
-        #endif
-        for (int i=0; i<(int) nPts; ++i)
-            out[i] = pdfFn(sphericalDirection(in[2*i], in[2*i+1]), ESolidAngle)
-                * std::sin(in[2*i]);
+            const Float *in, Float *out) {
+        out[0] = pdfFn(sphericalDirection(in[0], in[1]), ESolidAngle)
+            * std::sin(in[0]);
     }
 private:
     ELogLevel m_logLevel;
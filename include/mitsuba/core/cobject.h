@@ -23,6 +23,9 @@
 #include <mitsuba/mitsuba.h>
 #include <mitsuba/core/serialization.h>
 #include <mitsuba/core/properties.h>
+#if defined(MTS_STATIC_PLUGINS)
+#include <mitsuba/core/plugin.h>
+#endif
 
 MTS_NAMESPACE_BEGIN
 
@@ -94,8 +97,21 @@ protected:
 /** \brief This macro creates the binary interface, which Mitsuba
  * requires to load a plugin.
  *
+ * In builds with \c MTS_STATIC_PLUGINS, it instead adds the plugin
+ * to the built-in registry (see \ref StaticPlugin).
+ *
  * \ingroup libcore
  */
+#if defined(MTS_STATIC_PLUGINS)
+#define MTS_EXPORT_PLUGIN(name, descr) \
+    namespace { \
+        void *CreateInstance_##name(const Properties &props) { \
+            return new name(props); \
+        } \
+        StaticPlugin StaticPlugin_##name(__FILE__, descr, \
+            &CreateInstance_##name, NULL); \
+    }
+#else
 #define MTS_EXPORT_PLUGIN(name, descr) \
     extern "C" { \
         void MTS_EXPORT *CreateInstance(const Properties &props) { \
@@ -105,6 +121,7 @@ protected:
             return descr; \
         } \
     }
+#endif
 
 MTS_NAMESPACE_END
 
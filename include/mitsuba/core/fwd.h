@@ -63,6 +63,7 @@ class Properties;
 struct Version;
 class Random;
 template <typename PointType, typename VectorType> struct TRay;
+struct RayCone;
 struct RayDifferential;
 class RemoteProcess;
 class RemoteWorker;
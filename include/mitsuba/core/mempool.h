@@ -21,6 +21,7 @@
 #define __MITSUBA_CORE_MEMPOOL_H_
 
 #include <mitsuba/mitsuba.h>
+#include <mitsuba/core/arena.h>
 
 MTS_NAMESPACE_BEGIN
 
@@ -43,7 +44,8 @@ template <typename T> class BasicMemoryPool {
 public:
     /// Create a new memory pool with an initial set of 128 entries
     BasicMemoryPool(size_t nEntries = MTS_MEMPOOL_GRANULARITY) : m_size(0) {
-        increaseCapacity(nEntries);
+        if (nEntries > 0)
+            increaseCapacity(nEntries);
     }
 
     /// Destruct the memory pool and release all entries
@@ -54,8 +56,10 @@ public:
 
     /// Acquire an entry
     inline T *alloc() {
-        if (EXPECT_NOT_TAKEN(m_free.empty()))
+        if (EXPECT_NOT_TAKEN(m_free.empty())) {
+            MemoryArena::recordHeapAllocation();
             increaseCapacity();
+        }
         T *result = m_free.back();
         m_free.pop_back();
         return result;
@@ -152,6 +152,12 @@
 #error Unsupported compiler!
 #endif
 
+/* Rvalue references (used for move-aware reference counting) */
+#if __cplusplus >= 201103L || defined(__GXX_EXPERIMENTAL_CXX0X__) || \
+    (defined(_MSC_VER) && _MSC_VER >= 1600)
+#define MTS_HAS_RVALUE_REFS 1
+#endif
+
 #ifdef MTS_SSE
 #define SSE_STR "SSE2 enabled"
 #else
@@ -26,6 +26,64 @@
 
 MTS_NAMESPACE_BEGIN
 
+/**
+ * \brief Entry of the built-in plugin registry
+ *
+ * When Mitsuba is compiled with \c MTS_STATIC_PLUGINS, the plugins are
+ * linked directly into the executables instead of being built as shared
+ * libraries. Each plugin then registers itself using a static instance of
+ * this class (created by \ref MTS_EXPORT_PLUGIN and its counterparts for
+ * utilities and test cases), and the \ref PluginManager consults this
+ * registry before searching the file system.
+ *
+ * These instances are dynamically initialized (the name is stored as a
+ * \c std::string), i.e. they register themselves during static
+ * initialization of the executable. The registry must therefore not be
+ * queried from other static initializers.
+ *
+ * \ingroup libcore
+ */
+class MTS_EXPORT_CORE StaticPlugin {
+public:
+    typedef void *(*CreateInstanceFunc)(const Properties &props);
+    typedef void *(*CreateUtilityFunc)();
+
+    /**
+     * \brief Register a plugin
+     *
+     * \param filename
+     *    Source file of the plugin (i.e. \c __FILE__). Its base name without
+     *    extension is the name of the plugin, e.g. \c "diffuse".
+     */
+    StaticPlugin(const char *filename, const char *description,
+        CreateInstanceFunc createInstance, CreateUtilityFunc createUtility);
+
+    /// Return the name of the plugin
+    inline const std::string &getName() const { return m_name; }
+
+    /// Return a description of the plugin
+    inline const char *getDescription() const { return m_description; }
+
+    /// Is this a configurable object plugin or an utility plugin?
+    inline bool isUtility() const { return m_createUtility != NULL; }
+
+    /// Look up a registered plugin by name (returns \c NULL if not found)
+    static const StaticPlugin *find(const std::string &name);
+
+    /// Return the names of all registered plugins
+    static std::vector<std::string> getNames();
+
+private:
+    friend class Plugin;
+
+    std::string m_name;
+    const char *m_description;
+    CreateInstanceFunc m_createInstance;
+    CreateUtilityFunc m_createUtility;
+    StaticPlugin *m_next;
+    static StaticPlugin *m_head;
+};
+
 /**
  * \brief Abstract plugin class -- represents loadable configurable objects
  * and utilities.
@@ -40,6 +98,9 @@ public:
     /// Load a plugin from the supplied path
     Plugin(const std::string &shortName, const fs::path &path);
 
+    /// Wrap a plugin that is part of the built-in registry
+    Plugin(const std::string &shortName, const StaticPlugin *plugin);
+
     /// Virtual destructor
     virtual ~Plugin();
 
@@ -165,6 +165,7 @@ public:
      */
     Float integrate(const Integrand &f, Float a, Float b,
         size_t *evals = NULL) const;
+
 protected:
     /**
      * \brief Perform one step of the 4-point Gauss-Lobatto rule, then
@@ -292,6 +293,20 @@ public:
      */
     EResult integrateVectorized(const VectorizedIntegrand &f, const Float *min,
         const Float *max, Float *result, Float *error, size_t *evals = NULL) const;
+
+    /**
+     * \brief Integrate the function \c f over the rectangular domain
+     * bounded by \c min and \c max using multiple threads.
+     *
+     * This function takes the same (single point) integrand as
+     * \ref integrate(), but refines many regions at once like
+     * \ref integrateVectorized(). The resulting batches of points are
+     * then evaluated concurrently on all available cores using OpenMP.
+     * The integrand must therefore be safe to call from multiple
+     * threads, and it should not throw exceptions.
+     */
+    EResult integrateParallel(const Integrand &f, const Float *min,
+        const Float *max, Float *result, Float *error, size_t *evals = NULL) const;
 protected:
     size_t m_fdim, m_dim, m_maxEvals;
     Float m_absError, m_relError;
@@ -227,6 +227,59 @@ struct RayDifferential : public Ray {
     }
 };
 
+/**
+ * \brief Ray cone -- a cheap approximation of the footprint of a ray
+ *
+ * Instead of tracking the full set of offset rays of a \ref RayDifferential,
+ * a ray cone only stores the width of the footprint at the ray origin and
+ * its spread angle. This is sufficient to select a texture level of detail
+ * on surfaces hit by secondary rays, where exact differentials are rarely
+ * worth their cost.
+ * \ingroup libcore
+ */
+struct RayCone {
+    /// Width of the footprint at the ray origin
+    Float width;
+    /// Spread angle of the cone (in radians)
+    Float spread;
+
+    inline RayCone() : width(0.0f), spread(0.0f) { }
+
+    inline RayCone(Float width, Float spread)
+        : width(width), spread(spread) { }
+
+    /// Initialize the cone from the offset rays of a ray differential
+    inline explicit RayCone(const RayDifferential &ray) : width(0.0f), spread(0.0f) {
+        if (ray.hasDifferentials) {
+            width = std::max((ray.rxOrigin - ray.o).length(),
+                             (ray.ryOrigin - ray.o).length());
+            spread = std::max((ray.rxDirection - ray.d).length(),
+                              (ray.ryDirection - ray.d).length());
+        }
+    }
+
+    /// Return the width of the footprint at distance \c t
+    inline Float getWidth(Float t) const {
+        return width + spread * t;
+    }
+
+    /**
+     * \brief Move the cone origin to distance \c t, e.g. when
+     * a path is continued at a surface, and widen it by \c angle
+     */
+    inline void propagate(Float t, Float angle) {
+        width += spread * t;
+        spread += angle;
+    }
+
+    /// Return a string representation of this ray cone
+    inline std::string toString() const {
+        std::ostringstream oss;
+        oss << "RayCone[width = " << width << ", spread = " << spread << "]";
+        return oss.str();
+    }
+};
+
 MTS_NAMESPACE_END
 
 #endif /* __MITSUBA_CORE_RAY_H_ */
@@ -48,6 +48,11 @@ public:
     /// Copy-constructor
     ref(const ref &pRef) : m_ptr(pRef.m_ptr) { if (m_ptr) ((Object *) m_ptr)->incRef(); }
 
+#if defined(MTS_HAS_RVALUE_REFS)
+    /// Move-constructor (steals the reference without touching the reference count)
+    ref(ref &&pRef) : m_ptr(pRef.m_ptr) { pRef.m_ptr = NULL; }
+#endif
+
     /// Destroy this reference
     ~ref() { if (m_ptr) ((Object *) m_ptr)->decRef(); }
 
@@ -63,6 +68,27 @@ public:
         return *this;
     }
 
+#if defined(MTS_HAS_RVALUE_REFS)
+    /// Move another reference into this one
+    inline ref& operator= (ref &&r) {
+        if (this == &r)
+            return *this;
+        T *old = m_ptr;
+        m_ptr = r.m_ptr;
+        r.m_ptr = NULL;
+        if (old)
+            ((Object *) old)->decRef();
+        return *this;
+    }
+#endif
+
+    /// Exchange the referenced objects without touching their reference counts
+    inline void swap(ref &r) {
+        T *tmp = m_ptr;
+        m_ptr = r.m_ptr;
+        r.m_ptr = tmp;
+    }
+
     /// Overwrite this reference with a pointer to another object
     inline ref& operator= (T *ptr) {
         if (m_ptr == ptr)
@@ -21,6 +21,7 @@
 #define __MITSUBA_CORE_SERIALIZATION_H_
 
 #include <mitsuba/mitsuba.h>
+#include <boost/unordered_map.hpp>
 
 MTS_NAMESPACE_BEGIN
 
@@ -82,10 +83,13 @@ private:
     /// Called from the unserialization constructor of SerializableObject
     void registerInstance(SerializableObject *object);
 private:
+    typedef boost::unordered_map<unsigned int, SerializableObject *> IDMap;
+    typedef boost::unordered_map<const SerializableObject *, unsigned int> ObjectMap;
+
     unsigned int m_counter, m_lastID;
     std::vector<SerializableObject *> m_fullyAllocated;
-    std::map<unsigned int, SerializableObject *> m_idToObj;
-    std::map<const SerializableObject *, unsigned int> m_objToId;
+    IDMap m_idToObj;
+    ObjectMap m_objToId;
 };
 
 MTS_NAMESPACE_END
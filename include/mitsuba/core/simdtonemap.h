@@ -0,0 +1,201 @@
+/*
+    This file is part of Mitsuba, a physically based rendering system.
+
+    Copyright (c) 2007-2014 by Wenzel Jakob and others.
+
+    Mitsuba is free software; you can redistribute it and/or modify
+    it under the terms of the GNU General Public License Version 3
+    as published by the Free Software Foundation.
+
+    Mitsuba is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program. If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#pragma once
+#if !defined(__MITSUBA_CORE_SIMDTONEMAP_H_)
+#define __MITSUBA_CORE_SIMDTONEMAP_H_
+
+#include <mitsuba/core/bitmap.h>
+
+MTS_NAMESPACE_BEGIN
+
+/**
+ * \brief Fast CPU tone mapper for high dynamic range images
+ *
+ * Converts linear \ref Bitmap::ERGBA / \ref Bitmap::EFloat32 images into
+ * 8-bit \ref Bitmap::ERGB or \ref Bitmap::ERGBA images using either an exposure (gamma) or
+ * Reinhard et al.'s global photographic operator, followed by an sRGB
+ * or gamma display transform. When compiled with SSE support, four
+ * pixels are processed at a time; large images are additionally split
+ * into chunks that are processed in parallel using OpenMP. This
+ * includes the reduction that computes the log-average and maximum
+ * luminance needed by the Reinhard operator.
+ *
+ * The results match \ref Bitmap::tonemapReinhard() followed by
+ * \ref Bitmap::convert() to within one quantization step.
+ *
+ * Adapted from HDRI Tools by Edgar Velazquez-Armendariz.
+ *
+ * \ingroup libcore
+ * \ingroup libpython
+ */
+class MTS_EXPORT_CORE TonemapCPU : public Object {
+public:
+    /// Tone mapping parameters
+    struct Params {
+        float invGamma;
+        float invWhitePoint;
+        float multiplier;
+
+        /// key / averageLogLuminance
+        float scale;
+
+        bool isSRGB;
+
+        float avgLogLum;
+        float maxLum;
+
+        Params() :
+        invGamma(1.0f/2.2f), invWhitePoint(1.0f), multiplier(1.0f), scale(1.0f),
+        isSRGB(true), avgLogLum(0.18f), maxLum(1.0f)
+        {}
+    };
+
+    /// Create a new tone mapper with default parameters (sRGB, no scaling)
+    TonemapCPU();
+
+    inline Float logAvgLuminance() const {
+        return m_params.avgLogLum;
+    }
+
+    inline Float maxLuminance() const {
+        return m_params.maxLum;
+    }
+
+    inline Float multiplier() const {
+        return m_params.multiplier;
+    }
+
+    inline void setInvWhitePoint(Float invWhitePoint) {
+        m_params.invWhitePoint = static_cast<float>(invWhitePoint);
+    }
+
+    inline void setInvGamma(Float invGamma) {
+        m_params.invGamma = static_cast<float>(invGamma);
+    }
+
+    inline void setScale(Float scale) {
+        m_params.scale = static_cast<float>(scale);
+    }
+
+    inline void setMultiplier(Float multiplier) {
+        m_params.multiplier = static_cast<float>(multiplier);
+    }
+
+    inline void setSRGB(bool srgb) {
+        m_params.isSRGB = srgb;
+    }
+
+    /**
+     * \brief Set the display transform using the convention of
+     * \ref Bitmap::convert(), i.e. <tt>gamma=-1</tt> selects sRGB
+     */
+    void setGamma(Float gamma);
+
+    /// Return the current parameters
+    inline const Params &getParams() const { return m_params; }
+
+    /**
+     * \brief Exposure tone mapping: scale by the inverse white point,
+     * then apply the display transform
+     *
+     * Source: RGBA32F, Target: RGB8 or RGBA8. Returns \c false and prints a
+     * warning when the bitmaps have an unsupported format.
+     */
+    bool gammaTonemap(const Bitmap *source, Bitmap *target) const;
+
+    /**
+     * \brief Reinhard tone mapping using the current scale, inverse white
+     * point and multiplier, followed by the display transform
+     *
+     * Source: RGBA32F, Target: RGB8 or RGBA8. Returns \c false and prints a
+     * warning when the bitmaps have an unsupported format.
+     */
+    bool reinhardTonemap(const Bitmap *source, Bitmap *target) const;
+
+    /**
+     * \brief Compute the log-average and maximum luminance of
+     * an RGBA32F image, whose values are scaled by \c multiplier
+     *
+     * When \c ignoreLogo is set, pixels with a luminance of exactly
+     * 1024 are treated as black. The interactive viewer uses this
+     * value to draw the Mitsuba logo.
+     */
+    bool setLuminanceInfo(const Bitmap *source, Float multiplier = 1,
+        bool ignoreLogo = false);
+
+    /// Directly specify the luminance information (e.g. from a previous frame)
+    void setLuminanceInfo(Float logAvgLuminance, Float maxLuminance);
+
+    /**
+     * \brief Derive the scale and white point of the Reinhard operator
+     * from the luminance information
+     *
+     * The parameters have the same meaning as in
+     * \ref Bitmap::tonemapReinhard().
+     */
+    void setReinhardParameters(Float key, Float burn);
+
+    /**
+     * \brief Return a linear RGBA32F version of \c bitmap that is
+     * suitable as a source image
+     *
+     * Returns the bitmap itself when no conversion is necessary.
+     */
+    static ref<Bitmap> prepareSource(Bitmap *bitmap);
+
+    /**
+     * \brief Tonemap a high dynamic range image into an 8-bit bitmap
+     *
+     * When the vectorized operators cannot process the bitmaps, the
+     * implementation falls back to \ref Bitmap::tonemapReinhard() and
+     * \ref Bitmap::convert().
+     *
+     * \param source
+     *    Source image. Any format that \ref Bitmap::convert() can turn
+     *    into linear RGBA data is accepted (including the weighted
+     *    spectral data of image blocks).
+     * \param pixelFormat
+     *    Pixel format of the result (\ref Bitmap::ERGB or \ref Bitmap::ERGBA)
+     * \param gamma
+     *    Gamma value of the result (-1: sRGB)
+     * \param multiplier
+     *    Exposure multiplier. Only used when the Reinhard operator is
+     *    disabled, i.e. when \c key is negative.
+     * \param key, burn
+     *    Parameters of the Reinhard operator, see
+     *    \ref Bitmap::tonemapReinhard()
+     * \param logAvgLuminance, maxLuminance
+     *    Luminance statistics used by the Reinhard operator. When zero,
+     *    they are computed from the source image and returned.
+     */
+    static ref<Bitmap> develop(Bitmap *source, Bitmap::EPixelFormat pixelFormat,
+        Float gamma, Float multiplier, Float key, Float burn,
+        Float &logAvgLuminance, Float &maxLuminance);
+
+    MTS_DECLARE_CLASS()
+protected:
+    /// Virtual destructor
+    virtual ~TonemapCPU() { }
+private:
+    Params m_params;
+};
+
+MTS_NAMESPACE_END
+
+#endif /* __MITSUBA_CORE_SIMDTONEMAP_H_ */
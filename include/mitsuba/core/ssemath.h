@@ -72,6 +72,13 @@ namespace math {
      */
     extern MTS_EXPORT_CORE __m128 fastpow_ps(__m128 x, __m128 y);
 
+    /**
+     * \brief Fast SIMD (SSE2) approximation of \c exp
+     * which provides about 10-11 mantissa bits.
+     * Inspired by the Intel Approximate Math Library.
+     */
+    extern MTS_EXPORT_CORE __m128 fastexp_ps(__m128 x);
+
     /**
      * \brief The arguments <tt>row0</tt>, <tt>row1</tt>, <tt>row2</tt> and
      * <tt>row3</tt> are \c __m128 values whose elements form the corresponding
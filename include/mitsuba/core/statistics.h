@@ -276,6 +276,93 @@ private:
     CacheLineCounter *m_base;
 };
 
+/** \brief Tracks the memory held by a subsystem of the renderer
+ *
+ * In contrast to a \ref StatsCounter of type \ref EByteCount, which only
+ * accumulates, a memory counter is decremented when the memory is released
+ * again. It keeps track of the current value as well as the peak value
+ * observed since the last call to \ref resetPeak(). All memory counters also
+ * contribute to a global total (see \ref Statistics::getTotalMemory()).
+ *
+ * Counters are typically declared as static or global variables next to the
+ * code that performs the allocations, e.g.
+ * \code
+ * MemoryCounter meshMemory("Triangle meshes");
+ * ...
+ * meshMemory.allocate(size);
+ * ...
+ * meshMemory.release(size);
+ * \endcode
+ *
+ * \ingroup libcore
+ */
+class MTS_EXPORT_CORE MemoryCounter {
+public:
+    /// Create a new memory counter and register it with the statistics collector
+    MemoryCounter(const std::string &name);
+
+    /// Record an allocation of the given size (in bytes)
+    inline void allocate(size_t size) {
+#if !defined(MTS_NO_STATISTICS)
+        if (size == 0)
+            return;
+        atomicMaximum(&m_peak, atomicAdd(&m_current, (CounterType) size));
+        if (m_total)
+            m_total->allocate(size);
+#endif
+    }
+
+    /// Record that memory of the given size (in bytes) has been released
+    inline void release(size_t size) {
+#if !defined(MTS_NO_STATISTICS)
+        if (size == 0)
+            return;
+        atomicAdd(&m_current, -(CounterType) size);
+        if (m_total)
+            m_total->release(size);
+#endif
+    }
+
+    /**
+     * \brief Convenience function for data structures that grow or shrink:
+     * replaces a previously recorded size by a new one
+     */
+    inline void update(size_t oldSize, size_t newSize) {
+        if (newSize > oldSize)
+            allocate(newSize - oldSize);
+        else
+            release(oldSize - newSize);
+    }
+
+    /// Return the amount of memory that is currently in use (in bytes)
+    inline uint64_t getCurrent() const {
+        CounterType value = m_current;
+        return value > 0 ? (uint64_t) value : 0;
+    }
+
+    /// Return the peak memory usage (in bytes)
+    inline uint64_t getPeak() const { return (uint64_t) m_peak; }
+
+    /// Set the peak value to the current memory usage
+    inline void resetPeak() { m_peak = m_current; }
+
+    /// Return the name of this counter
+    inline const std::string &getName() const { return m_name; }
+private:
+    friend class Statistics;
+    MemoryCounter(const std::string &name, MemoryCounter *total);
+private:
+#if MTS_32BIT_COUNTERS == 1
+    typedef int32_t CounterType;
+#else
+    typedef int64_t CounterType;
+#endif
+    std::string m_name;
+    volatile CounterType m_current;
+    volatile CounterType m_peak;
+    MemoryCounter *m_total;
+};
+
 /** \brief General-purpose progress reporter
  *
  * This class is used to track the progress of various operations that might
@@ -330,8 +417,10 @@ private:
 /** \brief Collects various rendering statistics and presents them
  * in a human-readable form.
  *
- * \remark Only the \ref getInstance(), \ref getStats(), and
- * \ref printStats() functions are implemented in the Python bindings.
+ * \remark Only the \ref getInstance(), \ref getStats(), \ref printStats()
+ * and \ref getMemoryStats() functions are implemented in the Python bindings,
+ * along with a function \c getMemoryUsage(), which returns a dictionary
+ * mapping the names of all memory counters to (current, peak) tuples.
  *
  * \ingroup libcore
  * \ingroup libpython
@@ -344,6 +433,14 @@ public:
     /// Register a counter with the statistics collector
     void registerCounter(const StatsCounter *ctr);
 
+    /**
+     * \brief Look up a statistics counter by category and name
+     *
+     * \return The counter, or \c NULL if no such counter exists
+     */
+    const StatsCounter *getCounter(const std::string &category,
+        const std::string &name);
+
     /// Record that a plugin has been loaded
     void logPlugin(const std::string &pname, const std::string &descr);
 
@@ -353,9 +450,28 @@ public:
     /// Return a string containing gathered statistics
     std::string getStats();
 
-    /// Reset all statistics counters
+    /// Reset all statistics counters (and the peak values of all memory counters)
     void resetAll();
 
+    /// Register a memory counter with the statistics collector
+    void registerMemoryCounter(const MemoryCounter *ctr);
+
+    /**
+     * \brief Look up a memory counter by name
+     *
+     * \return The counter, or \c NULL if no counter with this name exists
+     */
+    const MemoryCounter *getMemoryCounter(const std::string &name);
+
+    /// Return a list of all registered memory counters
+    std::vector<const MemoryCounter *> getMemoryCounters();
+
+    /// Return the counter that keeps track of the total of all memory counters
+    inline const MemoryCounter *getTotalMemory() const { return m_totalMemory; }
+
+    /// Return a human-readable summary of the current and peak memory usage
+    std::string getMemoryStats();
+
     /// Initialize the global statistics collector
     static void staticInitialization();
 
@@ -364,10 +480,12 @@ public:
 
     MTS_DECLARE_CLASS()
 protected:
+    friend class MemoryCounter;
+
     /// Create a statistics instance
     Statistics();
     /// Virtual destructor
-    virtual ~Statistics() { }
+    virtual ~Statistics();
 private:
     struct compareCategory {
         bool operator()(const StatsCounter *c1, const StatsCounter *c2) {
@@ -379,6 +497,8 @@ private:
 
     static ref<Statistics> m_instance;
     std::vector<const StatsCounter *> m_counters;
+    std::vector<const MemoryCounter *> m_memoryCounters;
+    MemoryCounter *m_totalMemory;
     std::vector<std::pair<std::string, std::string> > m_plugins;
     ref<Mutex> m_mutex;
 };
@@ -121,6 +121,51 @@ namespace warp {
 
     //! @}
     // =============================================================
+
+    // =============================================================
+    //! @{ \name Batched warping techniques
+    //
+    // These functions warp an entire array of samples at once. When
+    // compiled with SSE support (and single precision), four samples
+    // are processed at a time using the SIMD routines declared in
+    // \ref warp_sse.h. The results match the scalar versions up to
+    // floating point tolerance.
+    // =============================================================
+
+    /// Batched version of \ref squareToUniformSphere()
+    extern MTS_EXPORT_CORE void squareToUniformSphere(const Point2 *samples,
+        Vector *result, size_t count);
+
+    /// Batched version of \ref squareToUniformHemisphere()
+    extern MTS_EXPORT_CORE void squareToUniformHemisphere(const Point2 *samples,
+        Vector *result, size_t count);
+
+    /// Batched version of \ref squareToCosineHemisphere()
+    extern MTS_EXPORT_CORE void squareToCosineHemisphere(const Point2 *samples,
+        Vector *result, size_t count);
+
+    /// Batched version of \ref squareToUniformCone()
+    extern MTS_EXPORT_CORE void squareToUniformCone(Float cosCutoff,
+        const Point2 *samples, Vector *result, size_t count);
+
+    /// Batched version of \ref squareToUniformDisk()
+    extern MTS_EXPORT_CORE void squareToUniformDisk(const Point2 *samples,
+        Point2 *result, size_t count);
+
+    /// Batched version of \ref squareToUniformDiskConcentric()
+    extern MTS_EXPORT_CORE void squareToUniformDiskConcentric(const Point2 *samples,
+        Point2 *result, size_t count);
+
+    /// Batched version of \ref squareToUniformTriangle()
+    extern MTS_EXPORT_CORE void squareToUniformTriangle(const Point2 *samples,
+        Point2 *result, size_t count);
+
+    /// Batched version of \ref squareToStdNormal()
+    extern MTS_EXPORT_CORE void squareToStdNormal(const Point2 *samples,
+        Point2 *result, size_t count);
+
+    //! @}
+    // =============================================================
 };
 
 MTS_NAMESPACE_END
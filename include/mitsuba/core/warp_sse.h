@@ -0,0 +1,77 @@
+/*
+    This file is part of Mitsuba, a physically based rendering system.
+
+    Copyright (c) 2007-2014 by Wenzel Jakob and others.
+
+    Mitsuba is free software; you can redistribute it and/or modify
+    it under the terms of the GNU General Public License Version 3
+    as published by the Free Software Foundation.
+
+    Mitsuba is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program. If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#pragma once
+#if !defined(__MITSUBA_CORE_WARP_SSE_H_)
+#define __MITSUBA_CORE_WARP_SSE_H_
+
+#if !MTS_SSE
+#error "This headers requires SSE support."
+#endif
+
+#include <mitsuba/core/platform.h>
+#include <mitsuba/core/sse.h>
+
+MTS_NAMESPACE_BEGIN
+
+/**
+ * \brief SIMD (SSE2) versions of the warping techniques in \ref warp.h
+ *
+ * Each function maps four samples at once. Inputs and outputs use a
+ * structure-of-arrays layout, i.e. \c u and \c v hold the first and
+ * second coordinates of the four input samples. The results agree with
+ * the scalar implementations up to the accuracy of the SIMD
+ * transcendental functions in \ref ssemath.h.
+ */
+namespace warp {
+    /// Four-wide version of \ref squareToUniformSphere()
+    extern MTS_EXPORT_CORE void squareToUniformSphere4(__m128 u, __m128 v,
+        __m128 &x, __m128 &y, __m128 &z);
+
+    /// Four-wide version of \ref squareToUniformHemisphere()
+    extern MTS_EXPORT_CORE void squareToUniformHemisphere4(__m128 u, __m128 v,
+        __m128 &x, __m128 &y, __m128 &z);
+
+    /// Four-wide version of \ref squareToCosineHemisphere()
+    extern MTS_EXPORT_CORE void squareToCosineHemisphere4(__m128 u, __m128 v,
+        __m128 &x, __m128 &y, __m128 &z);
+
+    /// Four-wide version of \ref squareToUniformCone()
+    extern MTS_EXPORT_CORE void squareToUniformCone4(float cosCutoff,
+        __m128 u, __m128 v, __m128 &x, __m128 &y, __m128 &z);
+
+    /// Four-wide version of \ref squareToUniformDisk()
+    extern MTS_EXPORT_CORE void squareToUniformDisk4(__m128 u, __m128 v,
+        __m128 &x, __m128 &y);
+
+    /// Four-wide version of \ref squareToUniformDiskConcentric()
+    extern MTS_EXPORT_CORE void squareToUniformDiskConcentric4(__m128 u, __m128 v,
+        __m128 &x, __m128 &y);
+
+    /// Four-wide version of \ref squareToUniformTriangle()
+    extern MTS_EXPORT_CORE void squareToUniformTriangle4(__m128 u, __m128 v,
+        __m128 &x, __m128 &y);
+
+    /// Four-wide version of \ref squareToStdNormal()
+    extern MTS_EXPORT_CORE void squareToStdNormal4(__m128 u, __m128 v,
+        __m128 &x, __m128 &y);
+};
+
+MTS_NAMESPACE_END
+
+#endif /* __MITSUBA_CORE_WARP_SSE_H_ */
@@ -203,6 +203,8 @@ public:
 
     ref<Bitmap> getBitmap(const Vector2i &resolutionHint) const;
 
+    int compile(TextureProgram *program) const;
+
     void serialize(Stream *stream, InstanceManager *manager) const;
 
     MTS_DECLARE_CLASS()
@@ -266,6 +268,8 @@ public:
 
     ref<Bitmap> getBitmap(const Vector2i &resolutionHint) const;
 
+    int compile(TextureProgram *program) const;
+
     void serialize(Stream *stream, InstanceManager *manager) const;
 
     MTS_DECLARE_CLASS()
@@ -332,6 +336,8 @@ public:
 
     ref<Bitmap> getBitmap(const Vector2i &resolutionHint) const;
 
+    int compile(TextureProgram *program) const;
+
     MTS_DECLARE_CLASS()
 protected:
     ref<const Texture> m_a, m_b;
@@ -36,6 +36,29 @@ MTS_NAMESPACE_BEGIN
  */
 class MTS_EXPORT_RENDER Film : public ConfigurableObject {
 public:
+    /// Rectangle of pixels relative to the crop window (see \ref setRegions())
+    struct Region {
+        Point2i offset;
+        Vector2i size;
+
+        inline Region() { }
+
+        inline Region(const Point2i &offset, const Vector2i &size)
+            : offset(offset), size(size) { }
+
+        /// Does this region overlap the given rectangle?
+        inline bool overlaps(const Point2i &o, const Vector2i &s) const {
+            return o.x < offset.x + size.x && offset.x < o.x + s.x &&
+                   o.y < offset.y + size.y && offset.y < o.y + s.y;
+        }
+
+        /// Return a human-readable description
+        inline std::string toString() const {
+            return formatString("Region[offset=%s, size=%s]",
+                offset.toString().c_str(), size.toString().c_str());
+        }
+    };
+
     /// Ignoring the crop window, return the resolution of the underlying sensor
     inline const Vector2i &getSize() const { return m_size; }
 
@@ -91,6 +114,35 @@ public:
     /// Return whether or not this film records the alpha channel
     virtual bool hasAlpha() const = 0;
 
+    /**
+     * \brief Restrict rendering to a set of dirty rectangles
+     *
+     * Block-based integrators then only schedule the image blocks that
+     * overlap one of the regions (enlarged by the reconstruction filter
+     * radius). When a \c base image is given, films that support it
+     * (currently \c hdrfilm) composite the re-rendered regions into it
+     * when the film is developed, leaving all other pixels untouched.
+     * The base image must either match the crop window or the full film
+     * size, in which case the crop window is extracted from it.
+     *
+     * The regions are clipped to the crop window. They are only needed
+     * on the machine that schedules the rendering and are therefore not
+     * serialized. Passing an empty list restores the default behavior.
+     */
+    void setRegions(const std::vector<Region> &regions, Bitmap *base = NULL);
+
+    /// Return the dirty regions (clipped to the crop window)
+    inline const std::vector<Region> &getRegions() const { return m_regions; }
+
+    /// Has rendering been restricted to a set of dirty regions?
+    inline bool hasRegions() const { return m_hasRegions; }
+
+    /// Return the base image, into which dirty regions are composited (or \c NULL)
+    inline const Bitmap *getRegionBase() const { return m_regionBase.get(); }
+
+    /// Does the given rectangle (relative to the crop window) overlap a dirty region?
+    bool isDirty(const Point2i &offset, const Vector2i &size) const;
+
     /// Return the image reconstruction filter
     inline ReconstructionFilter *getReconstructionFilter() { return m_filter.get(); }
 
@@ -126,11 +178,22 @@ protected:
 
     /// Virtual destructor
     virtual ~Film();
+
+    /**
+     * \brief Composite the dirty regions of a developed image into
+     * the base image
+     *
+     * Returns \c bitmap itself when no base image was specified.
+     */
+    ref<Bitmap> compositeRegions(Bitmap *bitmap) const;
 protected:
     Point2i m_cropOffset;
     Vector2i m_size, m_cropSize;
     bool m_highQualityEdges;
     ref<ReconstructionFilter> m_filter;
+    std::vector<Region> m_regions;
+    ref<Bitmap> m_regionBase;
+    bool m_hasRegions;
 };
 
 MTS_NAMESPACE_END
@@ -60,6 +60,7 @@ class ProjectiveCamera;
 struct RadianceQueryRecord;
 struct PositionSamplingRecord;
 class Random;
+struct RayBatch;
 class RangeWorkUnit;
 class ReconstructionFilter;
 class RectangularWorkUnit;
@@ -77,6 +78,7 @@ class SparseMipmap3D;
 class Spiral;
 class Subsurface;
 class Texture;
+class TextureProgram;
 struct TriAccel;
 struct TriAccel4;
 class TriMesh;
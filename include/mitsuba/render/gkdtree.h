@@ -22,6 +22,7 @@
 
 #include <mitsuba/core/timer.h>
 #include <mitsuba/core/lock.h>
+#include <mitsuba/core/statistics.h>
 #include <boost/static_assert.hpp>
 #include <stack>
 
@@ -59,6 +60,12 @@
 
 MTS_NAMESPACE_BEGIN
 
+namespace stats {
+    /// Memory used by kd-tree nodes, index lists and intersection data
+    extern MTS_EXPORT_RENDER MemoryCounter kdtreeMemory;
+    /// Temporary memory used during kd-tree construction
+    extern MTS_EXPORT_RENDER MemoryCounter kdtreeBuildMemory;
+};
 
 /**
  * \brief Special "ordered" memory allocator
@@ -92,8 +99,10 @@ public:
      */
     void cleanup() {
         for (std::vector<Chunk>::iterator it = m_chunks.begin();
-                it != m_chunks.end(); ++it)
+                it != m_chunks.end(); ++it) {
+            stats::kdtreeBuildMemory.release((*it).size);
             freeAligned((*it).start);
+        }
         m_chunks.clear();
     }
 
@@ -142,6 +151,7 @@ public:
         chunk.cur = chunk.start + size;
         chunk.size = allocSize;
         m_chunks.push_back(chunk);
+        stats::kdtreeBuildMemory.allocate(allocSize);
 
         return reinterpret_cast<T *>(chunk.start);
     }
@@ -729,7 +739,7 @@ public:
      * \brief Create a new kd-tree instance initialized with
      * the default parameters.
      */
-    GenericKDTree() : m_indices(NULL) {
+    GenericKDTree() : m_indices(NULL), m_nodeCount(0), m_indexCount(0) {
         m_nodes = NULL;
         m_traversalCost = 15;
         m_queryCost = 20;
@@ -753,6 +763,7 @@ public:
             delete[] m_indices;
         if (m_nodes)
             freeAligned(m_nodes-1); // undo alignment shift
+        stats::kdtreeMemory.release(getMemoryUsage());
     }
 
     /**
@@ -931,6 +942,13 @@ public:
     inline SizeType getExactPrimitiveThreshold() const {
         return m_exactPrimThreshold;
     }
+
+    /// Return the memory used by the nodes and index lists of the final tree
+    inline size_t getMemoryUsage() const {
+        if (!m_nodes)
+            return 0;
+        return sizeof(KDNode) * (m_nodeCount+1) + sizeof(IndexType) * m_indexCount;
+    }
 protected:
     /**
      * \brief Once the tree has been constructed, it is rewritten into
@@ -974,6 +992,8 @@ protected:
             // +1 shift is for alignment purposes (see KDNode::getSibling)
             m_nodes = static_cast<KDNode *>(allocAligned(sizeof(KDNode) * 2))+1;
             m_nodes[0].initLeafNode(0, 0);
+            m_nodeCount = 1;
+            stats::kdtreeMemory.allocate(getMemoryUsage());
             return;
         }
 
@@ -1113,6 +1133,7 @@ protected:
         m_nodes = static_cast<KDNode *> (allocAligned(
                 sizeof(KDNode) * (m_nodeCount+1)))+1;
         m_indices = new IndexType[m_indexCount];
+        stats::kdtreeMemory.allocate(getMemoryUsage());
 
         /* The following code rewrites all tree nodes with proper relative
            indices. It also computes the final tree cost and some other
@@ -23,9 +23,15 @@
 #include <mitsuba/core/bitmap.h>
 #include <mitsuba/core/sched.h>
 #include <mitsuba/core/rfilter.h>
+#include <mitsuba/core/statistics.h>
 
 MTS_NAMESPACE_BEGIN
 
+namespace stats {
+    /// Memory used by image blocks, including the storage of films
+    extern MTS_EXPORT_RENDER MemoryCounter imageBlockMemory;
+};
+
 /**
  * \brief Storage for an image sub-block (a.k.a render bucket)
  *
@@ -57,10 +57,22 @@ protected:
      */
     void init(const Point2i &offset, const Vector2i &size, uint32_t blockSize);
 
+    /**
+     * \brief Only generate the blocks for which \c mask is \c true
+     *
+     * The mask contains one entry per block in row-major order (see
+     * \ref m_numBlocks) and must be specified after calling \ref init().
+     * The spiraling order of the remaining blocks is preserved.
+     */
+    void setBlockMask(const std::vector<bool> &mask);
+
     /// Protected constructor
     inline BlockedImageProcess() { }
     /// Virtual destructor
     virtual ~BlockedImageProcess() { }
+
+    /// Advance to the next block position on the spiral
+    void nextBlock();
 protected:
     enum EDirection {
         ERight = 0,
@@ -76,6 +88,7 @@ protected:
     int m_stepsLeft, m_numBlocksTotal;
     int m_numBlocksGenerated;
     int m_blockSize;
+    std::vector<bool> m_blockMask;
 };
 
 MTS_NAMESPACE_END
@@ -151,6 +151,19 @@ public:
     virtual Spectrum evalTransmittance(const Ray &ray,
         Sampler *sampler = NULL) const = 0;
 
+    /**
+     * \brief Compute the transmittance along several ray segments
+     *
+     * This is a batched version of \ref evalTransmittance(), which
+     * lets homogeneous media process several segments at once. The
+     * default implementation calls \ref evalTransmittance() once per ray.
+     *
+     * \param rays     Array of \c count rays with normalized directions
+     * \param result   Array of \c count entries that receives the transmittances
+     */
+    virtual void evalTransmittanceBatch(const Ray *rays, size_t count,
+        Spectrum *result, Sampler *sampler = NULL) const;
+
     /// Return the phase function of this medium
     inline const PhaseFunction *getPhaseFunction() const { return m_phaseFunction.get(); }
 
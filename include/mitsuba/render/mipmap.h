@@ -47,6 +47,7 @@ namespace stats {
     extern MTS_EXPORT_RENDER StatsCounter avgEWASamples;
     extern MTS_EXPORT_RENDER StatsCounter clampedAnisotropy;
     extern MTS_EXPORT_RENDER StatsCounter mipStorage;
+    extern MTS_EXPORT_RENDER MemoryCounter mipMemory;
     extern MTS_EXPORT_RENDER StatsCounter filteredLookups;
 };
 
@@ -300,6 +301,7 @@ public:
                 m_weightLut[i] = math::fastexp(-2.0f * r2) - math::fastexp(-2.0f);
             }
         }
+        stats::mipMemory.allocate(getBufferSize());
     }
 
     /**
@@ -375,10 +377,12 @@ public:
                 m_weightLut[i] = math::fastexp(-2.0f * r2) - math::fastexp(-2.0f);
             }
         }
+        stats::mipMemory.allocate(getBufferSize());
     }
 
     /// Release all memory
     ~TMIPMap() {
+        stats::mipMemory.release(getBufferSize());
         delete[] m_pyramid;
         delete[] m_sizeRatio;
         if (m_weightLut)
@@ -625,6 +629,43 @@ public:
         gradient[1] = (p01 + p00*(dx-1) - tmp*dx) * static_cast<Float> (size.y);
     }
 
+    /**
+     * \brief Evaluate the texture at a fractional MIP level by interpolating
+     * between bilinear lookups on the two adjacent levels
+     */
+    inline Value evalTrilinear(Float level, const Point2 &uv) const {
+        int ilevel = math::floorToInt(level);
+
+        if (ilevel < 0) {
+            /* Bilinear interpolation (lookup is smaller than 1 pixel) */
+            return evalBilinear(0, uv);
+        } else {
+            /* Trilinear interpolation between two mipmap levels */
+            Float a = level - ilevel;
+            return evalBilinear(ilevel,   uv) * (1.0f - a)
+                 + evalBilinear(ilevel+1, uv) * a;
+        }
+    }
+
+    /**
+     * \brief Perform a lookup with an isotropic footprint of the given width
+     * (in UV coordinates), e.g. one derived from a ray cone
+     *
+     * The level of detail is computed directly from the footprint, which avoids
+     * the ellipse setup and EWA weighting of \ref eval(). Filter types other
+     * than \ref ENearest and \ref EBilinear use trilinear interpolation.
+     */
+    inline Value evalLOD(const Point2 &uv, Float width) const {
+        if (m_filterType == ENearest)
+            return evalBox(0, uv);
+        else if (m_filterType == EBilinear)
+            return evalBilinear(0, uv);
+
+        const Vector2i &size = m_pyramid[0].getSize();
+        Float texels = width * std::max(size.x, size.y);
+        return evalTrilinear(math::log2(std::max(texels, Epsilon)), uv);
+    }
+
     /// \brief Perform a filtered texture lookup using the configured method
     Value eval(const Point2 &uv, const Vector2 &d0, const Vector2 &d1) const {
         if (m_filterType == ENearest)
@@ -654,18 +695,7 @@ public:
         if (m_filterType == ETrilinear || !(minorRadius > 0) || !(majorRadius > 0) || F < 0) {
             /* Determine a suitable mip map level, while preferring
                blurring over aliasing */
-            Float level = math::log2(std::max(majorRadius, Epsilon));
-            int ilevel = math::floorToInt(level);
-
-            if (ilevel < 0) {
-                /* Bilinear interpolation (lookup is smaller than 1 pixel) */
-                return evalBilinear(0, uv);
-            } else {
-                /* Trilinear interpolation between two mipmap levels */
-                Float a = level - ilevel;
-                return evalBilinear(ilevel,   uv) * (1.0f - a)
-                     + evalBilinear(ilevel+1, uv) * a;
-            }
+            return evalTrilinear(math::log2(std::max(majorRadius, Epsilon)), uv);
         } else {
             /* Artificially enlarge ellipses that are too skinny
                to avoid having to compute excessively many samples */
@@ -20,10 +20,16 @@
 #if !defined(__MITSUBA_RENDER_PHOTONMAP_H_)
 #define __MITSUBA_RENDER_PHOTONMAP_H_
 
+#include <mitsuba/core/statistics.h>
 #include <mitsuba/render/photon.h>
 
 MTS_NAMESPACE_BEGIN
 
+namespace stats {
+    /// Memory used by photon maps
+    extern MTS_EXPORT_RENDER MemoryCounter photonMapMemory;
+};
+
 /** \brief Implementation of the photon map data structure
  *
  * Based on Henrik Wann Jensen's book "Realistic Image Synthesis
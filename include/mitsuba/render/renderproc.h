@@ -32,6 +32,13 @@ MTS_NAMESPACE_BEGIN
  * Splits an image into independent rectangular pixel regions, which are
  * then rendered in parallel.
  *
+ * When the sampler operates in deterministic mode (see
+ * \ref Sampler::isDeterministic()), finished blocks are committed to the
+ * film in the order in which they were generated rather than in the order
+ * of their completion. Together with the per-pixel seeding of the sampler,
+ * this makes the output bit-identical regardless of the number of local
+ * and remote workers.
+ *
  * \sa SamplingIntegrator
  * \ingroup librender
  */
@@ -90,6 +97,10 @@ protected:
     Bitmap::EPixelFormat m_pixelFormat;
     int m_channelCount;
     bool m_warnInvalid;
+    bool m_deterministic;
+    std::vector<int> m_blockSequence;
+    std::map<int, ref<ImageBlock> > m_pendingBlocks;
+    int m_nextBlock;
 };
 
 MTS_NAMESPACE_END
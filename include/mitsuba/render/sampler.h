@@ -158,6 +158,35 @@ public:
     /// Return the current sample index
     inline size_t getSampleIndex() const { return m_sampleIndex; }
 
+    /**
+     * \brief Does this sampler operate in deterministic mode?
+     *
+     * In deterministic mode, pseudorandom samplers reseed their random
+     * number generator at the beginning of every image block (see
+     * \ref seedBlock()) using a value that only depends on the block
+     * position and the user-specified seed. The samples of a block are
+     * then independent of the thread or machine that renders it.
+     */
+    inline bool isDeterministic() const { return m_deterministic; }
+
+    /// Enable or disable deterministic mode (see \ref isDeterministic())
+    void setDeterministic(bool deterministic, uint32_t seed = 0);
+
+    /// Return the seed used in deterministic mode
+    inline uint32_t getSeed() const { return m_seed; }
+
+    /**
+     * \brief Prepare the sampler for rendering the image block at the
+     * given offset
+     *
+     * In deterministic mode, pseudorandom samplers reseed their random
+     * number generator here. This is called by \ref BlockedRenderProcess
+     * before every block; other users of \ref generate() (e.g. progressive
+     * photon mapping) keep drawing fresh samples on every call. The default
+     * implementation does nothing.
+     */
+    virtual void seedBlock(const Point2i &offset);
+
     /// Serialize this sampler to a binary data stream
     virtual void serialize(Stream *stream, InstanceManager *manager) const;
 
@@ -171,7 +200,12 @@ protected:
 
     /// Virtual destructor
     virtual ~Sampler();
+
+    /// Return the random seed associated with a block in deterministic mode
+    uint64_t getBlockSeed(const Point2i &offset) const;
 protected:
+    bool m_deterministic;
+    uint32_t m_seed;
     size_t m_sampleCount;
     size_t m_sampleIndex;
     std::vector<size_t> m_req1D, m_req2D;
@@ -89,6 +89,44 @@ public:
      */
     void initializeBidirectional();
 
+    /**
+     * \brief Create a view of the scene that renders through another sensor
+     *
+     * The returned scene is a shallow copy which shares the geometry,
+     * emitters, media, textures and the kd-tree with this instance; only the
+     * sensor, its film and sampler are different. This makes it possible
+     * to render many viewpoints of a scene without loading it again. The
+     * scene is initialized first if this has not happened yet.
+     *
+     * \param sensor
+     *    Sensor of the view, usually one of the entries of \ref getSensors()
+     * \param cloneIntegrator
+     *    Give the view its own copy of the integrator. This is required when
+     *    several views are rendered at the same time, since integrators may
+     *    store intermediate state (e.g. photon maps) while rendering.
+     *    Subsurface integrators are always shared; they are preprocessed
+     *    by the first view that calls \ref preprocess() while no other
+     *    view is rendering.
+     *
+     * The emitters are shared as well. Their bounds (e.g. the bounding
+     * sphere of an environment map) are computed once so that they enclose
+     * the sensors of all views, and they are not changed by the views.
+     */
+    ref<Scene> createView(Sensor *sensor, bool cloneIntegrator = false);
+
+    /**
+     * \brief Reuse the kd-tree of another scene with the same geometry
+     *
+     * When this scene has not been initialized yet and contains exactly the
+     * same shape instances as \c scene (which must already be initialized),
+     * the kd-tree of \c scene is adopted instead of building a new one. This
+     * is the case when a scene is reloaded using a \ref SceneObjectCache and
+     * only non-geometric parts of its description have changed.
+     *
+     * \return \c true if the kd-tree could be reused
+     */
+    bool reuseKDTree(const Scene *scene);
+
     /**
      * \brief Perform any pre-processing steps before rendering
      *
@@ -849,6 +887,14 @@ public:
         return emitter->getSamplingWeight() * m_emitterPDF.getNormalization();
     }
 
+    /**
+     * \brief Return the discrete distribution used to choose
+     * an emitter in <tt>sampleEmitter*</tt>
+     *
+     * Entries are in the order of \ref getEmitters().
+     */
+    inline const DiscreteDistribution &getEmitterPDF() const { return m_emitterPDF; }
+
     /**
      * \brief Importance sample a ray according to the emission profile
      * defined by the sensors in the scene
@@ -1140,10 +1186,13 @@ protected:
     virtual ~Scene();
 
     /// \cond
-    /// Add a shape to the scene
-    void addShape(Shape *shape);
+    /// Add a shape to the scene (and optionally to the kd-tree)
+    void addShape(Shape *shape, bool addToKDTree = true);
     /// \endcond
 private:
+    /// Subsurface integrator bookkeeping shared by a scene and its views
+    struct SubsurfaceState;
+
     ref<ShapeKDTree> m_kdtree;
     ref<Sensor> m_sensor;
     ref<Integrator> m_integrator;
@@ -1151,20 +1200,26 @@ private:
     ref<Emitter> m_environmentEmitter;
     ref_vector<Shape> m_shapes;
     ref_vector<Shape> m_specialShapes;
+    ref_vector<Shape> m_emitterShapes;
     ref_vector<Sensor> m_sensors;
     ref_vector<Emitter> m_emitters;
     ref_vector<ConfigurableObject> m_objects;
     ref_vector<NetworkedObject> m_netObjects;
     ref_vector<Subsurface> m_ssIntegrators;
+    ref<SubsurfaceState> m_ssState;
+    bool m_ssClaimed;
     ref_vector<Medium> m_media;
     std::vector<TriMesh *> m_meshes;
     fs::path *m_sourceFile;
     fs::path *m_destinationFile;
     DiscreteDistribution m_emitterPDF;
     AABB m_aabb;
+    AABB m_emitterAABB;
     uint32_t m_blockSize;
     bool m_degenerateSensor;
     bool m_degenerateEmitters;
+    bool m_isView;
+    bool m_hasViews;
 };
 
 MTS_NAMESPACE_END
@@ -28,6 +28,7 @@
 #include <boost/unordered_map.hpp>
 #include <stack>
 #include <map>
+#include <set>
 
 XERCES_CPP_NAMESPACE_BEGIN
 class SAXParser;
@@ -71,6 +72,96 @@ private:
 /// Push a cleanup handler to be executed after loading the scene is done
 extern MTS_EXPORT_RENDER void pushSceneCleanupHandler(void (*cleanup)());
 
+/**
+ * \brief Cache of scene objects that is shared by several scene loads
+ *
+ * When the same scene description is loaded repeatedly with different
+ * parameters (e.g. the frames of an animation sequence), most of its
+ * objects are created from exactly the same properties and children every
+ * time. A \ref SceneHandler with an attached cache reuses such objects
+ * instead of instantiating them again, which avoids reloading meshes,
+ * textures and environment maps.
+ *
+ * Only shapes, textures, BSDFs, emitters, media, volumes and phase functions
+ * are cached. Objects with per-render state (sensors, films, samplers,
+ * integrators, etc.) are always created from scratch. Emitters nested in a
+ * shape (area lights) are bound to that shape and are not cached either,
+ * hence emissive shapes are also recreated on every load. The cache is not
+ * thread-safe and must only be used by one parser at a time.
+ *
+ * A reused object may still be part of a scene that is being rendered
+ * (e.g. the previous frame of an animation). The parser therefore does
+ * not attach reused objects to their new parents right away; this only
+ * happens when \ref commitParents() is called once that scene is finished.
+ *
+ * \ingroup librender
+ */
+class MTS_EXPORT_RENDER SceneObjectCache : public Object {
+public:
+    typedef std::vector<std::pair<std::string, ConfigurableObject *> > ChildList;
+
+    /// Identifies an object by its class, properties and children
+    struct Key {
+        const Class *theClass;
+        Properties props;
+        std::vector<std::pair<std::string, ref<ConfigurableObject> > > children;
+
+        inline Key() : theClass(NULL) { }
+        Key(const Class *theClass, const Properties &props, const ChildList &children);
+
+        bool operator==(const Key &key) const;
+    };
+
+    /// Create an empty cache
+    SceneObjectCache();
+
+    /// Look up a previously created object (returns \c NULL if there is none)
+    ConfigurableObject *get(const Key &key);
+
+    /// Register a newly created and configured object
+    void put(const Key &key, ConfigurableObject *object);
+
+    /// Release all objects that were not used since the last call to \ref purge()
+    void purge();
+
+    /// Check whether \c object was returned by \ref get() since the last call to \ref purge()
+    bool isReused(const ConfigurableObject *object) const;
+
+    /// Defer a call to <tt>object->setParent(parent)</tt> until \ref commitParents()
+    void deferParent(ConfigurableObject *object, ConfigurableObject *parent);
+
+    /// Perform all deferred \ref ConfigurableObject::setParent() calls
+    void commitParents();
+
+    /// Release all objects
+    void clear();
+
+    /// Return the number of cached objects
+    inline size_t size() const { return m_entries.size(); }
+
+    /// Return the number of successful lookups
+    inline size_t getHitCount() const { return m_hits; }
+
+    /// Return the number of unsuccessful lookups
+    inline size_t getMissCount() const { return m_misses; }
+
+    MTS_DECLARE_CLASS()
+protected:
+    /// Virtual destructor
+    virtual ~SceneObjectCache();
+private:
+    struct Entry {
+        Key key;
+        ref<ConfigurableObject> object;
+        bool used;
+    };
+
+    std::multimap<std::string, Entry> m_entries;
+    std::set<const ConfigurableObject *> m_reused;
+    std::vector<std::pair<ref<ConfigurableObject>, ref<ConfigurableObject> > > m_parents;
+    size_t m_hits, m_misses;
+};
+
 /**
  * \brief XML parser for Mitsuba scene files. To be used with the
  * SAX interface of Xerces-C++.
@@ -89,9 +180,16 @@ public:
             bool isIncludedFile = false);
     virtual ~SceneHandler();
 
-    /// Convenience method -- load a scene from a given filename
+    /**
+     * \brief Convenience method -- load a scene from a given filename
+     *
+     * When a \ref SceneObjectCache is specified, unchanged objects from
+     * previous loads are reused. \ref SceneObjectCache::commitParents()
+     * must then be called before the returned scene is rendered.
+     */
     static ref<Scene> loadScene(const fs::path &filename,
-        const ParameterMap &params= ParameterMap());
+        const ParameterMap &params= ParameterMap(),
+        SceneObjectCache *cache = NULL);
 
     /// Convenience method -- load a scene from a given string
     static ref<Scene> loadSceneFromString(const std::string &string,
@@ -119,6 +217,12 @@ public:
     inline const Scene *getScene() const { return m_scene.get(); }
     inline Scene *getScene() { return m_scene; }
 
+    /// Attach a cache that allows reusing objects across several loads
+    inline void setObjectCache(SceneObjectCache *cache) { m_cache = cache; }
+
+    /// Return the attached object cache (if any)
+    inline SceneObjectCache *getObjectCache() { return m_cache; }
+
     // -----------------------------------------------------------------------
     //  Implementation of the SAX ErrorHandler interface
     // -----------------------------------------------------------------------
@@ -133,6 +237,9 @@ protected:
 
     void clear();
 
+    /// Attach a child object to its parent (deferred for reused objects)
+    void setParent(ConfigurableObject *child, ConfigurableObject *parent);
+
 private:
     /**
      * Enumeration of all possible tags that can be encountered in a
@@ -176,6 +283,7 @@ private:
     TagMap m_tags;
     Transform m_transform;
     ref<AnimatedTransform> m_animatedTransform;
+    ref<SceneObjectCache> m_cache;
     bool m_isIncludedFile;
 };
 
@@ -26,6 +26,72 @@
 
 MTS_NAMESPACE_BEGIN
 
+/**
+ * \brief Structure-of-arrays storage for a batch of primary rays
+ *
+ * This is the output format of \ref Sensor::sampleRayBatch(). Each ray
+ * component is stored in a separate 16-byte aligned array, whose size is
+ * padded to a multiple of four. This lets sensors process several rays
+ * at once using SIMD instructions and allows groups of four rays to be
+ * loaded into the packets used by the coherent ray tracing code.
+ *
+ * \ingroup librender
+ */
+struct MTS_EXPORT_RENDER RayBatch {
+    /// Ray origins
+    Float *ox, *oy, *oz;
+    /// Ray directions
+    Float *dx, *dy, *dz;
+    /// Ray segments and time values
+    Float *mint, *maxt, *time;
+    /// Importance weights associated with the rays
+    Spectrum *weight;
+    /// Number of rays currently stored in the batch
+    size_t size;
+
+    /// Allocate storage for up to \c capacity rays
+    RayBatch(size_t capacity);
+
+    /// Release all memory
+    ~RayBatch();
+
+    /// Return the maximum number of rays that can be stored
+    inline size_t getCapacity() const { return m_capacity; }
+
+    /// Return ray \c i in array-of-structures form
+    inline Ray getRay(size_t i) const {
+        return Ray(Point(ox[i], oy[i], oz[i]), Vector(dx[i], dy[i], dz[i]),
+            mint[i], maxt[i], time[i]);
+    }
+
+    /// Overwrite ray \c i and its importance weight
+    inline void setRay(size_t i, const Ray &ray, const Spectrum &value) {
+        ox[i] = ray.o.x; oy[i] = ray.o.y; oz[i] = ray.o.z;
+        dx[i] = ray.d.x; dy[i] = ray.d.y; dz[i] = ray.d.z;
+        mint[i] = ray.mint; maxt[i] = ray.maxt; time[i] = ray.time;
+        weight[i] = value;
+    }
+
+#if defined(MTS_HAS_COHERENT_RT)
+    /**
+     * \brief Load rays <tt>4*index, ..., 4*index+3</tt> into a packet
+     * for \ref ShapeKDTree::rayIntersectPacket()
+     *
+     * Lanes past the end of the batch replicate its last ray.
+     *
+     * \return \c true if all rays of the packet have matching
+     * direction signs (see \ref RayPacket4::load())
+     */
+    bool getPacket(size_t index, RayPacket4 &packet, RayInterval4 &interval) const;
+#endif
+private:
+    RayBatch(const RayBatch &);
+    RayBatch &operator=(const RayBatch &);
+
+    Float *m_storage;
+    size_t m_capacity;
+};
+
 /**
  * \brief Abstract sensor interface
  *
@@ -197,6 +263,41 @@ public:
         const Point2 &apertureSample,
         Float timeSample) const;
 
+    /**
+     * \brief Importance sample a whole batch of primary rays
+     *
+     * This is a batched version of \ref sampleRay(), which generates the
+     * rays of an entire block of samples in one call and stores them in
+     * structure-of-arrays form. Sensors can override it to share work
+     * between rays and to process several of them at once using SIMD
+     * instructions. The resulting rays do not carry differentials.
+     *
+     * The default implementation calls \ref sampleRay() once per sample.
+     *
+     * \param batch
+     *    Output storage, whose capacity must be at least \c count
+     *
+     * \param samplePositions
+     *    Array of \c count sample positions in fractional pixel
+     *    coordinates (see \ref sampleRay())
+     *
+     * \param apertureSamples
+     *    Array of \c count uniformly distributed 2D aperture samples.
+     *    May be \c NULL when \ref needsApertureSample() == \c false
+     *
+     * \param timeSamples
+     *    Array of \c count uniformly distributed 1D time samples.
+     *    May be \c NULL when \ref needsTimeSample() == \c false
+     *
+     * \param count
+     *    Number of rays to generate
+     */
+    virtual void sampleRayBatch(RayBatch &batch,
+        const Point2 *samplePositions,
+        const Point2 *apertureSamples,
+        const Float *timeSamples,
+        size_t count) const;
+
     /// Importance sample the temporal part of the sensor response function
     inline Float sampleTime(Float sample) const {
         return m_shutterOpen + m_shutterOpenTime * sample;
@@ -436,6 +537,20 @@ public:
     virtual Transform getProjectionTransform(const Point2 &apertureSample,
             const Point2 &aaSample) const = 0;
 
+    /**
+     * \brief Compute the rectangle of pixels covered by the projection
+     * of a world-space bounding box
+     *
+     * The rectangle is specified relative to the crop window of the film
+     * and clipped to it. It conservatively accounts for sensor motion
+     * during the shutter interval and for the extent of the aperture.
+     * When the box extends behind the camera, the entire crop window
+     * is returned.
+     *
+     * \return \c false if the box is not visible by the camera
+     */
+    bool getScreenBounds(const AABB &aabb, Point2i &offset, Vector2i &size) const;
+
     /// Serialize this camera to a binary data stream
     virtual void serialize(Stream *stream, InstanceManager *manager) const;
 
@@ -531,6 +646,28 @@ protected:
     /// Unserialize a perspective camera instance from a binary data stream
     PerspectiveCamera(Stream *stream, InstanceManager *manager);
 
+    /**
+     * \brief First stage of the batched ray generation used by
+     * perspective cameras
+     *
+     * Stores the sampled time values, sets the ray origins to zero and
+     * writes the camera-space positions of the samples on the near plane
+     * (as given by \c sampleToCamera) into the direction arrays.
+     */
+    void prepareRayBatch(RayBatch &batch, const Transform &sampleToCamera,
+        const Point2 *samplePositions, const Float *timeSamples,
+        size_t count) const;
+
+    /**
+     * \brief Final stage of the batched ray generation used by
+     * perspective cameras
+     *
+     * Normalizes the camera-space directions, computes the ray segments
+     * from the near and far clipping planes and transforms the rays into
+     * world space.
+     */
+    void finishRayBatch(RayBatch &batch) const;
+
     /// Virtual destructor
     virtual ~PerspectiveCamera();
 protected:
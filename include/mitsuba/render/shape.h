@@ -36,7 +36,7 @@ MTS_NAMESPACE_BEGIN
 struct MTS_EXPORT_RENDER Intersection {
 public:
     inline Intersection() :
-        shape(NULL), t(std::numeric_limits<Float>::infinity()) { }
+        shape(NULL), t(std::numeric_limits<Float>::infinity()), uvFootprint(0.0f) { }
 
     /// Convert a local shading-space vector into world space
     inline Vector toWorld(const Vector &v) const {
@@ -118,6 +118,15 @@ public:
     /// Computes texture coordinate partials
     void computePartials(const RayDifferential &ray);
 
+    /**
+     * \brief Computes an isotropic texture space footprint from a ray cone
+     *
+     * This is a cheap alternative to \ref computePartials() for rays that
+     * don't carry differentials, e.g. after a diffuse or glossy bounce.
+     * The result is stored in \ref uvFootprint.
+     */
+    void computeFootprint(const RayCone &cone);
+
     /// Move the intersection forward or backward through time
     inline void adjustTime(Float time);
 
@@ -152,6 +161,9 @@ public:
     /// UV partials wrt. changes in screen-space
     Float dudx, dudy, dvdx, dvdy;
 
+    /// Width of the ray cone footprint in UV space (zero if not available)
+    Float uvFootprint;
+
     /// Time value associated with the intersection
     Float time;
 
@@ -267,6 +279,26 @@ public:
      */
     virtual bool rayIntersect(const Ray &ray, Float mint, Float maxt) const;
 
+#if defined(MTS_HAS_COHERENT_RT)
+    /**
+     * \brief Intersect a packet of four rays against the shape
+     *
+     * This function is used by the coherent ray tracing code path of
+     * \ref ShapeKDTree for shapes that are not triangle meshes. Rays whose
+     * bit is set in \c masked are ignored. The others are tested against
+     * the interval <tt>[mint[i], maxt[i]]</tt>. When an intersection is
+     * found, its distance is written to \c t[i], and \c temp[i] is used
+     * as temporary space in the same way as in \ref rayIntersect().
+     *
+     * The default implementation processes the rays one at a time.
+     *
+     * \return A bit mask of the rays that intersect the shape
+     * \remark This function is not exposed in Python
+     */
+    virtual int rayIntersectPacket(const RayPacket4 &packet, const Float *mint,
+        const Float *maxt, int masked, Float *t, void * const *temp) const;
+#endif
+
     /**
      * \brief Given that an intersection has been found, create a
      * detailed intersection record
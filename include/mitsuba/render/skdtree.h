@@ -74,6 +74,16 @@ class MTS_EXPORT_RENDER ShapeKDTree : public SAHKDTree3D<ShapeKDTree> {
     friend class SingleScatter;
 
 public:
+    /**
+     * \brief Temporarily holds some intersection information (stored
+     * at the beginning of the temporary space of an intersection query)
+     */
+    struct IntersectionCache {
+        SizeType shapeIndex;
+        SizeType primIndex;
+        Float u, v;
+    };
+
     // =============================================================
     //! @{ \name Initialization and tree construction
     // =============================================================
@@ -233,13 +243,6 @@ protected:
         }
     }
 
-    /// Temporarily holds some intersection information
-    struct IntersectionCache {
-        SizeType shapeIndex;
-        SizeType primIndex;
-        Float u, v;
-    };
-
     /**
      * Check whether a primitive is intersected by the given ray. Some
      * temporary space is supplied to store data that can later
@@ -415,6 +418,7 @@ protected:
 
             its.shape = trimesh;
             its.hasUVPartials = false;
+            its.uvFootprint = 0.0f;
             its.primIndex = cache->primIndex;
             its.instance = NULL;
             its.time = ray.time;
@@ -148,6 +148,17 @@ MTS_NAMESPACE_END
         return m_executed - m_succeeded;\
     }
 
+#if defined(MTS_STATIC_PLUGINS)
+#define MTS_EXPORT_TESTCASE(name, descr) \
+    MTS_IMPLEMENT_CLASS(name, false, TestCase) \
+    namespace { \
+        void *CreateUtility_##name() { \
+            return new name(); \
+        } \
+        StaticPlugin StaticPlugin_##name(__FILE__, descr, \
+            NULL, &CreateUtility_##name); \
+    }
+#else
 #define MTS_EXPORT_TESTCASE(name, descr) \
     MTS_IMPLEMENT_CLASS(name, false, TestCase) \
     extern "C" { \
@@ -158,5 +169,6 @@ MTS_NAMESPACE_END
             return descr; \
         } \
     }
+#endif
 
 #endif /* __MITSUBA_RENDER_TESTCASE_H_ */
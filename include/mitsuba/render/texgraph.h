@@ -0,0 +1,178 @@
+/*
+    This file is part of Mitsuba, a physically based rendering system.
+
+    Copyright (c) 2007-2014 by Wenzel Jakob and others.
+
+    Mitsuba is free software; you can redistribute it and/or modify
+    it under the terms of the GNU General Public License Version 3
+    as published by the Free Software Foundation.
+
+    Mitsuba is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program. If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#pragma once
+#if !defined(__MITSUBA_RENDER_TEXGRAPH_H_)
+#define __MITSUBA_RENDER_TEXGRAPH_H_
+
+#include <mitsuba/render/texture.h>
+
+MTS_NAMESPACE_BEGIN
+
+/**
+ * \brief Flattened representation of a texture network
+ *
+ * Texture networks are normally evaluated by recursive virtual \c eval()
+ * calls that pass \ref Spectrum temporaries between the nodes. This class
+ * instead turns a network into a linear list of instructions operating on
+ * a small register file, which is executed by a simple interpreter loop.
+ *
+ * While compiling, subgraphs that are constant (see \ref Texture::isConstant())
+ * are replaced by literals, arithmetic on literals is folded, and chains of
+ * scaling operations are merged. Afterwards, unused instructions are removed
+ * and the remaining temporaries are packed into as few registers as possible.
+ *
+ * Textures take part in this process by implementing \ref Texture::compile().
+ * Nodes that don't (e.g. bitmaps) are embedded as opaque calls to their
+ * \c eval() implementation.
+ *
+ * \ingroup librender
+ */
+class MTS_EXPORT_RENDER TextureProgram : public Object {
+public:
+    /// Supported instructions (\c r: registers, \c c: constants)
+    enum EOpcode {
+        /// <tt>r[dst] = c[a]</tt>
+        EConstant = 0,
+        /// <tt>r[dst] = texture[a]->eval(its, filter)</tt>
+        ETexture,
+        /// <tt>r[dst] = r[a] + r[b]</tt>
+        EAdd,
+        /// <tt>r[dst] = r[a] - r[b]</tt>
+        ESubtract,
+        /// <tt>r[dst] = r[a] * r[b]</tt>
+        EMultiply,
+        /// <tt>r[dst] = r[a] * c[b]</tt>
+        EScale,
+        /// Checkerboard using UV transformation \c a and colors <tt>c[b], c[b+1]</tt>
+        ECheckerboard,
+        /// Grid using UV transformation \c a and colors <tt>c[b], c[b+1]</tt>
+        EGrid
+    };
+
+    /// A single instruction of the program
+    struct Instruction {
+        uint16_t op, dst, a, b;
+
+        inline Instruction(EOpcode op, int dst, int a, int b)
+            : op((uint16_t) op), dst((uint16_t) dst),
+              a((uint16_t) a), b((uint16_t) b) { }
+    };
+
+    /// UV transformation (and pattern parameter) used by the procedural instructions
+    struct UVTransform {
+        Point2 offset;
+        Vector2 scale;
+        Float param;
+
+        inline UVTransform(const Point2 &offset, const Vector2 &scale, Float param)
+            : offset(offset), scale(scale), param(param) { }
+    };
+
+    /// Flatten the texture network rooted at \c texture
+    TextureProgram(const Texture *texture);
+
+    /// Evaluate the program for a single shading point
+    Spectrum eval(const Intersection &its, bool filter = true) const;
+
+    /// Return the number of instructions of the optimized program
+    inline size_t getInstructionCount() const { return m_code.size(); }
+
+    /// Return the number of registers used by the optimized program
+    inline int getRegisterCount() const { return m_registerCount; }
+
+    /// Return the number of texture nodes that were visited during compilation
+    inline size_t getNodeCount() const { return m_nodeCount; }
+
+    /// Does the program evaluate to a constant?
+    inline bool isConstant() const { return m_code.size() == 1 && m_code[0].op == EConstant; }
+
+    /**
+     * \brief If the program consists of a single opaque texture
+     * lookup, return the texture in question (and \c NULL otherwise)
+     */
+    const Texture *getPassthrough() const;
+
+    /// \name Instruction emitters (used by \ref Texture::compile())
+    //! @{
+
+    /**
+     * \brief Compile a nested texture and return the register holding its value
+     *
+     * Constant textures are directly turned into literals.
+     */
+    int compile(const Texture *texture);
+
+    /// Load a constant
+    int constant(const Spectrum &value);
+
+    /// Embed an opaque call to <tt>texture->eval()</tt>
+    int texture(const Texture *texture);
+
+    /// Sum of two registers
+    int add(int a, int b);
+
+    /// Difference of two registers
+    int subtract(int a, int b);
+
+    /// Product of two registers
+    int multiply(int a, int b);
+
+    /// Product of a register and a constant
+    int scale(int a, const Spectrum &factor);
+
+    /// Procedural checkerboard (see the \c checkerboard plugin)
+    int checkerboard(const Point2 &uvOffset, const Vector2 &uvScale,
+            const Spectrum &color0, const Spectrum &color1);
+
+    /// Procedural grid (see the \c gridtexture plugin)
+    int grid(const Point2 &uvOffset, const Vector2 &uvScale, Float lineWidth,
+            const Spectrum &color0, const Spectrum &color1);
+
+    //! @}
+
+    /// Return a human-readable listing of the program
+    std::string toString() const;
+
+    MTS_DECLARE_CLASS()
+protected:
+    /// Append an instruction and return the register it writes to
+    int emit(EOpcode op, int a, int b = 0);
+
+    /// Return whether register \c reg holds a literal (and store it in \c value)
+    bool getConstant(int reg, Spectrum &value) const;
+
+    /// Remove dead instructions and assign physical registers
+    void optimize(int result);
+
+    /// Virtual destructor
+    virtual ~TextureProgram() { }
+private:
+    std::vector<Instruction> m_code;
+    std::vector<Spectrum> m_constants;
+    std::vector<UVTransform> m_uvTransforms;
+    ref_vector<const Texture> m_textures;
+    std::map<const Texture *, int> m_compiled;
+    size_t m_nodeCount;
+    int m_registerCount;
+    int m_result;
+};
+
+MTS_NAMESPACE_END
+
+#endif /* __MITSUBA_RENDER_TEXGRAPH_H_ */
@@ -89,6 +89,16 @@ public:
      */
     virtual ref<Texture> expand();
 
+    /**
+     * \brief Append instructions that evaluate this texture to
+     * a \ref TextureProgram and return the register holding the result
+     *
+     * Nested textures should be compiled via \ref TextureProgram::compile(),
+     * which takes care of folding constant subgraphs. The default
+     * implementation embeds the texture as an opaque call to \ref eval().
+     */
+    virtual int compile(TextureProgram *program) const;
+
     /// Serialize to a binary data stream
     virtual void serialize(Stream *stream, InstanceManager *manager) const;
 
@@ -146,6 +156,16 @@ public:
     virtual Spectrum eval(const Point2 &uv, const Vector2 &d0,
             const Vector2 &d1) const = 0;
 
+    /**
+     * \brief Lookup with an isotropic footprint of the given width in UV space
+     *
+     * This is used for intersections that only carry a ray cone footprint
+     * (see \ref Intersection::computeFootprint()). The default implementation
+     * forwards to the filtered lookup, Texture2D subclasses can optionally
+     * provide a cheaper version.
+     */
+    virtual Spectrum evalLOD(const Point2 &uv, Float width) const;
+
     /// Unfiltered radient lookup lookup -- Texture2D subclasses can optionally provide this function
     virtual void evalGradient(const Point2 &uv, Spectrum *gradient) const;
 
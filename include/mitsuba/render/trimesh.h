@@ -22,10 +22,16 @@
 
 #include <mitsuba/core/triangle.h>
 #include <mitsuba/core/pmf.h>
+#include <mitsuba/core/statistics.h>
 #include <mitsuba/render/shape.h>
 
 MTS_NAMESPACE_BEGIN
 
+namespace stats {
+    /// Memory used by the vertex and index buffers of triangle meshes
+    extern MTS_EXPORT_RENDER MemoryCounter meshMemory;
+};
+
 /**
  * \brief Simple tangent space storage for surfaces
  *
@@ -161,6 +167,11 @@ public:
     /// Does the mesh have UV tangent information?
     inline bool hasUVTangents() const { return m_tangents != NULL; };
 
+    /// Return the per-vertex curvature (x: mean, y: Gaussian curvature)
+    inline const Vector2 *getVertexCurvatures() const { return m_curvatures; };
+    /// Does the mesh have precomputed per-vertex curvature information?
+    inline bool hasVertexCurvatures() const { return m_curvatures != NULL; };
+
     //! @}
     // =============================================================
 
@@ -281,6 +292,35 @@ public:
     void getNormalDerivative(const Intersection &its,
         Vector &dndu, Vector &dndv, bool shadingFrame) const;
 
+    /**
+     * \brief Precompute the mean and Gaussian curvature at every vertex
+     *
+     * The curvature of the interpolated shading normals is evaluated at
+     * the corners of all triangles and averaged over the triangles
+     * surrounding each vertex (weighted by their corner angles). Both
+     * steps run in parallel. Afterwards, \ref lookupCurvature() can
+     * interpolate the result without any further topology queries.
+     *
+     * Nothing happens when the curvature was already computed. This
+     * function is thread-safe.
+     */
+    void computeCurvature();
+
+    /**
+     * \brief Interpolate the precomputed per-vertex curvature
+     * at the given surface intersection
+     *
+     * Requires a prior call to \ref computeCurvature().
+     *
+     * \param its
+     *     Intersection record associated with the query
+     * \param H
+     *     Parameter used to store the mean curvature
+     * \param K
+     *     Parameter used to store the Gaussian curvature
+     */
+    void lookupCurvature(const Intersection &its, Float &H, Float &K) const;
+
     /**
      * \brief Return the number of primitives (triangles, hairs, ..)
      * contributed to the scene by this shape
@@ -352,6 +392,9 @@ protected:
 
     /// Prepare internal tables for sampling uniformly wrt. area
     void prepareSamplingTable();
+
+    /// Report changes in the size of the mesh buffers to \ref stats::meshMemory
+    void updateMemoryUsage();
 protected:
     AABB m_aabb;
     Triangle *m_triangles;
@@ -360,6 +403,7 @@ protected:
     Point2 *m_texcoords;
     TangentSpace *m_tangents;
     Color3 *m_colors;
+    Vector2 *m_curvatures;
     size_t m_triangleCount;
     size_t m_vertexCount;
     bool m_flipNormals;
@@ -370,6 +414,7 @@ protected:
     Float m_surfaceArea;
     Float m_invSurfaceArea;
     ref<Mutex> m_mutex;
+    size_t m_memoryUsage;
 };
 
 MTS_NAMESPACE_END
@@ -59,6 +59,17 @@ protected:
 #define MTS_DECLARE_UTILITY() \
     MTS_DECLARE_CLASS()
 
+#if defined(MTS_STATIC_PLUGINS)
+#define MTS_EXPORT_UTILITY(name, descr) \
+    MTS_IMPLEMENT_CLASS(name, false, Utility) \
+    namespace { \
+        void *CreateUtility_##name() { \
+            return new name(); \
+        } \
+        StaticPlugin StaticPlugin_##name(__FILE__, descr, \
+            NULL, &CreateUtility_##name); \
+    }
+#else
 #define MTS_EXPORT_UTILITY(name, descr) \
     MTS_IMPLEMENT_CLASS(name, false, Utility) \
     extern "C" { \
@@ -69,6 +80,7 @@ protected:
             return descr; \
         } \
     }
+#endif
 
 MTS_NAMESPACE_END
 
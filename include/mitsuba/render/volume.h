@@ -22,9 +22,15 @@
 
 #include <mitsuba/core/cobject.h>
 #include <mitsuba/core/aabb.h>
+#include <mitsuba/core/statistics.h>
 
 MTS_NAMESPACE_BEGIN
 
+namespace stats {
+    /// Heap memory used by volume data sources (memory-mapped grids are not included)
+    extern MTS_EXPORT_RENDER MemoryCounter volumeMemory;
+};
+
 /**
  * \brief Generalized source of volumetric information
  * \ingroup librender
@@ -87,7 +87,7 @@ struct SphericalCoordinates {
     }
 };
 
-Vector toSphere(const SphericalCoordinates coords) {
+inline Vector toSphere(const SphericalCoordinates coords) {
     Float sinTheta, cosTheta, sinPhi, cosPhi;
 
     math::sincos(coords.elevation, &sinTheta, &cosTheta);
@@ -96,7 +96,7 @@ Vector toSphere(const SphericalCoordinates coords) {
     return Vector(sinPhi*sinTheta, cosTheta, -cosPhi*sinTheta);
 }
 
-SphericalCoordinates fromSphere(const Vector &d) {
+inline SphericalCoordinates fromSphere(const Vector &d) {
     Float azimuth = std::atan2(d.x, -d.z);
     Float elevation = math::safe_acos(d.y);
     if (azimuth < 0)
@@ -112,7 +112,7 @@ SphericalCoordinates fromSphere(const Vector &d) {
  * Diego C. Alarcon-Padilla, Teodoro Lopez-Moratalla, and Martin Lara-Coira,
  * in "Solar energy", vol 27, number 5, 2001 by Pergamon Press.
  */
-SphericalCoordinates computeSunCoordinates(const DateTimeRecord &dateTime, const LocationRecord &location) {
+inline SphericalCoordinates computeSunCoordinates(const DateTimeRecord &dateTime, const LocationRecord &location) {
     // Main variables
     double elapsedJulianDays, decHours;
     double eclipticLongitude, eclipticObliquity;
@@ -203,11 +203,11 @@ SphericalCoordinates computeSunCoordinates(const DateTimeRecord &dateTime, const
     return SphericalCoordinates((Float) elevation, (Float) azimuth);
 }
 
-SphericalCoordinates computeSunCoordinates(const Vector& sunDir, const Transform &worldToLuminaire) {
+inline SphericalCoordinates computeSunCoordinates(const Vector& sunDir, const Transform &worldToLuminaire) {
     return fromSphere(normalize(worldToLuminaire(sunDir)));
 }
 
-SphericalCoordinates computeSunCoordinates(const Properties &props) {
+inline SphericalCoordinates computeSunCoordinates(const Properties &props) {
     /* configure position of sun */
     if (props.hasProperty("sunDirection")) {
         if (props.hasProperty("latitude") || props.hasProperty("longitude")
@@ -249,7 +249,7 @@ SphericalCoordinates computeSunCoordinates(const Properties &props) {
 /* All data lifted from MI. Units are either [] or cm^-1. refer when in doubt MI */
 
 // k_o Spectrum table from pg 127, MI.
-Float k_oWavelengths[64] = {
+const Float k_oWavelengths[64] = {
     300, 305, 310, 315, 320, 325, 330, 335, 340, 345,
     350, 355, 445, 450, 455, 460, 465, 470, 475, 480,
     485, 490, 495, 500, 505, 510, 515, 520, 525, 530,
@@ -259,7 +259,7 @@ Float k_oWavelengths[64] = {
     760, 770, 780, 790
 };
 
-Float k_oAmplitudes[65] = {
+const Float k_oAmplitudes[65] = {
     10.0, 4.8, 2.7, 1.35, .8, .380, .160, .075, .04, .019, .007,
     .0, .003, .003, .004, .006, .008, .009, .012, .014, .017,
     .021, .025, .03, .035, .04, .045, .048, .057, .063, .07,
@@ -270,22 +270,22 @@ Float k_oAmplitudes[65] = {
 };
 
 // k_g Spectrum table from pg 130, MI.
-Float k_gWavelengths[4] = {
+const Float k_gWavelengths[4] = {
     759, 760, 770, 771
 };
 
-Float k_gAmplitudes[4] = {
+const Float k_gAmplitudes[4] = {
     0, 3.0, 0.210, 0
 };
 
 // k_wa Spectrum table from pg 130, MI.
-Float k_waWavelengths[13] = {
+const Float k_waWavelengths[13] = {
     689, 690, 700, 710, 720,
     730, 740, 750, 760, 770,
     780, 790, 800
 };
 
-Float k_waAmplitudes[13] = {
+const Float k_waAmplitudes[13] = {
     0, 0.160e-1, 0.240e-1, 0.125e-1,
     0.100e+1, 0.870, 0.610e-1, 0.100e-2,
     0.100e-4, 0.100e-4, 0.600e-3,
@@ -293,7 +293,7 @@ Float k_waAmplitudes[13] = {
 };
 
 /* Wavelengths corresponding to the table below */
-Float solWavelengths[38] = {
+const Float solWavelengths[38] = {
     380, 390, 400, 410, 420, 430, 440, 450,
     460, 470, 480, 490, 500, 510, 520, 530,
     540, 550, 560, 570, 580, 590, 600, 610,
@@ -302,7 +302,7 @@ Float solWavelengths[38] = {
 };
 
 /* Solar amplitude in watts / (m^2 * nm * sr) */
-Float solAmplitudes[38] = {
+const Float solAmplitudes[38] = {
     16559.0, 16233.7, 21127.5, 25888.2, 25829.1,
     24232.3, 26760.5, 29658.3, 30545.4, 30057.5,
     30663.7, 28830.4, 28712.1, 27825.0, 27100.6,
@@ -313,7 +313,7 @@ Float solAmplitudes[38] = {
     19072.4, 18628.9, 18259.2
 };
 
-Spectrum computeSunRadiance(Float theta, Float turbidity) {
+inline Spectrum computeSunRadiance(Float theta, Float turbidity) {
     InterpolatedSpectrum k_oCurve(k_oWavelengths, k_oAmplitudes, 64);
     InterpolatedSpectrum k_gCurve(k_gWavelengths, k_gAmplitudes, 4);
     InterpolatedSpectrum k_waCurve(k_waWavelengths, k_waAmplitudes, 13);
@@ -29,7 +29,7 @@ MTS_NAMESPACE_BEGIN
  * This function implements a parser for the 'label[]' and 'metadata[]'
  * annotations supported by the ldrfilm and hdrfilm plugins
  */
-void annotate(const Scene *scene, const Properties &properties,
+inline void annotate(const Scene *scene, const Properties &properties,
         Bitmap *bitmap, Float renderTime, Float gamma) {
     /* Attach the custom annotations */
     Properties &metadata = bitmap->getMetadata();
@@ -493,6 +493,9 @@ public:
                     m_componentFormat, m_channelNames);
         }
 
+        /* Only re-rendered regions replace the pixels of a base image */
+        bitmap = compositeRegions(bitmap);
+
         if (m_banner && m_cropSize.x > bannerWidth+5 && m_cropSize.y > bannerHeight + 5 && m_pixelFormats.size() == 1) {
             int xoffs = m_cropSize.x - bannerWidth - 5,
                 yoffs = m_cropSize.y - bannerHeight - 5;
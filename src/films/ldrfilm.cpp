@@ -19,6 +19,7 @@
 #include <mitsuba/render/film.h>
 #include <mitsuba/core/fstream.h>
 #include <mitsuba/core/bitmap.h>
+#include <mitsuba/core/simdtonemap.h>
 #include <mitsuba/core/statistics.h>
 #include <boost/algorithm/string.hpp>
 #include "banner.h"
@@ -304,21 +305,34 @@ public:
         Log(EDebug, "Developing film ..");
 
         ref<Bitmap> bitmap = m_storage->getBitmap();
-        Float multiplier = 1.0f;
 
-        if (m_tonemapMethod == EReinhard) {
-            bitmap = bitmap->convert(m_pixelFormat, Bitmap::EFloat);
-
-            Float logAvgLuminance = 0, maxLuminance = 0; /* Unused */
-            bitmap->tonemapReinhard(logAvgLuminance, maxLuminance,
-                m_reinhardKey, m_reinhardBurn);
-            Log(EInfo, "Tonemapping finished (log-avg luminance=%f, max luminance=%f)",
-                logAvgLuminance, maxLuminance);
+        if (m_pixelFormat == Bitmap::ERGB || m_pixelFormat == Bitmap::ERGBA) {
+            /* Use the parallel SIMD tone mapper for color images */
+            Float logAvgLuminance = 0, maxLuminance = 0;
+            bool reinhard = m_tonemapMethod == EReinhard;
+            bitmap = TonemapCPU::develop(bitmap, m_pixelFormat, m_gamma,
+                std::pow((Float) 2, (Float) m_exposure), reinhard ? m_reinhardKey : -1,
+                m_reinhardBurn, logAvgLuminance, maxLuminance);
+            if (reinhard)
+                Log(EInfo, "Tonemapping finished (log-avg luminance=%f, max luminance=%f)",
+                    logAvgLuminance, maxLuminance);
         } else {
-            multiplier = std::pow((Float) 2, (Float) m_exposure);
-        }
+            Float multiplier = 1.0f;
+
+            if (m_tonemapMethod == EReinhard) {
+                bitmap = bitmap->convert(m_pixelFormat, Bitmap::EFloat);
+
+                Float logAvgLuminance = 0, maxLuminance = 0; /* Unused */
+                bitmap->tonemapReinhard(logAvgLuminance, maxLuminance,
+                    m_reinhardKey, m_reinhardBurn);
+                Log(EInfo, "Tonemapping finished (log-avg luminance=%f, max luminance=%f)",
+                    logAvgLuminance, maxLuminance);
+            } else {
+                multiplier = std::pow((Float) 2, (Float) m_exposure);
+            }
 
-        bitmap = bitmap->convert(m_pixelFormat, Bitmap::EUInt8, m_gamma, multiplier);
+            bitmap = bitmap->convert(m_pixelFormat, Bitmap::EUInt8, m_gamma, multiplier);
+        }
 
         if (m_hasBanner && m_cropSize.x > bannerWidth+5 && m_cropSize.y > bannerHeight + 5) {
             int xoffs = m_cropSize.x - bannerWidth - 5,
@@ -267,6 +267,7 @@ public:
         for (size_t i=0; i<m_channelNames.size(); ++i)
             channels.insert(m_channelNames[i].c_str(), Imf::Channel(compType));
 
+        Bitmap::initializeOpenEXRThreads();
         m_output = new Imf::TiledOutputFile(filename.string().c_str(), header);
         m_frameBuffer = new Imf::FrameBuffer();
         m_blockSize = (int) blockSize;
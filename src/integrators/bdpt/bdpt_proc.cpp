@@ -78,6 +78,10 @@ public:
             enableFPExceptions();
         #endif
 
+        /* The vertices and edges of each sample are taken from the thread's
+           memory arena and reclaimed at once when the sample is done */
+        MemoryArena *arena = MemoryArena::getThreadArena();
+        MemoryPool pool(arena);
         Path emitterSubpath;
         Path sensorSubpath;
 
@@ -105,19 +109,21 @@ public:
                 if (needsTimeSample)
                     time = m_sensor->sampleTime(m_sampler->next1D());
 
+                MemoryArena::Scope scope(arena);
+
                 /* Start new emitter and sensor subpaths */
-                emitterSubpath.initialize(m_scene, time, EImportance, m_pool);
-                sensorSubpath.initialize(m_scene, time, ERadiance, m_pool);
+                emitterSubpath.initialize(m_scene, time, EImportance, pool);
+                sensorSubpath.initialize(m_scene, time, ERadiance, pool);
 
                 /* Perform a random walk using alternating steps on each path */
                 Path::alternatingRandomWalkFromPixel(m_scene, m_sampler,
                     emitterSubpath, emitterDepth, sensorSubpath,
-                    sensorDepth, offset, m_config.rrDepth, m_pool);
+                    sensorDepth, offset, m_config.rrDepth, pool);
 
                 evaluate(result, emitterSubpath, sensorSubpath);
 
-                emitterSubpath.release(m_pool);
-                sensorSubpath.release(m_pool);
+                emitterSubpath.release(pool);
+                sensorSubpath.release(pool);
 
                 m_sampler->advance();
             }
@@ -126,9 +132,6 @@ public:
         #if defined(MTS_DEBUG_FP)
             disableFPExceptions();
         #endif
-
-        /* Make sure that there were no memory leaks */
-        Assert(m_pool.unused());
     }
 
     /// Evaluate the contributions of the given eye and light paths
@@ -323,7 +326,6 @@ private:
     ref<Sensor> m_sensor;
     ref<Sampler> m_sampler;
     ref<ReconstructionFilter> m_rfilter;
-    MemoryPool m_pool;
     BDPTConfiguration m_config;
     HilbertCurve2D<uint8_t> m_hilbertCurve;
 };
@@ -20,6 +20,7 @@
 #include <mitsuba/render/renderproc.h>
 #include <mitsuba/core/autodiff.h>
 #include <mitsuba/core/statistics.h>
+#include <mitsuba/core/arena.h>
 #include <boost/algorithm/string.hpp>
 
 DECLARE_DIFFSCALAR_BASE();
@@ -136,6 +137,7 @@ public:
     typedef Eigen::Matrix<Float, 1, 7> Gradient;
     typedef DScalar1<Float, Gradient> DScalar;
     typedef DScalar::DVector3 DVector;
+    typedef std::vector<Intersection, ArenaAllocator<Intersection> > IntersectionVector;
 
     MotionIntegrator(const Properties &props) : SamplingIntegrator(props) {
         m_time = props.getFloat("time");
@@ -201,7 +203,9 @@ public:
                 p1 = its2.p;
             }
         } else {
-            std::vector<Intersection> source, target, temp, temp2;
+            /* Intersection records of this sample live in the thread's memory arena */
+            MemoryArena::Scope scope;
+            IntersectionVector source, target, temp, temp2;
             Ray ray(r);
 
             /* Trace an initial light path with the given configuration*/
@@ -270,7 +274,7 @@ public:
         return result;
     }
 
-    bool timeStep(RadianceQueryRecord &rRec, std::vector<Intersection> &source, const std::vector<Intersection> &target, std::vector<Intersection> &temp, std::vector<Intersection> &temp2) const {
+    bool timeStep(RadianceQueryRecord &rRec, IntersectionVector &source, const IntersectionVector &target, IntersectionVector &temp, IntersectionVector &temp2) const {
         Ray ray = extrapolateTimeRay(source, target);
 
         if (!tracePath(rRec, ray, temp))
@@ -308,7 +312,7 @@ public:
         return true;
     }
 
-    bool tracePath(RadianceQueryRecord &rRec, Ray ray, std::vector<Intersection> &intersections) const {
+    bool tracePath(RadianceQueryRecord &rRec, Ray ray, IntersectionVector &intersections) const {
         int depth = 0;
 
         Intersection its;
@@ -390,7 +394,7 @@ public:
         return true;
     }
 
-    void adjustTime(const RadianceQueryRecord &rRec, const Point2 &apertureSample, const std::vector<Intersection> &source, std::vector<Intersection> &target, Float timeStepSize) const {
+    void adjustTime(const RadianceQueryRecord &rRec, const Point2 &apertureSample, const IntersectionVector &source, IntersectionVector &target, Float timeStepSize) const {
         target = source;
 
         Float targetTime = (1-timeStepSize) * source[0].time + timeStepSize * m_time;
@@ -409,7 +413,7 @@ public:
             target[i].adjustTime(targetTime);
     }
 
-    DVector getVertexPosition(const std::vector<Intersection> &source, const std::vector<Intersection> &target, int i, int rel) const {
+    DVector getVertexPosition(const IntersectionVector &source, const IntersectionVector &target, int i, int rel) const {
         DScalar u(rel*2, 0), v(rel*2+1, 0), time(6, 0);
 
         return DScalar::vector(source[i].p)
@@ -418,7 +422,7 @@ public:
              + DScalar::vector(target[i].p-source[i].p) * time;
     }
 
-    void getVertexFrame(const std::vector<Intersection> &source, const std::vector<Intersection> &target, int i, DVector &s, DVector &t, DVector &n) const {
+    void getVertexFrame(const IntersectionVector &source, const IntersectionVector &target, int i, DVector &s, DVector &t, DVector &n) const {
         DScalar u(2, 0), v(3, 0), time(6, 0);
         const BSDF *bsdf = source[i].shape->getBSDF();
 
@@ -454,7 +458,7 @@ public:
         t = (1-time)*t0 + time*t1;
     }
 
-    void assembleMatrix(const std::vector<Intersection> &source, const std::vector<Intersection> &target, EMatrix &M) const {
+    void assembleMatrix(const IntersectionVector &source, const IntersectionVector &target, EMatrix &M) const {
         DScalar::setVariableCount(7);
         M.resize(2*(source.size()-2), 2*source.size()+1);
         M.setZero();
@@ -491,14 +495,14 @@ public:
         }
     }
 
-    Point extrapolateTimePoint(const std::vector<Intersection> &source, const std::vector<Intersection> &target) const {
+    Point extrapolateTimePoint(const IntersectionVector &source, const IntersectionVector &target) const {
         EMatrix M;
         assembleMatrix(source, target, M);
         EVector b = -M.block(0, 2, (source.size()-2)*2, (source.size()-2)*2).lu().solve(M.col(M.cols()-1));
         return target[1].p + target[1].dpdu * b[0] + target[1].dpdv * b[1];
     }
 
-    Ray extrapolateTimeRay(const std::vector<Intersection> &source, const std::vector<Intersection> &target) const {
+    Ray extrapolateTimeRay(const IntersectionVector &source, const IntersectionVector &target) const {
         EMatrix M;
         assembleMatrix(source, target, M);
 
@@ -508,13 +512,13 @@ public:
         return Ray(rayOrigin, normalize(rayTarget-rayOrigin), target[1].time);
     }
 
-    Float computeError(const std::vector<Intersection> &source, const std::vector<Intersection> &target) const {
+    Float computeError(const IntersectionVector &source, const IntersectionVector &target) const {
         int last = source.size()-1;
         Float scale = std::max(Epsilon,std::max(std::abs(target[last].p.x), std::max(std::abs(target[last].p.y), std::abs(target[last].p.z))));
         return (target[last].p-source[last].p).length() / scale;
     }
 
-    Ray extrapolateSpaceRay(const std::vector<Intersection> &source, const std::vector<Intersection> &target, Float stepSize) const {
+    Ray extrapolateSpaceRay(const IntersectionVector &source, const IntersectionVector &target, Float stepSize) const {
         EMatrix M;
         assembleMatrix(source, target, M);
 
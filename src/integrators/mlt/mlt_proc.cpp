@@ -425,6 +425,5 @@ void MLTProcess::bindResource(const std::string &name, int id) {
 
 MTS_IMPLEMENT_CLASS_S(MLTRenderer, false, WorkProcessor)
 MTS_IMPLEMENT_CLASS(MLTProcess, false, ParallelProcess)
-MTS_IMPLEMENT_CLASS(SeedWorkUnit, false, WorkUnit)
 
 MTS_NAMESPACE_END
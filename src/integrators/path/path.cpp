@@ -44,6 +44,10 @@ static StatsCounter avgPathLength("Path tracer", "Average path length", EAverage
  *        See page~\pageref{sec:hideemitters} for details.
  *        \default{no, i.e. \code{false}}
  *     }
+ *     \parameter{rayCones}{\Boolean}{Prefilter texture lookups after the
+ *        first bounce using a ray cone footprint? See the description below
+ *        for details. \default{no, i.e. \code{false}}
+ *     }
  * }
  *
  * This integrator implements a basic path tracer and is a \emph{good default choice}
@@ -100,6 +104,17 @@ static StatsCounter avgPathLength("Path tracer", "Average path length", EAverage
  * implicitly have \code{strictNormals} set to \code{true}. Hence, another use of this parameter
  * is to match renderings created by these methods.
  *
+ * \paragraph{Ray cones:}
+ * Ray differentials are only available for rays leaving the sensor, hence textures
+ * seen after the first bounce are normally looked up at their full resolution.
+ * When \code{rayCones} is set to \code{true}, the path tracer instead tracks a
+ * cone around each path, whose width grows with the traveled distance and whose
+ * spread angle increases at every diffuse or glossy bounce (by an amount inversely
+ * proportional to the square root of the sampling density). The resulting footprint
+ * directly selects a MIP map level for texture lookups, which reduces both the
+ * filtering cost and the memory bandwidth. Since indirectly seen textures are
+ * blurred slightly more than necessary, this is an approximation and disabled by default.
+ *
  * \remarks{
  *    \item This integrator does not handle participating media
  *    \item This integrator has poor convergence properties when rendering
@@ -110,17 +125,22 @@ static StatsCounter avgPathLength("Path tracer", "Average path length", EAverage
 class MIPathTracer : public MonteCarloIntegrator {
 public:
     MIPathTracer(const Properties &props)
-        : MonteCarloIntegrator(props) { }
+        : MonteCarloIntegrator(props) {
+        m_rayCones = props.getBoolean("rayCones", false);
+    }
 
     /// Unserialize from a binary data stream
     MIPathTracer(Stream *stream, InstanceManager *manager)
-        : MonteCarloIntegrator(stream, manager) { }
+        : MonteCarloIntegrator(stream, manager) {
+        m_rayCones = stream->readBool();
+    }
 
     Spectrum Li(const RayDifferential &r, RadianceQueryRecord &rRec) const {
         /* Some aliases and local variables */
         const Scene *scene = rRec.scene;
         Intersection &its = rRec.its;
         RayDifferential ray(r);
+        RayCone cone(r);
         Spectrum Li(0.0f);
         bool scattered = false;
 
@@ -144,6 +164,10 @@ public:
 
             const BSDF *bsdf = its.getBSDF(ray);
 
+            /* Without ray differentials, fall back to the ray cone footprint */
+            if (m_rayCones && !its.hasUVPartials && bsdf->usesRayDifferentials())
+                its.computeFootprint(cone);
+
             /* Possibly include emitted radiance if requested */
             if (its.isEmitter() && (rRec.type & RadianceQueryRecord::EEmittedRadiance)
                 && (!m_hideEmitters || scattered))
@@ -221,6 +245,11 @@ public:
             bool hitEmitter = false;
             Spectrum value;
 
+            /* Widen the ray cone unless the path continues along a delta lobe */
+            if (m_rayCones)
+                cone.propagate(its.t, (bRec.sampledType & BSDF::EDelta) ? 0.0f
+                    : std::min(1 / std::sqrt(bsdfPdf), (Float) M_PI));
+
             /* Trace a ray in this direction */
             ray = Ray(its.p, wo, ray.time);
             if (scene->rayIntersect(ray, its)) {
@@ -301,6 +330,7 @@ public:
 
     void serialize(Stream *stream, InstanceManager *manager) const {
         MonteCarloIntegrator::serialize(stream, manager);
+        stream->writeBool(m_rayCones);
     }
 
     std::string toString() const {
@@ -308,12 +338,15 @@ public:
         oss << "MIPathTracer[" << endl
             << "  maxDepth = " << m_maxDepth << "," << endl
             << "  rrDepth = " << m_rrDepth << "," << endl
-            << "  strictNormals = " << m_strictNormals << endl
+            << "  strictNormals = " << m_strictNormals << "," << endl
+            << "  rayCones = " << m_rayCones << endl
             << "]";
         return oss.str();
     }
 
     MTS_DECLARE_CLASS()
+private:
+    bool m_rayCones;
 };
 
 MTS_IMPLEMENT_CLASS_S(MIPathTracer, false, MonteCarloIntegrator)
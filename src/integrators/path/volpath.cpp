@@ -45,6 +45,15 @@ static StatsCounter avgPathLength("Volumetric path tracer", "Average path length
  *        See page~\pageref{sec:hideemitters} for details.
  *        \default{no, i.e. \code{false}}
  *     }
+ *     \parameter{equiangular}{\Boolean}{Additionally sample single scattering
+ *        from point and spot lights inside homogeneous media using equi-angular
+ *        sampling? See below for details.
+ *        \default{no, i.e. \code{false}}
+ *     }
+ *     \parameter{equiangularSamples}{\Integer}{Number of equi-angular samples
+ *        that are placed on each ray segment inside a homogeneous medium
+ *        \default{\code{1}}
+ *     }
  * }
  *
  * This plugin provides a volumetric path tracer that can be used to
@@ -64,6 +73,17 @@ static StatsCounter avgPathLength("Volumetric path tracer", "Average path length
  * index-matched boundaries that involve some amount of interaction.} BSDF assigned
  * to it (as compared to, say, a \pluginref{dielectric} or \pluginref{roughdielectric} BSDF).
  *
+ * \paragraph{Equi-angular sampling:}
+ * Distance sampling places scattering events according to the transmittance
+ * along a ray, which is a poor match for media lit by point or spot lights
+ * (e.g. haze around a street lamp), since most of the single scattered light
+ * originates close to the emitter. When \code{equiangular} is set to \code{true},
+ * the integrator additionally places points on every ray segment passing through a
+ * homogeneous medium with a density that is proportional to the inverse
+ * squared distance to a randomly chosen point or spot light \cite{Kulla2012Importance},
+ * and combines both strategies using multiple importance sampling. The
+ * transmittance along the shadow rays of these points is evaluated in batches.
+ *
  * \remarks{
  *    \item This integrator will generally perform poorly when rendering
  *      participating media that have a different index of refraction compared
@@ -75,11 +95,20 @@ static StatsCounter avgPathLength("Volumetric path tracer", "Average path length
  */
 class VolumetricPathTracer : public MonteCarloIntegrator {
 public:
-    VolumetricPathTracer(const Properties &props) : MonteCarloIntegrator(props) { }
+    VolumetricPathTracer(const Properties &props) : MonteCarloIntegrator(props) {
+        m_equiangular = props.getBoolean("equiangular", false);
+        m_equiangularSamples = props.getInteger("equiangularSamples", 1);
+
+        if (m_equiangularSamples <= 0)
+            Log(EError, "'equiangularSamples' must be positive!");
+    }
 
     /// Unserialize from a binary data stream
     VolumetricPathTracer(Stream *stream, InstanceManager *manager)
-     : MonteCarloIntegrator(stream, manager) { }
+     : MonteCarloIntegrator(stream, manager) {
+        m_equiangular = stream->readBool();
+        m_equiangularSamples = stream->readInt();
+    }
 
     Spectrum Li(const RayDifferential &r, RadianceQueryRecord &rRec) const {
         /* Some aliases and local variables */
@@ -98,6 +127,14 @@ public:
         bool scattered = false;
 
         while (rRec.depth <= m_maxDepth || m_maxDepth < 0) {
+            /* Place additional single scattering samples near point lights? */
+            bool equiangular = m_equiangular && rRec.medium && rRec.medium->isHomogeneous()
+                && (rRec.type & RadianceQueryRecord::EDirectMediumRadiance)
+                && (rRec.depth < m_maxDepth || m_maxDepth == -1);
+
+            if (equiangular)
+                Li += throughput * sampleEquiangular(scene, rRec, ray, its.t);
+
             /* ==================================================================== */
             /*                 Radiative Transfer Equation sampling                 */
             /* ==================================================================== */
@@ -140,7 +177,15 @@ public:
                                     ? phase->pdf(pRec) : (Float) 0.0f;
 
                             /* Weight using the power heuristic */
-                            const Float weight = miWeight(dRec.pdf, phasePdf);
+                            Float weight = miWeight(dRec.pdf, phasePdf);
+
+                            /* Account for equi-angular sampling of point-like emitters */
+                            if (equiangular && isPointLike(emitter)) {
+                                Float pdfEquiangular = m_equiangularSamples * pdfEquiangularDistance(
+                                    ray, its.t, getPosition(emitter, ray.time), mRec.t);
+                                weight *= miWeight(mRec.pdfSuccess, pdfEquiangular);
+                            }
+
                             Li += throughput * value * phaseVal * weight;
                         }
                     }
@@ -427,6 +472,129 @@ public:
         }
     }
 
+    /**
+     * Estimate single scattering from a point or spot light along the
+     * segment [0, maxt] of 'ray', which lies inside the homogeneous
+     * medium 'rRec.medium'. The emitter is chosen using the same
+     * distribution as in direct illumination sampling, and positions along
+     * the segment are placed with a density proportional to the inverse
+     * squared distance to it [Kulla and Fajardo 2012]. The result
+     * is weighted against distance sampling using the power heuristic
+     * and does not include the path throughput.
+     */
+    Spectrum sampleEquiangular(const Scene *scene, RadianceQueryRecord &rRec,
+            const Ray &ray, Float maxt) const {
+        const Medium *medium = rRec.medium;
+        Float emPdf;
+        size_t index = scene->getEmitterPDF().sample(rRec.nextSample1D(), emPdf);
+        const Emitter *emitter = scene->getEmitters()[index].get();
+
+        if (!isPointLike(emitter))
+            return Spectrum(0.0f);
+
+        /* Parameterize the segment by the angle as seen from the emitter */
+        Point lightPos = getPosition(emitter, ray.time);
+        Float delta = dot(lightPos - ray.o, ray.d),
+              D = distance(ray(delta), lightPos);
+        if (D == 0)
+            return Spectrum(0.0f);
+
+        Float thetaA = std::atan(-delta / D),
+              thetaB = std::atan((maxt - delta) / D);
+        if (!(thetaB > thetaA))
+            return Spectrum(0.0f);
+
+        const size_t count = (size_t) m_equiangularSamples;
+        Ray *shadowRays = (Ray *) alloca(count * sizeof(Ray));
+        Spectrum *contrib = (Spectrum *) alloca(count * sizeof(Spectrum));
+        Spectrum *transmittance = (Spectrum *) alloca(count * sizeof(Spectrum));
+        size_t *indices = (size_t *) alloca(count * sizeof(size_t));
+        size_t batchSize = 0;
+        int interactions = m_maxDepth - rRec.depth - 1;
+        Spectrum result(0.0f);
+
+        for (size_t i=0; i<count; ++i) {
+            Float theta = thetaA + (thetaB - thetaA) * rRec.nextSample1D(),
+                  t = delta + D * std::tan(theta),
+                  pdf = D / ((thetaB - thetaA) * (D*D + (t-delta)*(t-delta)));
+
+            if (!(t > 0 && t < maxt))
+                continue;
+
+            /* Transmittance and distance sampling density up to the sampled point */
+            MediumSamplingRecord mRec;
+            medium->eval(Ray(ray, 0, t), mRec);
+            mRec.t = t;
+            mRec.p = ray(t);
+            mRec.orientation = Vector(0.0f);
+
+            DirectSamplingRecord dRec(mRec.p, ray.time);
+            Spectrum value = emitter->sampleDirect(dRec, Point2(0.5f));
+            if (dRec.pdf == 0 || value.isZero())
+                continue;
+
+            PhaseFunctionSamplingRecord pRec(mRec, -ray.d, dRec.d);
+            Float phaseVal = mRec.getPhaseFunction()->eval(pRec);
+            if (phaseVal == 0)
+                continue;
+
+            Float weight = miWeight(count * pdf, mRec.pdfSuccess);
+            contrib[i] = value * mRec.sigmaS * mRec.transmittance
+                * (phaseVal * weight / (pdf * emPdf * count));
+
+            Ray shadowRay(mRec.p, dRec.d, 0, dRec.dist * (1-ShadowEpsilon), ray.time);
+            if (!scene->rayIntersect(shadowRay)) {
+                /* Unoccluded: only the medium attenuates -- defer to the batch below */
+                shadowRays[batchSize] = shadowRay;
+                indices[batchSize++] = i;
+            } else {
+                /* Handle occluders and index-matched boundaries */
+                int remaining = interactions;
+                result += contrib[i] * scene->evalTransmittance(mRec.p, false,
+                    dRec.p, false, ray.time, medium, remaining, rRec.sampler);
+            }
+        }
+
+        if (batchSize > 0) {
+            medium->evalTransmittanceBatch(shadowRays, batchSize,
+                transmittance, rRec.sampler);
+            for (size_t i=0; i<batchSize; ++i)
+                result += contrib[indices[i]] * transmittance[i];
+        }
+
+        return result;
+    }
+
+    /**
+     * Density of choosing position 't' of the segment [0, maxt] of 'ray'
+     * using equi-angular sampling with respect to a light at 'lightPos'
+     */
+    inline Float pdfEquiangularDistance(const Ray &ray, Float maxt,
+            const Point &lightPos, Float t) const {
+        Float delta = dot(lightPos - ray.o, ray.d),
+              D = distance(ray(delta), lightPos);
+        if (D == 0)
+            return 0.0f;
+
+        Float thetaA = std::atan(-delta / D),
+              thetaB = std::atan((maxt - delta) / D);
+        if (!(thetaB > thetaA))
+            return 0.0f;
+
+        return D / ((thetaB - thetaA) * (D*D + (t-delta)*(t-delta)));
+    }
+
+    /// Can an emitter be handled by equi-angular sampling? (i.e. point and spot lights)
+    inline bool isPointLike(const Emitter *emitter) const {
+        return (emitter->getType() & (Emitter::EDeltaPosition | Emitter::EDeltaDirection))
+            == Emitter::EDeltaPosition;
+    }
+
+    /// Return the position of a point-like emitter
+    inline Point getPosition(const Emitter *emitter, Float time) const {
+        return emitter->getWorldTransform()->eval(time).transformAffine(Point(0.0f));
+    }
+
     inline Float miWeight(Float pdfA, Float pdfB) const {
         pdfA *= pdfA; pdfB *= pdfB;
         return pdfA / (pdfA + pdfB);
@@ -434,6 +602,8 @@ public:
 
     void serialize(Stream *stream, InstanceManager *manager) const {
         MonteCarloIntegrator::serialize(stream, manager);
+        stream->writeBool(m_equiangular);
+        stream->writeInt(m_equiangularSamples);
     }
 
     std::string toString() const {
@@ -441,12 +611,17 @@ public:
         oss << "VolumetricPathTracer[" << endl
             << "  maxDepth = " << m_maxDepth << "," << endl
             << "  rrDepth = " << m_rrDepth << "," << endl
-            << "  strictNormals = " << m_strictNormals << endl
+            << "  strictNormals = " << m_strictNormals << "," << endl
+            << "  equiangular = " << m_equiangular << "," << endl
+            << "  equiangularSamples = " << m_equiangularSamples << endl
             << "]";
         return oss.str();
     }
 
     MTS_DECLARE_CLASS()
+private:
+    bool m_equiangular;
+    int m_equiangularSamples;
 };
 
 MTS_IMPLEMENT_CLASS_S(VolumetricPathTracer, false, MonteCarloIntegrator)
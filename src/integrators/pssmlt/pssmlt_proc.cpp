@@ -353,6 +353,5 @@ void PSSMLTProcess::bindResource(const std::string &name, int id) {
 
 MTS_IMPLEMENT_CLASS_S(PSSMLTRenderer, false, WorkProcessor)
 MTS_IMPLEMENT_CLASS(PSSMLTProcess, false, ParallelProcess)
-MTS_IMPLEMENT_CLASS(SeedWorkUnit, false, WorkUnit)
 
 MTS_NAMESPACE_END
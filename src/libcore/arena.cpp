@@ -0,0 +1,150 @@
+/*
+    This file is part of Mitsuba, a physically based rendering system.
+
+    Copyright (c) 2007-2014 by Wenzel Jakob and others.
+
+    Mitsuba is free software; you can redistribute it and/or modify
+    it under the terms of the GNU General Public License Version 3
+    as published by the Free Software Foundation.
+
+    Mitsuba is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program. If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include <mitsuba/core/arena.h>
+#include <mitsuba/core/statistics.h>
+#include <mitsuba/core/tls.h>
+
+MTS_NAMESPACE_BEGIN
+
+static StatsCounter statsArenaAllocs("Memory arena",
+        "Arena allocations per work unit", EAverage);
+static StatsCounter statsArenaBlocks("Memory arena",
+        "Heap allocations (arena blocks)", ENumberValue);
+static StatsCounter statsArenaPeak("Memory arena",
+        "Peak usage per work unit", EMaximumValue);
+static StatsCounter statsArenaHeapAllocs("Memory arena",
+        "Heap allocations per sample", EAverage);
+
+static PrimitiveThreadLocal<MemoryArena> __arena_tls;
+
+MemoryArena::MemoryArena(size_t blockSize)
+    : m_current(NULL), m_block(0), m_offset(0), m_blockSize(0),
+      m_defaultBlockSize(blockSize), m_peakUsage(0), m_allocCount(0),
+      m_heapAllocCount(0), m_scopeCount(0) {
+}
+
+MemoryArena::~MemoryArena() {
+    clear();
+}
+
+void *MemoryArena::allocSlow(size_t size) {
+    size_t next = m_current ? m_block + 1 : 0;
+
+    /* Look for a previously allocated (and currently unused) block that
+       is large enough. All blocks after the current one are unused. */
+    size_t idx = next;
+    while (idx < m_blocks.size() && m_blocks[idx].size < size)
+        ++idx;
+
+    if (idx < m_blocks.size()) {
+        std::swap(m_blocks[idx], m_blocks[next]);
+    } else {
+        Block block;
+        block.size = std::max(size, m_defaultBlockSize);
+        block.ptr = static_cast<uint8_t *>(allocAligned(block.size));
+        m_blocks.insert(m_blocks.begin() + next, block);
+        ++statsArenaBlocks;
+        ++m_heapAllocCount;
+    }
+
+    m_block = next;
+    m_current = m_blocks[next].ptr;
+    m_blockSize = m_blocks[next].size;
+    m_offset = size;
+    return m_current;
+}
+
+void MemoryArena::reset() {
+    size_t used = getUsedBytes();
+    if (used > m_peakUsage)
+        m_peakUsage = used;
+
+    if (m_allocCount > 0) {
+        statsArenaAllocs += m_allocCount;
+        statsArenaAllocs.incrementBase();
+        statsArenaPeak.recordMaximum(used);
+        m_allocCount = 0;
+    }
+
+    if (m_scopeCount > 0) {
+        statsArenaHeapAllocs += m_heapAllocCount;
+        statsArenaHeapAllocs.incrementBase(m_scopeCount);
+    }
+    m_heapAllocCount = m_scopeCount = 0;
+
+    if (!m_blocks.empty()) {
+        m_block = 0;
+        m_current = m_blocks[0].ptr;
+        m_blockSize = m_blocks[0].size;
+    }
+    m_offset = 0;
+}
+
+void MemoryArena::clear() {
+    for (size_t i=0; i<m_blocks.size(); ++i)
+        freeAligned(m_blocks[i].ptr);
+    m_blocks.clear();
+    m_current = NULL;
+    m_block = m_offset = m_blockSize = 0;
+    m_allocCount = m_heapAllocCount = m_scopeCount = 0;
+}
+
+size_t MemoryArena::getUsedBytes() const {
+    if (!m_current)
+        return 0;
+    size_t result = m_offset;
+    for (size_t i=0; i<m_block; ++i)
+        result += m_blocks[i].size;
+    return result;
+}
+
+size_t MemoryArena::getCapacity() const {
+    size_t result = 0;
+    for (size_t i=0; i<m_blocks.size(); ++i)
+        result += m_blocks[i].size;
+    return result;
+}
+
+MemoryArena *MemoryArena::getThreadArena() {
+    return &__arena_tls.get();
+}
+
+void MemoryArena::recordHeapAllocation() {
+    MemoryArena *arena;
+    try {
+        arena = &__arena_tls.get();
+    } catch (...) {
+        /* Unregistered thread without thread-local storage */
+        return;
+    }
+    ++arena->m_heapAllocCount;
+}
+
+std::string MemoryArena::toString() const {
+    std::ostringstream oss;
+    oss << "MemoryArena[" << endl
+        << "  blocks = " << m_blocks.size() << "," << endl
+        << "  used = " << memString(getUsedBytes()) << "," << endl
+        << "  capacity = " << memString(getCapacity()) << "," << endl
+        << "  peakUsage = " << memString(m_peakUsage) << endl
+        << "]";
+    return oss.str();
+}
+
+MTS_NAMESPACE_END
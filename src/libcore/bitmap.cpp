@@ -23,6 +23,7 @@
 #include <boost/algorithm/string.hpp>
 #include <boost/scoped_array.hpp>
 #include <boost/thread/mutex.hpp>
+#include <boost/thread/once.hpp>
 #include <set>
 
 #if defined(__WINDOWS__)
@@ -84,10 +85,18 @@ template <> inline half safe_cast(double a) {
  *     EXR helper classes     *
  * ========================== */
 
+static boost::once_flag __openexr_once = BOOST_ONCE_INIT;
+
+static void createOpenEXRThreadPool() {
+    /* Use multiple threads to read/write OpenEXR files */
+    Imf::setGlobalThreadCount(getCoreCount());
+}
+
 class EXRIStream : public Imf::IStream {
 public:
     EXRIStream(Stream *stream) : IStream(stream->toString().c_str()),
         m_stream(stream) {
+        Bitmap::initializeOpenEXRThreads();
         m_offset = stream->getPos();
         m_size = stream->getSize();
     }
@@ -115,6 +124,7 @@ class EXROStream : public Imf::OStream {
 public:
     EXROStream(Stream *stream) : OStream(stream->toString().c_str()),
         m_stream(stream) {
+        Bitmap::initializeOpenEXRThreads();
     }
 
     void write(const char *c, int n) {
@@ -760,6 +770,7 @@ Spectrum Bitmap::average() const {
 
 #if defined(MTS_HAS_FFTW)
 static boost::mutex __fftw_lock;
+static bool __fftw_threads = false;
 #endif
 
 void Bitmap::convolve(const Bitmap *_kernel) {
@@ -789,6 +800,12 @@ void Bitmap::convolve(const Bitmap *_kernel) {
            paddedSize   = paddedWidth*paddedHeight;
 
     __fftw_lock.lock();
+    if (!__fftw_threads) {
+        /* Initialized on first use, see Bitmap::staticInitialization() */
+        fftw_init_threads();
+        fftw_plan_with_nthreads(getCoreCount());
+        __fftw_threads = true;
+    }
     complex *kernel  = (complex *) fftw_malloc(sizeof(complex) * paddedSize),
             *kernelS = (complex *) fftw_malloc(sizeof(complex) * paddedSize),
             *data    = (complex *) fftw_malloc(sizeof(complex) * paddedSize),
@@ -2777,6 +2794,82 @@ void Bitmap::writeJPEG(Stream *stream, int quality) const {
 #endif
 
 #if defined(MTS_HAS_OPENEXR)
+/// Convert the supported attributes of an OpenEXR header into metadata
+static void readEXRMetadata(const Imf::Header &header, Properties &metadata) {
+    for (Imf::Header::ConstIterator it = header.begin(); it != header.end(); ++it) {
+        std::string name = it.name(), typeName = it.attribute().typeName();
+        const Imf::StringAttribute *sattr;
+        const Imf::IntAttribute *iattr;
+        const Imf::FloatAttribute *fattr;
+        const Imf::DoubleAttribute *dattr;
+        const Imf::V3fAttribute *vattr;
+        const Imf::M44fAttribute *mattr;
+
+        if (typeName == "string" &&
+            (sattr = header.findTypedAttribute<Imf::StringAttribute>(name.c_str())))
+            metadata.setString(name, sattr->value());
+        else if (typeName == "int" &&
+            (iattr = header.findTypedAttribute<Imf::IntAttribute>(name.c_str())))
+            metadata.setInteger(name, iattr->value());
+        else if (typeName == "float" &&
+            (fattr = header.findTypedAttribute<Imf::FloatAttribute>(name.c_str())))
+            metadata.setFloat(name, (Float) fattr->value());
+        else if (typeName == "double" &&
+            (dattr = header.findTypedAttribute<Imf::DoubleAttribute>(name.c_str())))
+            metadata.setFloat(name, (Float) dattr->value());
+        else if (typeName == "v3f" &&
+            (vattr = header.findTypedAttribute<Imf::V3fAttribute>(name.c_str()))) {
+            Imath::V3f vec = vattr->value();
+            metadata.setVector(name, Vector(vec.x, vec.y, vec.z));
+        } else if (typeName == "m44f" &&
+            (mattr = header.findTypedAttribute<Imf::M44fAttribute>(name.c_str()))) {
+            Matrix4x4 M;
+            for (int i=0; i<4; ++i)
+                for (int j=0; j<4; ++j)
+                    M(i, j) = mattr->value().x[i][j];
+            metadata.setTransform(name, Transform(M));
+        }
+    }
+}
+
+/// Store metadata as attributes of an OpenEXR header
+static void writeEXRMetadata(const Properties &metadata, Imf::Header &header) {
+    std::vector<std::string> keys = metadata.getPropertyNames();
+    for (std::vector<std::string>::const_iterator it = keys.begin(); it != keys.end(); ++it) {
+        Properties::EPropertyType type = metadata.getType(*it);
+
+        switch (type) {
+            case Properties::EString:
+                header.insert(it->c_str(), Imf::StringAttribute(metadata.getString(*it)));
+                break;
+            case Properties::EInteger:
+                header.insert(it->c_str(), Imf::IntAttribute(metadata.getInteger(*it)));
+                break;
+            case Properties::EFloat:
+                header.insert(it->c_str(), Imf::FloatAttribute((float) metadata.getFloat(*it)));
+                break;
+            case Properties::EPoint: {
+                    Point val = metadata.getPoint(*it);
+                    header.insert(it->c_str(), Imf::V3fAttribute(
+                        Imath::V3f((float) val.x, (float) val.y, (float) val.z)));
+                }
+                break;
+            case Properties::ETransform: {
+                    Matrix4x4 val = metadata.getTransform(*it).getMatrix();
+                    header.insert(it->c_str(), Imf::M44fAttribute(Imath::M44f(
+                        (float) val(0, 0), (float) val(0, 1), (float) val(0, 2), (float) val(0, 3),
+                        (float) val(1, 0), (float) val(1, 1), (float) val(1, 2), (float) val(1, 3),
+                        (float) val(2, 0), (float) val(2, 1), (float) val(2, 2), (float) val(2, 3),
+                        (float) val(3, 0), (float) val(3, 1), (float) val(3, 2), (float) val(3, 3))));
+                }
+                break;
+            default:
+                header.insert(it->c_str(), Imf::StringAttribute(metadata.getAsString(*it)));
+                break;
+        }
+    }
+}
+
 void Bitmap::readOpenEXR(Stream *stream, const std::string &_prefix) {
     EXRIStream istr(stream);
     Imf::InputFile file(istr);
@@ -2928,40 +3021,7 @@ void Bitmap::readOpenEXR(Stream *stream, const std::string &_prefix) {
     }
 
     /* Load metadata if present */
-    for (Imf::Header::ConstIterator it = header.begin(); it != header.end(); ++it) {
-        std::string name = it.name(), typeName = it.attribute().typeName();
-        const Imf::StringAttribute *sattr;
-        const Imf::IntAttribute *iattr;
-        const Imf::FloatAttribute *fattr;
-        const Imf::DoubleAttribute *dattr;
-        const Imf::V3fAttribute *vattr;
-        const Imf::M44fAttribute *mattr;
-
-        if (typeName == "string" &&
-            (sattr = header.findTypedAttribute<Imf::StringAttribute>(name.c_str())))
-            m_metadata.setString(name, sattr->value());
-        else if (typeName == "int" &&
-            (iattr = header.findTypedAttribute<Imf::IntAttribute>(name.c_str())))
-            m_metadata.setInteger(name, iattr->value());
-        else if (typeName == "float" &&
-            (fattr = header.findTypedAttribute<Imf::FloatAttribute>(name.c_str())))
-            m_metadata.setFloat(name, (Float) fattr->value());
-        else if (typeName == "double" &&
-            (dattr = header.findTypedAttribute<Imf::DoubleAttribute>(name.c_str())))
-            m_metadata.setFloat(name, (Float) dattr->value());
-        else if (typeName == "v3f" &&
-            (vattr = header.findTypedAttribute<Imf::V3fAttribute>(name.c_str()))) {
-            Imath::V3f vec = vattr->value();
-            m_metadata.setVector(name, Vector(vec.x, vec.y, vec.z));
-        } else if (typeName == "m44f" &&
-            (mattr = header.findTypedAttribute<Imf::M44fAttribute>(name.c_str()))) {
-            Matrix4x4 M;
-            for (int i=0; i<4; ++i)
-                for (int j=0; j<4; ++j)
-                    M(i, j) = mattr->value().x[i][j];
-            m_metadata.setTransform(name, Transform(M));
-        }
-    }
+    readEXRMetadata(header, m_metadata);
 
     updateChannelCount();
     m_gamma = 1.0f;
@@ -3192,42 +3252,8 @@ void Bitmap::writeOpenEXR(Stream *stream) const {
     if (!metadata.hasProperty("generatedBy"))
         metadata.setString("generatedBy", "Mitsuba version " MTS_VERSION);
 
-    std::vector<std::string> keys = metadata.getPropertyNames();
-
     Imf::Header header(m_size.x, m_size.y);
-    for (std::vector<std::string>::const_iterator it = keys.begin(); it != keys.end(); ++it) {
-        Properties::EPropertyType type = metadata.getType(*it);
-
-        switch (type) {
-            case Properties::EString:
-                header.insert(it->c_str(), Imf::StringAttribute(metadata.getString(*it)));
-                break;
-            case Properties::EInteger:
-                header.insert(it->c_str(), Imf::IntAttribute(metadata.getInteger(*it)));
-                break;
-            case Properties::EFloat:
-                header.insert(it->c_str(), Imf::FloatAttribute((float) metadata.getFloat(*it)));
-                break;
-            case Properties::EPoint: {
-                    Point val = metadata.getPoint(*it);
-                    header.insert(it->c_str(), Imf::V3fAttribute(
-                        Imath::V3f((float) val.x, (float) val.y, (float) val.z)));
-                }
-                break;
-            case Properties::ETransform: {
-                    Matrix4x4 val = metadata.getTransform(*it).getMatrix();
-                    header.insert(it->c_str(), Imf::M44fAttribute(Imath::M44f(
-                        (float) val(0, 0), (float) val(0, 1), (float) val(0, 2), (float) val(0, 3),
-                        (float) val(1, 0), (float) val(1, 1), (float) val(1, 2), (float) val(1, 3),
-                        (float) val(2, 0), (float) val(2, 1), (float) val(2, 2), (float) val(2, 3),
-                        (float) val(3, 0), (float) val(3, 1), (float) val(3, 2), (float) val(3, 3))));
-                }
-                break;
-            default:
-                header.insert(it->c_str(), Imf::StringAttribute(metadata.getAsString(*it)));
-                break;
-        }
-    }
+    writeEXRMetadata(metadata, header);
 
     if (pixelFormat == EXYZ || pixelFormat == EXYZA) {
         Imf::addChromaticities(header, Imf::Chromaticities(
@@ -3339,6 +3365,222 @@ void Bitmap::writeOpenEXR(Stream *stream) const {
 }
 #endif
 
+/* ========================== *
+ *   Streaming EXR access     *
+ * ========================== */
+
+#if defined(MTS_HAS_OPENEXR)
+struct EXRScanlineReader::EXRScanlineReaderPrivate {
+    EXRIStream istr;
+    Imf::InputFile file;
+    Imath::Box2i dataWindow;
+    Vector2i size;
+    std::vector<std::string> channelNames;
+    Bitmap::EComponentFormat componentFormat;
+    Properties metadata;
+    int position;
+
+    EXRScanlineReaderPrivate(Stream *stream) : istr(stream), file(istr),
+        componentFormat(Bitmap::EInvalid), position(0) { }
+};
+
+struct EXRScanlineWriter::EXRScanlineWriterPrivate {
+    EXROStream ostr;
+    Imf::Header header;
+    boost::scoped_ptr<Imf::OutputFile> file;
+    Vector2i size;
+    std::vector<std::string> channelNames;
+    int position;
+
+    EXRScanlineWriterPrivate(Stream *stream, const Vector2i &size)
+        : ostr(stream), header(size.x, size.y), size(size), position(0) { }
+};
+
+EXRScanlineReader::EXRScanlineReader(Stream *stream)
+        : d(new EXRScanlineReaderPrivate(stream)) {
+    const Imf::Header &header = d->file.header();
+    d->dataWindow = header.dataWindow();
+    d->size = Vector2i(
+        d->dataWindow.max.x - d->dataWindow.min.x + 1,
+        d->dataWindow.max.y - d->dataWindow.min.y + 1);
+
+    const Imf::ChannelList &channels = header.channels();
+    Imf::PixelType pxType = Imf::FLOAT;
+    for (Imf::ChannelList::ConstIterator it = channels.begin(); it != channels.end(); ++it) {
+        const Imf::Channel &channel = it.channel();
+        if (channel.xSampling != 1 || channel.ySampling != 1)
+            Log(EError, "EXRScanlineReader: channel \"%s\" is subsampled, which "
+                "is not supported!", it.name());
+        if (d->channelNames.empty())
+            pxType = channel.type;
+        else if (channel.type != pxType)
+            Log(EError, "EXRScanlineReader: the channels of \"%s\" use different "
+                "pixel types, which is not supported!", stream->toString().c_str());
+        d->channelNames.push_back(it.name());
+    }
+
+    if (d->channelNames.empty())
+        Log(EError, "EXRScanlineReader: the image does not contain any channels!");
+
+    switch (pxType) {
+        case Imf::HALF: d->componentFormat = Bitmap::EFloat16; break;
+        case Imf::FLOAT: d->componentFormat = Bitmap::EFloat32; break;
+        case Imf::UINT: d->componentFormat = Bitmap::EUInt32; break;
+        default: Log(EError, "EXRScanlineReader: invalid pixel type!");
+    }
+
+    readEXRMetadata(header, d->metadata);
+
+    Log(EDebug, "Streaming a %ix%i OpenEXR file (%i channels, %s)",
+        d->size.x, d->size.y, (int) d->channelNames.size(),
+        memString((size_t) d->size.x * d->size.y * d->channelNames.size()
+            * (d->componentFormat == Bitmap::EFloat16 ? 2 : 4)).c_str());
+}
+
+int EXRScanlineReader::read(Bitmap *band) {
+    if (band->getComponentFormat() != Bitmap::EFloat32 ||
+        band->getWidth() != d->size.x ||
+        band->getChannelCount() != (int) d->channelNames.size())
+        Log(EError, "EXRScanlineReader::read(): the band must be a float32 "
+            "bitmap with a width of %i and %i channels!", d->size.x,
+            (int) d->channelNames.size());
+
+    int rows = std::min(band->getHeight(), d->size.y - d->position);
+    if (rows <= 0)
+        return 0;
+
+    /* Slices are addressed using absolute data window coordinates */
+    ptrdiff_t pixelStride = (ptrdiff_t) d->channelNames.size() * sizeof(float),
+              rowStride = pixelStride * d->size.x;
+    int y0 = d->dataWindow.min.y + d->position;
+    char *base = ((char *) band->getFloat32Data())
+        - d->dataWindow.min.x * pixelStride - y0 * rowStride;
+
+    Imf::FrameBuffer frameBuffer;
+    for (size_t i=0; i<d->channelNames.size(); ++i)
+        frameBuffer.insert(d->channelNames[i].c_str(), Imf::Slice(Imf::FLOAT,
+            base + i * sizeof(float), pixelStride, rowStride));
+
+    d->file.setFrameBuffer(frameBuffer);
+    d->file.readPixels(y0, y0 + rows - 1);
+    d->position += rows;
+    return rows;
+}
+
+EXRScanlineWriter::EXRScanlineWriter(Stream *stream, const Vector2i &size,
+        const std::vector<std::string> &channelNames,
+        Bitmap::EComponentFormat componentFormat, const Properties &metadata)
+        : d(new EXRScanlineWriterPrivate(stream, size)) {
+    Imf::PixelType compType;
+    if (componentFormat == Bitmap::EFloat16)
+        compType = Imf::HALF;
+    else if (componentFormat == Bitmap::EFloat32)
+        compType = Imf::FLOAT;
+    else if (componentFormat == Bitmap::EUInt32)
+        compType = Imf::UINT;
+    else
+        Log(EError, "EXRScanlineWriter: Invalid component type (must be "
+            "float16, float32, or uint32)");
+
+    if (channelNames.empty())
+        Log(EError, "EXRScanlineWriter: at least one channel is required!");
+
+    d->channelNames = channelNames;
+    Properties headerMetadata(metadata);
+    if (!headerMetadata.hasProperty("generatedBy"))
+        headerMetadata.setString("generatedBy", "Mitsuba version " MTS_VERSION);
+    writeEXRMetadata(headerMetadata, d->header);
+    Imf::ChannelList &channels = d->header.channels();
+    for (size_t i=0; i<channelNames.size(); ++i)
+        channels.insert(channelNames[i].c_str(), Imf::Channel(compType));
+    d->file.reset(new Imf::OutputFile(d->ostr, d->header));
+}
+
+void EXRScanlineWriter::write(const Bitmap *band, int rows) {
+    if (band->getComponentFormat() != Bitmap::EFloat32 ||
+        band->getWidth() != d->size.x ||
+        band->getChannelCount() != (int) d->channelNames.size())
+        Log(EError, "EXRScanlineWriter::write(): the band must be a float32 "
+            "bitmap with a width of %i and %i channels!", d->size.x,
+            (int) d->channelNames.size());
+
+    if (rows < 0)
+        rows = band->getHeight();
+    rows = std::min(std::min(rows, band->getHeight()), d->size.y - d->position);
+    if (rows <= 0)
+        return;
+
+    ptrdiff_t pixelStride = (ptrdiff_t) d->channelNames.size() * sizeof(float),
+              rowStride = pixelStride * d->size.x;
+    char *base = ((char *) band->getFloat32Data()) - d->position * rowStride;
+
+    Imf::FrameBuffer frameBuffer;
+    for (size_t i=0; i<d->channelNames.size(); ++i)
+        frameBuffer.insert(d->channelNames[i].c_str(), Imf::Slice(Imf::FLOAT,
+            base + i * sizeof(float), pixelStride, rowStride));
+
+    d->file->setFrameBuffer(frameBuffer);
+    d->file->writePixels(rows);
+    d->position += rows;
+}
+#else
+struct EXRScanlineReader::EXRScanlineReaderPrivate {
+    Vector2i size;
+    std::vector<std::string> channelNames;
+    Bitmap::EComponentFormat componentFormat;
+    Properties metadata;
+    int position;
+};
+
+struct EXRScanlineWriter::EXRScanlineWriterPrivate {
+    int position;
+};
+
+EXRScanlineReader::EXRScanlineReader(Stream *stream) {
+    Log(EError, "EXRScanlineReader: OpenEXR support was disabled at compile time!");
+}
+
+int EXRScanlineReader::read(Bitmap *band) {
+    return 0;
+}
+
+EXRScanlineWriter::EXRScanlineWriter(Stream *stream, const Vector2i &size,
+        const std::vector<std::string> &channelNames,
+        Bitmap::EComponentFormat componentFormat, const Properties &metadata) {
+    Log(EError, "EXRScanlineWriter: OpenEXR support was disabled at compile time!");
+}
+
+void EXRScanlineWriter::write(const Bitmap *band, int rows) { }
+#endif
+
+EXRScanlineReader::~EXRScanlineReader() { }
+
+const Vector2i &EXRScanlineReader::getSize() const {
+    return d->size;
+}
+
+const std::vector<std::string> &EXRScanlineReader::getChannelNames() const {
+    return d->channelNames;
+}
+
+Bitmap::EComponentFormat EXRScanlineReader::getComponentFormat() const {
+    return d->componentFormat;
+}
+
+const Properties &EXRScanlineReader::getMetadata() const {
+    return d->metadata;
+}
+
+int EXRScanlineReader::getPosition() const {
+    return d->position;
+}
+
+EXRScanlineWriter::~EXRScanlineWriter() { }
+
+int EXRScanlineWriter::getPosition() const {
+    return d->position;
+}
+
 void Bitmap::readTGA(Stream *stream) {
     Stream::EByteOrder byteOrder = stream->getByteOrder();
     stream->setByteOrder(Stream::ELittleEndian);
@@ -3904,20 +4146,23 @@ void Bitmap::writePPM(Stream *stream) const {
 
 void Bitmap::staticInitialization() {
 #if defined(MTS_HAS_OPENEXR)
-    /* Prevent races during the OpenEXR initialization */
+    /* Prevent races during the OpenEXR initialization. The thread
+       pool used to read/write files is created lazily. */
     Imf::staticInitialize();
-
-    /* Use multiple threads to read/write OpenEXR files */
-    Imf::setGlobalThreadCount(getCoreCount());
 #endif
 
     /* Initialize the Bitmap format conversion */
     FormatConverter::staticInitialization();
 
-#if defined(MTS_HAS_FFTW)
-    /* Initialize FFTW if enabled */
-    fftw_init_threads();
-    fftw_plan_with_nthreads(getCoreCount());
+    /* FFTW's threading support is likewise initialized by the first
+       call to Bitmap::convolve() */
+}
+
+void Bitmap::initializeOpenEXRThreads() {
+#if defined(MTS_HAS_OPENEXR)
+    /* The thread pool is only created once the first file is accessed,
+       which keeps it out of the startup time of short-lived processes */
+    boost::call_once(createOpenEXRThreadPool, __openexr_once);
 #endif
 }
 
@@ -3925,7 +4170,10 @@ void Bitmap::staticShutdown() {
     FormatConverter::staticShutdown();
 
 #if defined(MTS_HAS_FFTW)
-    fftw_cleanup_threads();
+    if (__fftw_threads) {
+        fftw_cleanup_threads();
+        __fftw_threads = false;
+    }
 #endif
 }
 
@@ -4032,4 +4280,6 @@ std::ostream &operator<<(std::ostream &os, const Bitmap::EComponentFormat &value
 }
 
 MTS_IMPLEMENT_CLASS(Bitmap, false, Object)
+MTS_IMPLEMENT_CLASS(EXRScanlineReader, false, Object)
+MTS_IMPLEMENT_CLASS(EXRScanlineWriter, false, Object)
 MTS_NAMESPACE_END
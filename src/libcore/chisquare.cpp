@@ -149,8 +149,9 @@ void ChiSquare::fill(
             max[1] = (j+1) * factor.y;
             Float result, error;
 
-            integrator.integrateVectorized(
-                boost::bind(&ChiSquare::integrand, pdfFn, _1, _2, _3),
+            /* The batches of points are evaluated on all cores */
+            integrator.integrateParallel(
+                boost::bind(&ChiSquare::integrand, pdfFn, _1, _2),
                 min, max, &result, &error
             );
 
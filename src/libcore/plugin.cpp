@@ -23,6 +23,7 @@
 #include <mitsuba/core/fresolver.h>
 #include <mitsuba/core/cobject.h>
 #include <mitsuba/core/version.h>
+#include <mitsuba/core/timer.h>
 
 #if !defined(__WINDOWS__)
 # include <dlfcn.h>
@@ -32,6 +33,39 @@
 
 MTS_NAMESPACE_BEGIN
 
+// -----------------------------------------------------------------------
+//  Built-in plugin registry
+// -----------------------------------------------------------------------
+
+/* Intrusive list of registered plugins. Being a zero-initialized POD, the
+   head is valid before any static constructor registers a plugin */
+StaticPlugin *StaticPlugin::m_head = NULL;
+
+StaticPlugin::StaticPlugin(const char *filename, const char *description,
+        CreateInstanceFunc createInstance, CreateUtilityFunc createUtility)
+    : m_description(description), m_createInstance(createInstance),
+      m_createUtility(createUtility) {
+    m_name = fs::path(filename).stem().string();
+    m_next = m_head;
+    m_head = this;
+}
+
+const StaticPlugin *StaticPlugin::find(const std::string &name) {
+    for (const StaticPlugin *plugin = m_head; plugin != NULL; plugin = plugin->m_next) {
+        if (plugin->m_name == name)
+            return plugin;
+    }
+    return NULL;
+}
+
+std::vector<std::string> StaticPlugin::getNames() {
+    std::vector<std::string> names;
+    for (const StaticPlugin *plugin = m_head; plugin != NULL; plugin = plugin->m_next)
+        names.push_back(plugin->m_name);
+    std::sort(names.begin(), names.end());
+    return names;
+}
+
 // -----------------------------------------------------------------------
 //  Abstract plugin module implementation
 // -----------------------------------------------------------------------
@@ -54,6 +88,7 @@ struct Plugin::PluginPrivate {
     GetDescriptionFunc getDescription;
     CreateInstanceFunc createInstance;
     CreateUtilityFunc createUtility;
+    std::string description;
 
     PluginPrivate(const std::string &sn, const fs::path &p)
     : shortName(sn), path(p) {}
@@ -101,6 +136,17 @@ Plugin::Plugin(const std::string &shortName, const fs::path &path)
     Class::staticInitialization();
 }
 
+Plugin::Plugin(const std::string &shortName, const StaticPlugin *plugin)
+ : d(new PluginPrivate(shortName, fs::path())) {
+    d->handle = NULL;
+    d->getDescription = NULL;
+    d->createInstance = plugin->m_createInstance;
+    d->createUtility = plugin->m_createUtility;
+    d->isUtility = plugin->isUtility();
+    d->description = plugin->getDescription();
+    Statistics::getInstance()->logPlugin(shortName, getDescription());
+}
+
 bool Plugin::hasSymbol(const std::string &sym) const {
 #if defined(__WINDOWS__)
     void *ptr = GetProcAddress(d->handle, sym.c_str());
@@ -140,6 +186,8 @@ bool Plugin::isUtility() const {
 }
 
 std::string Plugin::getDescription() const {
+    if (!d->getDescription)
+        return d->description;
     return d->getDescription();
 }
 
@@ -152,6 +200,8 @@ const std::string& Plugin::getShortName() const {
 }
 
 Plugin::~Plugin() {
+    if (!d->handle)
+        return;
 #if defined(__WINDOWS__)
     FreeLibrary(d->handle);
 #else
@@ -224,6 +274,14 @@ void PluginManager::ensurePluginLoaded(const std::string &name) {
     if (m_plugins[name] != NULL)
         return;
 
+    /* Plugins that were linked into the executable take precedence */
+    const StaticPlugin *staticPlugin = StaticPlugin::find(name);
+    if (staticPlugin) {
+        Log(EDebug, "Using built-in plugin \"%s\"", name.c_str());
+        m_plugins[name] = new Plugin(name, staticPlugin);
+        return;
+    }
+
     /* Build the full plugin file name */
     fs::path shortName = fs::path("plugins") / name;
 #if defined(__WINDOWS__)
@@ -239,7 +297,10 @@ void PluginManager::ensurePluginLoaded(const std::string &name) {
 
     if (fs::exists(path)) {
         Log(EInfo, "Loading plugin \"%s\" ..", shortName.string().c_str());
+        ref<Timer> timer = new Timer();
         m_plugins[name] = new Plugin(shortName.string(), path);
+        Log(EDebug, "Plugin \"%s\" was loaded in %i ms", name.c_str(),
+            timer->getMilliseconds());
         return;
     }
 
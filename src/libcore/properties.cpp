@@ -364,8 +364,12 @@ bool Properties::operator==(const Properties &p) const {
 
     std::map<std::string, PropertyElement>::const_iterator it = m_elements->begin();
     for (; it != m_elements->end(); ++it) {
+        std::map<std::string, PropertyElement>::const_iterator it2 = p.m_elements->find(it->first);
+        if (it2 == p.m_elements->end())
+            return false;
+
         const PropertyElement &first = it->second;
-        const PropertyElement &second = (*p.m_elements)[it->first];
+        const PropertyElement &second = it2->second;
 
         if (!boost::apply_visitor(EqualityVisitor(&first.data), second.data))
             return false;
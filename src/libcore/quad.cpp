@@ -307,6 +307,8 @@ Float GaussLobattoIntegrator::integrate(
     Float factor = 1;
     size_t evals = 0;
     if (a == b) {
+        if (_evals)
+            *_evals = 0;
         return 0;
     } else if (b < a) {
         std::swap(a, b);
@@ -1403,6 +1405,33 @@ private:
     Float *m_temp;
 };
 
+class ParallelAdapter {
+public:
+    ParallelAdapter(const NDIntegrator::Integrand &integrand, size_t fdim,
+            size_t dim) : m_integrand(integrand), m_fdim(fdim), m_dim(dim) { }
+
+    void f(size_t nPt, const Float *in, Float *out) {
+        #if defined(MTS_OPENMP)
+            #pragma omp parallel
+        #endif
+        {
+            Float *temp = (Float *) alloca(sizeof(Float) * m_fdim);
+
+            #if defined(MTS_OPENMP)
+                #pragma omp for
+            #endif
+            for (int i = 0; i < (int) nPt; ++i) {
+                m_integrand(in + i*m_dim, temp);
+                for (size_t k = 0; k < m_fdim; ++k)
+                    out[k*nPt + i] = temp[k];
+            }
+        }
+    }
+private:
+    const NDIntegrator::Integrand &m_integrand;
+    size_t m_fdim, m_dim;
+};
+
 NDIntegrator::NDIntegrator(size_t fDim, size_t dim,
             size_t maxEvals, Float absError, Float relError)
  : m_fdim(fDim), m_dim(dim), m_maxEvals(maxEvals), m_absError(absError),
@@ -1420,6 +1449,18 @@ NDIntegrator::EResult NDIntegrator::integrate(const Integrand &f, const Float *m
     return retval;
 }
 
+NDIntegrator::EResult NDIntegrator::integrateParallel(const Integrand &f, const Float *min,
+        const Float *max, Float *result, Float *error, size_t *_evals) const {
+    ParallelAdapter adapter(f, m_fdim, m_dim);
+    size_t evals = 0;
+    EResult retval = mitsuba::integrate((unsigned int) m_fdim, boost::bind(
+        &ParallelAdapter::f, &adapter, _1, _2, _3), (unsigned int) m_dim,
+        min, max, m_maxEvals, m_absError, m_relError, result, error, evals, true);
+    if (_evals)
+        *_evals = evals;
+    return retval;
+}
+
 NDIntegrator::EResult NDIntegrator::integrateVectorized(const VectorizedIntegrand &f, const Float *min,
         const Float *max, Float *result, Float *error, size_t *_evals) const {
     size_t evals = 0;
@@ -19,6 +19,7 @@
 #include <mitsuba/core/sched.h>
 #include <mitsuba/core/plugin.h>
 #include <mitsuba/core/mstream.h>
+#include <mitsuba/core/arena.h>
 
 #include <boost/thread/thread.hpp>
 
@@ -647,10 +648,13 @@ LocalWorker::~LocalWorker() {
 }
 
 void LocalWorker::run() {
+    MemoryArena *arena = MemoryArena::getThreadArena();
+
     while (acquireWork(true) != Scheduler::EStop) {
         try {
             m_schedItem.wp->process(m_schedItem.workUnit, m_schedItem.workResult, m_schedItem.stop);
         } catch (const std::exception &ex) {
+            arena->reset();
             m_schedItem.stop = true;
             releaseWork(m_schedItem);
             ELogLevel warnLogLevel = Thread::getThread()->getLogger()->getErrorLevel() == EError
@@ -660,6 +664,8 @@ void LocalWorker::run() {
             cancel(false);
             continue;
         }
+        /* Temporary per-work unit allocations are no longer needed */
+        arena->reset();
         releaseWork(m_schedItem);
     }
 }
@@ -24,21 +24,68 @@
      Edgar Velazquez-Armendariz <cs#cornell#edu - eva5>
 ============================================================================*/
 
-#include "simdtonemap.h"
 
-#if defined(MTS_SSE)
-
-#include <mitsuba/core/sse.h>
+#include <mitsuba/core/simdtonemap.h>
+#if MTS_SSE
 #include <mitsuba/core/ssemath.h>
 #include <mitsuba/core/ssevector.h>
-#include <mitsuba/core/bitmap.h>
+#endif
+
+/* Number of pixels that are processed by each parallel work item */
+#define MTS_TONEMAP_CHUNK_SIZE (64*1024)
 
+MTS_NAMESPACE_BEGIN
 
 namespace
 {
 
-typedef mitsuba::math::SSEVector4f V4f;
-typedef mitsuba::math::SSEVector4i V4i;
+// Check the source and target formats of a tone mapping operation
+bool checkFormats(const Bitmap* source, const Bitmap* target)
+{
+    if (source->getSize() != target->getSize()) {
+        SLog(EWarn, "TonemapCPU: images size missmatch");
+        return false;
+    }
+
+    // Check the format
+    if (source->getPixelFormat() != Bitmap::ERGBA) {
+        SLog(EWarn, "TonemapCPU: the source image is not in RGBA format");
+        return false;
+    }
+    else if (target->getPixelFormat() != Bitmap::ERGBA &&
+             target->getPixelFormat() != Bitmap::ERGB) {
+        SLog(EWarn, "TonemapCPU: the target image is not in RGB(A) format");
+        return false;
+    }
+    else if (source->getComponentFormat() != Bitmap::EFloat32) {
+        SLog(EWarn, "TonemapCPU: the source component format is not Float32");
+        return false;
+    }
+    else if (target->getComponentFormat() != Bitmap::EUInt8) {
+        SLog(EWarn, "TonemapCPU: the target component format is not UInt8");
+        return false;
+    }
+    return true;
+}
+
+// Check the source format of a luminance computation
+bool checkFormat(const Bitmap* source)
+{
+    if (source->getPixelFormat() != Bitmap::ERGBA) {
+        SLog(EWarn, "TonemapCPU: the image is not in RGBA format");
+        return false;
+    }
+    else if (source->getComponentFormat() != Bitmap::EFloat32) {
+        SLog(EWarn, "TonemapCPU: the image component format is not Float32");
+        return false;
+    }
+    return true;
+}
+
+#if MTS_SSE
+
+typedef math::SSEVector4f V4f;
+typedef math::SSEVector4i V4i;
 
 // Method for scaling the luminance
 enum ELuminanceMethod {
@@ -87,14 +134,22 @@ union PixelRGBA8Group
     }
 };
 
+// Copy the color components of RGBA8 pixels into a packed RGB8 image
+inline void stripAlpha(const PixelRGBA8* source, uint8_t* target, size_t count)
+{
+    for (size_t i = 0; i < count; ++i, target += 3) {
+        target[0] = source[i].r;
+        target[1] = source[i].g;
+        target[2] = source[i].b;
+    }
+}
+
 
 // Inline version of fastlog_ps for extra performance
-inline mitsuba::math::SSEVector4f am_log(const mitsuba::math::SSEVector4f& x) {
-    typedef mitsuba::math::SSEVector4f v4f;
-    typedef mitsuba::math::SSEVector4i v4i;
-    using mitsuba::math::castAsFloat;
-    using mitsuba::math::clamp_ps;
-    using mitsuba::math::fastpow_ps;
+inline V4f am_log(const V4f& x) {
+    typedef V4f v4f;
+    typedef V4i v4i;
+    using math::castAsFloat;
 
     // Constants
     const v4f min_normal(castAsFloat(v4i::constant<0x00800000>()));
@@ -222,9 +277,9 @@ inline void reinhard(V4f& r, V4f& g, V4f& b, const V4f& multiplier,
     const V4f& scale, const V4f& invWp2)
 {
     const V4f ONE(1.0f);
-    const V4f LVec0(0.357580f);
+    const V4f LVec0(0.212671f);
     const V4f LVec1(0.715160f);
-    const V4f LVec2(0.119193f);
+    const V4f LVec2(0.072169f);
 
     // Get the luminance
     const V4f Y = multiplier * (LVec0*r + LVec1*g + LVec2*b);
@@ -325,45 +380,30 @@ void tonemap(const PixelRGBA32FGroup* const begin,
             stream(&(out->packed), pixel);
         }
     }
+
+    // Make the non-temporal stores visible to other threads
+    _mm_sfence();
 }
 
 
 
 // Tonemap dispatcher
 template <ELuminanceMethod luminanceMethod, EDisplayMethod displayMethod>
-bool tonemap(const mitsuba::Bitmap* source, mitsuba::Bitmap* target,
+bool tonemap(const Bitmap* source, Bitmap* target,
     const TonemapCPU::Params& params)
 {
-    using namespace mitsuba;
-
-    if (source->getSize() != target->getSize()) {
-        SLog(EWarn, "TonemapCPU: images size missmatch");
+    if (!checkFormats(source, target))
         return false;
-    }
-
-    // Check the format
-    if (source->getPixelFormat() != Bitmap::ERGBA ||
-        target->getPixelFormat() != Bitmap::ERGBA) {
-        SLog(EWarn, "TonemapCPU: the images are not in RGBA format");
-        return false;
-    }
-    else if (source->getComponentFormat() != Bitmap::EFloat32) {
-        SLog(EWarn, "TonemapCPU: the source component format is not Float32");
-        return false;
-    }
-    else if (target->getComponentFormat() != Bitmap::EUInt8) {
-        SLog(EWarn, "TonemapCPU: the target component format is not UInt8");
-        return false;
-    }
 
     // Raw pointers to the data, checking for alignment
     const float *sourceData = source->getFloat32Data();
     uint8_t *targetData = static_cast<uint8_t*>(target->getData());
+    const bool hasAlpha = target->getPixelFormat() == Bitmap::ERGBA;
     if (reinterpret_cast<uintptr_t>(sourceData) % 16 != 0) {
         SLog(EWarn, "TonemapCPU: the source data is not 16-byte aligned");
         return false;
     }
-    else if (reinterpret_cast<uintptr_t>(targetData) % 16 != 0) {
+    else if (hasAlpha && reinterpret_cast<uintptr_t>(targetData) % 16 != 0) {
         SLog(EWarn, "TonemapCPU: the target data is not 16-byte aligned");
         return false;
     }
@@ -373,11 +413,31 @@ bool tonemap(const mitsuba::Bitmap* source, mitsuba::Bitmap* target,
     const size_t pixelCount = source->getPixelCount();
     const PixelRGBA32FGroup* begin =
         reinterpret_cast<const PixelRGBA32FGroup*>(sourceData);
-    const PixelRGBA32FGroup* end   = begin + (pixelCount / 4);
+    const ptrdiff_t groupCount = (ptrdiff_t) (pixelCount / 4);
     PixelRGBA8Group* dest = reinterpret_cast<PixelRGBA8Group*>(targetData);
 
-    // Main processing
-    tonemap<luminanceMethod, displayMethod> (begin, end, dest, params);
+    // Main processing, split into chunks which are processed in parallel
+    const ptrdiff_t chunkSize = MTS_TONEMAP_CHUNK_SIZE / 4;
+    const int chunkCount = (int) ((groupCount + chunkSize - 1) / chunkSize);
+
+    #pragma omp parallel for schedule(dynamic) if (chunkCount > 1)
+    for (int i = 0; i < chunkCount; ++i) {
+        const ptrdiff_t offset = i * chunkSize;
+        const ptrdiff_t count = std::min(chunkSize, groupCount - offset);
+        if (hasAlpha) {
+            tonemap<luminanceMethod, displayMethod> (begin + offset,
+                begin + offset + count, dest + offset, params);
+        } else {
+            // Tonemap into a temporary RGBA buffer and drop the alpha channel
+            PixelRGBA8Group *temp = static_cast<PixelRGBA8Group *>(
+                allocAligned(count * sizeof(PixelRGBA8Group)));
+            tonemap<luminanceMethod, displayMethod> (begin + offset,
+                begin + offset + count, temp, params);
+            stripAlpha(reinterpret_cast<const PixelRGBA8*>(temp),
+                targetData + 3 * 4 * offset, 4 * count);
+            freeAligned(temp);
+        }
+    }
 
     if (pixelCount % 4 != 0) {
         // Individual final group
@@ -393,9 +453,13 @@ bool tonemap(const mitsuba::Bitmap* source, mitsuba::Bitmap* target,
             &lastTarget, params);
 
         // Copy the final pixels to the target
-        PixelRGBA8* dest = reinterpret_cast<PixelRGBA8*>(targetData) + offset;
-        for (int i = 0; i < static_cast<int>(pixelCount % 4); ++i) {
-            dest[i].abgr = lastTarget.p[i].abgr;
+        if (hasAlpha) {
+            PixelRGBA8* dest = reinterpret_cast<PixelRGBA8*>(targetData) + offset;
+            for (int i = 0; i < static_cast<int>(pixelCount % 4); ++i) {
+                dest[i].abgr = lastTarget.p[i].abgr;
+            }
+        } else {
+            stripAlpha(lastTarget.p, targetData + 3 * offset, pixelCount % 4);
         }
     }
 
@@ -411,9 +475,10 @@ struct LuminanceResult
 };
 
 
-// Compute the luminance mapping NaNs, negatives and the Mitsuba logo to 0.0
+// Compute the luminance mapping NaNs, negatives and optionally the Mitsuba
+// logo (which the interactive viewer draws with a luminance of 1024) to 0.0
 inline V4f computeLuminance(const V4f& r, const V4f& g, const V4f& b,
-    const V4f& multiplier)
+    const V4f& multiplier, bool ignoreLogo)
 {
     const V4f L0(0.212671f);
     const V4f L1(0.715160f);
@@ -421,7 +486,9 @@ inline V4f computeLuminance(const V4f& r, const V4f& g, const V4f& b,
     const V4f const_1024f(1024.0f);
 
     const V4f Y = multiplier * (L0*r + L1*g + L2*b);
-    const V4f invalidMask = (Y < V4f::zero()) | isnan(Y) | (Y == const_1024f);
+    V4f invalidMask = (Y < V4f::zero()) | isnan(Y);
+    if (ignoreLogo)
+        invalidMask = invalidMask | (Y == const_1024f);
 
     // 0.0 is just zeros, so the mask works
     const V4f result = andnot(invalidMask, Y);
@@ -429,7 +496,7 @@ inline V4f computeLuminance(const V4f& r, const V4f& g, const V4f& b,
 }
 
 LuminanceResult luminance(const PixelRGBA32FGroup* const begin,
-    const PixelRGBA32FGroup* const end, float inMultiplier)
+    const PixelRGBA32FGroup* const end, float inMultiplier, bool ignoreLogo)
 {
     // Use 24 KiB for temporary block storage
     const ptrdiff_t BLOCK_SIZE = (24*1024) / sizeof(V4f);
@@ -453,7 +520,8 @@ LuminanceResult luminance(const PixelRGBA32FGroup* const begin,
             V4f b    = it->p[2];
             V4f junk = it->p[3];
             transpose(r, g, b, junk);
-            const V4f luminance = computeLuminance(r, g, b, multiplier);
+            const V4f luminance = computeLuminance(r, g, b, multiplier,
+                ignoreLogo);
             maxLuminance = max(luminance, maxLuminance);
             buffer[i] = luminance;
         }
@@ -474,20 +542,11 @@ LuminanceResult luminance(const PixelRGBA32FGroup* const begin,
 
 
 // Luminance dispatcher
-bool luminance(const mitsuba::Bitmap* source, const float multiplier,
-    float& outMaxLuminance, float &outAvgLogLuminance)
+bool luminance(const Bitmap* source, const float multiplier,
+    bool ignoreLogo, float& outMaxLuminance, float &outAvgLogLuminance)
 {
-    using namespace mitsuba;
-
-    // Check the format
-    if (source->getPixelFormat() != Bitmap::ERGBA) {
-        SLog(EWarn, "TonemapCPU: the image is not in RGBA format");
+    if (!checkFormat(source))
         return false;
-    }
-    else if (source->getComponentFormat() != Bitmap::EFloat32) {
-        SLog(EWarn, "TonemapCPU: the image component format is not Float32");
-        return false;
-    }
 
     // Raw pointers to the data, checking for alignment
     const float *sourceData = source->getFloat32Data();
@@ -501,10 +560,31 @@ bool luminance(const mitsuba::Bitmap* source, const float multiplier,
     const size_t pixelCount = source->getPixelCount();
     const PixelRGBA32FGroup* begin =
         reinterpret_cast<const PixelRGBA32FGroup*>(sourceData);
-    const PixelRGBA32FGroup* end   = begin + (pixelCount / 4);
+    const ptrdiff_t groupCount = (ptrdiff_t) (pixelCount / 4);
+
+    // Main processing: compute partial results for each chunk in parallel
+    // and accumulate them in double precision to avoid cancellation
+    const ptrdiff_t chunkSize = MTS_TONEMAP_CHUNK_SIZE / 4;
+    const int chunkCount = (int) ((groupCount + chunkSize - 1) / chunkSize);
+    std::vector<double> chunkSum(chunkCount);
+    std::vector<float> chunkMax(chunkCount);
+
+    #pragma omp parallel for schedule(dynamic) if (chunkCount > 1)
+    for (int i = 0; i < chunkCount; ++i) {
+        const ptrdiff_t offset = i * chunkSize;
+        const ptrdiff_t count = std::min(chunkSize, groupCount - offset);
+        LuminanceResult result = luminance(begin + offset,
+            begin + offset + count, multiplier, ignoreLogo);
+        chunkSum[i] = math::hsum_ps(result.sumLogLuminance);
+        chunkMax[i] = math::hmax_ps(result.maxLuminance);
+    }
 
-    // Main processing
-    LuminanceResult result = luminance(begin, end, multiplier);
+    double sumLogLuminance = 0;
+    float maxLuminance = -1.0f;
+    for (int i = 0; i < chunkCount; ++i) {
+        sumLogLuminance += chunkSum[i];
+        maxLuminance = std::max(maxLuminance, chunkMax[i]);
+    }
 
     if (pixelCount % 4 != 0) {
         // Individual final group
@@ -514,7 +594,8 @@ bool luminance(const mitsuba::Bitmap* source, const float multiplier,
         for (int i = 0; i < static_cast<int>(pixelCount % 4); ++i) {
             last.p[i] = pixels[i];
         }
-        LuminanceResult rTail = luminance(&last, (&last)+1, multiplier);
+        LuminanceResult rTail = luminance(&last, (&last)+1, multiplier,
+            ignoreLogo);
 
         // Remove the invalid results
         V4i tailMask = V4i::zero();
@@ -532,26 +613,128 @@ bool luminance(const mitsuba::Bitmap* source, const float multiplier,
         // maxLuminance contains zeros in the invalid positions which is OK
         rTail.sumLogLuminance &= castAsFloat(tailMask);
 
-        result.sumLogLuminance += rTail.sumLogLuminance;
-        result.maxLuminance = max(rTail.maxLuminance, result.maxLuminance);
+        sumLogLuminance += math::hsum_ps(rTail.sumLogLuminance);
+        maxLuminance = std::max(maxLuminance, math::hmax_ps(rTail.maxLuminance));
     }
 
-    using mitsuba::math::hmax_ps;
-    using mitsuba::math::hsum_ps;
-    using mitsuba::math::fastexp;
-
-    outMaxLuminance = hmax_ps(result.maxLuminance);
-    const float sumLogLuminance = hsum_ps(result.sumLogLuminance);
-    outAvgLogLuminance =  fastexp(sumLogLuminance / pixelCount);
+    outMaxLuminance = maxLuminance;
+    outAvgLogLuminance = math::fastexp((float) (sumLogLuminance / pixelCount));
     return true;
 };
 
+#else /* MTS_SSE */
+
+/* Portable fallback used when compiling without SSE support */
+
+enum ELuminanceMethod {
+    EExposure,
+    EReinhard02
+};
+
+enum EDisplayMethod {
+    ESRGB,
+    EGamma
+};
+
+inline float toSRGB(float value) {
+    if (value < 0.0031308f)
+        return 12.92f * value;
+    return 1.055f * std::pow(value, 1.0f/2.4f) - 0.055f;
+}
+
+inline uint8_t quantize(float value) {
+    return (uint8_t) (std::max(0.0f, std::min(1.0f, value)) * 255.0f + 0.5f);
+}
+
+template <ELuminanceMethod luminanceMethod, EDisplayMethod displayMethod>
+bool tonemap(const Bitmap* source, Bitmap* target,
+    const TonemapCPU::Params& params)
+{
+    if (!checkFormats(source, target))
+        return false;
+
+    const float *sourceData = source->getFloat32Data();
+    uint8_t *targetData = target->getUInt8Data();
+    const int channels = target->getChannelCount();
+    const float invWp2 = params.invWhitePoint * params.invWhitePoint;
+    const int pixelCount = (int) source->getPixelCount();
+
+    #pragma omp parallel for if (pixelCount > MTS_TONEMAP_CHUNK_SIZE)
+    for (int i = 0; i < pixelCount; ++i) {
+        const float *src = sourceData + 4*i;
+        uint8_t *dst = targetData + channels*i;
+        float rgb[3] = { src[0], src[1], src[2] };
+
+        if (luminanceMethod == EReinhard02) {
+            float Y = params.multiplier * (0.212671f * rgb[0] +
+                0.715160f * rgb[1] + 0.072169f * rgb[2]);
+            float Lp = params.scale * Y;
+            float k = params.scale * (1 + invWp2 * Lp) / (1 + Lp)
+                * params.multiplier;
+            for (int j = 0; j < 3; ++j)
+                rgb[j] *= k;
+        } else {
+            for (int j = 0; j < 3; ++j)
+                rgb[j] *= params.invWhitePoint;
+        }
+
+        for (int j = 0; j < 3; ++j) {
+            float value = std::max(0.0f, std::min(1.0f, rgb[j]));
+            if (displayMethod == ESRGB)
+                value = toSRGB(value);
+            else
+                value = std::pow(value, params.invGamma);
+            dst[j] = quantize(value);
+        }
+        if (channels == 4)
+            dst[3] = quantize(src[3]);
+    }
+
+    return true;
+}
+
+bool luminance(const Bitmap* source, const float multiplier,
+    bool ignoreLogo, float& outMaxLuminance, float &outAvgLogLuminance)
+{
+    if (!checkFormat(source))
+        return false;
+
+    const float *data = source->getFloat32Data();
+    const size_t pixelCount = source->getPixelCount();
+    double sumLogLuminance = 0;
+    float maxLuminance = -1.0f;
+
+    for (size_t i = 0; i < pixelCount; ++i, data += 4) {
+        float Y = multiplier * (0.212671f * data[0] +
+            0.715160f * data[1] + 0.072169f * data[2]);
+
+        // Map NaNs, negatives and optionally the Mitsuba logo to 0.0
+        if (!(Y >= 0) || (ignoreLogo && Y == 1024.0f))
+            Y = 0.0f;
+
+        maxLuminance = std::max(maxLuminance, Y);
+        sumLogLuminance += math::fastlog(1e-3f + Y);
+    }
+
+    outMaxLuminance = maxLuminance;
+    outAvgLogLuminance = math::fastexp((float) (sumLogLuminance / pixelCount));
+    return true;
+}
+
+#endif /* MTS_SSE */
+
 } // namespace
 
 
+TonemapCPU::TonemapCPU() { }
 
-bool TonemapCPU::gammaTonemap(const mitsuba::Bitmap* source,
-    mitsuba::Bitmap* target) const
+void TonemapCPU::setGamma(Float gamma) {
+    m_params.isSRGB = gamma == -1;
+    if (!m_params.isSRGB)
+        m_params.invGamma = static_cast<float>(1 / gamma);
+}
+
+bool TonemapCPU::gammaTonemap(const Bitmap* source, Bitmap* target) const
 {
     if (m_params.isSRGB) {
         return tonemap<EExposure, ESRGB> (source, target, m_params);
@@ -560,9 +743,7 @@ bool TonemapCPU::gammaTonemap(const mitsuba::Bitmap* source,
     }
 }
 
-
-bool TonemapCPU::reinhardTonemap(const mitsuba::Bitmap* source,
-    mitsuba::Bitmap* target) const
+bool TonemapCPU::reinhardTonemap(const Bitmap* source, Bitmap* target) const
 {
     if (m_params.isSRGB) {
         return tonemap<EReinhard02, ESRGB> (source, target, m_params);
@@ -571,16 +752,88 @@ bool TonemapCPU::reinhardTonemap(const mitsuba::Bitmap* source,
     }
 }
 
-
-bool TonemapCPU::setLuminanceInfo(const mitsuba::Bitmap* source,
-    mitsuba::Float multiplier)
+bool TonemapCPU::setLuminanceInfo(const Bitmap* source, Float multiplier,
+    bool ignoreLogo)
 {
-    return luminance(source, static_cast<float>(multiplier),
+    return luminance(source, static_cast<float>(multiplier), ignoreLogo,
         m_params.maxLum, m_params.avgLogLum);
 }
 
+void TonemapCPU::setLuminanceInfo(Float logAvgLuminance, Float maxLuminance) {
+    m_params.avgLogLum = static_cast<float>(logAvgLuminance);
+    m_params.maxLum = static_cast<float>(maxLuminance);
+}
+
+void TonemapCPU::setReinhardParameters(Float key, Float burn) {
+    /* Same parameterization as in Bitmap::tonemapReinhard() */
+    burn = std::min((Float) 1, std::max((Float) 1e-8f, 1-burn));
 
-using mitsuba::Object;
-MTS_IMPLEMENT_CLASS_I(TonemapCPU, false/*abstract*/, Object)
+    Float scale = key / m_params.avgLogLum,
+          Lwhite = m_params.maxLum * scale;
 
-#endif
+    setScale(scale);
+    setInvWhitePoint(1 / (Lwhite * burn * burn));
+}
+
+ref<Bitmap> TonemapCPU::prepareSource(Bitmap *bitmap) {
+    if (bitmap->getPixelFormat() == Bitmap::ERGBA &&
+        bitmap->getComponentFormat() == Bitmap::EFloat32 &&
+        bitmap->getGamma() == 1.0f)
+        return bitmap;
+    return bitmap->convert(Bitmap::ERGBA, Bitmap::EFloat32, 1.0f);
+}
+
+ref<Bitmap> TonemapCPU::develop(Bitmap *source, Bitmap::EPixelFormat pixelFormat,
+        Float gamma, Float multiplier, Float key, Float burn,
+        Float &logAvgLuminance, Float &maxLuminance) {
+    if (pixelFormat != Bitmap::ERGB && pixelFormat != Bitmap::ERGBA)
+        SLog(EError, "TonemapCPU::develop(): unsupported target pixel format!");
+
+    ref<Bitmap> hdr = prepareSource(source);
+    ref<Bitmap> result = new Bitmap(pixelFormat, Bitmap::EUInt8, hdr->getSize());
+    ref<TonemapCPU> tonemapper = new TonemapCPU();
+    tonemapper->setGamma(gamma);
+
+    bool reinhard = key >= 0, success = true;
+    if (reinhard) {
+        if (logAvgLuminance <= 0 || maxLuminance <= 0) {
+            success = tonemapper->setLuminanceInfo(hdr);
+            if (success) {
+                logAvgLuminance = tonemapper->logAvgLuminance();
+                maxLuminance = tonemapper->maxLuminance();
+            }
+        } else {
+            tonemapper->setLuminanceInfo(logAvgLuminance, maxLuminance);
+        }
+    } else {
+        tonemapper->setInvWhitePoint(multiplier);
+    }
+
+    /* A black image is left unchanged by the Reinhard operator */
+    if (success) {
+        if (reinhard && maxLuminance > 0) {
+            tonemapper->setReinhardParameters(key, burn);
+            success = tonemapper->reinhardTonemap(hdr, result);
+        } else {
+            success = tonemapper->gammaTonemap(hdr, result);
+        }
+    }
+
+    if (!success) {
+        /* The vectorized code path rejected the bitmaps (e.g. due to
+           their alignment) -- fall back to the scalar implementation */
+        if (reinhard) {
+            ref<Bitmap> fallback = hdr->clone();
+            fallback->tonemapReinhard(logAvgLuminance, maxLuminance, key, burn);
+            return fallback->convert(pixelFormat, Bitmap::EUInt8, gamma);
+        } else {
+            return hdr->convert(pixelFormat, Bitmap::EUInt8, gamma, multiplier);
+        }
+    }
+
+    result->setGamma(gamma);
+    return result;
+}
+
+MTS_IMPLEMENT_CLASS(TonemapCPU, false, Object)
+MTS_NAMESPACE_END
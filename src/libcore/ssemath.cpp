@@ -301,7 +301,7 @@ __m128 sin_ps(__m128 x) { // any x
     v4si emm0, emm2;
     sign_bit = x;
     /* take the absolute value */
-    x = _mm_and_ps(x, constants::inv_mant_mask.ps);
+    x = _mm_and_ps(x, constants::inv_sign_mask.ps);
     /* extract the sign bit (upper one) */
     sign_bit = _mm_and_ps(sign_bit, constants::sign_mask.ps);
 
@@ -713,6 +713,58 @@ __m128 fastpow_ps(__m128 x, __m128 y) {
     return result;
 }
 
+__m128 fastexp_ps(__m128 x) {
+    typedef SSEVector4f V4f;
+    typedef SSEVector4i V4i;
+
+    // Constants
+    const V4f const_1(constants::ps_1.ps);
+    const V4f const_0p5(constants::ps_0p5.ps);
+    const V4i const_127(constants::pi32_0x7f.pi);
+    const V4f log2_c0(constants::am_log2_c0.ps);
+
+    const V4f exp2_hi(constants::am_exp2_hi.ps);
+    const V4f exp2_lo(constants::am_exp2_lo.ps);
+
+    const V4f exp2_p0(constants::am_exp2_p0.ps);
+    const V4f exp2_p1(constants::am_exp2_p1.ps);
+    const V4f exp2_p2(constants::am_exp2_p2.ps);
+
+    const V4f exp2_q0(constants::am_exp2_q0.ps);
+    const V4f exp2_q1(constants::am_exp2_q1.ps);
+
+    // exp(x) = 2^(x * log2(e)), clamped to the representable range
+    V4f exponent = V4f(x) * log2_c0;
+    exponent = max(min(exponent, exp2_hi), exp2_lo);
+
+    // Normalize the mantissa to [1.0 - 1.5] (see fastpow_ps)
+    const V4f normExponent = exponent + const_0p5;
+
+    // Build the biased exponent
+    const V4f expNegExponentMask = cmpnlt(V4f::zero(), normExponent);
+    const V4f expNormalization = expNegExponentMask & const_1;
+    const V4f truncExp = roundTruncate(normExponent);
+    const V4f resExp = truncExp - expNormalization;
+    V4i biasedExp = toInt(resExp) + const_127;
+    biasedExp = sll(biasedExp, 23);
+    const V4f exponentPart = castAsFloat(biasedExp);
+
+    // Get the fractional part of the exponent
+    exponent -= resExp;
+    const V4f exponentSqr = exponent * exponent;
+
+    // Exp polynomial
+    const V4f EPolyP = ((((exp2_p0 * exponentSqr) + exp2_p1) *
+                                     exponentSqr) + exp2_p2) * exponent;
+    const V4f EPolyQ =   ((exp2_q0 * exponentSqr) + exp2_q1) - EPolyP;
+    V4f expApprox = EPolyP * rcp(EPolyQ);
+    expApprox += expApprox;
+    expApprox += const_1;
+
+    V4f result = expApprox * exponentPart;
+    return result;
+}
+
 }
 
 MTS_NAMESPACE_END
@@ -112,6 +112,17 @@ bool StatsCounter::operator<(const StatsCounter &v) const {
     return getCategory() < v.getCategory();
 }
 
+MemoryCounter::MemoryCounter(const std::string &name)
+ : m_name(name), m_current(0), m_peak(0) {
+    Statistics *stats = Statistics::getInstance();
+    assert(stats != NULL);
+    m_total = stats->m_totalMemory;
+    stats->registerMemoryCounter(this);
+}
+
+MemoryCounter::MemoryCounter(const std::string &name, MemoryCounter *total)
+ : m_name(name), m_current(0), m_peak(0), m_total(total) { }
+
 ref<Statistics> Statistics::m_instance = new Statistics();
 
 void Statistics::staticInitialization() {
@@ -124,12 +135,66 @@ void Statistics::staticShutdown() {
 
 Statistics::Statistics() {
     m_mutex = new Mutex();
+    m_totalMemory = new MemoryCounter("Total", NULL);
+}
+
+Statistics::~Statistics() {
+    delete m_totalMemory;
 }
 
 void Statistics::registerCounter(const StatsCounter *ctr) {
     m_counters.push_back(ctr);
 }
 
+void Statistics::registerMemoryCounter(const MemoryCounter *ctr) {
+    LockGuard lock(m_mutex);
+    m_memoryCounters.push_back(ctr);
+}
+
+const StatsCounter *Statistics::getCounter(const std::string &category,
+        const std::string &name) {
+    LockGuard lock(m_mutex);
+    for (size_t i=0; i<m_counters.size(); ++i) {
+        if (m_counters[i]->getCategory() == category &&
+            m_counters[i]->getName() == name)
+            return m_counters[i];
+    }
+    return NULL;
+}
+
+const MemoryCounter *Statistics::getMemoryCounter(const std::string &name) {
+    LockGuard lock(m_mutex);
+    if (name == m_totalMemory->getName())
+        return m_totalMemory;
+    for (size_t i=0; i<m_memoryCounters.size(); ++i) {
+        if (m_memoryCounters[i]->getName() == name)
+            return m_memoryCounters[i];
+    }
+    return NULL;
+}
+
+std::vector<const MemoryCounter *> Statistics::getMemoryCounters() {
+    LockGuard lock(m_mutex);
+    return m_memoryCounters;
+}
+
+std::string Statistics::getMemoryStats() {
+    std::ostringstream oss;
+    LockGuard lock(m_mutex);
+    char temp[128];
+    for (size_t i=0; i<=m_memoryCounters.size(); ++i) {
+        const MemoryCounter *counter = i < m_memoryCounters.size()
+            ? m_memoryCounters[i] : m_totalMemory;
+        if (counter->getPeak() == 0)
+            continue;
+        snprintf(temp, sizeof(temp), "    -  %s : %s (peak: %s)",
+            counter->getName().c_str(), memString(counter->getCurrent()).c_str(),
+            memString(counter->getPeak()).c_str());
+        oss << temp << endl;
+    }
+    return oss.str();
+}
+
 void Statistics::logPlugin(const std::string &name, const std::string &descr) {
     m_plugins.push_back(std::pair<std::string, std::string>(name, descr));
 }
@@ -147,6 +212,9 @@ void Statistics::resetAll() {
     LockGuard lock(m_mutex);
     for (size_t i=0; i<m_counters.size(); ++i)
         const_cast<StatsCounter *>(m_counters[i])->reset();
+    for (size_t i=0; i<m_memoryCounters.size(); ++i)
+        const_cast<MemoryCounter *>(m_memoryCounters[i])->resetPeak();
+    m_totalMemory->resetPeak();
 }
 
 std::string Statistics::getStats() {
@@ -263,6 +331,12 @@ std::string Statistics::getStats() {
         ++statsEntries;
     }
 
+    std::string memoryStats = getMemoryStats();
+    if (!memoryStats.empty()) {
+        oss << endl << "  * Memory usage :" << endl << memoryStats;
+        ++statsEntries;
+    }
+
     if (statsEntries == 0) {
         oss << " * Statistics:" << endl
             << "     none." << endl;
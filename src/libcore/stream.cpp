@@ -37,6 +37,27 @@ static Stream::EByteOrder getByteOrder() {
 
 Stream::EByteOrder Stream::m_hostByteOrder = mitsuba::getByteOrder();
 
+/// Size of the scratch buffer used when writing byte-swapped arrays
+#define SWAP_BUFFER_SIZE 4096
+
+/**
+ * Write an array with swapped endianness in fixed-size chunks, which avoids
+ * allocating a temporary copy of the entire array on the heap
+ */
+template <typename T> static void writeSwapped(Stream *stream, const T *data, size_t size) {
+    const size_t chunkSize = SWAP_BUFFER_SIZE / sizeof(T);
+    T buffer[SWAP_BUFFER_SIZE / sizeof(T)];
+
+    while (size > 0) {
+        size_t count = std::min(size, chunkSize);
+        for (size_t i=0; i<count; ++i)
+            buffer[i] = endianness_swap(data[i]);
+        stream->write(buffer, sizeof(T) * count);
+        data += count;
+        size -= count;
+    }
+}
+
 Stream::Stream() : m_byteOrder(m_hostByteOrder) { }
 
 void Stream::setByteOrder(EByteOrder value) {
@@ -55,11 +76,7 @@ void Stream::writeInt(int value) {
 
 void Stream::writeIntArray(const int *data, size_t size) {
     if (m_byteOrder != m_hostByteOrder) {
-        int *temp = new int[size];
-        for (size_t i=0; i<size; ++i)
-            temp[i] = endianness_swap(data[i]);
-        write(temp, sizeof(int)*size);
-        delete[] temp;
+        writeSwapped(this, data, size);
     } else {
         write(data, sizeof(int)*size);
     }
@@ -73,11 +90,7 @@ void Stream::writeUInt(unsigned int value) {
 
 void Stream::writeUIntArray(const unsigned int *data, size_t size) {
     if (m_byteOrder != m_hostByteOrder) {
-        unsigned int *temp = new unsigned int[size];
-        for (size_t i=0; i<size; ++i)
-            temp[i] = endianness_swap(data[i]);
-        write(temp, sizeof(unsigned int)*size);
-        delete[] temp;
+        writeSwapped(this, data, size);
     } else {
         write(data, sizeof(unsigned int)*size);
     }
@@ -91,11 +104,7 @@ void Stream::writeLong(int64_t value) {
 
 void Stream::writeLongArray(const int64_t *data, size_t size) {
     if (m_byteOrder != m_hostByteOrder) {
-        int64_t *temp = new int64_t[size];
-        for (size_t i=0; i<size; ++i)
-            temp[i] = endianness_swap(data[i]);
-        write(temp, sizeof(int64_t)*size);
-        delete[] temp;
+        writeSwapped(this, data, size);
     } else {
         write(data, sizeof(int64_t)*size);
     }
@@ -109,11 +118,7 @@ void Stream::writeULong(uint64_t value) {
 
 void Stream::writeULongArray(const uint64_t *data, size_t size) {
     if (m_byteOrder != m_hostByteOrder) {
-        uint64_t *temp = new uint64_t[size];
-        for (size_t i=0; i<size; ++i)
-            temp[i] = endianness_swap(data[i]);
-        write(temp, sizeof(uint64_t)*size);
-        delete[] temp;
+        writeSwapped(this, data, size);
     } else {
         write(data, sizeof(uint64_t)*size);
     }
@@ -127,11 +132,7 @@ void Stream::writeShort(short value) {
 
 void Stream::writeShortArray(const short *data, size_t size) {
     if (m_byteOrder != m_hostByteOrder) {
-        short *temp = new short[size];
-        for (size_t i=0; i<size; ++i)
-            temp[i] = endianness_swap(data[i]);
-        write(temp, sizeof(short)*size);
-        delete[] temp;
+        writeSwapped(this, data, size);
     } else {
         write(data, sizeof(short)*size);
     }
@@ -145,11 +146,7 @@ void Stream::writeUShort(unsigned short value) {
 
 void Stream::writeUShortArray(const unsigned short *data, size_t size) {
     if (m_byteOrder != m_hostByteOrder) {
-        unsigned short *temp = new unsigned short[size];
-        for (size_t i=0; i<size; ++i)
-            temp[i] = endianness_swap(data[i]);
-        write(temp, sizeof(unsigned short)*size);
-        delete[] temp;
+        writeSwapped(this, data, size);
     } else {
         write(data, sizeof(unsigned short)*size);
     }
@@ -173,11 +170,7 @@ void Stream::writeHalf(half halfValue) {
 void Stream::writeHalfArray(const half *data, size_t size) {
     BOOST_STATIC_ASSERT(sizeof(half) == 2);
     if (m_byteOrder != m_hostByteOrder) {
-        short *temp = new short[size];
-        for (size_t i=0; i<size; ++i)
-            temp[i] = endianness_swap(data[i].bits());
-        write(temp, sizeof(short)*size);
-        delete[] temp;
+        writeSwapped(this, reinterpret_cast<const uint16_t *>(data), size);
     } else {
         write(data, sizeof(half)*size);
     }
@@ -191,11 +184,7 @@ void Stream::writeSingle(float value) {
 
 void Stream::writeSingleArray(const float *data, size_t size) {
     if (m_byteOrder != m_hostByteOrder) {
-        float *temp = new float[size];
-        for (size_t i=0; i<size; ++i)
-            temp[i] = endianness_swap(data[i]);
-        write(temp, sizeof(float)*size);
-        delete[] temp;
+        writeSwapped(this, data, size);
     } else {
         write(data, sizeof(float)*size);
     }
@@ -203,11 +192,7 @@ void Stream::writeSingleArray(const float *data, size_t size) {
 
 void Stream::writeDoubleArray(const double *data, size_t size) {
     if (m_byteOrder != m_hostByteOrder) {
-        double *temp = new double[size];
-        for (size_t i=0; i<size; ++i)
-            temp[i] = endianness_swap(data[i]);
-        write(temp, sizeof(double)*size);
-        delete[] temp;
+        writeSwapped(this, data, size);
     } else {
         write(data, sizeof(double)*size);
     }
@@ -17,6 +17,11 @@
 */
 
 #include <mitsuba/core/warp.h>
+#if MTS_SSE && defined(SINGLE_PRECISION)
+#include <mitsuba/core/warp_sse.h>
+#include <mitsuba/core/ssemath.h>
+#define MTS_WARP_SSE 1
+#endif
 
 MTS_NAMESPACE_BEGIN
 
@@ -175,6 +180,150 @@ Float intervalToNonuniformTent(Float a, Float b, Float c, Float sample) {
     return b + factor * (1-math::safe_sqrt(sample));
 }
 
+#if MTS_WARP_SSE
+namespace {
+    /// Load four 2D samples and convert them into SoA form
+    inline void load4(const Point2 *samples, __m128 &u, __m128 &v) {
+        __m128 a = _mm_loadu_ps(&samples[0].x),
+               b = _mm_loadu_ps(&samples[2].x);
+        u = _mm_shuffle_ps(a, b, _MM_SHUFFLE(2, 0, 2, 0));
+        v = _mm_shuffle_ps(a, b, _MM_SHUFFLE(3, 1, 3, 1));
+    }
+
+    /// Store four 2D points given in SoA form
+    inline void store4(Point2 *result, __m128 x, __m128 y) {
+        _mm_storeu_ps(&result[0].x, _mm_unpacklo_ps(x, y));
+        _mm_storeu_ps(&result[2].x, _mm_unpackhi_ps(x, y));
+    }
+
+    /// Store four 3D vectors given in SoA form
+    inline void store4(Vector *result, __m128 x, __m128 y, __m128 z) {
+        __m128 w = _mm_setzero_ps();
+        math::transpose_ps(x, y, z, w);
+        /* The 16-byte stores spill into the following entry,
+           which is subsequently overwritten */
+        _mm_storeu_ps(&result[0].x, x);
+        _mm_storeu_ps(&result[1].x, y);
+        _mm_storeu_ps(&result[2].x, z);
+        _mm_storel_pi((__m64 *) &result[3].x, w);
+        _mm_store_ss(&result[3].z, _mm_movehl_ps(w, w));
+    }
+};
+#endif
+
+void squareToUniformSphere(const Point2 *samples, Vector *result, size_t count) {
+    size_t i = 0;
+#if MTS_WARP_SSE
+    for (; i+4 <= count; i += 4) {
+        __m128 u, v, x, y, z;
+        load4(samples + i, u, v);
+        squareToUniformSphere4(u, v, x, y, z);
+        store4(result + i, x, y, z);
+    }
+#endif
+    for (; i<count; ++i)
+        result[i] = squareToUniformSphere(samples[i]);
+}
+
+void squareToUniformHemisphere(const Point2 *samples, Vector *result, size_t count) {
+    size_t i = 0;
+#if MTS_WARP_SSE
+    for (; i+4 <= count; i += 4) {
+        __m128 u, v, x, y, z;
+        load4(samples + i, u, v);
+        squareToUniformHemisphere4(u, v, x, y, z);
+        store4(result + i, x, y, z);
+    }
+#endif
+    for (; i<count; ++i)
+        result[i] = squareToUniformHemisphere(samples[i]);
+}
+
+void squareToCosineHemisphere(const Point2 *samples, Vector *result, size_t count) {
+    size_t i = 0;
+#if MTS_WARP_SSE
+    for (; i+4 <= count; i += 4) {
+        __m128 u, v, x, y, z;
+        load4(samples + i, u, v);
+        squareToCosineHemisphere4(u, v, x, y, z);
+        store4(result + i, x, y, z);
+    }
+#endif
+    for (; i<count; ++i)
+        result[i] = squareToCosineHemisphere(samples[i]);
+}
+
+void squareToUniformCone(Float cosCutoff, const Point2 *samples,
+        Vector *result, size_t count) {
+    size_t i = 0;
+#if MTS_WARP_SSE
+    for (; i+4 <= count; i += 4) {
+        __m128 u, v, x, y, z;
+        load4(samples + i, u, v);
+        squareToUniformCone4(cosCutoff, u, v, x, y, z);
+        store4(result + i, x, y, z);
+    }
+#endif
+    for (; i<count; ++i)
+        result[i] = squareToUniformCone(cosCutoff, samples[i]);
+}
+
+void squareToUniformDisk(const Point2 *samples, Point2 *result, size_t count) {
+    size_t i = 0;
+#if MTS_WARP_SSE
+    for (; i+4 <= count; i += 4) {
+        __m128 u, v, x, y;
+        load4(samples + i, u, v);
+        squareToUniformDisk4(u, v, x, y);
+        store4(result + i, x, y);
+    }
+#endif
+    for (; i<count; ++i)
+        result[i] = squareToUniformDisk(samples[i]);
+}
+
+void squareToUniformDiskConcentric(const Point2 *samples, Point2 *result, size_t count) {
+    size_t i = 0;
+#if MTS_WARP_SSE
+    for (; i+4 <= count; i += 4) {
+        __m128 u, v, x, y;
+        load4(samples + i, u, v);
+        squareToUniformDiskConcentric4(u, v, x, y);
+        store4(result + i, x, y);
+    }
+#endif
+    for (; i<count; ++i)
+        result[i] = squareToUniformDiskConcentric(samples[i]);
+}
+
+void squareToUniformTriangle(const Point2 *samples, Point2 *result, size_t count) {
+    size_t i = 0;
+#if MTS_WARP_SSE
+    for (; i+4 <= count; i += 4) {
+        __m128 u, v, x, y;
+        load4(samples + i, u, v);
+        squareToUniformTriangle4(u, v, x, y);
+        store4(result + i, x, y);
+    }
+#endif
+    for (; i<count; ++i)
+        result[i] = squareToUniformTriangle(samples[i]);
+}
+
+void squareToStdNormal(const Point2 *samples, Point2 *result, size_t count) {
+    size_t i = 0;
+#if MTS_WARP_SSE
+    for (; i+4 <= count; i += 4) {
+        __m128 u, v, x, y;
+        load4(samples + i, u, v);
+        squareToStdNormal4(u, v, x, y);
+        store4(result + i, x, y);
+    }
+#endif
+    for (; i<count; ++i)
+        result[i] = squareToStdNormal(samples[i]);
+}
+
 };
 
 MTS_NAMESPACE_END
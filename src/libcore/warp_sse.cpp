@@ -0,0 +1,147 @@
+/*
+    This file is part of Mitsuba, a physically based rendering system.
+
+    Copyright (c) 2007-2014 by Wenzel Jakob and others.
+
+    Mitsuba is free software; you can redistribute it and/or modify
+    it under the terms of the GNU General Public License Version 3
+    as published by the Free Software Foundation.
+
+    Mitsuba is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program. If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include <mitsuba/mitsuba.h>
+
+#if MTS_SSE
+
+#include <mitsuba/core/warp_sse.h>
+#include <mitsuba/core/ssemath.h>
+#include <mitsuba/core/ssevector.h>
+
+MTS_NAMESPACE_BEGIN
+
+namespace warp {
+
+typedef math::SSEVector4f V4f;
+
+namespace {
+    /// Square root of the argument clamped to zero (cf. \ref math::safe_sqrt)
+    inline V4f safe_sqrt(const V4f &x) {
+        return _mm_sqrt_ps(max(x, V4f::zero()));
+    }
+
+    /// Compute the sine and cosine of <tt>2 * pi * x</tt>
+    inline void sincos2pi(const V4f &x, __m128 &s, __m128 &c) {
+        math::sincos_ps(x * V4f((float) (2 * M_PI)), &s, &c);
+    }
+};
+
+void squareToUniformSphere4(__m128 u, __m128 v,
+        __m128 &x, __m128 &y, __m128 &z) {
+    const V4f one(1.0f);
+    V4f vz = one - V4f(2.0f) * V4f(v);
+    V4f r = safe_sqrt(one - vz*vz);
+    __m128 sinPhi, cosPhi;
+    sincos2pi(u, sinPhi, cosPhi);
+    x = r * V4f(cosPhi);
+    y = r * V4f(sinPhi);
+    z = vz;
+}
+
+void squareToUniformHemisphere4(__m128 u, __m128 v,
+        __m128 &x, __m128 &y, __m128 &z) {
+    V4f vz(u);
+    V4f tmp = safe_sqrt(V4f(1.0f) - vz*vz);
+    __m128 sinPhi, cosPhi;
+    sincos2pi(v, sinPhi, cosPhi);
+    x = tmp * V4f(cosPhi);
+    y = tmp * V4f(sinPhi);
+    z = vz;
+}
+
+void squareToCosineHemisphere4(__m128 u, __m128 v,
+        __m128 &x, __m128 &y, __m128 &z) {
+    __m128 px, py;
+    squareToUniformDiskConcentric4(u, v, px, py);
+    V4f vx(px), vy(py);
+    V4f vz = safe_sqrt(V4f(1.0f) - vx*vx - vy*vy);
+
+    /* Guard against numerical imprecisions */
+    vz = select(cmpeq(vz, V4f::zero()), V4f(1e-10f), vz);
+
+    x = vx; y = vy; z = vz;
+}
+
+void squareToUniformCone4(float cosCutoff, __m128 u, __m128 v,
+        __m128 &x, __m128 &y, __m128 &z) {
+    V4f vu(u);
+    V4f cosTheta = (V4f(1.0f) - vu) + vu * V4f(cosCutoff);
+    V4f sinTheta = safe_sqrt(V4f(1.0f) - cosTheta * cosTheta);
+    __m128 sinPhi, cosPhi;
+    sincos2pi(v, sinPhi, cosPhi);
+    x = V4f(cosPhi) * sinTheta;
+    y = V4f(sinPhi) * sinTheta;
+    z = cosTheta;
+}
+
+void squareToUniformDisk4(__m128 u, __m128 v, __m128 &x, __m128 &y) {
+    V4f r = _mm_sqrt_ps(u);
+    __m128 sinPhi, cosPhi;
+    sincos2pi(v, sinPhi, cosPhi);
+    x = V4f(cosPhi) * r;
+    y = V4f(sinPhi) * r;
+}
+
+void squareToUniformDiskConcentric4(__m128 u, __m128 v, __m128 &x, __m128 &y) {
+    const V4f one(1.0f), two(2.0f), zero(V4f::zero());
+    const V4f piOver4((float) (M_PI / 4)), piOver2((float) (M_PI / 2));
+
+    V4f r1 = two * V4f(u) - one;
+    V4f r2 = two * V4f(v) - one;
+
+    /* Branch-free version of the concentric map in warp.cpp. Both cases
+       are evaluated and blended; lanes where r1 == r2 == 0 are masked
+       out to avoid propagating the NaNs from the divisions below */
+    V4f firstCase = cmpgt(r1*r1, r2*r2);
+    V4f degenerate = cmpeq(r1, zero) & cmpeq(r2, zero);
+
+    V4f r = select(firstCase, r1, r2);
+    V4f phi = select(firstCase,
+        piOver4 * (r2 / r1),
+        piOver2 - (r1 / r2) * piOver4);
+    r = andnot(degenerate, r);
+    phi = andnot(degenerate, phi);
+
+    __m128 sinPhi, cosPhi;
+    math::sincos_ps(phi, &sinPhi, &cosPhi);
+    x = r * V4f(cosPhi);
+    y = r * V4f(sinPhi);
+}
+
+void squareToUniformTriangle4(__m128 u, __m128 v, __m128 &x, __m128 &y) {
+    const V4f one(1.0f);
+    V4f a = safe_sqrt(one - V4f(u));
+    x = one - a;
+    y = a * V4f(v);
+}
+
+void squareToStdNormal4(__m128 u, __m128 v, __m128 &x, __m128 &y) {
+    V4f r = _mm_sqrt_ps(V4f(-2.0f) *
+        V4f(math::fastlog_ps(V4f(1.0f) - V4f(u))));
+    __m128 sinPhi, cosPhi;
+    sincos2pi(v, sinPhi, cosPhi);
+    x = V4f(cosPhi) * r;
+    y = V4f(sinPhi) * r;
+}
+
+};
+
+MTS_NAMESPACE_END
+
+#endif /* MTS_SSE */
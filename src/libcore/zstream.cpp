@@ -72,7 +72,26 @@ void ZStream::truncate(size_t size) {
 }
 
 void ZStream::flush() {
-    Log(EError, "flush(): not implemented!");
+    if (m_didWrite) {
+        /* Emit all pending compressed data so that the receiving end
+           can decompress everything written so far (streaming mode) */
+        m_deflateStream.avail_in = 0;
+        m_deflateStream.next_in = NULL;
+
+        do {
+            m_deflateStream.avail_out = sizeof(m_deflateBuffer);
+            m_deflateStream.next_out = m_deflateBuffer;
+
+            int retval = deflate(&m_deflateStream, Z_SYNC_FLUSH);
+            if (retval == Z_STREAM_ERROR)
+                Log(EError, "deflate(): stream error!");
+
+            size_t outputSize = sizeof(m_deflateBuffer) - m_deflateStream.avail_out;
+            m_childStream->write(m_deflateBuffer, outputSize);
+        } while (m_deflateStream.avail_out == 0);
+    }
+
+    m_childStream->flush();
 }
 
 void ZStream::write(const void *ptr, size_t size) {
@@ -17,6 +17,7 @@
 */
 
 #include <mitsuba/hw/basicshader.h>
+#include <mitsuba/render/texgraph.h>
 
 MTS_NAMESPACE_BEGIN
 
@@ -72,6 +73,10 @@ ref<Bitmap> SpectrumProductTexture::getBitmap(const Vector2i &sizeHint) const {
     return Bitmap::arithmeticOperation(Bitmap::EMultiplication, bitmap1.get(), bitmap2.get());
 }
 
+int SpectrumProductTexture::compile(TextureProgram *program) const {
+    return program->multiply(program->compile(m_a.get()), program->compile(m_b.get()));
+}
+
 SpectrumAdditionTexture::SpectrumAdditionTexture(Stream *stream, InstanceManager *manager)
  : Texture(stream, manager) {
     m_a = static_cast<Texture *>(manager->getInstance(stream));
@@ -90,6 +95,10 @@ ref<Bitmap> SpectrumAdditionTexture::getBitmap(const Vector2i &sizeHint) const {
     return Bitmap::arithmeticOperation(Bitmap::EAddition, bitmap1.get(), bitmap2.get());
 }
 
+int SpectrumAdditionTexture::compile(TextureProgram *program) const {
+    return program->add(program->compile(m_a.get()), program->compile(m_b.get()));
+}
+
 SpectrumSubtractionTexture::SpectrumSubtractionTexture(Stream *stream, InstanceManager *manager)
  : Texture(stream, manager) {
     m_a = static_cast<Texture *>(manager->getInstance(stream));
@@ -108,6 +117,10 @@ ref<Bitmap> SpectrumSubtractionTexture::getBitmap(const Vector2i &sizeHint) cons
     return Bitmap::arithmeticOperation(Bitmap::ESubtraction, bitmap1.get(), bitmap2.get());
 }
 
+int SpectrumSubtractionTexture::compile(TextureProgram *program) const {
+    return program->subtract(program->compile(m_a.get()), program->compile(m_b.get()));
+}
+
 class ConstantSpectrumTextureShader : public Shader {
 public:
     ConstantSpectrumTextureShader(Renderer *renderer, const Spectrum &value)
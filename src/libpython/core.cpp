@@ -10,6 +10,7 @@
 #include <mitsuba/core/properties.h>
 #include <mitsuba/core/appender.h>
 #include <mitsuba/core/bitmap.h>
+#include <mitsuba/core/simdtonemap.h>
 #include <mitsuba/core/random.h>
 #include <mitsuba/core/aabb.h>
 #include <mitsuba/core/frame.h>
@@ -732,6 +733,16 @@ static bp::dict bitmap_split(Bitmap *bitmap) {
     return result;
 }
 
+static bp::dict statistics_getMemoryUsage(Statistics *stats) {
+    std::vector<const MemoryCounter *> counters = stats->getMemoryCounters();
+    counters.push_back(stats->getTotalMemory());
+    bp::dict result;
+    for (size_t i=0; i<counters.size(); ++i)
+        result[counters[i]->getName()] = bp::make_tuple(
+            counters[i]->getCurrent(), counters[i]->getPeak());
+    return result;
+}
+
 static bp::object bitmap_plot(Bitmap *_bitmap) {
     bp::dict locals;
     locals["bitmap"] = ref<Bitmap>(_bitmap);
@@ -781,6 +792,13 @@ static bp::tuple bitmap_tonemapReinhard(Bitmap *bitmap, Float logAvgLuminance, F
     return bp::make_tuple(logAvgLuminance, maxLuminance);
 }
 
+static bp::tuple bitmap_develop(Bitmap *bitmap, Bitmap::EPixelFormat fmt, Float gamma, Float multiplier,
+        Float key, Float burn, Float logAvgLuminance, Float maxLuminance) {
+    ref<Bitmap> result = TonemapCPU::develop(bitmap, fmt, gamma, multiplier,
+        key, burn, logAvgLuminance, maxLuminance);
+    return bp::make_tuple(result, logAvgLuminance, maxLuminance);
+}
+
 static bp::object bitmap_join(Bitmap::EPixelFormat fmt, bp::list list) {
     std::vector<Bitmap *> bitmaps(bp::len(list));
 
@@ -892,146 +910,6 @@ static bp::tuple gaussLobatto_(int n) {
  */
 extern MTS_EXPORT_CORE void gaussLobatto(int n, Float *nodes, Float *weights);
 
-struct NativeBuffer {
-    ref<Object> owner;
-    void *ptr;
-    Bitmap::EComponentFormat format;
-    int ndim;
-    Py_ssize_t shape[3], strides[4];
-    const char* formatString;
-
-    NativeBuffer(Object *owner, void *ptr, Bitmap::EComponentFormat format, int ndim,
-            Py_ssize_t shape[3]) : owner(owner), ptr(ptr), format(format), ndim(ndim) {
-        size_t itemSize = 0;
-        switch (format) {
-            case Bitmap::EUInt8:   formatString = "B"; itemSize = 1; break;
-            case Bitmap::EUInt16:  formatString = "H"; itemSize = 2; break;
-            case Bitmap::EUInt32:  formatString = "I"; itemSize = 4; break;
-            case Bitmap::EFloat16: formatString = "e"; itemSize = 2; break;
-            case Bitmap::EFloat32: formatString = "f"; itemSize = 4; break;
-            case Bitmap::EFloat64: formatString = "d"; itemSize = 8; break;
-            default:
-                SLog(EError, "Unsupported bufer format!");
-        }
-        strides[ndim] = itemSize;
-
-        for (int i=ndim-1; i>=0; --i) {
-            this->shape[i] = shape[i];
-            strides[i] = strides[i+1] * shape[i];
-        }
-    }
-
-    std::string toString() const {
-        std::ostringstream oss;
-        oss << "NativeBuffer[ndim=" << ndim << ", shape=[";
-        for (int i=0; i<ndim; ++i) {
-            oss << shape[i];
-            if (i+1 < ndim)
-                oss << ", ";
-        }
-        oss << "], strides=[";
-        for (int i=0; i<=ndim; ++i) {
-            oss << strides[i];
-            if (i+1 <= ndim)
-                oss << ", ";
-        }
-        oss << "], format=" << format << ", size=" << memString(strides[0]) << "]";
-        return oss.str();
-    }
-
-    static int getbuffer(PyObject *obj, Py_buffer *view, int flags) {
-        bp::extract<NativeBuffer&> b(obj);
-        if (!b.check()) {
-            PyErr_SetString(PyExc_BufferError, "Native buffer is invalid!");
-            view->obj = NULL;
-            return -1;
-        }
-        NativeBuffer &buf = b();
-
-        if (!buf.ptr) {
-            PyErr_SetString(PyExc_BufferError, "Native buffer does not point anywhere!");
-            view->obj = NULL;
-            return -1;
-        }
-
-        if (view == NULL)
-            return 0;
-
-        view->obj = obj;
-        if (view->obj)
-            Py_INCREF(view->obj);
-        buf.owner->incRef();
-
-        view->ndim = 1;
-        view->buf = buf.ptr;
-        view->format = NULL;
-        view->shape = NULL;
-        view->suboffsets = NULL;
-        view->internal = NULL;
-        view->strides = NULL;
-        view->len = buf.strides[0];
-        view->readonly = false;
-        view->itemsize = buf.strides[buf.ndim];
-
-        if ((flags & PyBUF_FORMAT) == PyBUF_FORMAT)
-            view->format = const_cast<char *>(buf.formatString);
-
-        if ((flags & PyBUF_STRIDES) == PyBUF_STRIDES)
-            view->strides = &buf.strides[1];
-
-        if ((flags & PyBUF_ND) == PyBUF_ND) {
-            view->ndim = buf.ndim;
-            view->shape = &buf.shape[0];
-        }
-
-        return 0;
-    }
-
-    static void releasebuffer(PyObject *obj, Py_buffer *view) {
-        bp::extract<NativeBuffer&> b(obj);
-        if (!b.check()) {
-            PyErr_SetString(PyExc_BufferError, "Native buffer is invalid!");
-            return;
-        }
-        NativeBuffer &buf = b();
-        buf.owner->decRef();
-    }
-
-    static Py_ssize_t len(PyObject *obj) {
-        bp::extract<NativeBuffer&> b(obj);
-        if (!b.check()) {
-            PyErr_SetString(PyExc_BufferError, "Native buffer is invalid!");
-            return -1;
-        }
-        NativeBuffer &buf = b();
-        return buf.strides[0] / buf.strides[buf.ndim];
-    }
-
-    static PyObject* item(PyObject *obj, Py_ssize_t idx) {
-        bp::extract<NativeBuffer&> b(obj);
-        if (!b.check()) {
-            PyErr_SetString(PyExc_BufferError, "Native buffer is invalid!");
-            return 0;
-        }
-        NativeBuffer &buf = b();
-
-        bp::object result;
-        switch (buf.format) {
-            case Bitmap::EUInt8:   result = bp::object(((uint8_t *) buf.ptr)[idx]); break;
-            case Bitmap::EUInt16:  result = bp::object(((uint16_t *) buf.ptr)[idx]); break;
-            case Bitmap::EUInt32:  result = bp::object(((uint32_t *) buf.ptr)[idx]); break;
-            case Bitmap::EFloat16: result = bp::object((float) ((half *) buf.ptr)[idx]); break;
-            case Bitmap::EFloat32: result = bp::object(((float *) buf.ptr)[idx]); break;
-            case Bitmap::EFloat64: result = bp::object(((double *) buf.ptr)[idx]); break;
-            default:
-                PyErr_SetString(PyExc_BufferError, "Unsupported buffer format!");
-                return 0;
-        }
-
-        return bp::incref(result.ptr());
-    }
-};
-
 static NativeBuffer bitmap_buffer(Bitmap *bitmap) {
     int ndim = bitmap->getChannelCount() == 1 ? 2 : 3;
     Py_ssize_t shape[3] = {
@@ -1544,6 +1422,7 @@ void export_core() {
         .def("write", &bitmap_write5)
         .def("write", &bitmap_write6)
         .def("tonemapReinhard", &bitmap_tonemapReinhard)
+        .def("develop", &bitmap_develop)
         .def("expand", &Bitmap::expand, BP_RETURN_VALUE)
         .def("extractChannel", &Bitmap::extractChannel, BP_RETURN_VALUE)
         .def("extractChannels", bitmap_extractChannels, BP_RETURN_VALUE)
@@ -1730,6 +1609,8 @@ void export_core() {
         .def("getStats", &Statistics::getStats, BP_RETURN_VALUE)
         .def("resetAll", &Statistics::resetAll)
         .def("printStats", &Statistics::printStats)
+        .def("getMemoryStats", &Statistics::getMemoryStats, BP_RETURN_VALUE)
+        .def("getMemoryUsage", statistics_getMemoryUsage)
         .def("getInstance", &Statistics::getInstance, BP_RETURN_VALUE)
         .staticmethod("getInstance");
 
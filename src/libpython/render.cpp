@@ -4,8 +4,13 @@
 #include <mitsuba/render/renderqueue.h>
 #include <mitsuba/render/renderjob.h>
 #include <mitsuba/render/noise.h>
+#include <mitsuba/core/sched.h>
 #include "../shapes/instance.h"
 
+#if defined(MTS_OPENMP)
+# include <omp.h>
+#endif
+
 using namespace mitsuba;
 
 static bool intersection_get_hasUVPartials(const Intersection &its) { return its.hasUVPartials;  }
@@ -96,6 +101,230 @@ static bp::object shape_rayIntersect(const Shape *shape, const Ray &ray, Float m
     return bp::object(its);
 }
 
+/**
+ * Read-only access to a contiguous array of shape (N, dim) (or (N) when
+ * dim == 1) holding single or double precision values, e.g. a NumPy array
+ */
+class RayQueryArray {
+public:
+    RayQueryArray(bp::object obj, int dim, const char *name) : m_dim(dim) {
+        if (PyObject_GetBuffer(obj.ptr(), &m_buffer, PyBUF_CONTIG_RO | PyBUF_FORMAT)) {
+            PyErr_Clear();
+            SLog(EError, "Could not access the argument \"%s\" using the buffer protocol!", name);
+        }
+
+        const char *format = m_buffer.format;
+        if (strlen(format) == 2 && (format[0] == '@' || format[0] == '=' || format[0] == '<'))
+            ++format;
+        bool validShape = dim == 1 ? m_buffer.ndim == 1 :
+            (m_buffer.ndim == 2 && m_buffer.shape[1] == dim);
+        if (strlen(format) != 1 || (format[0] != 'f' && format[0] != 'd') || !validShape) {
+            PyBuffer_Release(&m_buffer);
+            if (dim == 1)
+                SLog(EError, "The argument \"%s\" must be a one-dimensional float32/float64 array!", name);
+            else
+                SLog(EError, "The argument \"%s\" must be a float32/float64 array of "
+                    "shape (N, %i)!", name, dim);
+        }
+        m_double = format[0] == 'd';
+        m_size = (size_t) m_buffer.shape[0];
+    }
+
+    ~RayQueryArray() {
+        PyBuffer_Release(&m_buffer);
+    }
+
+    inline size_t getSize() const { return m_size; }
+
+    inline Float get(size_t i, int j = 0) const {
+        size_t idx = i * m_dim + j;
+        if (m_double)
+            return (Float) static_cast<const double *>(m_buffer.buf)[idx];
+        else
+            return (Float) static_cast<const float *>(m_buffer.buf)[idx];
+    }
+private:
+    Py_buffer m_buffer;
+    size_t m_size;
+    int m_dim;
+    bool m_double;
+};
+
+/// Allocate an output array of shape (N, dim) (or (N) when dim == 1)
+template <typename T> static NativeBuffer rayQuery_output(
+        Bitmap::EComponentFormat format, size_t size, int dim, T *&ptr) {
+    ref<Bitmap> storage = new Bitmap(dim == 1 ? Bitmap::ELuminance : Bitmap::EMultiChannel,
+        format, Vector2i((int) size, 1), dim);
+    ptr = reinterpret_cast<T *>(storage->getData());
+    Py_ssize_t shape[3] = { (Py_ssize_t) size, (Py_ssize_t) dim, 1 };
+    return NativeBuffer(storage, ptr, format, dim == 1 ? 1 : 2, shape);
+}
+
+/// Use OpenMP worker threads matching the number of local scheduler cores
+static void rayQuery_initializeThreads() {
+#if defined(MTS_OPENMP)
+    Scheduler *sched = Scheduler::getInstance();
+    size_t coreCount = sched->getLocalWorkerCount();
+    Thread::initializeOpenMP(coreCount > 0 ? coreCount : (size_t) getCoreCount());
+#endif
+}
+
+/**
+ * Trace a batch of rays given as arrays of origins and directions and return
+ * a dictionary of arrays: the hit distance ("t", infinite when there is no
+ * hit), hit position ("p"), shading normal ("n"), UV coordinates ("uv"),
+ * primitive index ("primIndex") and index of the shape in
+ * ShapeKDTree.getShapes() ("shapeIndex", 0xFFFFFFFF when there is no hit
+ * or the shape is part of an instance). The GIL is released while the rays
+ * are traced in parallel.
+ */
+static bp::dict shapekdtree_rayIntersectBatch(const ShapeKDTree *kdtree,
+        bp::object _origins, bp::object _directions, bp::object _maxt) {
+    RayQueryArray origins(_origins, 3, "origins"), directions(_directions, 3, "directions");
+    size_t count = origins.getSize();
+    if (directions.getSize() != count)
+        SLog(EError, "rayIntersectBatch(): the origin and direction arrays have different sizes!");
+
+    Float maxtValue = std::numeric_limits<Float>::infinity();
+    boost::scoped_ptr<RayQueryArray> maxt;
+    bp::extract<Float> extractMaxt(_maxt);
+    if (_maxt.ptr() == Py_None)
+        ;
+    else if (extractMaxt.check())
+        maxtValue = extractMaxt();
+    else
+        maxt.reset(new RayQueryArray(_maxt, 1, "maxt"));
+    if (maxt && maxt->getSize() != count)
+        SLog(EError, "rayIntersectBatch(): the 'maxt' array has the wrong size!");
+
+    Float *t, *p, *n, *uv;
+    uint32_t *primIndex, *shapeIndex;
+    bp::dict result;
+    result["t"] = rayQuery_output(Bitmap::EFloat, count, 1, t);
+    result["p"] = rayQuery_output(Bitmap::EFloat, count, 3, p);
+    result["n"] = rayQuery_output(Bitmap::EFloat, count, 3, n);
+    result["uv"] = rayQuery_output(Bitmap::EFloat, count, 2, uv);
+    result["primIndex"] = rayQuery_output(Bitmap::EUInt32, count, 1, primIndex);
+    result["shapeIndex"] = rayQuery_output(Bitmap::EUInt32, count, 1, shapeIndex);
+
+    const std::vector<const Shape *> &shapes = kdtree->getShapes();
+    std::map<const Shape *, uint32_t> shapeMap;
+    for (size_t i=0; i<shapes.size(); ++i)
+        shapeMap[shapes[i]] = (uint32_t) i;
+
+    rayQuery_initializeThreads();
+
+    {
+        ReleaseGIL gil;
+
+        #if defined(MTS_OPENMP)
+            #pragma omp parallel for schedule(dynamic, 256)
+        #endif
+        for (int i=0; i<(int) count; ++i) {
+            Ray ray(Point(origins.get(i, 0), origins.get(i, 1), origins.get(i, 2)),
+                Vector(directions.get(i, 0), directions.get(i, 1), directions.get(i, 2)), 0.0f);
+            ray.maxt = maxt ? maxt->get(i) : maxtValue;
+
+            Intersection its;
+            if (ray.maxt > ray.mint && kdtree->rayIntersect(ray, its)) {
+                std::map<const Shape *, uint32_t>::const_iterator it = shapeMap.find(its.shape);
+                t[i] = its.t;
+                for (int j=0; j<3; ++j) {
+                    p[3*i+j] = its.p[j];
+                    n[3*i+j] = its.shFrame.n[j];
+                }
+                uv[2*i] = its.uv.x;
+                uv[2*i+1] = its.uv.y;
+                primIndex[i] = its.primIndex;
+                shapeIndex[i] = it != shapeMap.end() ? it->second : 0xFFFFFFFFU;
+            } else {
+                t[i] = std::numeric_limits<Float>::infinity();
+                for (int j=0; j<3; ++j)
+                    p[3*i+j] = n[3*i+j] = 0.0f;
+                uv[2*i] = uv[2*i+1] = 0.0f;
+                primIndex[i] = shapeIndex[i] = 0xFFFFFFFFU;
+            }
+        }
+    }
+
+    return result;
+}
+
+static bp::dict shapekdtree_rayIntersectBatch_2(const ShapeKDTree *kdtree,
+        bp::object origins, bp::object directions) {
+    return shapekdtree_rayIntersectBatch(kdtree, origins, directions, bp::object());
+}
+
+/**
+ * Occlusion queries for a batch of rays, returns an array containing
+ * 1 for every ray that hits something within [Epsilon, maxt], and 0 otherwise
+ */
+static NativeBuffer shapekdtree_rayOccludedBatch(const ShapeKDTree *kdtree,
+        bp::object _origins, bp::object _directions, bp::object _maxt) {
+    RayQueryArray origins(_origins, 3, "origins"), directions(_directions, 3, "directions");
+    size_t count = origins.getSize();
+    if (directions.getSize() != count)
+        SLog(EError, "rayOccludedBatch(): the origin and direction arrays have different sizes!");
+
+    Float maxtValue = std::numeric_limits<Float>::infinity();
+    boost::scoped_ptr<RayQueryArray> maxt;
+    bp::extract<Float> extractMaxt(_maxt);
+    if (_maxt.ptr() == Py_None)
+        ;
+    else if (extractMaxt.check())
+        maxtValue = extractMaxt();
+    else
+        maxt.reset(new RayQueryArray(_maxt, 1, "maxt"));
+    if (maxt && maxt->getSize() != count)
+        SLog(EError, "rayOccludedBatch(): the 'maxt' array has the wrong size!");
+
+    uint8_t *occluded;
+    NativeBuffer result = rayQuery_output(Bitmap::EUInt8, count, 1, occluded);
+
+    rayQuery_initializeThreads();
+
+    {
+        ReleaseGIL gil;
+
+        #if defined(MTS_OPENMP)
+            #pragma omp parallel for schedule(dynamic, 256)
+        #endif
+        for (int i=0; i<(int) count; ++i) {
+            Ray ray(Point(origins.get(i, 0), origins.get(i, 1), origins.get(i, 2)),
+                Vector(directions.get(i, 0), directions.get(i, 1), directions.get(i, 2)), 0.0f);
+            ray.maxt = maxt ? maxt->get(i) : maxtValue;
+            occluded[i] = (ray.maxt > ray.mint && kdtree->rayIntersect(ray)) ? 1 : 0;
+        }
+    }
+
+    return result;
+}
+
+static NativeBuffer shapekdtree_rayOccludedBatch_2(const ShapeKDTree *kdtree,
+        bp::object origins, bp::object directions) {
+    return shapekdtree_rayOccludedBatch(kdtree, origins, directions, bp::object());
+}
+
+static bp::dict scene_rayIntersectBatch(const Scene *scene,
+        bp::object origins, bp::object directions, bp::object maxt) {
+    return shapekdtree_rayIntersectBatch(scene->getKDTree(), origins, directions, maxt);
+}
+
+static bp::dict scene_rayIntersectBatch_2(const Scene *scene,
+        bp::object origins, bp::object directions) {
+    return shapekdtree_rayIntersectBatch(scene->getKDTree(), origins, directions, bp::object());
+}
+
+static NativeBuffer scene_rayOccludedBatch(const Scene *scene,
+        bp::object origins, bp::object directions, bp::object maxt) {
+    return shapekdtree_rayOccludedBatch(scene->getKDTree(), origins, directions, maxt);
+}
+
+static NativeBuffer scene_rayOccludedBatch_2(const Scene *scene,
+        bp::object origins, bp::object directions) {
+    return shapekdtree_rayOccludedBatch(scene->getKDTree(), origins, directions, bp::object());
+}
+
 static bp::object scene_rayIntersect(const Scene *scene, const Ray &ray) {
     Intersection its;
 
@@ -349,7 +578,11 @@ void export_render() {
         .def("isBuilt", &shapekdtree_isBuilt)
         .def("getAABB", &shapekdtree_getAABB, BP_RETURN_VALUE)
         .def("getShapes", &shapekdtree_getShapes)
-        .def("rayIntersect", &shapekdtree_rayIntersect);
+        .def("rayIntersect", &shapekdtree_rayIntersect)
+        .def("rayIntersectBatch", &shapekdtree_rayIntersectBatch)
+        .def("rayIntersectBatch", &shapekdtree_rayIntersectBatch_2)
+        .def("rayOccludedBatch", &shapekdtree_rayOccludedBatch)
+        .def("rayOccludedBatch", &shapekdtree_rayOccludedBatch_2);
 
     Sampler *(Scene::*scene_getSampler)(void) = &Scene::getSampler;
     Film *(Scene::*scene_getFilm)(void) = &Scene::getFilm;
@@ -368,6 +601,10 @@ void export_render() {
         .def("cancel", scene_cancel)
         .def("rayIntersect", &scene_rayIntersect)
         .def("rayIntersectAll", &scene_rayIntersectAll)
+        .def("rayIntersectBatch", &scene_rayIntersectBatch)
+        .def("rayIntersectBatch", &scene_rayIntersectBatch_2)
+        .def("rayOccludedBatch", &scene_rayOccludedBatch)
+        .def("rayOccludedBatch", &scene_rayOccludedBatch_2)
         .def("evalTransmittance", &Scene::evalTransmittance)
         .def("evalTransmittanceAll", &Scene::evalTransmittanceAll)
         .def("sampleEmitterDirect", &Scene::sampleEmitterDirect)
@@ -456,6 +693,7 @@ void export_render() {
         .def_readwrite("dudy", &Intersection::dudy)
         .def_readwrite("dvdx", &Intersection::dvdx)
         .def_readwrite("dvdy", &Intersection::dvdy)
+        .def_readwrite("uvFootprint", &Intersection::uvFootprint)
         .def_readwrite("time", &Intersection::time)
         .def_readwrite("color", &Intersection::color)
         .def_readwrite("wi", &Intersection::wi)
@@ -573,6 +811,8 @@ void export_render() {
         .def("getUVTangents", trimesh_getUVTangents, BP_RETURN_VALUE)
         .def("computeUVTangents", &TriMesh::computeUVTangents)
         .def("computeNormals", &TriMesh::computeNormals)
+        .def("hasVertexCurvatures", &TriMesh::hasVertexCurvatures)
+        .def("computeCurvature", &TriMesh::computeCurvature)
         .def("rebuildTopology", &TriMesh::rebuildTopology)
         .def("serialize", triMesh_serialize1)
         .def("serialize", triMesh_serialize2)
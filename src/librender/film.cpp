@@ -52,6 +52,7 @@ Film::Film(const Properties &props)
        quality at the edges especially with large reconstruction
        filters. */
     m_highQualityEdges = props.getBoolean("highQualityEdges", false);
+    m_hasRegions = false;
 }
 
 Film::Film(Stream *stream, InstanceManager *manager)
@@ -61,6 +62,7 @@ Film::Film(Stream *stream, InstanceManager *manager)
     m_cropSize = Vector2i(stream);
     m_highQualityEdges = stream->readBool();
     m_filter = static_cast<ReconstructionFilter *>(manager->getInstance(stream));
+    m_hasRegions = false;
 }
 
 Film::~Film() { }
@@ -95,5 +97,69 @@ void Film::configure() {
     }
 }
 
+void Film::setRegions(const std::vector<Region> &regions, Bitmap *base) {
+    m_regions.clear();
+    m_regionBase = NULL;
+    m_hasRegions = !regions.empty();
+    if (!m_hasRegions)
+        return;
+
+    for (size_t i=0; i<regions.size(); ++i) {
+        Point2i min(
+            std::max(regions[i].offset.x, 0),
+            std::max(regions[i].offset.y, 0));
+        Point2i max(
+            std::min(regions[i].offset.x + regions[i].size.x, m_cropSize.x),
+            std::min(regions[i].offset.y + regions[i].size.y, m_cropSize.y));
+        if (max.x > min.x && max.y > min.y)
+            m_regions.push_back(Region(min, max - min));
+    }
+
+    if (base) {
+        if (base->getSize() == m_size && m_size != m_cropSize)
+            m_regionBase = base->crop(m_cropOffset, m_cropSize);
+        else if (base->getSize() == m_cropSize)
+            m_regionBase = base;
+        else
+            Log(EError, "The base image has the wrong size (%s, expected %s)!",
+                base->getSize().toString().c_str(), m_cropSize.toString().c_str());
+    }
+}
+
+bool Film::isDirty(const Point2i &offset, const Vector2i &size) const {
+    if (!m_hasRegions)
+        return true;
+    for (size_t i=0; i<m_regions.size(); ++i) {
+        if (m_regions[i].overlaps(offset, size))
+            return true;
+    }
+    return false;
+}
+
+ref<Bitmap> Film::compositeRegions(Bitmap *bitmap) const {
+    if (!m_regionBase)
+        return bitmap;
+
+    if (m_regionBase->getChannelCount() != bitmap->getChannelCount() &&
+        (m_regionBase->getPixelFormat() == Bitmap::EMultiChannel ||
+         bitmap->getPixelFormat() == Bitmap::EMultiChannel))
+        Log(EError, "The base image has %i channels, but the film produces %i!",
+            m_regionBase->getChannelCount(), bitmap->getChannelCount());
+
+    ref<Bitmap> result = new Bitmap(bitmap->getPixelFormat(),
+        bitmap->getComponentFormat(), bitmap->getSize(),
+        bitmap->getChannelCount());
+    result->setGamma(bitmap->getGamma());
+    m_regionBase->convert(result);
+    result->setChannelNames(bitmap->getChannelNames());
+    result->setMetadata(bitmap->getMetadata());
+
+    for (size_t i=0; i<m_regions.size(); ++i)
+        result->copyFrom(bitmap, m_regions[i].offset,
+            m_regions[i].offset, m_regions[i].size);
+
+    return result;
+}
+
 MTS_IMPLEMENT_CLASS(Film, true, ConfigurableObject)
 MTS_NAMESPACE_END
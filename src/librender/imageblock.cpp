@@ -20,6 +20,10 @@
 
 MTS_NAMESPACE_BEGIN
 
+namespace stats {
+    MemoryCounter imageBlockMemory("Image blocks and film storage");
+};
+
 ImageBlock::ImageBlock(Bitmap::EPixelFormat fmt, const Vector2i &size,
         const ReconstructionFilter *filter, int channels, bool warn) : m_offset(0),
         m_size(size), m_filter(filter), m_weightsX(NULL), m_weightsY(NULL), m_warn(warn) {
@@ -28,6 +32,7 @@ ImageBlock::ImageBlock(Bitmap::EPixelFormat fmt, const Vector2i &size,
     /* Allocate a small bitmap data structure for the block */
     m_bitmap = new Bitmap(fmt, Bitmap::EFloat,
         size + Vector2i(2 * m_borderSize), channels);
+    stats::imageBlockMemory.allocate(m_bitmap->getBufferSize());
 
     if (filter) {
         /* Temporary buffers used in put() */
@@ -38,6 +43,7 @@ ImageBlock::ImageBlock(Bitmap::EPixelFormat fmt, const Vector2i &size,
 }
 
 ImageBlock::~ImageBlock() {
+    stats::imageBlockMemory.release(m_bitmap->getBufferSize());
     if (m_weightsX)
         delete[] m_weightsX;
 }
@@ -38,6 +38,14 @@ void BlockedImageProcess::init(const Point2i &offset, const Vector2i &size, uint
     m_curBlock = Point2i(m_numBlocks / 2);
     m_stepsLeft = 1;
     m_numSteps = 1;
+    m_blockMask.clear();
+}
+
+void BlockedImageProcess::setBlockMask(const std::vector<bool> &mask) {
+    Assert(mask.empty() || mask.size() == (size_t) (m_numBlocks.x * m_numBlocks.y));
+    m_blockMask = mask;
+    m_numBlocksTotal = mask.empty() ? (m_numBlocks.x * m_numBlocks.y)
+        : (int) std::count(mask.begin(), mask.end(), true);
 }
 
 ParallelProcess::EStatus BlockedImageProcess::generateWork(WorkUnit *unit, int worker) {
@@ -47,6 +55,12 @@ ParallelProcess::EStatus BlockedImageProcess::generateWork(WorkUnit *unit, int w
     if (m_numBlocksTotal == m_numBlocksGenerated)
         return EFailure;
 
+    /* Skip blocks that were masked out */
+    if (!m_blockMask.empty()) {
+        while (!m_blockMask[m_curBlock.x + m_curBlock.y * m_numBlocks.x])
+            nextBlock();
+    }
+
     Point2i pos = m_curBlock * m_blockSize;
     rect.setOffset(pos + m_offset);
     rect.setSize(Vector2i(
@@ -56,6 +70,12 @@ ParallelProcess::EStatus BlockedImageProcess::generateWork(WorkUnit *unit, int w
     if (++m_numBlocksGenerated == m_numBlocksTotal)
         return ESuccess;
 
+    nextBlock();
+
+    return ESuccess;
+}
+
+void BlockedImageProcess::nextBlock() {
     do {
         switch (m_direction) {
             case ERight: ++m_curBlock.x; break;
@@ -73,8 +93,6 @@ ParallelProcess::EStatus BlockedImageProcess::generateWork(WorkUnit *unit, int w
     } while (m_curBlock.x < 0 || m_curBlock.y < 0
         || m_curBlock.x >= m_numBlocks.x
         || m_curBlock.y >= m_numBlocks.y);
-
-    return ESuccess;
 }
 
 MTS_IMPLEMENT_CLASS(BlockedImageProcess, true, ParallelProcess)
@@ -75,6 +75,22 @@ void Intersection::computePartials(const RayDifferential &ray) {
     }
 }
 
+void Intersection::computeFootprint(const RayCone &cone) {
+    Float width = cone.getWidth(t),
+          area = cross(dpdu, dpdv).length();
+
+    if (!(width > 0) || area == 0) {
+        uvFootprint = 0.0f;
+        return;
+    }
+
+    /* The footprint is stretched by 1/cos(theta) on the surface. Limit
+       this at grazing angles, where it would mostly cause overblurring */
+    Float cosTheta = std::max(std::abs(Frame::cosTheta(wi)), (Float) 0.1f);
+
+    uvFootprint = width / std::sqrt(area * cosTheta);
+}
+
 std::string Intersection::toString() const {
     if (!isValid())
         return "Intersection[invalid]";
@@ -92,6 +108,8 @@ std::string Intersection::toString() const {
     if (hasUVPartials) {
         oss << "  dud[x,y] = [" << dudx << ", " << dudy << "]," << endl
             << "  dvd[x,y] = [" << dvdx << ", " << dvdy << "]," << endl;
+    } else if (uvFootprint > 0) {
+        oss << "  uvFootprint = " << uvFootprint << "," << endl;
     }
     oss << "  time = " << time << "," << endl
         << "  shape = " << indent(((Object *)shape)->toString()) << endl
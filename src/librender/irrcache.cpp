@@ -21,6 +21,8 @@
 
 MTS_NAMESPACE_BEGIN
 
+static MemoryCounter irradMemory("Irradiance cache");
+
 HemisphereSampler::HemisphereSampler(uint32_t M, uint32_t N) : m_M(M), m_N(N) {
     m_entries = new SampleEntry[m_M*m_N];
     m_uk = new Vector[m_N];
@@ -249,11 +251,13 @@ IrradianceCache::IrradianceCache(Stream *stream, InstanceManager *manager) :
         ));
         m_records.push_back(sample);
     }
+    irradMemory.allocate(recordCount * sizeof(Record));
 }
 
 IrradianceCache::~IrradianceCache() {
     for (size_t i=0; i<m_records.size(); ++i)
         delete m_records[i];
+    irradMemory.release(m_records.size() * sizeof(Record));
 }
 
 void IrradianceCache::serialize(Stream *stream, InstanceManager *manager) const {
@@ -350,6 +354,7 @@ void IrradianceCache::insert(Record *record) {
     ));
     LockGuard lock(m_mutex);
     m_records.push_back(record);
+    irradMemory.allocate(sizeof(Record));
 }
 
 static StatsCounter irradHits("Irradiance cache", "Hits");
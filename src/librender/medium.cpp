@@ -56,6 +56,12 @@ void Medium::addChild(const std::string &name, ConfigurableObject *child) {
     }
 }
 
+void Medium::evalTransmittanceBatch(const Ray *rays, size_t count,
+        Spectrum *result, Sampler *sampler) const {
+    for (size_t i=0; i<count; ++i)
+        result[i] = evalTransmittance(rays[i], sampler);
+}
+
 void Medium::configure() {
     if (m_phaseFunction == NULL) {
         m_phaseFunction = static_cast<PhaseFunction *> (PluginManager::getInstance()->
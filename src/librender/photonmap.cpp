@@ -23,9 +23,90 @@
 
 MTS_NAMESPACE_BEGIN
 
+namespace stats {
+    MemoryCounter photonMapMemory("Photon maps");
+};
+
+/* Number of photons that are packed into a buffer before
+   being written to (or after being read from) a stream */
+#define PHOTON_CHUNK_SIZE 4096
+
+/* Size of a photon record as written by Photon::serialize() */
+static const size_t photonRecordSize = 3 * sizeof(Float)
+    + (Photon::leftBalancedLayout ? 0 : sizeof(uint32_t))
+#if defined(SINGLE_PRECISION) && SPECTRUM_SAMPLES == 3
+    + 8
+#else
+    + SPECTRUM_SAMPLES * sizeof(Float) + 4
+#endif
+    + sizeof(uint16_t) + sizeof(uint8_t);
+
+namespace {
+    template <typename T> inline void pack(uint8_t *&ptr, T value, bool swap) {
+        if (swap)
+            value = endianness_swap(value);
+        memcpy(ptr, &value, sizeof(T));
+        ptr += sizeof(T);
+    }
+
+    template <typename T> inline T unpack(const uint8_t *&ptr, bool swap) {
+        T value;
+        memcpy(&value, ptr, sizeof(T));
+        ptr += sizeof(T);
+        return swap ? endianness_swap(value) : value;
+    }
+
+    /* Binary layout must match Photon::serialize() */
+    inline void packPhoton(uint8_t *&ptr, const Photon &photon, bool swap) {
+        for (int i=0; i<3; ++i)
+            pack<Float>(ptr, photon.getPosition()[i], swap);
+        if (!Photon::leftBalancedLayout)
+            pack<uint32_t>(ptr, photon.getRightIndex(0), swap);
+        const PhotonData &data = photon.getData();
+#if defined(SINGLE_PRECISION) && SPECTRUM_SAMPLES == 3
+        memcpy(ptr, data.power, 8);
+        ptr += 8;
+#else
+        for (int i=0; i<SPECTRUM_SAMPLES; ++i)
+            pack<Float>(ptr, data.power[i], swap);
+        *ptr++ = data.phi;
+        *ptr++ = data.theta;
+        *ptr++ = data.phiN;
+        *ptr++ = data.thetaN;
+#endif
+        pack<uint16_t>(ptr, data.depth, swap);
+        *ptr++ = photon.flags;
+    }
+
+    /* Binary layout must match Photon::Photon(Stream *) */
+    inline void unpackPhoton(const uint8_t *&ptr, Photon &photon, bool swap) {
+        Point p;
+        for (int i=0; i<3; ++i)
+            p[i] = unpack<Float>(ptr, swap);
+        photon.setPosition(p);
+        if (!Photon::leftBalancedLayout)
+            photon.setRightIndex(0, unpack<uint32_t>(ptr, swap));
+        PhotonData &data = photon.getData();
+#if defined(SINGLE_PRECISION) && SPECTRUM_SAMPLES == 3
+        memcpy(data.power, ptr, 8);
+        ptr += 8;
+#else
+        for (int i=0; i<SPECTRUM_SAMPLES; ++i)
+            data.power[i] = unpack<Float>(ptr, swap);
+        data.phi = *ptr++;
+        data.theta = *ptr++;
+        data.phiN = *ptr++;
+        data.thetaN = *ptr++;
+#endif
+        data.depth = unpack<uint16_t>(ptr, swap);
+        photon.flags = *ptr++;
+    }
+};
+
 PhotonMap::PhotonMap(size_t photonCount)
         : m_kdtree(0, PhotonTree::ESlidingMidpoint), m_scale(1.0f) {
     m_kdtree.reserve(photonCount);
+    stats::photonMapMemory.allocate(m_kdtree.capacity() * sizeof(Photon));
     Assert(Photon::m_precompTableReady);
 }
 
@@ -35,10 +116,20 @@ PhotonMap::PhotonMap(Stream *stream, InstanceManager *manager)
     Assert(Photon::m_precompTableReady);
     m_scale = (Float) stream->readFloat();
     m_kdtree.resize(stream->readSize());
+    stats::photonMapMemory.allocate(m_kdtree.capacity() * sizeof(Photon));
     m_kdtree.setDepth(stream->readSize());
     m_kdtree.setAABB(AABB(stream));
-    for (size_t i=0; i<m_kdtree.size(); ++i)
-        m_kdtree[i] = Photon(stream);
+
+    /* Read the photons in large chunks and decode them in memory */
+    bool swap = stream->getByteOrder() != Stream::getHostByteOrder();
+    std::vector<uint8_t> buffer(PHOTON_CHUNK_SIZE * photonRecordSize);
+    for (size_t i=0; i<m_kdtree.size(); i += PHOTON_CHUNK_SIZE) {
+        size_t count = std::min((size_t) PHOTON_CHUNK_SIZE, m_kdtree.size() - i);
+        stream->read(&buffer[0], count * photonRecordSize);
+        const uint8_t *ptr = &buffer[0];
+        for (size_t j=0; j<count; ++j)
+            unpackPhoton(ptr, m_kdtree[i+j], swap);
+    }
 }
 
 void PhotonMap::serialize(Stream *stream, InstanceManager *manager) const {
@@ -48,11 +139,22 @@ void PhotonMap::serialize(Stream *stream, InstanceManager *manager) const {
     stream->writeSize(m_kdtree.size());
     stream->writeSize(m_kdtree.getDepth());
     m_kdtree.getAABB().serialize(stream);
-    for (size_t i=0; i<m_kdtree.size(); ++i)
-        m_kdtree[i].serialize(stream);
+
+    /* Encode the photons in large chunks to avoid issuing several
+       small writes per photon */
+    bool swap = stream->getByteOrder() != Stream::getHostByteOrder();
+    std::vector<uint8_t> buffer(PHOTON_CHUNK_SIZE * photonRecordSize);
+    for (size_t i=0; i<m_kdtree.size(); i += PHOTON_CHUNK_SIZE) {
+        size_t count = std::min((size_t) PHOTON_CHUNK_SIZE, m_kdtree.size() - i);
+        uint8_t *ptr = &buffer[0];
+        for (size_t j=0; j<count; ++j)
+            packPhoton(ptr, m_kdtree[i+j], swap);
+        stream->write(&buffer[0], count * photonRecordSize);
+    }
 }
 
 PhotonMap::~PhotonMap() {
+    stats::photonMapMemory.release(m_kdtree.capacity() * sizeof(Photon));
 }
 
 std::string PhotonMap::toString() const {
@@ -76,6 +76,7 @@ public:
 
         block->setOffset(rect->getOffset());
         block->setSize(rect->getSize());
+        m_sampler->seedBlock(rect->getOffset());
         m_hilbertCurve.initialize(TVector2<uint8_t>(rect->getSize()));
         m_integrator->renderBlock(m_scene, m_sensor, m_sampler,
             block, stop, m_hilbertCurve.getPoints());
@@ -121,6 +122,8 @@ BlockedRenderProcess::BlockedRenderProcess(const RenderJob *parent, RenderQueue
     m_pixelFormat = Bitmap::ESpectrumAlphaWeight;
     m_channelCount = -1;
     m_warnInvalid = true;
+    m_deterministic = false;
+    m_nextBlock = 0;
 }
 
 BlockedRenderProcess::~BlockedRenderProcess() {
@@ -142,6 +145,27 @@ ref<WorkProcessor> BlockedRenderProcess::createWorkProcessor() const {
 void BlockedRenderProcess::processResult(const WorkResult *result, bool cancelled) {
     const ImageBlock *block = static_cast<const ImageBlock *>(result);
     UniqueLock lock(m_resultMutex);
+    if (m_deterministic && !cancelled) {
+        /* Commit the blocks in a fixed order so that overlapping filter
+           footprints are always accumulated in the same sequence */
+        Vector2i pos = (block->getOffset() - m_offset) / m_blockSize;
+        int sequence = m_blockSequence[pos.x + pos.y * m_numBlocks.x];
+        m_pendingBlocks[sequence] = block->clone();
+        m_progress->update(++m_resultCount);
+
+        std::vector<ref<ImageBlock> > committed;
+        std::map<int, ref<ImageBlock> >::iterator it;
+        while ((it = m_pendingBlocks.find(m_nextBlock)) != m_pendingBlocks.end()) {
+            m_film->put(it->second);
+            committed.push_back(it->second);
+            m_pendingBlocks.erase(it);
+            ++m_nextBlock;
+        }
+        lock.unlock();
+        for (size_t i=0; i<committed.size(); ++i)
+            m_queue->signalWorkEnd(m_parent, committed[i], false);
+        return;
+    }
     m_film->put(block);
     m_progress->update(++m_resultCount);
     lock.unlock();
@@ -150,8 +174,14 @@ void BlockedRenderProcess::processResult(const WorkResult *result, bool cancelle
 
 ParallelProcess::EStatus BlockedRenderProcess::generateWork(WorkUnit *unit, int worker) {
     EStatus status = BlockedImageProcess::generateWork(unit, worker);
-    if (status == ESuccess)
-        m_queue->signalWorkBegin(m_parent, static_cast<RectangularWorkUnit *>(unit), worker);
+    if (status == ESuccess) {
+        RectangularWorkUnit *rect = static_cast<RectangularWorkUnit *>(unit);
+        if (m_deterministic) {
+            Vector2i pos = (rect->getOffset() - m_offset) / m_blockSize;
+            m_blockSequence[pos.x + pos.y * m_numBlocks.x] = m_numBlocksGenerated - 1;
+        }
+        m_queue->signalWorkBegin(m_parent, rect, worker);
+    }
     return status;
 }
 
@@ -174,9 +204,37 @@ void BlockedRenderProcess::bindResource(const std::string &name, int id) {
             Log(EError, "The block size must be larger than the image reconstruction filter radius!");
 
         BlockedImageProcess::init(offset, size, m_blockSize);
+
+        if (m_film->hasRegions()) {
+            /* Only render blocks that contribute to a dirty region */
+            std::vector<bool> mask(m_numBlocks.x * m_numBlocks.y);
+            Vector2i border(m_borderSize);
+            for (int y=0; y<m_numBlocks.y; ++y) {
+                for (int x=0; x<m_numBlocks.x; ++x) {
+                    Point2i blockOffset = offset + Vector2i(x, y) * m_blockSize;
+                    Vector2i blockSize(
+                        std::min(offset.x + size.x - blockOffset.x, m_blockSize),
+                        std::min(offset.y + size.y - blockOffset.y, m_blockSize));
+                    mask[x + y * m_numBlocks.x] = m_film->isDirty(
+                        blockOffset - border, blockSize + border * 2);
+                }
+            }
+            setBlockMask(mask);
+            Log(EInfo, "Rendering %i dirty regions (%i/%i blocks)",
+                (int) m_film->getRegions().size(), m_numBlocksTotal,
+                m_numBlocks.x * m_numBlocks.y);
+        }
+
+        m_blockSequence.resize(m_numBlocks.x * m_numBlocks.y);
+        m_pendingBlocks.clear();
+        m_nextBlock = 0;
+
         if (m_progress)
             delete m_progress;
         m_progress = new ProgressReporter("Rendering", m_numBlocksTotal, m_parent);
+    } else if (name == "sampler") {
+        m_deterministic = static_cast<Sampler *>(Scheduler::getInstance()->
+            getResource(id, 0))->isDeterministic();
     }
     BlockedImageProcess::bindResource(name, id);
 }
@@ -17,14 +17,22 @@
 */
 
 #include <mitsuba/render/sampler.h>
+#include <mitsuba/core/qmc.h>
 
 MTS_NAMESPACE_BEGIN
 
 Sampler::Sampler(const Properties &props)
- : ConfigurableObject(props), m_sampleCount(0), m_sampleIndex(0) { }
+ : ConfigurableObject(props), m_sampleCount(0), m_sampleIndex(0) {
+    /* Derive the random numbers of each pixel from its position and
+       the seed so that renderings are reproducible */
+    m_deterministic = props.getBoolean("deterministic", false);
+    m_seed = (uint32_t) props.getInteger("seed", 0);
+}
 
 Sampler::Sampler(Stream *stream, InstanceManager *manager)
  : ConfigurableObject(stream, manager) {
+    m_deterministic = stream->readBool();
+    m_seed = stream->readUInt();
     m_sampleCount = stream->readSize();
     size_t n1DArrays = stream->readSize();
     for (size_t i=0; i<n1DArrays; ++i)
@@ -37,6 +45,8 @@ Sampler::Sampler(Stream *stream, InstanceManager *manager)
 void Sampler::serialize(Stream *stream, InstanceManager *manager) const {
     ConfigurableObject::serialize(stream, manager);
 
+    stream->writeBool(m_deterministic);
+    stream->writeUInt(m_seed);
     stream->writeSize(m_sampleCount);
     stream->writeSize(m_req1D.size());
     for (size_t i=0; i<m_req1D.size(); ++i)
@@ -48,6 +58,20 @@ void Sampler::serialize(Stream *stream, InstanceManager *manager) const {
 
 void Sampler::setFilmResolution(const Vector2i &, bool) { }
 
+void Sampler::setDeterministic(bool deterministic, uint32_t seed) {
+    m_deterministic = deterministic;
+    m_seed = seed;
+    m_properties.setBoolean("deterministic", deterministic, false);
+    m_properties.setInteger("seed", (int) seed, false);
+}
+
+void Sampler::seedBlock(const Point2i &) { }
+
+uint64_t Sampler::getBlockSeed(const Point2i &offset) const {
+    return sampleTEA((uint32_t) offset.x ^ (m_seed * 0x9E3779B9U),
+        (uint32_t) offset.y, 8);
+}
+
 void Sampler::generate(const Point2i &) {
     m_sampleIndex = 0;
     m_dimension1DArray = m_dimension2DArray = 0;
@@ -19,12 +19,23 @@
 #include <mitsuba/render/scene.h>
 #include <mitsuba/render/renderjob.h>
 #include <mitsuba/core/plugin.h>
+#include <mitsuba/core/mstream.h>
 #include <mitsuba/core/statistics.h>
+#include <mitsuba/core/lock.h>
 
 #define DEFAULT_BLOCKSIZE 32
 
 MTS_NAMESPACE_BEGIN
 
+struct Scene::SubsurfaceState : public Object {
+    /// Serializes the preprocessing of the subsurface integrators
+    ref<Mutex> mutex;
+    /// Number of scenes/views that are currently using the integrators
+    int users;
+
+    SubsurfaceState() : mutex(new Mutex()), users(0) { }
+};
+
 // ===========================================================================
 //         Constructors, destructor and serialization-related code
 // ===========================================================================
@@ -34,6 +45,9 @@ Scene::Scene()
     m_kdtree = new ShapeKDTree();
     m_sourceFile = new fs::path();
     m_destinationFile = new fs::path();
+    m_ssState = new SubsurfaceState();
+    m_ssClaimed = false;
+    m_isView = m_hasViews = false;
 }
 
 Scene::Scene(const Properties &props)
@@ -78,6 +92,9 @@ Scene::Scene(const Properties &props)
         m_kdtree->setMaxBadRefines(props.getInteger("kdMaxBadRefines"));
     m_sourceFile = new fs::path();
     m_destinationFile = new fs::path();
+    m_ssState = new SubsurfaceState();
+    m_ssClaimed = false;
+    m_isView = m_hasViews = false;
 }
 
 Scene::Scene(Scene *scene) : NetworkedObject(Properties()) {
@@ -96,6 +113,12 @@ Scene::Scene(Scene *scene) : NetworkedObject(Properties()) {
     m_emitters = scene->m_emitters;
     m_media = scene->m_media;
     m_ssIntegrators = scene->m_ssIntegrators;
+    m_ssState = scene->m_ssState;
+    m_ssClaimed = false;
+    m_isView = scene->m_isView;
+    m_hasViews = scene->m_hasViews;
+    m_emitterShapes = scene->m_emitterShapes;
+    m_emitterAABB = scene->m_emitterAABB;
     m_objects = scene->m_objects;
     m_netObjects = scene->m_netObjects;
     m_specialShapes = scene->m_specialShapes;
@@ -123,6 +146,9 @@ Scene::Scene(Stream *stream, InstanceManager *manager)
     m_environmentEmitter = static_cast<Emitter *>(manager->getInstance(stream));
     m_sourceFile = new fs::path(stream->readString());
     m_destinationFile = new fs::path(stream->readString());
+    m_ssState = new SubsurfaceState();
+    m_ssClaimed = false;
+    m_isView = m_hasViews = false;
 
     size_t count = stream->readSize();
     m_shapes.reserve(count);
@@ -165,6 +191,10 @@ Scene::Scene(Stream *stream, InstanceManager *manager)
 }
 
 Scene::~Scene() {
+    if (m_ssClaimed) {
+        LockGuard lock(m_ssState->mutex);
+        --m_ssState->users;
+    }
     delete m_destinationFile;
     delete m_sourceFile;
 }
@@ -385,7 +415,6 @@ void Scene::initialize() {
 
 void Scene::initializeBidirectional() {
     m_aabb = m_kdtree->getAABB();
-    m_degenerateEmitters = true;
     m_specialShapes.clear();
 
     if (m_sensor) {
@@ -397,20 +426,112 @@ void Scene::initializeBidirectional() {
         m_degenerateSensor = m_sensor->getType() & Sensor::EDeltaPosition;
     }
 
-    AABB aabb(m_aabb);
-    for (ref_vector<Emitter>::iterator it = m_emitters.begin();
-            it != m_emitters.end(); ++it) {
-        Emitter *emitter = it->get();
+    /* Views share the emitters (and their shapes) with the scene that
+       created them, see createView() */
+    if (!m_isView) {
+        AABB sensorAABB(m_aabb);
+
+        /* The bounds of the shared emitters must enclose the sensors
+           of all views, since they cannot be changed per view */
+        if (m_hasViews) {
+            for (ref_vector<Sensor>::iterator it = m_sensors.begin();
+                    it != m_sensors.end(); ++it)
+                m_aabb.expandBy((*it)->getAABB());
+        }
 
-        ref<Shape> shape = emitter->createShape(this);
-        if (shape != NULL)
-            m_specialShapes.push_back(shape);
+        AABB aabb(m_aabb);
+        m_degenerateEmitters = true;
+        m_emitterShapes.clear();
+        for (ref_vector<Emitter>::iterator it = m_emitters.begin();
+                it != m_emitters.end(); ++it) {
+            Emitter *emitter = it->get();
+
+            ref<Shape> shape = emitter->createShape(this);
+            if (shape != NULL)
+                m_emitterShapes.push_back(shape);
+
+            aabb.expandBy(emitter->getAABB());
+            if (!(emitter->getType() & Emitter::EDeltaPosition))
+                m_degenerateEmitters = false;
+        }
+        m_emitterAABB = aabb;
+        m_aabb = sensorAABB;
+    }
+
+    m_specialShapes.insert(m_specialShapes.end(),
+        m_emitterShapes.begin(), m_emitterShapes.end());
+    m_aabb.expandBy(m_emitterAABB);
+}
 
-        aabb.expandBy(emitter->getAABB());
-        if (!(emitter->getType() & Emitter::EDeltaPosition))
-            m_degenerateEmitters = false;
+ref<Scene> Scene::createView(Sensor *sensor, bool cloneIntegrator) {
+    /* Build the shared kd-tree, emitter sampling data and emitter
+       bounds once. Views never reinitialize the shared emitters */
+    if (!m_hasViews) {
+        m_hasViews = true;
+        initialize();
+    }
+
+    ref<Scene> view = new Scene(this);
+    view->m_isView = true;
+    view->setSensor(sensor);
+    view->setSampler(sensor->getSampler());
+
+    if (cloneIntegrator) {
+        /* Copy the integrator by passing it through a memory stream */
+        ref<MemoryStream> mstream = new MemoryStream();
+        ref<InstanceManager> manager = new InstanceManager();
+        manager->serialize(mstream, m_integrator.get());
+        mstream->seek(0);
+        manager = new InstanceManager();
+        view->setIntegrator(static_cast<Integrator *>(manager->getInstance(mstream)));
+    }
+
+    /* The sampler of the main sensor was already configured by configure() */
+    if (view->getSampler() != m_sampler.get())
+        view->getIntegrator()->configureSampler(view, view->getSampler());
+
+    return view;
+}
+
+/// Recursively expand compound shapes in the same order as Scene::addShape()
+static void expandShape(Shape *shape, ref_vector<Shape> &result) {
+    if (shape->isCompound()) {
+        int index = 0;
+        do {
+            ref<Shape> element = shape->getElement(index++);
+            if (element == NULL)
+                break;
+            expandShape(element, result);
+        } while (true);
+    } else {
+        result.push_back(shape);
+    }
 }
-    m_aabb = aabb;
+
+bool Scene::reuseKDTree(const Scene *scene) {
+    if (m_kdtree->isBuilt() || !scene->m_kdtree->isBuilt())
+        return false;
+
+    ref_vector<Shape> shapes(m_shapes), expanded;
+    shapes.ensureUnique();
+    for (size_t i=0; i<shapes.size(); ++i)
+        expandShape(shapes[i], expanded);
+
+    if (expanded.size() != scene->m_shapes.size())
+        return false;
+    for (size_t i=0; i<expanded.size(); ++i) {
+        if (expanded[i] != scene->m_shapes[i])
+            return false;
+    }
+
+    /* Same geometry: only redo the bookkeeping of addShape() */
+    m_kdtree = scene->m_kdtree;
+    m_shapes.clear();
+    for (size_t i=0; i<expanded.size(); ++i)
+        addShape(expanded[i], false);
+    m_aabb = m_kdtree->getAABB();
+
+    return true;
 }
 
 bool Scene::preprocess(RenderQueue *queue, const RenderJob *job,
@@ -423,20 +544,36 @@ bool Scene::preprocess(RenderQueue *queue, const RenderJob *job,
         sceneResID, sensorResID, samplerResID))
         return false;
 
-    /* Pre-process step for all sub-surface integrators (each one in independence) */
-    for (ref_vector<Subsurface>::iterator it = m_ssIntegrators.begin();
-            it != m_ssIntegrators.end(); ++it)
-        (*it)->setActive(false);
+    /* Pre-process step for all sub-surface integrators (each one in
+       independence). The views created by createView() share these
+       integrators and may be preprocessed while another view is already
+       rendering. Hence, this step is serialized, and the integrators are
+       only preprocessed again once no other view is using them. */
+    LockGuard lock(m_ssState->mutex);
+    if (m_ssClaimed) {
+        /* Rendered again without a postprocess() call */
+        --m_ssState->users;
+        m_ssClaimed = false;
+    }
 
-    for (ref_vector<Subsurface>::iterator it = m_ssIntegrators.begin();
-        it != m_ssIntegrators.end(); ++it)
-        if (!(*it)->preprocess(this, queue, job,
-                sceneResID, sensorResID, samplerResID))
-            return false;
+    if (m_ssState->users == 0) {
+        for (ref_vector<Subsurface>::iterator it = m_ssIntegrators.begin();
+                it != m_ssIntegrators.end(); ++it)
+            (*it)->setActive(false);
 
-    for (ref_vector<Subsurface>::iterator it = m_ssIntegrators.begin();
+        for (ref_vector<Subsurface>::iterator it = m_ssIntegrators.begin();
             it != m_ssIntegrators.end(); ++it)
-        (*it)->setActive(true);
+            if (!(*it)->preprocess(this, queue, job,
+                    sceneResID, sensorResID, samplerResID))
+                return false;
+
+        for (ref_vector<Subsurface>::iterator it = m_ssIntegrators.begin();
+                it != m_ssIntegrators.end(); ++it)
+            (*it)->setActive(true);
+    }
+
+    ++m_ssState->users;
+    m_ssClaimed = true;
 
     return true;
 }
@@ -472,6 +609,12 @@ void Scene::postprocess(RenderQueue *queue, const RenderJob *job,
     m_integrator->postprocess(this, queue, job, sceneResID,
         sensorResID, samplerResID);
     m_sensor->getFilm()->develop(this, queue->getRenderTime(job));
+
+    LockGuard lock(m_ssState->mutex);
+    if (m_ssClaimed) {
+        --m_ssState->users;
+        m_ssClaimed = false;
+    }
 }
 
 void Scene::addChild(const std::string &name, ConfigurableObject *child) {
@@ -555,14 +698,14 @@ void Scene::addChild(const std::string &name, ConfigurableObject *child) {
     }
 }
 
-void Scene::addShape(Shape *shape) {
+void Scene::addShape(Shape *shape, bool addToKDTree) {
     if (shape->isCompound()) {
         int index = 0;
         do {
             ref<Shape> element = shape->getElement(index++);
             if (element == NULL)
                 break;
-            addShape(element);
+            addShape(element, addToKDTree);
         } while (true);
     } else {
         if (shape->isSensor() && !m_sensors.contains(shape->getSensor()))
@@ -586,7 +729,8 @@ void Scene::addShape(Shape *shape) {
         if (shape->getClass()->derivesFrom(MTS_CLASS(TriMesh)))
             m_meshes.push_back(static_cast<TriMesh *>(shape));
 
-        m_kdtree->addShape(shape);
+        if (addToKDTree)
+            m_kdtree->addShape(shape);
         m_shapes.push_back(shape);
     }
 }
@@ -131,6 +131,14 @@ void SceneHandler::clear() {
     }
 }
 
+void SceneHandler::setParent(ConfigurableObject *child, ConfigurableObject *parent) {
+    /* A reused object may still belong to a scene that is being rendered */
+    if (m_cache != NULL && m_cache->isReused(child))
+        m_cache->deferParent(child, parent);
+    else
+        child->setParent(parent);
+}
+
 std::string SceneHandler::transcode(const XMLCh * input) const {
     XMLSize_t charsToBeConsumed = XMLString::stringLen(input);
     char output[TRANSCODE_BLOCKSIZE + 4];
@@ -279,6 +287,8 @@ void SceneHandler::endElement(const XMLCh* const xmlName) {
         context.properties.setID(context.attributes["id"]);
 
     ref<ConfigurableObject> object;
+    SceneObjectCache::Key cacheKey;
+    bool cacheable = false, cacheHit = false;
 
     TagMap::const_iterator it = m_tags.find(name);
     if (it == m_tags.end())
@@ -668,6 +678,7 @@ void SceneHandler::endElement(const XMLCh* const xmlName) {
 
                 /* Set the handler and start parsing */
                 SceneHandler *handler = new SceneHandler(m_params, m_namedObjects, true);
+                handler->setObjectCache(m_cache);
                 parser->setDoNamespaces(true);
                 parser->setDocumentHandler(handler);
                 parser->setErrorHandler(handler);
@@ -719,7 +730,7 @@ void SceneHandler::endElement(const XMLCh* const xmlName) {
                                 it != context.children.end(); ++it) {
                             if (it->second != NULL) {
                                 object->addChild(it->first, it->second);
-                                it->second->setParent(object);
+                                setParent(it->second, object);
                                 it->second->decRef();
                             }
                         }
@@ -739,10 +750,29 @@ void SceneHandler::endElement(const XMLCh* const xmlName) {
 
                     }
                 } else {
-                    try {
-                        object = m_pluginManager->createObject(tag.second, props);
-                    } catch (const std::exception &ex) {
-                        XMLLog(EError, "Error while creating object: %s", ex.what());
+                    cacheable = m_cache != NULL && (tag.first == EShape ||
+                        tag.first == ETexture || tag.first == EBSDF ||
+                        tag.first == EEmitter || tag.first == EMedium ||
+                        tag.first == EVolume || tag.first == EPhase);
+
+                    /* Emitters nested in a shape (e.g. area lights) are bound
+                       to that shape instance and cannot be shared with another */
+                    if (tag.first == EEmitter && context.parent != NULL
+                            && context.parent->tag == EShape)
+                        cacheable = false;
+
+                    if (cacheable) {
+                        cacheKey = SceneObjectCache::Key(tag.second, props, context.children);
+                        object = m_cache->get(cacheKey);
+                        cacheHit = object != NULL;
+                    }
+
+                    if (!cacheHit) {
+                        try {
+                            object = m_pluginManager->createObject(tag.second, props);
+                        } catch (const std::exception &ex) {
+                            XMLLog(EError, "Error while creating object: %s", ex.what());
+                        }
                     }
                 }
             }
@@ -761,23 +791,36 @@ void SceneHandler::endElement(const XMLCh* const xmlName) {
                     std::pair<std::string, ConfigurableObject *>(nodeName, object));
             }
 
-            /* If the object has children, append them */
-            for (std::vector<std::pair<std::string, ConfigurableObject *> >
-                    ::iterator it = context.children.begin();
-                    it != context.children.end(); ++it) {
-                if (it->second != NULL) {
-                    object->addChild(it->first, it->second);
-                    it->second->setParent(object);
-                    it->second->decRef();
+            if (cacheHit) {
+                /* A cached object already holds its children and is configured */
+                for (std::vector<std::pair<std::string, ConfigurableObject *> >
+                        ::iterator it = context.children.begin();
+                        it != context.children.end(); ++it) {
+                    if (it->second != NULL)
+                        it->second->decRef();
+                }
+            } else {
+                /* If the object has children, append them */
+                for (std::vector<std::pair<std::string, ConfigurableObject *> >
+                        ::iterator it = context.children.begin();
+                        it != context.children.end(); ++it) {
+                    if (it->second != NULL) {
+                        object->addChild(it->first, it->second);
+                        setParent(it->second, object);
+                        it->second->decRef();
+                    }
                 }
-            }
 
-            /* Don't configure a scene object if it is from an included file */
-            if (name != "include" && (!m_isIncludedFile || !object->getClass()->derivesFrom(MTS_CLASS(Scene))))
-                object->configure();
+                /* Don't configure a scene object if it is from an included file */
+                if (name != "include" && (!m_isIncludedFile || !object->getClass()->derivesFrom(MTS_CLASS(Scene))))
+                    object->configure();
 
-            if (object->getClass()->derivesFrom(MTS_CLASS(Texture)))
-                object = static_cast<Texture *>(object.get())->expand();
+                if (object->getClass()->derivesFrom(MTS_CLASS(Texture)))
+                    object = static_cast<Texture *>(object.get())->expand();
+
+                if (cacheable)
+                    m_cache->put(cacheKey, object);
+            }
         }
 
         if (id != "" && name != "ref") {
@@ -789,14 +832,101 @@ void SceneHandler::endElement(const XMLCh* const xmlName) {
         }
     }
 
-    /* Warn about unqueried properties */
-    std::vector<std::string> unq = context.properties.getUnqueried();
-    for (unsigned int i=0; i<unq.size(); ++i)
-        XMLLog(EWarn, "Unqueried attribute \"%s\" in element \"%s\"", unq[i].c_str(), name.c_str());
+    /* Warn about unqueried properties (cached objects were not constructed from them) */
+    if (!cacheHit) {
+        std::vector<std::string> unq = context.properties.getUnqueried();
+        for (unsigned int i=0; i<unq.size(); ++i)
+            XMLLog(EWarn, "Unqueried attribute \"%s\" in element \"%s\"", unq[i].c_str(), name.c_str());
+    }
 
     m_context.pop();
 }
 
+// -----------------------------------------------------------------------
+//  Scene object cache
+// -----------------------------------------------------------------------
+
+SceneObjectCache::Key::Key(const Class *theClass, const Properties &props,
+        const ChildList &children) : theClass(theClass), props(props) {
+    this->children.reserve(children.size());
+    for (ChildList::const_iterator it = children.begin(); it != children.end(); ++it)
+        this->children.push_back(std::make_pair(it->first, ref<ConfigurableObject>(it->second)));
+}
+
+bool SceneObjectCache::Key::operator==(const Key &key) const {
+    if (theClass != key.theClass || children.size() != key.children.size())
+        return false;
+    for (size_t i=0; i<children.size(); ++i) {
+        if (children[i].first != key.children[i].first ||
+            children[i].second != key.children[i].second)
+            return false;
+    }
+    return props == key.props;
+}
+
+SceneObjectCache::SceneObjectCache() : m_hits(0), m_misses(0) { }
+
+SceneObjectCache::~SceneObjectCache() { }
+
+ConfigurableObject *SceneObjectCache::get(const Key &key) {
+    typedef std::multimap<std::string, Entry>::iterator iterator;
+    std::pair<iterator, iterator> range =
+        m_entries.equal_range(key.props.getPluginName());
+
+    for (iterator it = range.first; it != range.second; ++it) {
+        if (it->second.key == key) {
+            it->second.used = true;
+            m_reused.insert(it->second.object.get());
+            ++m_hits;
+            return it->second.object;
+        }
+    }
+    ++m_misses;
+    return NULL;
+}
+
+void SceneObjectCache::put(const Key &key, ConfigurableObject *object) {
+    Entry entry;
+    entry.key = key;
+    entry.object = object;
+    entry.used = true;
+    m_entries.insert(std::make_pair(key.props.getPluginName(), entry));
+}
+
+void SceneObjectCache::purge() {
+    std::multimap<std::string, Entry>::iterator it = m_entries.begin();
+    while (it != m_entries.end()) {
+        if (!it->second.used) {
+            m_entries.erase(it++);
+        } else {
+            it->second.used = false;
+            ++it;
+        }
+    }
+    m_reused.clear();
+}
+
+bool SceneObjectCache::isReused(const ConfigurableObject *object) const {
+    return m_reused.find(object) != m_reused.end();
+}
+
+void SceneObjectCache::deferParent(ConfigurableObject *object, ConfigurableObject *parent) {
+    m_parents.push_back(std::make_pair(ref<ConfigurableObject>(object),
+        ref<ConfigurableObject>(parent)));
+}
+
+void SceneObjectCache::commitParents() {
+    for (size_t i=0; i<m_parents.size(); ++i)
+        m_parents[i].first->setParent(m_parents[i].second);
+    m_parents.clear();
+}
+
+void SceneObjectCache::clear() {
+    m_entries.clear();
+    m_reused.clear();
+    m_parents.clear();
+}
+
 // -----------------------------------------------------------------------
 //  Implementation of the SAX ErrorHandler interface
 // -----------------------------------------------------------------------
@@ -821,7 +951,8 @@ void SceneHandler::fatalError(const SAXParseException& e) {
 
 // -----------------------------------------------------------------------
 
-ref<Scene> SceneHandler::loadScene(const fs::path &filename, const ParameterMap &params) {
+ref<Scene> SceneHandler::loadScene(const fs::path &filename, const ParameterMap &params,
+        SceneObjectCache *cache) {
     /* Prepare for parsing scene descriptions */
     FileResolver *resolver = Thread::getThread()->getFileResolver();
     SAXParser* parser = new SAXParser();
@@ -835,6 +966,7 @@ ref<Scene> SceneHandler::loadScene(const fs::path &filename, const ParameterMap
     parser->setExternalNoNamespaceSchemaLocation(schemaPath.c_str());
 
     SceneHandler *handler = new SceneHandler(params);
+    handler->setObjectCache(cache);
     parser->setDoNamespaces(true);
     parser->setDocumentHandler(handler);
     parser->setErrorHandler(handler);
@@ -896,4 +1028,5 @@ void SceneHandler::staticShutdown() {
 
 VersionException::~VersionException() throw () {}
 
+MTS_IMPLEMENT_CLASS(SceneObjectCache, false, Object)
 MTS_NAMESPACE_END
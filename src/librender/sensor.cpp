@@ -21,9 +21,68 @@
 #include <mitsuba/core/track.h>
 #include <mitsuba/core/plugin.h>
 #include <boost/algorithm/string.hpp>
+#if defined(SINGLE_PRECISION) && defined(MTS_SSE)
+#include <mitsuba/core/sse.h>
+#endif
+#if defined(MTS_HAS_COHERENT_RT)
+#include <mitsuba/core/ray_sse.h>
+#endif
 
 MTS_NAMESPACE_BEGIN
 
+RayBatch::RayBatch(size_t capacity) : size(0), m_capacity(capacity) {
+    /* Pad to a multiple of four so that all arrays stay 16-byte aligned */
+    size_t padded = (capacity + 3) & ~((size_t) 3);
+    m_storage = static_cast<Float *>(allocAligned(sizeof(Float) * 9 * padded));
+    memset(m_storage, 0, sizeof(Float) * 9 * padded);
+    ox = m_storage; oy = ox + padded; oz = oy + padded;
+    dx = oz + padded; dy = dx + padded; dz = dy + padded;
+    mint = dz + padded; maxt = mint + padded; time = maxt + padded;
+    weight = new Spectrum[padded];
+}
+
+RayBatch::~RayBatch() {
+    freeAligned(m_storage);
+    delete[] weight;
+}
+
+#if defined(MTS_HAS_COHERENT_RT)
+bool RayBatch::getPacket(size_t index, RayPacket4 &packet, RayInterval4 &interval) const {
+    size_t offset = 4 * index;
+    SAssert(offset < size);
+
+    if (offset + 4 <= size) {
+        packet.o[0].ps = _mm_load_ps(ox + offset);
+        packet.o[1].ps = _mm_load_ps(oy + offset);
+        packet.o[2].ps = _mm_load_ps(oz + offset);
+        packet.d[0].ps = _mm_load_ps(dx + offset);
+        packet.d[1].ps = _mm_load_ps(dy + offset);
+        packet.d[2].ps = _mm_load_ps(dz + offset);
+        interval.mint.ps = _mm_load_ps(mint + offset);
+        interval.maxt.ps = _mm_load_ps(maxt + offset);
+    } else {
+        for (int i=0; i<4; ++i) {
+            size_t j = std::min(offset + i, size - 1);
+            packet.o[0].f[i] = ox[j]; packet.o[1].f[i] = oy[j]; packet.o[2].f[i] = oz[j];
+            packet.d[0].f[i] = dx[j]; packet.d[1].f[i] = dy[j]; packet.d[2].f[i] = dz[j];
+            interval.mint.f[i] = mint[j];
+            interval.maxt.f[i] = maxt[j];
+        }
+    }
+
+    bool coherent = true;
+    for (int axis=0; axis<3; ++axis) {
+        packet.dRcp[axis].ps = _mm_div_ps(SSEConstants::one.ps, packet.d[axis].ps);
+        int mask = _mm_movemask_ps(_mm_cmplt_ps(packet.d[axis].ps, SSEConstants::zero.ps));
+        for (int i=0; i<4; ++i)
+            packet.signs[axis][i] = (mask >> i) & 1;
+        if (mask != 0 && mask != 0xF)
+            coherent = false;
+    }
+    return coherent;
+}
+#endif
+
 Sensor::Sensor(const Properties &props)
  : AbstractEmitter(props) {
     m_shutterOpen = props.getFloat("shutterOpen", 0.0f);
@@ -131,6 +190,25 @@ Spectrum Sensor::sampleRayDifferential(RayDifferential &ray,
     return result;
 }
 
+void Sensor::sampleRayBatch(RayBatch &batch, const Point2 *samplePositions,
+        const Point2 *apertureSamples, const Float *timeSamples, size_t count) const {
+    SAssert(count <= batch.getCapacity());
+    Point2 apertureSample(0.5f);
+    Float timeSample = 0.5f;
+    Ray ray;
+
+    for (size_t i=0; i<count; ++i) {
+        if (apertureSamples)
+            apertureSample = apertureSamples[i];
+        if (timeSamples)
+            timeSample = timeSamples[i];
+        Spectrum value = sampleRay(ray, samplePositions[i],
+            apertureSample, timeSample);
+        batch.setRay(i, ray, value);
+    }
+    batch.size = count;
+}
+
 Float Sensor::pdfTime(const Ray &ray, EMeasure measure) const {
     if (ray.time < m_shutterOpen || ray.time > m_shutterOpen + m_shutterOpenTime)
         return 0.0f;
@@ -217,6 +295,74 @@ void ProjectiveCamera::setWorldTransform(AnimatedTransform *trafo) {
     m_properties.setAnimatedTransform("toWorld", trafo, false);
 }
 
+bool ProjectiveCamera::getScreenBounds(const AABB &aabb, Point2i &offset, Vector2i &size) const {
+    const Vector2i &cropSize = m_film->getCropSize();
+    if (!aabb.isValid())
+        return false;
+
+    /* Account for the extent of the aperture and the shutter interval. The
+       screen-space offset caused by a lens position is linear in that position,
+       hence the extremes are attained on the boundary of the aperture. Use the
+       corners and edge midpoints of the sample domain: the concentric disk
+       mapping sends the midpoints to the x/y extremes of a circular lens. */
+    std::vector<Point2> apertureSamples;
+    if (needsApertureSample()) {
+        for (int i=0; i<9; ++i) {
+            if (i != 4)
+                apertureSamples.push_back(Point2((Float) (i % 3), (Float) (i / 3)) * 0.5f);
+        }
+    } else {
+        apertureSamples.push_back(Point2(0.5f));
+    }
+    Float times[2] = { m_shutterOpen, m_shutterOpen + m_shutterOpenTime };
+
+    /* The projection transformation uses the OpenGL camera convention */
+    Transform flip = Transform::scale(Vector(-1.0f, 1.0f, -1.0f));
+
+    Point2 min(std::numeric_limits<Float>::infinity()),
+           max(-std::numeric_limits<Float>::infinity());
+    for (size_t i=0; i<apertureSamples.size(); ++i) {
+        Transform proj = getProjectionTransform(apertureSamples[i], Point2(0.5f));
+        for (int j=0; j<(m_shutterOpenTime > 0 ? 2 : 1); ++j) {
+            const Matrix4x4 &M = (proj * flip * getViewTransform(times[j])).getMatrix();
+
+            for (int k=0; k<8; ++k) {
+                Point p = aabb.getCorner(k);
+                Float x = M(0,0) * p.x + M(0,1) * p.y + M(0,2) * p.z + M(0,3),
+                      y = M(1,0) * p.x + M(1,1) * p.y + M(1,2) * p.z + M(1,3),
+                      w = M(3,0) * p.x + M(3,1) * p.y + M(3,2) * p.z + M(3,3);
+
+                if (w <= Epsilon) {
+                    /* The box extends behind the camera */
+                    offset = Point2i(0);
+                    size = cropSize;
+                    return true;
+                }
+
+                /* Clip space -> pixel coordinates within the crop window */
+                Point2 q((x / w + 1) * 0.5f * cropSize.x,
+                         (1 - y / w) * 0.5f * cropSize.y);
+                min = Point2(std::min(min.x, q.x), std::min(min.y, q.y));
+                max = Point2(std::max(max.x, q.x), std::max(max.y, q.y));
+            }
+        }
+    }
+
+    /* Add a one pixel margin and clip to the crop window */
+    Point2i pmin(
+        (int) std::floor(math::clamp(min.x - 1, (Float) 0, (Float) cropSize.x)),
+        (int) std::floor(math::clamp(min.y - 1, (Float) 0, (Float) cropSize.y)));
+    Point2i pmax(
+        (int) std::ceil(math::clamp(max.x + 1, (Float) 0, (Float) cropSize.x)),
+        (int) std::ceil(math::clamp(max.y + 1, (Float) 0, (Float) cropSize.y)));
+    if (pmax.x <= pmin.x || pmax.y <= pmin.y)
+        return false;
+
+    offset = pmin;
+    size = pmax - pmin;
+    return true;
+}
+
 PerspectiveCamera::PerspectiveCamera(const Properties &props)
     : ProjectiveCamera(props), m_xfov(0.0f) {
     props.markQueried("fov");
@@ -305,6 +451,153 @@ void PerspectiveCamera::setDiagonalFov(Float dfov) {
 }
 
 
+void PerspectiveCamera::prepareRayBatch(RayBatch &batch, const Transform &sampleToCamera,
+        const Point2 *samplePositions, const Float *timeSamples, size_t count) const {
+    SAssert(count <= batch.getCapacity());
+    size_t i = 0;
+
+#if defined(SINGLE_PRECISION) && defined(MTS_SSE)
+    /* Map four samples at a time onto the near plane */
+    const Matrix4x4 &M = sampleToCamera.getMatrix();
+    const __m128
+        m00 = _mm_set1_ps(M.m[0][0]), m01 = _mm_set1_ps(M.m[0][1]), m03 = _mm_set1_ps(M.m[0][3]),
+        m10 = _mm_set1_ps(M.m[1][0]), m11 = _mm_set1_ps(M.m[1][1]), m13 = _mm_set1_ps(M.m[1][3]),
+        m20 = _mm_set1_ps(M.m[2][0]), m21 = _mm_set1_ps(M.m[2][1]), m23 = _mm_set1_ps(M.m[2][3]),
+        m30 = _mm_set1_ps(M.m[3][0]), m31 = _mm_set1_ps(M.m[3][1]), m33 = _mm_set1_ps(M.m[3][3]),
+        invResX = _mm_set1_ps(m_invResolution.x), invResY = _mm_set1_ps(m_invResolution.y),
+        zero = _mm_setzero_ps();
+
+    for (; i + 4 <= count; i += 4) {
+        /* Deinterleave the (x, y) pairs */
+        __m128 a = _mm_loadu_ps(&samplePositions[i].x),
+               b = _mm_loadu_ps(&samplePositions[i+2].x),
+               x = _mm_mul_ps(_mm_shuffle_ps(a, b, _MM_SHUFFLE(2, 0, 2, 0)), invResX),
+               y = _mm_mul_ps(_mm_shuffle_ps(a, b, _MM_SHUFFLE(3, 1, 3, 1)), invResY);
+
+        __m128 px = _mm_add_ps(_mm_add_ps(_mm_mul_ps(m00, x), _mm_mul_ps(m01, y)), m03),
+               py = _mm_add_ps(_mm_add_ps(_mm_mul_ps(m10, x), _mm_mul_ps(m11, y)), m13),
+               pz = _mm_add_ps(_mm_add_ps(_mm_mul_ps(m20, x), _mm_mul_ps(m21, y)), m23),
+               w  = _mm_add_ps(_mm_add_ps(_mm_mul_ps(m30, x), _mm_mul_ps(m31, y)), m33);
+
+        __m128 invW = _mm_div_ps(SSEConstants::one.ps, w);
+        _mm_store_ps(batch.dx + i, _mm_mul_ps(px, invW));
+        _mm_store_ps(batch.dy + i, _mm_mul_ps(py, invW));
+        _mm_store_ps(batch.dz + i, _mm_mul_ps(pz, invW));
+        _mm_store_ps(batch.ox + i, zero);
+        _mm_store_ps(batch.oy + i, zero);
+        _mm_store_ps(batch.oz + i, zero);
+    }
+#endif
+
+    for (; i < count; ++i) {
+        Point nearP = sampleToCamera(Point(
+            samplePositions[i].x * m_invResolution.x,
+            samplePositions[i].y * m_invResolution.y, 0.0f));
+        batch.dx[i] = nearP.x; batch.dy[i] = nearP.y; batch.dz[i] = nearP.z;
+        batch.ox[i] = batch.oy[i] = batch.oz[i] = 0.0f;
+    }
+
+    for (i = 0; i < count; ++i)
+        batch.time[i] = sampleTime(timeSamples ? timeSamples[i] : (Float) 0.5f);
+
+    batch.size = count;
+}
+
+void PerspectiveCamera::finishRayBatch(RayBatch &batch) const {
+    const size_t count = batch.size;
+    size_t i = 0;
+
+#if defined(SINGLE_PRECISION) && defined(MTS_SSE)
+    const __m128
+        nearClip = _mm_set1_ps(m_nearClip),
+        farClip = _mm_set1_ps(m_farClip);
+
+    for (; i + 4 <= count; i += 4) {
+        __m128 x = _mm_load_ps(batch.dx + i),
+               y = _mm_load_ps(batch.dy + i),
+               z = _mm_load_ps(batch.dz + i);
+
+        __m128 length = _mm_sqrt_ps(_mm_add_ps(_mm_add_ps(
+            _mm_mul_ps(x, x), _mm_mul_ps(y, y)), _mm_mul_ps(z, z)));
+        __m128 invLength = _mm_div_ps(SSEConstants::one.ps, length);
+        z = _mm_mul_ps(z, invLength);
+
+        __m128 invZ = _mm_div_ps(SSEConstants::one.ps, z);
+        _mm_store_ps(batch.dx + i, _mm_mul_ps(x, invLength));
+        _mm_store_ps(batch.dy + i, _mm_mul_ps(y, invLength));
+        _mm_store_ps(batch.dz + i, z);
+        _mm_store_ps(batch.mint + i, _mm_mul_ps(nearClip, invZ));
+        _mm_store_ps(batch.maxt + i, _mm_mul_ps(farClip, invZ));
+    }
+#endif
+
+    for (; i < count; ++i) {
+        Vector d = normalize(Vector(batch.dx[i], batch.dy[i], batch.dz[i]));
+        Float invZ = 1.0f / d.z;
+        batch.dx[i] = d.x; batch.dy[i] = d.y; batch.dz[i] = d.z;
+        batch.mint[i] = m_nearClip * invZ;
+        batch.maxt[i] = m_farClip * invZ;
+    }
+
+    if (!m_worldTransform->isStatic()) {
+        /* Animated sensor: evaluate the transformation for each ray */
+        for (i = 0; i < count; ++i) {
+            const Transform &trafo = m_worldTransform->eval(batch.time[i]);
+            Point o = trafo.transformAffine(Point(batch.ox[i], batch.oy[i], batch.oz[i]));
+            Vector d = trafo(Vector(batch.dx[i], batch.dy[i], batch.dz[i]));
+            batch.ox[i] = o.x; batch.oy[i] = o.y; batch.oz[i] = o.z;
+            batch.dx[i] = d.x; batch.dy[i] = d.y; batch.dz[i] = d.z;
+        }
+    } else {
+        const Matrix4x4 &M = m_worldTransform->eval(0).getMatrix();
+        i = 0;
+
+#if defined(SINGLE_PRECISION) && defined(MTS_SSE)
+        __m128 m[3][4];
+        for (int r=0; r<3; ++r)
+            for (int c=0; c<4; ++c)
+                m[r][c] = _mm_set1_ps(M.m[r][c]);
+
+        for (; i + 4 <= count; i += 4) {
+            __m128 x = _mm_load_ps(batch.ox + i),
+                   y = _mm_load_ps(batch.oy + i),
+                   z = _mm_load_ps(batch.oz + i);
+            _mm_store_ps(batch.ox + i, _mm_add_ps(_mm_add_ps(_mm_add_ps(_mm_mul_ps(m[0][0], x),
+                _mm_mul_ps(m[0][1], y)), _mm_mul_ps(m[0][2], z)), m[0][3]));
+            _mm_store_ps(batch.oy + i, _mm_add_ps(_mm_add_ps(_mm_add_ps(_mm_mul_ps(m[1][0], x),
+                _mm_mul_ps(m[1][1], y)), _mm_mul_ps(m[1][2], z)), m[1][3]));
+            _mm_store_ps(batch.oz + i, _mm_add_ps(_mm_add_ps(_mm_add_ps(_mm_mul_ps(m[2][0], x),
+                _mm_mul_ps(m[2][1], y)), _mm_mul_ps(m[2][2], z)), m[2][3]));
+
+            x = _mm_load_ps(batch.dx + i);
+            y = _mm_load_ps(batch.dy + i);
+            z = _mm_load_ps(batch.dz + i);
+            _mm_store_ps(batch.dx + i, _mm_add_ps(_mm_add_ps(_mm_mul_ps(m[0][0], x),
+                _mm_mul_ps(m[0][1], y)), _mm_mul_ps(m[0][2], z)));
+            _mm_store_ps(batch.dy + i, _mm_add_ps(_mm_add_ps(_mm_mul_ps(m[1][0], x),
+                _mm_mul_ps(m[1][1], y)), _mm_mul_ps(m[1][2], z)));
+            _mm_store_ps(batch.dz + i, _mm_add_ps(_mm_add_ps(_mm_mul_ps(m[2][0], x),
+                _mm_mul_ps(m[2][1], y)), _mm_mul_ps(m[2][2], z)));
+        }
+#endif
+
+        for (; i < count; ++i) {
+            Float x = batch.ox[i], y = batch.oy[i], z = batch.oz[i];
+            batch.ox[i] = M.m[0][0] * x + M.m[0][1] * y + M.m[0][2] * z + M.m[0][3];
+            batch.oy[i] = M.m[1][0] * x + M.m[1][1] * y + M.m[1][2] * z + M.m[1][3];
+            batch.oz[i] = M.m[2][0] * x + M.m[2][1] * y + M.m[2][2] * z + M.m[2][3];
+
+            x = batch.dx[i]; y = batch.dy[i]; z = batch.dz[i];
+            batch.dx[i] = M.m[0][0] * x + M.m[0][1] * y + M.m[0][2] * z;
+            batch.dy[i] = M.m[1][0] * x + M.m[1][1] * y + M.m[1][2] * z;
+            batch.dz[i] = M.m[2][0] * x + M.m[2][1] * y + M.m[2][2] * z;
+        }
+    }
+
+    for (i = 0; i < count; ++i)
+        batch.weight[i] = Spectrum(1.0f);
+}
+
 Float PerspectiveCamera::getYFov() const {
     return radToDeg(2*std::atan(
         std::tan(0.5f * degToRad(m_xfov)) / m_aspect));
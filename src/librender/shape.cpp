@@ -24,6 +24,9 @@
 #include <mitsuba/render/emitter.h>
 #include <mitsuba/render/medium.h>
 #include <mitsuba/render/sensor.h>
+#if defined(MTS_HAS_COHERENT_RT)
+#include <mitsuba/core/ray_sse.h>
+#endif
 
 MTS_NAMESPACE_BEGIN
 
@@ -201,6 +204,26 @@ bool Shape::rayIntersect(const Ray &ray, Float mint,
 bool Shape::rayIntersect(const Ray &ray, Float mint,
         Float maxt) const { NotImplementedError("rayIntersect"); }
 
+#if defined(MTS_HAS_COHERENT_RT)
+int Shape::rayIntersectPacket(const RayPacket4 &packet, const Float *mint,
+        const Float *maxt, int masked, Float *t, void * const *temp) const {
+    int hit = 0;
+    for (int i=0; i<4; ++i) {
+        if (masked & (1 << i))
+            continue;
+        Ray ray;
+        for (int axis=0; axis<3; axis++) {
+            ray.o[axis] = packet.o[axis].f[i];
+            ray.d[axis] = packet.d[axis].f[i];
+            ray.dRcp[axis] = packet.dRcp[axis].f[i];
+        }
+        if (rayIntersect(ray, mint[i], maxt[i], t[i], temp[i]))
+            hit |= 1 << i;
+    }
+    return hit;
+}
+#endif
+
 void Shape::fillIntersectionRecord(const Ray &ray,
         const void *temp, Intersection &its) const {
     NotImplementedError("fillIntersectionRecord"); }
@@ -27,6 +27,11 @@
 
 MTS_NAMESPACE_BEGIN
 
+namespace stats {
+    MemoryCounter kdtreeMemory("Kd-trees");
+    MemoryCounter kdtreeBuildMemory("Kd-tree construction (temporary)");
+};
+
 ShapeKDTree::ShapeKDTree() {
 #if !defined(MTS_KD_CONSERVE_MEMORY)
     m_triAccel = NULL;
@@ -36,8 +41,10 @@ ShapeKDTree::ShapeKDTree() {
 
 ShapeKDTree::~ShapeKDTree() {
 #if !defined(MTS_KD_CONSERVE_MEMORY)
-    if (m_triAccel)
+    if (m_triAccel) {
+        stats::kdtreeMemory.release(getPrimitiveCount() * sizeof(TriAccel));
         freeAligned(m_triAccel);
+    }
 #endif
     for (size_t i=0; i<m_shapes.size(); ++i)
         m_shapes[i]->decRef();
@@ -77,6 +84,7 @@ void ShapeKDTree::build() {
     Log(EDebug, "Precomputing triangle intersection information (%s)",
             memString(sizeof(TriAccel)*primCount).c_str());
     m_triAccel = static_cast<TriAccel *>(allocAligned(primCount * sizeof(TriAccel)));
+    stats::kdtreeMemory.allocate(primCount * sizeof(TriAccel));
 
     IndexType idx = 0;
     for (IndexType i=0; i<m_shapes.size(); ++i) {
@@ -316,26 +324,22 @@ void ShapeKDTree::rayIntersectPacket(const RayPacket4 &packet,
                         mitsuba::rayIntersectPacket(kdTri, packet, searchStart.ps, searchEnd.ps, masked.ps, its));
                 } else {
                     const Shape *shape = m_shapes[kdTri.shapeIndex];
+                    void *shapeTemp[4];
+                    for (int i=0; i<4; ++i)
+                        shapeTemp[i] = reinterpret_cast<uint8_t *>(temp)
+                            + i * MTS_KD_INTERSECTION_TEMP + 2*sizeof(IndexType);
+
+                    SSEVector t;
+                    int hit = shape->rayIntersectPacket(packet, searchStart.f, searchEnd.f,
+                        _mm_movemask_ps(masked.ps), t.f, shapeTemp);
 
                     for (int i=0; i<4; ++i) {
-                        if (masked.i[i])
+                        if (!(hit & (1 << i)))
                             continue;
-                        Ray ray;
-                        for (int axis=0; axis<3; axis++) {
-                            ray.o[axis] = packet.o[axis].f[i];
-                            ray.d[axis] = packet.d[axis].f[i];
-                            ray.dRcp[axis] = packet.dRcp[axis].f[i];
-                        }
-                        Float t;
-
-                        if (shape->rayIntersect(ray, searchStart.f[i], searchEnd.f[i], t,
-                                reinterpret_cast<uint8_t *>(temp)
-                                + i * MTS_KD_INTERSECTION_TEMP + 2*sizeof(IndexType))) {
-                            its.t.f[i] = t;
-                            its.shapeIndex.i[i] = kdTri.shapeIndex;
-                            its.primIndex.i[i] = KNoTriangleFlag;
-                            itsFound.i[i] = 0xFFFFFFFF;
-                        }
+                        its.t.f[i] = t.f[i];
+                        its.shapeIndex.i[i] = kdTri.shapeIndex;
+                        its.primIndex.i[i] = KNoTriangleFlag;
+                        itsFound.i[i] = 0xFFFFFFFF;
                     }
                 }
                 searchEnd.ps = _mm_min_ps(searchEnd.ps, its.t.ps);
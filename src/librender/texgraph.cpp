@@ -0,0 +1,352 @@
+/*
+    This file is part of Mitsuba, a physically based rendering system.
+
+    Copyright (c) 2007-2014 by Wenzel Jakob and others.
+
+    Mitsuba is free software; you can redistribute it and/or modify
+    it under the terms of the GNU General Public License Version 3
+    as published by the Free Software Foundation.
+
+    Mitsuba is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program. If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include <mitsuba/render/texgraph.h>
+#include <mitsuba/render/shape.h>
+
+MTS_NAMESPACE_BEGIN
+
+namespace {
+    /// Number of register operands read by an instruction
+    inline int getOperandCount(uint16_t op) {
+        switch (op) {
+            case TextureProgram::EAdd:
+            case TextureProgram::ESubtract:
+            case TextureProgram::EMultiply:
+                return 2;
+            case TextureProgram::EScale:
+                return 1;
+            default:
+                return 0;
+        }
+    }
+
+    inline Point2 transformUV(const TextureProgram::UVTransform &t, const Intersection &its) {
+        return Point2(its.uv.x * t.scale.x, its.uv.y * t.scale.y) + t.offset;
+    }
+
+    /* Same patterns as in the 'checkerboard' and 'gridtexture' plugins */
+    inline bool checkerParity(const Point2 &uv) {
+        int x = 2*math::modulo((int) (uv.x * 2), 2) - 1,
+            y = 2*math::modulo((int) (uv.y * 2), 2) - 1;
+        return x*y == 1;
+    }
+
+    inline bool gridLine(const Point2 &uv, Float lineWidth) {
+        Float x = uv.x - math::floorToInt(uv.x);
+        Float y = uv.y - math::floorToInt(uv.y);
+
+        if (x > .5)
+            x -= 1;
+        if (y > .5)
+            y -= 1;
+
+        return std::abs(x) < lineWidth || std::abs(y) < lineWidth;
+    }
+}
+
+TextureProgram::TextureProgram(const Texture *texture)
+    : m_nodeCount(0), m_registerCount(0), m_result(0) {
+    int result = compile(texture);
+    m_compiled.clear();
+    optimize(result);
+}
+
+int TextureProgram::emit(EOpcode op, int a, int b) {
+    if (m_code.size() >= 0xFFFF)
+        Log(EError, "The texture network is too large to be compiled!");
+    int dst = (int) m_code.size();
+    m_code.push_back(Instruction(op, dst, a, b));
+    return dst;
+}
+
+bool TextureProgram::getConstant(int reg, Spectrum &value) const {
+    const Instruction &instr = m_code[reg];
+    if (instr.op != EConstant)
+        return false;
+    value = m_constants[instr.a];
+    return true;
+}
+
+int TextureProgram::compile(const Texture *texture) {
+    /* Shared subgraphs only need to be evaluated once */
+    std::map<const Texture *, int>::const_iterator it = m_compiled.find(texture);
+    if (it != m_compiled.end())
+        return it->second;
+
+    ++m_nodeCount;
+    int result;
+    if (texture->isConstant())
+        result = constant(texture->getAverage());
+    else
+        result = texture->compile(this);
+
+    m_compiled[texture] = result;
+    return result;
+}
+
+int TextureProgram::constant(const Spectrum &value) {
+    m_constants.push_back(value);
+    return emit(EConstant, (int) m_constants.size() - 1);
+}
+
+int TextureProgram::texture(const Texture *texture) {
+    m_textures.push_back(texture);
+    return emit(ETexture, (int) m_textures.size() - 1);
+}
+
+int TextureProgram::add(int a, int b) {
+    Spectrum va, vb;
+    bool ca = getConstant(a, va), cb = getConstant(b, vb);
+    if (ca && cb)
+        return constant(va + vb);
+    else if (ca && va.isZero())
+        return b;
+    else if (cb && vb.isZero())
+        return a;
+    return emit(EAdd, a, b);
+}
+
+int TextureProgram::subtract(int a, int b) {
+    Spectrum va, vb;
+    bool ca = getConstant(a, va), cb = getConstant(b, vb);
+    if (ca && cb)
+        return constant(va - vb);
+    else if (cb && vb.isZero())
+        return a;
+    return emit(ESubtract, a, b);
+}
+
+int TextureProgram::multiply(int a, int b) {
+    Spectrum value;
+    if (getConstant(b, value))
+        return scale(a, value);
+    else if (getConstant(a, value))
+        return scale(b, value);
+    return emit(EMultiply, a, b);
+}
+
+int TextureProgram::scale(int a, const Spectrum &factor) {
+    if (factor == Spectrum(1.0f))
+        return a;
+    else if (factor.isZero())
+        return constant(Spectrum(0.0f));
+
+    const Instruction instr = m_code[a];
+    switch (instr.op) {
+        case EConstant:
+            return constant(m_constants[instr.a] * factor);
+
+        case EScale:
+            /* Merge chains of scaling operations */
+            return scale(instr.a, m_constants[instr.b] * factor);
+
+        case ECheckerboard:
+        case EGrid: {
+                /* Scale the two colors of the pattern instead */
+                m_constants.push_back(m_constants[instr.b] * factor);
+                m_constants.push_back(m_constants[instr.b + 1] * factor);
+                return emit((EOpcode) instr.op, instr.a, (int) m_constants.size() - 2);
+            }
+
+        default:
+            m_constants.push_back(factor);
+            return emit(EScale, a, (int) m_constants.size() - 1);
+    }
+}
+
+int TextureProgram::checkerboard(const Point2 &uvOffset, const Vector2 &uvScale,
+        const Spectrum &color0, const Spectrum &color1) {
+    if (color0 == color1)
+        return constant(color0);
+    m_uvTransforms.push_back(UVTransform(uvOffset, uvScale, 0.0f));
+    m_constants.push_back(color0);
+    m_constants.push_back(color1);
+    return emit(ECheckerboard, (int) m_uvTransforms.size() - 1,
+        (int) m_constants.size() - 2);
+}
+
+int TextureProgram::grid(const Point2 &uvOffset, const Vector2 &uvScale,
+        Float lineWidth, const Spectrum &color0, const Spectrum &color1) {
+    if (color0 == color1)
+        return constant(color0);
+    m_uvTransforms.push_back(UVTransform(uvOffset, uvScale, lineWidth));
+    m_constants.push_back(color0);
+    m_constants.push_back(color1);
+    return emit(EGrid, (int) m_uvTransforms.size() - 1,
+        (int) m_constants.size() - 2);
+}
+
+void TextureProgram::optimize(int result) {
+    size_t count = m_code.size();
+
+    /* Find the instructions that contribute to the result */
+    std::vector<bool> live(count, false);
+    live[result] = true;
+    for (int i=(int) count-1; i>=0; --i) {
+        if (!live[i])
+            continue;
+        const Instruction &instr = m_code[i];
+        int operands = getOperandCount(instr.op);
+        if (operands > 0)
+            live[instr.a] = true;
+        if (operands > 1)
+            live[instr.b] = true;
+    }
+
+    /* Determine the last instruction reading each temporary */
+    std::vector<int> lastUse(count, -1);
+    for (size_t i=0; i<count; ++i) {
+        if (!live[i])
+            continue;
+        const Instruction &instr = m_code[i];
+        int operands = getOperandCount(instr.op);
+        if (operands > 0)
+            lastUse[instr.a] = (int) i;
+        if (operands > 1)
+            lastUse[instr.b] = (int) i;
+    }
+    lastUse[result] = (int) count;
+
+    /* Linear scan register allocation. Operands are released before
+       the destination is assigned, since all instructions read their
+       inputs before writing the output */
+    std::vector<int> physical(count, -1), freeList;
+    std::vector<Instruction> code;
+    code.reserve(count);
+    m_registerCount = 0;
+
+    for (size_t i=0; i<count; ++i) {
+        if (!live[i])
+            continue;
+        Instruction instr = m_code[i];
+        int operands = getOperandCount(instr.op);
+        int a = operands > 0 ? physical[instr.a] : instr.a,
+            b = operands > 1 ? physical[instr.b] : instr.b;
+
+        if (operands > 0 && lastUse[instr.a] == (int) i)
+            freeList.push_back(a);
+        if (operands > 1 && lastUse[instr.b] == (int) i && instr.b != instr.a)
+            freeList.push_back(b);
+
+        int dst;
+        if (!freeList.empty()) {
+            dst = freeList.back();
+            freeList.pop_back();
+        } else {
+            dst = m_registerCount++;
+        }
+
+        physical[i] = dst;
+        instr.dst = (uint16_t) dst;
+        instr.a = (uint16_t) a;
+        instr.b = (uint16_t) b;
+        code.push_back(instr);
+    }
+
+    m_code = code;
+    m_result = physical[result];
+}
+
+const Texture *TextureProgram::getPassthrough() const {
+    if (m_code.size() == 1 && m_code[0].op == ETexture)
+        return m_textures[m_code[0].a].get();
+    return NULL;
+}
+
+Spectrum TextureProgram::eval(const Intersection &its, bool filter) const {
+    Spectrum *r = (Spectrum *) alloca(m_registerCount * sizeof(Spectrum));
+
+    for (std::vector<Instruction>::const_iterator it = m_code.begin();
+            it != m_code.end(); ++it) {
+        const Instruction &instr = *it;
+        switch (instr.op) {
+            case EConstant:
+                r[instr.dst] = m_constants[instr.a];
+                break;
+
+            case ETexture:
+                r[instr.dst] = m_textures[instr.a]->eval(its, filter);
+                break;
+
+            case EAdd:
+                r[instr.dst] = r[instr.a] + r[instr.b];
+                break;
+
+            case ESubtract:
+                r[instr.dst] = r[instr.a] - r[instr.b];
+                break;
+
+            case EMultiply:
+                r[instr.dst] = r[instr.a] * r[instr.b];
+                break;
+
+            case EScale:
+                r[instr.dst] = r[instr.a] * m_constants[instr.b];
+                break;
+
+            case ECheckerboard:
+                r[instr.dst] = m_constants[instr.b +
+                    (checkerParity(transformUV(m_uvTransforms[instr.a], its)) ? 0 : 1)];
+                break;
+
+            case EGrid: {
+                    const UVTransform &t = m_uvTransforms[instr.a];
+                    r[instr.dst] = m_constants[instr.b +
+                        (gridLine(transformUV(t, its), t.param) ? 1 : 0)];
+                }
+                break;
+
+            default:
+                Log(EError, "Unknown texture program instruction!");
+        }
+    }
+
+    return r[m_result];
+}
+
+std::string TextureProgram::toString() const {
+    std::ostringstream oss;
+    oss << "TextureProgram[" << endl
+        << "  nodeCount = " << m_nodeCount << "," << endl
+        << "  registerCount = " << m_registerCount << "," << endl
+        << "  code = {" << endl;
+    for (size_t i=0; i<m_code.size(); ++i) {
+        const Instruction &instr = m_code[i];
+        oss << "    r" << instr.dst << " = ";
+        switch (instr.op) {
+            case EConstant: oss << m_constants[instr.a].toString(); break;
+            case ETexture: oss << m_textures[instr.a]->getClass()->getName() << "->eval()"; break;
+            case EAdd: oss << "r" << instr.a << " + r" << instr.b; break;
+            case ESubtract: oss << "r" << instr.a << " - r" << instr.b; break;
+            case EMultiply: oss << "r" << instr.a << " * r" << instr.b; break;
+            case EScale: oss << "r" << instr.a << " * " << m_constants[instr.b].toString(); break;
+            case ECheckerboard: oss << "checkerboard(uv" << instr.a << ")"; break;
+            case EGrid: oss << "grid(uv" << instr.a << ")"; break;
+            default: oss << "<unknown>";
+        }
+        oss << endl;
+    }
+    oss << "  }," << endl
+        << "  result = r" << m_result << endl
+        << "]";
+    return oss.str();
+}
+
+MTS_IMPLEMENT_CLASS(TextureProgram, false, Object)
+MTS_NAMESPACE_END
@@ -18,6 +18,7 @@
 
 #include <mitsuba/render/scene.h>
 #include <mitsuba/render/mipmap.h>
+#include <mitsuba/render/texgraph.h>
 
 MTS_NAMESPACE_BEGIN
 
@@ -26,6 +27,7 @@ namespace stats {
     StatsCounter clampedAnisotropy("Texture system", "Lookups with clamped anisotropy", EPercentage);
     StatsCounter avgEWASamples("Texture system", "Average EWA samples / lookup", EAverage);
     StatsCounter filteredLookups("Texture system", "Filtered texture lookups", EPercentage);
+    MemoryCounter mipMemory("MIP maps");
 
 }
 
@@ -54,6 +56,10 @@ ref<Texture> Texture::expand() {
     return this;
 }
 
+int Texture::compile(TextureProgram *program) const {
+    return program->texture(this);
+}
+
 void Texture::evalGradient(const Intersection &_its, Spectrum *gradient) const {
     const Float eps = Epsilon;
     Intersection its(_its);
@@ -115,11 +121,17 @@ Spectrum Texture2D::eval(const Intersection &its, bool filter) const {
         return eval(uv,
             Vector2(its.dudx * m_uvScale.x, its.dvdx * m_uvScale.y),
             Vector2(its.dudy * m_uvScale.x, its.dvdy * m_uvScale.y));
+    } else if (its.uvFootprint > 0 && filter) {
+        return evalLOD(uv, its.uvFootprint * std::max(m_uvScale.x, m_uvScale.y));
     } else {
         return eval(uv);
     }
 }
 
+Spectrum Texture2D::evalLOD(const Point2 &uv, Float width) const {
+    return eval(uv, Vector2(width, 0), Vector2(0, width));
+}
+
 void Texture2D::evalGradient(const Intersection &its, Spectrum *gradient) const {
     Point2 uv = Point2(its.uv.x * m_uvScale.x, its.uv.y * m_uvScale.y) + m_uvOffset;
 
@@ -37,12 +37,16 @@
 
 MTS_NAMESPACE_BEGIN
 
+namespace stats {
+    MemoryCounter meshMemory("Triangle meshes");
+};
+
 TriMesh::TriMesh(const std::string &name, size_t triangleCount,
         size_t vertexCount, bool hasNormals, bool hasTexcoords,
         bool hasVertexColors, bool flipNormals, bool faceNormals)
     : Shape(Properties()), m_triangleCount(triangleCount),
       m_vertexCount(vertexCount), m_flipNormals(flipNormals),
-      m_faceNormals(faceNormals) {
+      m_faceNormals(faceNormals), m_memoryUsage(0) {
     m_name = name;
     m_triangles = new Triangle[m_triangleCount];
     m_positions = new Point[m_vertexCount];
@@ -50,14 +54,16 @@ TriMesh::TriMesh(const std::string &name, size_t triangleCount,
     m_texcoords = hasTexcoords ? new Point2[m_vertexCount] : NULL;
     m_colors = hasVertexColors ? new Color3[m_vertexCount] : NULL;
     m_tangents = NULL;
+    m_curvatures = NULL;
     m_surfaceArea = m_invSurfaceArea = -1;
     m_mutex = new Mutex();
+    updateMemoryUsage();
 }
 
 TriMesh::TriMesh(const Properties &props)
  : Shape(props), m_triangles(NULL), m_positions(NULL),
     m_normals(NULL), m_texcoords(NULL), m_tangents(NULL),
-    m_colors(NULL) {
+    m_colors(NULL), m_curvatures(NULL), m_memoryUsage(0) {
 
     /* By default, any existing normals will be used for
        rendering. If no normals are found, Mitsuba will
@@ -79,10 +85,11 @@ TriMesh::TriMesh(const Properties &props)
 TriMesh::TriMesh(Stream *stream, int index)
         : Shape(Properties()), m_triangles(NULL),
     m_positions(NULL), m_normals(NULL), m_texcoords(NULL),
-    m_tangents(NULL), m_colors(NULL) {
+    m_tangents(NULL), m_colors(NULL), m_curvatures(NULL), m_memoryUsage(0) {
 
     m_mutex = new Mutex();
     loadCompressed(stream, index);
+    updateMemoryUsage();
 }
 
 /* Flags used to identify available data during serialization */
@@ -97,7 +104,8 @@ enum ETriMeshFlags {
 };
 
 TriMesh::TriMesh(Stream *stream, InstanceManager *manager)
-    : Shape(stream, manager), m_tangents(NULL) {
+    : Shape(stream, manager), m_tangents(NULL), m_curvatures(NULL),
+      m_memoryUsage(0) {
     m_name = stream->readString();
     m_aabb = AABB(stream);
 
@@ -142,6 +150,7 @@ TriMesh::TriMesh(Stream *stream, InstanceManager *manager)
     m_surfaceArea = m_invSurfaceArea = -1;
     m_mutex = new Mutex();
     configure();
+    updateMemoryUsage();
 }
 
 static void readHelper(Stream *stream, bool fileDoublePrecision,
@@ -337,6 +346,7 @@ int TriMesh::readOffsetDictionary(Stream *stream, short version,
 }
 
 TriMesh::~TriMesh() {
+    stats::meshMemory.release(m_memoryUsage);
     if (m_positions)
         delete[] m_positions;
     if (m_normals)
@@ -347,6 +357,8 @@ TriMesh::~TriMesh() {
         delete[] m_tangents;
     if (m_colors)
         delete[] m_colors;
+    if (m_curvatures)
+        delete[] m_curvatures;
     if (m_triangles)
         delete[] m_triangles;
 }
@@ -383,6 +395,26 @@ void TriMesh::configure() {
     /* For manifold exploration: always compute UV tangents when a glossy material
        is involved. TODO: find a way to avoid this expense (compute on demand?) */
     computeUVTangents();
+
+    updateMemoryUsage();
+}
+
+void TriMesh::updateMemoryUsage() {
+    size_t usage = m_triangleCount * sizeof(Triangle);
+    if (m_positions)
+        usage += m_vertexCount * sizeof(Point);
+    if (m_normals)
+        usage += m_vertexCount * sizeof(Normal);
+    if (m_texcoords)
+        usage += m_vertexCount * sizeof(Point2);
+    if (m_colors)
+        usage += m_vertexCount * sizeof(Color3);
+    if (m_tangents)
+        usage += m_triangleCount * sizeof(TangentSpace);
+    if (m_curvatures)
+        usage += m_vertexCount * sizeof(Vector2);
+    stats::meshMemory.update(m_memoryUsage, usage);
+    m_memoryUsage = usage;
 }
 
 void TriMesh::prepareSamplingTable() {
@@ -481,6 +513,11 @@ void TriMesh::rebuildTopology(Float maxAngle) {
         m_tangents = NULL;
     }
 
+    if (m_curvatures) {
+        delete[] m_curvatures;
+        m_curvatures = NULL;
+    }
+
     Log(EInfo, "Rebuilding the topology of \"%s\" (" SIZE_T_FMT
             " triangles, " SIZE_T_FMT " vertices, max. angle = %f)",
             m_name.c_str(), m_triangleCount, m_vertexCount, maxAngle);
@@ -822,6 +859,146 @@ void TriMesh::getNormalDerivative(const Intersection &its,
     }
 }
 
+void TriMesh::computeCurvature() {
+    if (m_curvatures)
+        return;
+
+    LockGuard guard(m_mutex);
+    if (m_curvatures)
+        return;
+
+    Vector2 *curvatures = new Vector2[m_vertexCount];
+    if (!m_normals || m_triangleCount == 0) {
+        /* Consistent with getNormalDerivative(): no shading normals, no curvature */
+        std::fill(curvatures, curvatures + m_vertexCount, Vector2(0.0f));
+        m_curvatures = curvatures;
+        updateMemoryUsage();
+        return;
+    }
+
+    ref<Timer> timer = new Timer();
+
+    /* 1. Curvature and angle at each triangle corner */
+    std::vector<Vector2> cornerCurvature(m_triangleCount * 3);
+    std::vector<Float> cornerWeight(m_triangleCount * 3);
+
+    #if defined(MTS_OPENMP)
+        #pragma omp parallel for
+    #endif
+    for (int i=0; i<(int) m_triangleCount; ++i) {
+        const Triangle &tri = m_triangles[i];
+        const Point &p0 = m_positions[tri.idx[0]];
+        const Normal &n0 = m_normals[tri.idx[0]],
+                     &n1 = m_normals[tri.idx[1]],
+                     &n2 = m_normals[tri.idx[2]];
+
+        /* First fundamental form of the barycentric parameterization */
+        Vector dpdu = m_positions[tri.idx[1]] - p0,
+               dpdv = m_positions[tri.idx[2]] - p0;
+        Float E = dot(dpdu, dpdu), F = dot(dpdu, dpdv), G = dot(dpdv, dpdv),
+              det = E*G - F*F;
+
+        for (int j=0; j<3; ++j) {
+            size_t corner = 3*i + j;
+            const Normal &nc = m_normals[tri.idx[j]];
+            Float il = 1.0f / nc.length();
+            Vector e0 = m_positions[tri.idx[(j+1)%3]] - m_positions[tri.idx[j]],
+                   e1 = m_positions[tri.idx[(j+2)%3]] - m_positions[tri.idx[j]];
+            Float l0 = e0.length(), l1 = e1.length();
+
+            /* Skip (nearly) degenerate triangles */
+            if (det <= 1e-6f * E * G || !std::isfinite(il) || l0 == 0 || l1 == 0) {
+                cornerCurvature[corner] = Vector2(0.0f);
+                cornerWeight[corner] = 0.0f;
+                continue;
+            }
+
+            /* Derivative of the normalized, interpolated normal (see
+               getNormalDerivative()) and second fundamental form */
+            Normal N(nc * il);
+            Vector dndu = (n1 - n0) * il, dndv = (n2 - n0) * il;
+            dndu -= N * dot(N, dndu);
+            dndv -= N * dot(N, dndv);
+
+            Float e = -dot(dpdu, dndu),
+                  f = -dot(dpdv, dndu),
+                  g = -dot(dpdv, dndv),
+                  invDet = 1.0f / det;
+
+            cornerCurvature[corner] = Vector2(
+                .5f*(e*G - 2*f*F + g*E) * invDet,
+                (e*g - f*f) * invDet);
+            cornerWeight[corner] = math::safe_acos(dot(e0, e1) / (l0 * l1));
+        }
+    }
+
+    /* 2. Vertex to corner adjacency in compressed form */
+    std::vector<uint32_t> offsets(m_vertexCount + 1, 0);
+    std::vector<uint32_t> corners(m_triangleCount * 3);
+    for (size_t i=0; i<m_triangleCount; ++i)
+        for (int j=0; j<3; ++j)
+            offsets[m_triangles[i].idx[j] + 1]++;
+    for (size_t i=0; i<m_vertexCount; ++i)
+        offsets[i+1] += offsets[i];
+    std::vector<uint32_t> fill(offsets.begin(), offsets.end() - 1);
+    for (size_t i=0; i<m_triangleCount; ++i)
+        for (int j=0; j<3; ++j)
+            corners[fill[m_triangles[i].idx[j]]++] = (uint32_t) (3*i + j);
+
+    /* 3. Angle-weighted average over the corners of each vertex */
+    #if defined(MTS_OPENMP)
+        #pragma omp parallel for
+    #endif
+    for (int i=0; i<(int) m_vertexCount; ++i) {
+        Vector2 sum(0.0f);
+        Float weight = 0.0f;
+        for (uint32_t k=offsets[i]; k<offsets[i+1]; ++k) {
+            sum += cornerCurvature[corners[k]] * cornerWeight[corners[k]];
+            weight += cornerWeight[corners[k]];
+        }
+        curvatures[i] = weight > 0 ? sum / weight : Vector2(0.0f);
+    }
+
+    m_curvatures = curvatures;
+    updateMemoryUsage();
+
+    Log(EDebug, "Precomputed the curvature of \"%s\" (" SIZE_T_FMT
+        " vertices) in %i ms", m_name.c_str(), m_vertexCount,
+        timer->getMilliseconds());
+}
+
+void TriMesh::lookupCurvature(const Intersection &its, Float &H, Float &K) const {
+    Assert(m_curvatures && its.primIndex < m_triangleCount);
+
+    const Triangle &tri = m_triangles[its.primIndex];
+    const Point &p0 = m_positions[tri.idx[0]];
+
+    /* Recompute the barycentric coordinates (see getNormalDerivative()) */
+    Vector rel = its.p - p0,
+           du = m_positions[tri.idx[1]] - p0,
+           dv = m_positions[tri.idx[2]] - p0;
+
+    Float b1  = dot(du, rel), b2 = dot(dv, rel),
+          a11 = dot(du, du), a12 = dot(du, dv),
+          a22 = dot(dv, dv),
+          det = a11 * a22 - a12 * a12;
+
+    if (det == 0) {
+        H = K = 0.0f;
+        return;
+    }
+
+    Float invDet = 1.0f / det,
+          u = ( a22 * b1 - a12 * b2) * invDet,
+          v = (-a12 * b1 + a11 * b2) * invDet;
+
+    Vector2 value = m_curvatures[tri.idx[0]] * (1 - u - v)
+        + m_curvatures[tri.idx[1]] * u + m_curvatures[tri.idx[2]] * v;
+
+    H = value.x;
+    K = value.y;
+}
+
 ref<TriMesh> TriMesh::createTriMesh() {
     return this;
 }
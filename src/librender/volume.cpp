@@ -25,6 +25,10 @@
 
 MTS_NAMESPACE_BEGIN
 
+namespace stats {
+    MemoryCounter volumeMemory("Volume data");
+};
+
 VolumeDataSource::VolumeDataSource(Stream *stream, InstanceManager *manager) :
     ConfigurableObject(stream, manager) {
     m_aabb = AABB(stream);
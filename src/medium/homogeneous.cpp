@@ -17,6 +17,9 @@
 */
 
 #include <mitsuba/render/scene.h>
+#if defined(MTS_SSE) && defined(SINGLE_PRECISION)
+#include <mitsuba/core/ssemath.h>
+#endif
 #include "maxexp.h"
 
 MTS_NAMESPACE_BEGIN
@@ -250,9 +253,12 @@ public:
     void configure() {
         Medium::configure();
         m_albedo = 0;
+        m_grey = true;
         for (int i=0; i<SPECTRUM_SAMPLES; ++i) {
             if (m_sigmaT[i] != 0)
                 m_albedo = std::max(m_albedo, m_sigmaS[i]/m_sigmaT[i]);
+            if (m_sigmaT[i] != m_sigmaT[0])
+                m_grey = false;
         }
     }
 
@@ -263,15 +269,62 @@ public:
         stream->writeFloat(m_mediumSamplingWeight);
     }
 
-    Spectrum evalTransmittance(const Ray &ray, Sampler *) const {
-        Float negLength = ray.mint - ray.maxt;
+    /**
+     * \brief Compute exp(-sigma_t * distance)
+     *
+     * Grey media (e.g. haze) only need a single exponentiation, and
+     * RGB media evaluate all channels at once using SSE.
+     */
+    inline Spectrum computeTransmittance(Float distance) const {
+        if (m_grey)
+            return Spectrum(m_sigmaT[0] != 0
+                ? math::fastexp(-m_sigmaT[0] * distance) : (Float) 1.0f);
+
         Spectrum transmittance;
+#if defined(MTS_SSE) && defined(SINGLE_PRECISION) && SPECTRUM_SAMPLES == 3
+        const __m128 sigmaT = _mm_set_ps(0.0f, m_sigmaT[2], m_sigmaT[1], m_sigmaT[0]),
+            isZero = _mm_cmpeq_ps(sigmaT, _mm_setzero_ps());
+        SSEVector value;
+
+        /* Channels without extinction stay at one (even for infinite distances) */
+        value.ps = math::exp_ps(_mm_mul_ps(sigmaT, _mm_set1_ps(-distance)));
+        value.ps = _mm_or_ps(_mm_and_ps(isZero, SSEConstants::one.ps),
+            _mm_andnot_ps(isZero, value.ps));
+        for (int i=0; i<3; ++i)
+            transmittance[i] = value.f[i];
+#else
         for (int i=0; i<SPECTRUM_SAMPLES; ++i)
             transmittance[i] = m_sigmaT[i] != 0
-                ? math::fastexp(m_sigmaT[i] * negLength) : (Float) 1.0f;
+                ? math::fastexp(-m_sigmaT[i] * distance) : (Float) 1.0f;
+#endif
         return transmittance;
     }
 
+    Spectrum evalTransmittance(const Ray &ray, Sampler *) const {
+        return computeTransmittance(ray.maxt - ray.mint);
+    }
+
+    void evalTransmittanceBatch(const Ray *rays, size_t count,
+            Spectrum *result, Sampler *) const {
+        size_t i = 0;
+#if defined(MTS_SSE) && defined(SINGLE_PRECISION)
+        if (m_grey && m_sigmaT[0] != 0) {
+            /* Exponentiate the lengths of four segments at a time */
+            const __m128 negSigmaT = _mm_set1_ps(-m_sigmaT[0]);
+            for (; i + 4 <= count; i += 4) {
+                SSEVector value;
+                value.ps = math::exp_ps(_mm_mul_ps(negSigmaT, _mm_set_ps(
+                    rays[i+3].maxt - rays[i+3].mint, rays[i+2].maxt - rays[i+2].mint,
+                    rays[i+1].maxt - rays[i+1].mint, rays[i].maxt - rays[i].mint)));
+                for (int j=0; j<4; ++j)
+                    result[i+j] = Spectrum(value.f[j]);
+            }
+        }
+#endif
+        for (; i < count; ++i)
+            result[i] = computeTransmittance(rays[i].maxt - rays[i].mint);
+    }
+
     bool sampleDistance(const Ray &ray, MediumSamplingRecord &mRec,
             Sampler *sampler) const {
         Float rand = sampler->next1D(), sampledDistance;
@@ -314,21 +367,17 @@ public:
             success = false;
         }
 
+        /* The spectral MIS densities below reuse these exponentials */
+        mRec.transmittance = computeTransmittance(sampledDistance);
+
         switch (m_strategy) {
             case EMaximum:
                 mRec.pdfFailure = 1-m_maxExpDist->cdf(sampledDistance);
                 break;
 
             case EBalance:
-                mRec.pdfFailure = 0;
-                mRec.pdfSuccess = 0;
-                for (int i=0; i<SPECTRUM_SAMPLES; ++i) {
-                    Float tmp = math::fastexp(-m_sigmaT[i] * sampledDistance);
-                    mRec.pdfFailure += tmp;
-                    mRec.pdfSuccess += m_sigmaT[i] * tmp;
-                }
-                mRec.pdfFailure /= SPECTRUM_SAMPLES;
-                mRec.pdfSuccess /= SPECTRUM_SAMPLES;
+                mRec.pdfFailure = mRec.transmittance.average();
+                mRec.pdfSuccess = (m_sigmaT * mRec.transmittance).average();
                 break;
 
             case ESingle:
@@ -341,7 +390,6 @@ public:
                 Log(EError, "Unknown sampling strategy!");
         }
 
-        mRec.transmittance = (m_sigmaT * (-sampledDistance)).exp();
         mRec.pdfSuccessRev = mRec.pdfSuccess = mRec.pdfSuccess * m_mediumSamplingWeight;
         mRec.pdfFailure = m_mediumSamplingWeight * mRec.pdfFailure + (1-m_mediumSamplingWeight);
         mRec.medium = this;
@@ -353,6 +401,8 @@ public:
 
     void eval(const Ray &ray, MediumSamplingRecord &mRec) const {
         Float distance = ray.maxt - ray.mint;
+        mRec.transmittance = computeTransmittance(distance);
+
         switch (m_strategy) {
             case EManual:
             case ESingle: {
@@ -362,17 +412,9 @@ public:
                 }
                 break;
 
-            case EBalance: {
-                    mRec.pdfSuccess = 0;
-                    mRec.pdfFailure = 0;
-                    for (int i=0; i<SPECTRUM_SAMPLES; ++i) {
-                        Float temp = math::fastexp(-m_sigmaT[i] * distance);
-                        mRec.pdfSuccess += m_sigmaT[i] * temp;
-                        mRec.pdfFailure += temp;
-                    }
-                    mRec.pdfSuccess /= SPECTRUM_SAMPLES;
-                    mRec.pdfFailure /= SPECTRUM_SAMPLES;
-                }
+            case EBalance:
+                mRec.pdfSuccess = (m_sigmaT * mRec.transmittance).average();
+                mRec.pdfFailure = mRec.transmittance.average();
                 break;
 
             case EMaximum:
@@ -384,7 +426,6 @@ public:
                 Log(EError, "Unknown sampling strategy!");
         }
 
-        mRec.transmittance = (m_sigmaT * (-distance)).exp();
         mRec.pdfSuccess = mRec.pdfSuccessRev = mRec.pdfSuccess * m_mediumSamplingWeight;
         mRec.pdfFailure = mRec.pdfFailure * m_mediumSamplingWeight + (1-m_mediumSamplingWeight);
         mRec.sigmaA = m_sigmaA;
@@ -427,6 +468,7 @@ private:
     ESamplingStrategy m_strategy;
     MaxExpDist *m_maxExpDist;
     Float m_albedo;
+    bool m_grey;
 };
 
 MTS_IMPLEMENT_CLASS_S(HomogeneousMedium, false, Medium)
@@ -27,6 +27,7 @@
 #include <mitsuba/core/sched_remote.h>
 #include <mitsuba/core/sstream.h>
 #include <mitsuba/core/fresolver.h>
+#include <mitsuba/core/timer.h>
 #include <mitsuba/core/fstream.h>
 #include <mitsuba/core/appender.h>
 #include <mitsuba/core/sshstream.h>
@@ -74,6 +75,32 @@ void help() {
     cout <<  "   -j count    Simultaneously schedule several scenes. Can sometimes accelerate" << endl;
     cout <<  "               rendering when large amounts of processing power are available" << endl;
     cout <<  "               (e.g. when running Mitsuba on a cluster. Default: 1)" << endl << endl;
+    cout <<  "   -m          Render every sensor of the scene. The scene is loaded only once," << endl;
+    cout <<  "               and its geometry, textures and kd-tree are shared by all sensors." << endl;
+    cout <<  "               The output file names are suffixed with the sensor ID (or index)" << endl << endl;
+    cout <<  "   -V file     Render several variants of each scene. Every line of the file" << endl;
+    cout <<  "               specifies one variant as a list of key=val definitions (which" << endl;
+    cout <<  "               override those given with -D). The output file names are" << endl;
+    cout <<  "               suffixed with the variant number" << endl << endl;
+    cout <<  "   -F a:b[:s]  Render the frames a to b (with step size s) of an animation." << endl;
+    cout <<  "               The parameters \"$frame\" and \"$time\" are available in the scene," << endl;
+    cout <<  "               and the shutter of the sensor opens at the frame time. Unchanged" << endl;
+    cout <<  "               objects and kd-trees are reused across frames, and the next" << endl;
+    cout <<  "               frame is loaded while the current one renders" << endl << endl;
+    cout <<  "   -f rate     Frame rate of the animation, i.e. frames per unit of scene" << endl;
+    cout <<  "               time (default: 1)" << endl << endl;
+    cout <<  "   -R x,y,w,h  Only re-render the given rectangle of pixels (can be specified" << endl;
+    cout <<  "               several times). The result is composited into an existing image" << endl;
+    cout <<  "               (see -B), and only affected image blocks are scheduled" << endl << endl;
+    cout <<  "   -O id       Like -R, but use the screen-space bounds of the object with the" << endl;
+    cout <<  "               given ID or name, e.g. after changing its material (can be" << endl;
+    cout <<  "               specified several times)" << endl << endl;
+    cout <<  "   -B file     Full-frame EXR image into which the regions given by -R and -O" << endl;
+    cout <<  "               are composited (default: the existing output file)" << endl << endl;
+    cout <<  "   -S seed     Deterministic mode: derive the random numbers of every block" << endl;
+    cout <<  "               from its position and the given seed, and accumulate image" << endl;
+    cout <<  "               blocks in a fixed order. The output is then bit-identical" << endl;
+    cout <<  "               regardless of the number of local and remote workers" << endl << endl;
     cout <<  "   -n name     Assign a node name to this instance (Default: host name)" << endl << endl;
     cout <<  "   -x          Skip rendering of files where output already exists" << endl << endl;
     cout <<  "   -r sec      Write (partial) output images every 'sec' seconds" << endl << endl;
@@ -88,6 +115,9 @@ void help() {
 
 ref<RenderQueue> renderQueue = NULL;
 
+/// Time since the start of mts_main(), used to report the startup time
+static ref<Timer> startupTimer;
+
 #if !defined(__WINDOWS__)
 /* Handle the hang-up signal and write a partially rendered image to disk */
 void signalHandler(int signal) {
@@ -126,6 +156,154 @@ private:
     int m_timeout;
 };
 
+/// Loads the scene of an animation frame in the background
+class FrameLoader : public Thread {
+public:
+    FrameLoader(const fs::path &filename, const SceneHandler::ParameterMap &params,
+        SceneObjectCache *cache) : Thread("load"), m_filename(filename),
+        m_params(params), m_cache(cache) { }
+
+    void run() {
+        try {
+            m_scene = SceneHandler::loadScene(m_filename, m_params, m_cache);
+            m_cache->purge();
+        } catch (const std::exception &e) {
+            m_error = e.what();
+        }
+    }
+
+    /// Wait until loading has finished and return the scene
+    ref<Scene> getScene() {
+        join();
+        if (!m_error.empty())
+            SLog(EError, "Could not load the animation frame: %s", m_error.c_str());
+        return m_scene;
+    }
+private:
+    fs::path m_filename;
+    SceneHandler::ParameterMap m_params;
+    ref<SceneObjectCache> m_cache;
+    ref<Scene> m_scene;
+    std::string m_error;
+};
+
+/// Start loading an animation frame
+ref<FrameLoader> loadFrame(const fs::path &filename, SceneHandler::ParameterMap params,
+        SceneObjectCache *cache, int frame, Float frameRate) {
+    params["frame"] = formatString("%i", frame);
+    params["time"] = formatString("%f", frame / frameRate);
+    ref<FrameLoader> loader = new FrameLoader(filename, params, cache);
+    loader->start();
+    return loader;
+}
+
+/**
+ * Render the frames of an animation sequence one after the other. All frames
+ * are loaded through a common object cache, hence meshes, textures, etc. that
+ * do not change are only loaded once. The kd-tree is rebuilt only when the
+ * geometry has changed, and frame N+1 is loaded while frame N renders
+ * (without modifying the objects that both frames share).
+ */
+void renderSequence(const fs::path &filename, const fs::path &destination,
+        const SceneHandler::ParameterMap &params, int firstFrame, int lastFrame,
+        int frameStep, Float frameRate, int blockSize, bool skipExisting,
+        bool interactive, bool deterministic, uint32_t seed, int &jobIdx) {
+    ref<SceneObjectCache> cache = new SceneObjectCache();
+    ref<FrameLoader> loader = loadFrame(filename, params, cache, firstFrame, frameRate);
+    ref<Scene> previous;
+
+    for (int frame = firstFrame; frame <= lastFrame; frame += frameStep) {
+        ref<Scene> scene = loader->getScene();
+        loader = NULL;
+
+        /* The previous frame has finished rendering, hence the objects
+           shared with it can now be attached to the new scene */
+        cache->commitParents();
+
+        Float time = frame / frameRate;
+        scene->setSourceFile(filename);
+        scene->setDestinationFile(destination.string() + formatString("_%04i", frame));
+        scene->setBlockSize(blockSize);
+        scene->getSensor()->setShutterOpen(time);
+        if (deterministic)
+            scene->getSampler()->setDeterministic(true, seed);
+
+        if (previous != NULL && scene->reuseKDTree(previous))
+            SLog(EInfo, "Frame %i: geometry is unchanged, reusing the kd-tree", frame);
+
+        if (frame + frameStep <= lastFrame)
+            loader = loadFrame(filename, params, cache, frame + frameStep, frameRate);
+
+        if (scene->destinationExists() && skipExisting)
+            continue;
+
+        SLog(EInfo, "Rendering frame %i (time = %f) ..", frame, time);
+        ref<RenderJob> thr = new RenderJob(formatString("ren%i", jobIdx++),
+            scene, renderQueue, -1, -1, -1, true, interactive);
+        thr->start();
+        renderQueue->waitLeft(0);
+        previous = scene;
+    }
+
+    SLog(EInfo, "Animation finished (object cache: " SIZE_T_FMT " hits, "
+        SIZE_T_FMT " misses)", cache->getHitCount(), cache->getMissCount());
+}
+
+/**
+ * Restrict rendering to dirty rectangles (specified in pixel coordinates of
+ * the full film) and to the screen-space bounds of changed objects. The
+ * film composites the re-rendered regions into the base image if it exists.
+ */
+void setupRegions(Scene *scene, const std::vector<Film::Region> &rects,
+        const std::vector<std::string> &objects, fs::path basePath, bool explicitBase) {
+    Film *film = scene->getFilm();
+    Sensor *sensor = scene->getSensor();
+    std::vector<Film::Region> regions;
+
+    for (size_t i=0; i<rects.size(); ++i)
+        regions.push_back(Film::Region(Point2i(rects[i].offset - film->getCropOffset()),
+            rects[i].size));
+
+    for (size_t i=0; i<objects.size(); ++i) {
+        const ref_vector<Shape> &shapes = scene->getShapes();
+        AABB aabb;
+        for (size_t j=0; j<shapes.size(); ++j) {
+            if (shapes[j]->getID() == objects[i] || shapes[j]->getName() == objects[i])
+                aabb.expandBy(shapes[j]->getAABB());
+        }
+        if (!aabb.isValid())
+            SLog(EError, "Could not find an object named \"%s\"!", objects[i].c_str());
+        if (!(sensor->getType() & Sensor::EProjectiveCamera))
+            SLog(EError, "Deriving dirty regions from objects requires a projective camera!");
+
+        Film::Region region;
+        if (static_cast<ProjectiveCamera *>(sensor)->getScreenBounds(aabb, region.offset, region.size)) {
+            SLog(EInfo, "Object \"%s\" covers %ix%i pixels at (%i, %i)", objects[i].c_str(),
+                region.size.x, region.size.y, region.offset.x, region.offset.y);
+            regions.push_back(region);
+        } else {
+            SLog(EInfo, "Object \"%s\" is not visible", objects[i].c_str());
+        }
+    }
+
+    ref<Bitmap> base;
+    if (!explicitBase && boost::to_lower_copy(basePath.extension().string()) != ".exr")
+        basePath.replace_extension(".exr");
+    if (fs::exists(basePath)) {
+        SLog(EInfo, "Compositing the dirty regions into \"%s\"", basePath.string().c_str());
+        ref<FileStream> stream = new FileStream(basePath, FileStream::EReadOnly);
+        base = new Bitmap(Bitmap::EAuto, stream);
+        if (film->getClass()->getName() != "HDRFilm")
+            SLog(EWarn, "Only the \"hdrfilm\" plugin supports compositing into a base image!");
+    } else if (explicitBase) {
+        SLog(EError, "The base image \"%s\" does not exist!", basePath.string().c_str());
+    } else {
+        SLog(EWarn, "No base image found -- pixels outside of the dirty regions will be black");
+    }
+
+    film->setRegions(regions, base);
+}
+
 int mitsuba_app(int argc, char **argv) {
     int optchar;
     char *end_ptr = NULL;
@@ -137,12 +315,21 @@ int mitsuba_app(int argc, char **argv) {
         std::string nodeName = getHostName(),
                     networkHosts = "", destFile="";
         bool quietMode = false, progressBars = true, skipExisting = false;
+        bool renderAllSensors = false, renderSequenceMode = false;
+        int firstFrame = 0, lastFrame = 0, frameStep = 1;
+        Float frameRate = 1;
         ELogLevel logLevel = EInfo;
         ref<FileResolver> fileResolver = Thread::getThread()->getFileResolver();
         bool treatWarningsAsErrors = false;
-        std::map<std::string, std::string, SimpleStringOrdering> parameters;
+        SceneHandler::ParameterMap parameters;
+        std::vector<SceneHandler::ParameterMap> variants;
         int blockSize = 32;
         int flushTimer = -1;
+        std::vector<Film::Region> regions;
+        std::vector<std::string> regionObjects;
+        std::string baseFile;
+        bool deterministic = false;
+        uint32_t seed = 0;
 
         if (argc < 2) {
             help();
@@ -151,7 +338,7 @@ int mitsuba_app(int argc, char **argv) {
 
         optind = 1;
         /* Parse command-line arguments */
-        while ((optchar = getopt(argc, argv, "a:c:D:s:j:n:o:r:b:p:L:qhzvtwx")) != -1) {
+        while ((optchar = getopt(argc, argv, "a:c:D:s:j:n:o:r:b:p:L:V:F:f:R:O:B:S:qhzvtwxm")) != -1) {
             switch (optchar) {
                 case 'a': {
                         std::vector<std::string> paths = tokenize(optarg, ";");
@@ -184,6 +371,76 @@ int mitsuba_app(int argc, char **argv) {
                         }
                     }
                     break;
+                case 'V': {
+                        std::ifstream is(optarg);
+                        if (is.fail())
+                            SLog(EError, "Could not open variant file!");
+                        std::string line;
+                        while (std::getline(is, line)) {
+                            boost::trim(line);
+                            if (line.length() < 1 || line.c_str()[0] == '#')
+                                continue;
+                            std::vector<std::string> defs = tokenize(line, " \t");
+                            SceneHandler::ParameterMap variant;
+                            for (size_t i=0; i<defs.size(); ++i) {
+                                std::vector<std::string> param = tokenize(defs[i], "=");
+                                if (param.size() != 2)
+                                    SLog(EError, "Invalid parameter specification \"%s\" in variant file",
+                                        defs[i].c_str());
+                                variant[param[0]] = param[1];
+                            }
+                            variants.push_back(variant);
+                        }
+                    }
+                    break;
+                case 'm':
+                    renderAllSensors = true;
+                    break;
+                case 'F': {
+                        std::vector<std::string> range = tokenize(optarg, ":");
+                        if (range.size() < 2 || range.size() > 3)
+                            SLog(EError, "Invalid frame range specification \"%s\"", optarg);
+                        firstFrame = strtol(range[0].c_str(), &end_ptr, 10);
+                        if (*end_ptr == '\0')
+                            lastFrame = strtol(range[1].c_str(), &end_ptr, 10);
+                        if (*end_ptr == '\0' && range.size() == 3)
+                            frameStep = strtol(range[2].c_str(), &end_ptr, 10);
+                        if (*end_ptr != '\0' || frameStep <= 0 || lastFrame < firstFrame)
+                            SLog(EError, "Could not parse the frame range!");
+                        renderSequenceMode = true;
+                    }
+                    break;
+                case 'f':
+                    frameRate = (Float) strtod(optarg, &end_ptr);
+                    if (*end_ptr != '\0' || frameRate <= 0)
+                        SLog(EError, "Could not parse the frame rate!");
+                    break;
+                case 'R': {
+                        std::vector<std::string> rect = tokenize(optarg, ",");
+                        if (rect.size() != 4)
+                            SLog(EError, "Invalid region specification \"%s\"", optarg);
+                        int values[4];
+                        for (int j=0; j<4; ++j) {
+                            values[j] = strtol(rect[j].c_str(), &end_ptr, 10);
+                            if (*end_ptr != '\0' || values[j] < 0 || (j >= 2 && values[j] == 0))
+                                SLog(EError, "Could not parse the region \"%s\"!", optarg);
+                        }
+                        regions.push_back(Film::Region(Point2i(values[0], values[1]),
+                            Vector2i(values[2], values[3])));
+                    }
+                    break;
+                case 'O':
+                    regionObjects.push_back(optarg);
+                    break;
+                case 'B':
+                    baseFile = optarg;
+                    break;
+                case 'S':
+                    seed = (uint32_t) strtoul(optarg, &end_ptr, 10);
+                    if (*end_ptr != '\0')
+                        SLog(EError, "Could not parse the random seed!");
+                    deterministic = true;
+                    break;
                 case 'n':
                     nodeName = optarg;
                     break;
@@ -250,6 +507,15 @@ int mitsuba_app(int argc, char **argv) {
             }
         }
 
+        if (renderSequenceMode && (renderAllSensors || !variants.empty()))
+            SLog(EError, "Animation sequences cannot be combined with the -m and -V options!");
+
+        bool regionMode = !regions.empty() || !regionObjects.empty();
+        if (regionMode && renderSequenceMode)
+            SLog(EError, "Region rendering cannot be combined with animation sequences!");
+        if (!baseFile.empty() && !regionMode)
+            SLog(EError, "The -B option requires dirty regions (-R or -O)!");
+
         ProgressReporter::setEnabled(progressBars);
 
         /* Initialize OpenMP */
@@ -327,6 +593,7 @@ int mitsuba_app(int argc, char **argv) {
         }
 
         scheduler->start();
+        SLog(EInfo, "Startup took %i ms", startupTimer->getMilliseconds());
 
 #if !defined(__WINDOWS__)
             /* Initialize signal handlers */
@@ -374,24 +641,89 @@ int mitsuba_app(int argc, char **argv) {
             frClone->prependPath(filePath);
             Thread::getThread()->setFileResolver(frClone);
 
-            SLog(EInfo, "Parsing scene description from \"%s\" ..", argv[i]);
+            fs::path destination = destFile.length() > 0 ?
+                fs::path(destFile) : (filePath / baseName);
 
-            parser->parse(filename.c_str());
-            ref<Scene> scene = handler->getScene();
+            if (renderSequenceMode) {
+                SLog(EInfo, "Rendering frames %i-%i of \"%s\" ..", firstFrame, lastFrame, argv[i]);
+                renderSequence(filename, destination, parameters, firstFrame, lastFrame,
+                    frameStep, frameRate, blockSize, skipExisting, flushTimer > 0,
+                    deterministic, seed, jobIdx);
+                continue;
+            }
+            size_t variantCount = std::max(variants.size(), (size_t) 1);
+
+            /* Variants share all objects whose parameters do not differ */
+            ref<SceneObjectCache> variantCache;
+            if (!variants.empty())
+                variantCache = new SceneObjectCache();
+
+            for (size_t v=0; v<variantCount; ++v) {
+                ref<Scene> scene;
+                fs::path sceneDestination = destination;
+
+                if (variants.empty()) {
+                    SLog(EInfo, "Parsing scene description from \"%s\" ..", argv[i]);
+                    parser->parse(filename.c_str());
+                    scene = handler->getScene();
+                } else {
+                    SceneHandler::ParameterMap variantParameters(parameters);
+                    for (SceneHandler::ParameterMap::const_iterator it = variants[v].begin();
+                            it != variants[v].end(); ++it)
+                        variantParameters[it->first] = it->second;
+
+                    SLog(EInfo, "Parsing scene description from \"%s\" (variant %i/%i) ..",
+                        argv[i], (int) v+1, (int) variantCount);
+                    scene = SceneHandler::loadScene(filename, variantParameters, variantCache);
+                    variantCache->purge();
+                    sceneDestination = destination.string() + formatString("_v%03i", (int) v+1);
+                }
 
-            scene->setSourceFile(filename);
-            scene->setDestinationFile(destFile.length() > 0 ?
-                fs::path(destFile) : (filePath / baseName));
-            scene->setBlockSize(blockSize);
+                scene->setSourceFile(filename);
+                scene->setBlockSize(blockSize);
+                if (deterministic) {
+                    /* Each sensor may have its own sampler (see -m) */
+                    scene->getSampler()->setDeterministic(true, seed);
+                    ref_vector<Sensor> &sensors = scene->getSensors();
+                    for (size_t j=0; j<sensors.size(); ++j)
+                        sensors[j]->getSampler()->setDeterministic(true, seed);
+                }
 
-            if (scene->destinationExists() && skipExisting)
-                continue;
+                /* Create one shallow copy of the scene per sensor when requested */
+                std::vector<ref<Scene> > views;
+                ref_vector<Sensor> &sensors = scene->getSensors();
+                if (renderAllSensors && sensors.size() > 1) {
+                    SLog(EInfo, "Rendering %i sensors of the scene ..", (int) sensors.size());
+                    for (size_t j=0; j<sensors.size(); ++j) {
+                        ref<Scene> view = scene->createView(sensors[j], numParallelScenes > 1);
+                        std::string suffix = sensors[j]->getID();
+                        if (suffix.empty() || suffix == "unnamed")
+                            suffix = formatString("%i", (int) j);
+                        view->setDestinationFile(sceneDestination.string() + "_" + suffix);
+                        views.push_back(view);
+                    }
+                } else {
+                    scene->setDestinationFile(sceneDestination);
+                    views.push_back(scene);
+                }
+
+                for (size_t j=0; j<views.size(); ++j) {
+                    if (views[j]->destinationExists() && skipExisting)
+                        continue;
+
+                    if (regionMode)
+                        setupRegions(views[j], regions, regionObjects,
+                            baseFile.empty() ? views[j]->getDestinationFile() : fs::path(baseFile),
+                            !baseFile.empty());
 
-            ref<RenderJob> thr = new RenderJob(formatString("ren%i", jobIdx++),
-                scene, renderQueue, -1, -1, -1, true, flushTimer > 0);
-            thr->start();
+                    ref<RenderJob> thr = new RenderJob(formatString("ren%i", jobIdx++),
+                        views[j], renderQueue, -1, -1, -1, true, flushTimer > 0);
+                    thr->start();
+
+                    renderQueue->waitLeft(numParallelScenes-1);
+                }
+            }
 
-            renderQueue->waitLeft(numParallelScenes-1);
             if (i+1 < argc && numParallelScenes == 1)
                 Statistics::getInstance()->resetAll();
         }
@@ -421,6 +753,7 @@ int mts_main(int argc, char **argv) {
     /* Initialize the core framework */
     Class::staticInitialization();
     Object::staticInitialization();
+    startupTimer = new Timer();
     PluginManager::staticInitialization();
     Statistics::staticInitialization();
     Thread::staticInitialization();
@@ -447,6 +780,7 @@ int mts_main(int argc, char **argv) {
 #endif
 
     int retval = mitsuba_app(argc, argv);
+    startupTimer = NULL;
 
     /* Shutdown the core framework */
     SceneHandler::staticShutdown();
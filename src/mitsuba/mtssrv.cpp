@@ -26,6 +26,7 @@
 #include <mitsuba/core/appender.h>
 #include <mitsuba/core/version.h>
 #include <mitsuba/core/fresolver.h>
+#include <mitsuba/core/timer.h>
 #include <mitsuba/core/plugin.h>
 #include <mitsuba/core/bitmap.h>
 #include <fstream>
@@ -56,6 +57,9 @@
 using namespace mitsuba;
 
 static bool running = true;
+
+/// Time since the start of mts_main(), used to report the startup time
+static ref<Timer> startupTimer;
 static SOCKET sock = INVALID_SOCKET;
 
 #if defined(__WINDOWS__)
@@ -284,6 +288,7 @@ int mtssrv(int argc, char **argv) {
             }
         }
         scheduler->start();
+        SLog(EInfo, "Startup took %i ms", startupTimer->getMilliseconds());
 
         if (listenPort == -1) {
             ref<StreamBackend> backend = new StreamBackend("con0",
@@ -409,6 +414,7 @@ int mts_main(int argc, char **argv) {
     /* Initialize the core framework */
     Class::staticInitialization();
     Object::staticInitialization();
+    startupTimer = new Timer();
     PluginManager::staticInitialization();
     Statistics::staticInitialization();
     Thread::staticInitialization();
@@ -433,6 +439,7 @@ int mts_main(int argc, char **argv) {
 #endif
 
     int retval = mtssrv(argc, argv);
+    startupTimer = NULL;
 
     /* Shutdown the core framework */
     SHVector::staticShutdown();
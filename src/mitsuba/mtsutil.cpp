@@ -32,6 +32,7 @@
 #include <mitsuba/core/fstream.h>
 #include <mitsuba/core/version.h>
 #include <mitsuba/core/appender.h>
+#include <mitsuba/core/timer.h>
 #include <mitsuba/render/util.h>
 #include <mitsuba/render/testcase.h>
 #include <mitsuba/render/renderjob.h>
@@ -49,6 +50,31 @@
 
 using namespace mitsuba;
 
+/// Time since the start of mts_main(), used to report the startup time
+static ref<Timer> startupTimer;
+
+void listUtility(std::ostringstream &oss, const std::string &name, const std::string &description) {
+    oss << "\t" << name;
+    for (int i=0; i<22-(int) name.length(); ++i)
+        oss << ' ';
+    oss << description << endl;
+}
+
+/// Run a test case and accumulate the number of executed and succeeded tests
+void runTestCase(const Plugin &plugin, int argc, char **argv, int &executed, int &succeeded) {
+    ref<Utility> utility = plugin.createUtility();
+
+    TestCase *testCase = static_cast<TestCase *>(utility.get());
+    if (!utility->getClass()->derivesFrom(MTS_CLASS(TestCase)))
+        SLog(EError, "This is not a test case!");
+
+    if (testCase->run(argc, argv) != 0)
+        SLog(EError, "Testcase unexpectedly returned with a nonzero value.");
+
+    executed += testCase->getExecuted();
+    succeeded += testCase->getSucceeded();
+}
+
 void help() {
     cout <<  "Mitsuba version " << Version(MTS_VERSION).toStringComplete()
         << ", Copyright (c) " MTS_YEAR " Wenzel Jakob" << endl;
@@ -85,6 +111,16 @@ void help() {
     std::vector<fs::path> dirPaths = fileResolver->resolveAll("plugins");
     std::set<std::string> seen;
 
+    /* Utilities that were linked into the executable */
+    std::vector<std::string> builtIn = StaticPlugin::getNames();
+    for (size_t i=0; i<builtIn.size(); ++i) {
+        const StaticPlugin *plugin = StaticPlugin::find(builtIn[i]);
+        seen.insert(builtIn[i]);
+        if (plugin->isUtility())
+            listUtility(boost::starts_with(builtIn[i], "test_") ? testcases : utilities,
+                builtIn[i], plugin->getDescription());
+    }
+
     for (size_t i=0; i<dirPaths.size(); ++i) {
         fs::path dirPath = fs::absolute(dirPaths[i]);
 
@@ -116,17 +152,8 @@ void help() {
             Plugin utility(shortName, it->path());
             if (!utility.isUtility())
                 continue;
-            if (boost::starts_with(shortName, "test_")) {
-                testcases << "\t" << shortName;
-                for (int i=0; i<22-(int) shortName.length(); ++i)
-                    testcases << ' ';
-                testcases << utility.getDescription() << endl;
-            } else {
-                utilities << "\t" << shortName;
-                for (int i=0; i<22-(int) shortName.length(); ++i)
-                    utilities << ' ';
-                utilities << utility.getDescription() << endl;
-            }
+            listUtility(boost::starts_with(shortName, "test_") ? testcases : utilities,
+                shortName, utility.getDescription());
         }
     }
 
@@ -285,12 +312,24 @@ int mtsutil(int argc, char **argv) {
         }
 
         scheduler->start();
+        SLog(EInfo, "Startup took %i ms", startupTimer->getMilliseconds());
 
         if (testCaseMode) {
             std::vector<fs::path> dirPaths = fileResolver->resolveAll("plugins");
             std::set<std::string> seen;
             int executed = 0, succeeded = 0;
 
+            /* Test cases that were linked into the executable */
+            std::vector<std::string> builtIn = StaticPlugin::getNames();
+            for (size_t i=0; i<builtIn.size(); ++i) {
+                const StaticPlugin *staticPlugin = StaticPlugin::find(builtIn[i]);
+                seen.insert(builtIn[i]);
+                if (!staticPlugin->isUtility() || !boost::starts_with(builtIn[i], "test_"))
+                    continue;
+                Plugin plugin(builtIn[i], staticPlugin);
+                runTestCase(plugin, argc-optind, argv+optind, executed, succeeded);
+            }
+
             for (size_t i=0; i<dirPaths.size(); ++i) {
                 fs::path dirPath = fs::absolute(dirPaths[i]);
 
@@ -322,18 +361,7 @@ int mtsutil(int argc, char **argv) {
                     Plugin plugin(shortName, it->path());
                     if (!plugin.isUtility())
                         continue;
-
-                    ref<Utility> utility = plugin.createUtility();
-
-                    TestCase *testCase = static_cast<TestCase *>(utility.get());
-                    if (!utility->getClass()->derivesFrom(MTS_CLASS(TestCase)))
-                        SLog(EError, "This is not a test case!");
-
-                    if (testCase->run(argc-optind, argv+optind) != 0)
-                        SLog(EError, "Testcase unexpectedly returned with a nonzero value.");
-
-                    executed += testCase->getExecuted();
-                    succeeded += testCase->getSucceeded();
+                    runTestCase(plugin, argc-optind, argv+optind, executed, succeeded);
                 }
             }
 
@@ -343,28 +371,35 @@ int mtsutil(int argc, char **argv) {
                 std::cerr << "A utility name must be supplied!" << endl;
                 return -1;
             }
-            fs::path pluginName(argv[optind]);
+            Plugin *plugin;
+            const StaticPlugin *staticPlugin = StaticPlugin::find(argv[optind]);
 
-            /* Build the full plugin file name */
+            if (staticPlugin) {
+                plugin = new Plugin(argv[optind], staticPlugin);
+            } else {
+                fs::path pluginName(argv[optind]);
+
+                /* Build the full plugin file name */
 #if defined(__WINDOWS__)
-            pluginName.replace_extension(".dll");
+                pluginName.replace_extension(".dll");
 #elif defined(__OSX__)
-            pluginName.replace_extension(".dylib");
+                pluginName.replace_extension(".dylib");
 #elif defined(__LINUX__)
-            pluginName.replace_extension(".so");
+                pluginName.replace_extension(".so");
 #else
 #error Unknown operating system!
 #endif
-            fs::path fullName = fileResolver->resolve(fs::path("plugins") / pluginName);
+                fs::path fullName = fileResolver->resolve(fs::path("plugins") / pluginName);
 
-            if (!fs::exists(fullName)) {
-                /* Plugin not found! */
-                SLog(EError, "Utility \"%s\" not found (run \"mtsutil\" without arguments to "
-                    "see a list of available utilities)", fullName.string().c_str());
-            }
+                if (!fs::exists(fullName)) {
+                    /* Plugin not found! */
+                    SLog(EError, "Utility \"%s\" not found (run \"mtsutil\" without arguments to "
+                        "see a list of available utilities)", fullName.string().c_str());
+                }
 
-            SLog(EInfo, "Loading utility \"%s\" ..", argv[optind]);
-            Plugin *plugin = new Plugin(argv[optind], fullName);
+                SLog(EInfo, "Loading utility \"%s\" ..", argv[optind]);
+                plugin = new Plugin(argv[optind], fullName);
+            }
             if (!plugin->isUtility())
                 SLog(EError, "This plugin does not implement the 'Utility' interface!");
             Statistics::getInstance()->logPlugin(argv[optind], plugin->getDescription());
@@ -390,6 +425,7 @@ int mts_main(int argc, char **argv) {
     /* Initialize the core framework */
     Class::staticInitialization();
     Object::staticInitialization();
+    startupTimer = new Timer();
     PluginManager::staticInitialization();
     Statistics::staticInitialization();
     Thread::staticInitialization();
@@ -416,6 +452,7 @@ int mts_main(int argc, char **argv) {
 #endif
 
     int retval = mtsutil(argc, argv);
+    startupTimer = NULL;
 
     /* Shutdown the core framework */
     SceneHandler::staticShutdown();
@@ -1053,7 +1053,7 @@ void GLWidget::paintGL() {
                     if (m_context->mode == EPreview) {
                         mult /= entry.vplSampleOffset;
                     }
-                    m_cpuTonemap->setLuminanceInfo(m_context->framebuffer,mult);
+                    m_cpuTonemap->setLuminanceInfo(m_context->framebuffer,mult,true);
 #else
                     /* Manually generate a gamma-corrected image
                        on the CPU (with gamma=2.2) - this will be slow! */
@@ -1109,7 +1109,7 @@ void GLWidget::paintGL() {
                 /* Getting the luminance info is rather expensive, avoid if the
                    multiplier has not changed */
                 if (mult != m_cpuTonemap->multiplier()) {
-                    m_cpuTonemap->setLuminanceInfo(m_context->framebuffer,mult);
+                    m_cpuTonemap->setLuminanceInfo(m_context->framebuffer,mult,true);
                 }
                 Float burn = std::min((Float) 1, std::max((Float)1e-8f,
                     1-(m_context->reinhardBurn + 10) / 20.0f));
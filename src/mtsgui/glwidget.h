@@ -20,11 +20,9 @@
 #define __GLWIDGET_H
 
 #include "common.h"
-#if MTS_SSE
-#include "simdtonemap.h"
-#endif
 #include <QtOpenGL/QGLWidget>
 #include <mitsuba/core/bitmap.h>
+#include <mitsuba/core/simdtonemap.h>
 #include <mitsuba/render/vpl.h>
 #include <mitsuba/hw/renderer.h>
 #include <mitsuba/hw/gputexture.h>
@@ -21,7 +21,9 @@
 
 #include <mitsuba/core/statistics.h>
 #include <mitsuba/core/brent.h>
+#include <mitsuba/core/lock.h>
 #include <boost/bind.hpp>
+#include <boost/shared_ptr.hpp>
 #include <boost/math/special_functions/erf.hpp>
 
 MTS_NAMESPACE_BEGIN
@@ -40,6 +42,7 @@ FINLINE Float mts_erf(Float arg) {
 #define FIBERDIST_STDDEV_MAX        4
 #define FIBERDIST_SIGMA_T_ELEMENTS  100
 #define FIBERDIST_SIGMA_T_COEFFS    10
+#define FIBERDIST_TABLE_RES         1024
 
 /**
  * Each row of this table table stores an expansion of \sigma_t in terms of
@@ -186,6 +189,22 @@ static StatsCounter avgBrentFunEvals("Micro-flake model",
         "Average Brent solver function evaluations", EAverage);
 #endif
 
+/**
+ * \brief Tabulated projected area of a \ref GaussianFiberDistribution
+ *
+ * Stores \sigma_t at \ref FIBERDIST_TABLE_RES uniformly spaced values of
+ * sin(theta) for one standard deviation value. Tables are created on demand
+ * and shared between all distributions (and thus all media) that use the
+ * same parameter.
+ */
+struct GaussianFiberTable {
+    Float stddev;
+    Float sigmaT[FIBERDIST_TABLE_RES];
+};
+
+static ref<Mutex> fiberTableMutex = new Mutex();
+static std::vector<boost::shared_ptr<const GaussianFiberTable> > fiberTables;
+
 
 /**
  * \brief Flake distribution for simulating rough fibers
@@ -223,10 +242,30 @@ public:
         for (int i=0; i<FIBERDIST_SIGMA_T_COEFFS; ++i)
             m_coeffs[i] = (Float) (((1-alpha) * fiberSigmaTCoeffs[idx0][i]
                 + alpha * fiberSigmaTCoeffs[idx1][i]));
+
+        m_table = lookupTable();
     }
 
-    /// Evaluate \sigma_t as a function of \cos\theta
+    /// Evaluate \sigma_t as a function of \cos\theta (tabulated)
     inline Float sigmaT(Float cosTheta) const {
+        Float sinTheta = std::sqrt(std::max(
+                (Float) 0, 1-cosTheta*cosTheta)),
+              pos = sinTheta * (FIBERDIST_TABLE_RES - 1);
+
+        int idx = std::min((int) pos, FIBERDIST_TABLE_RES - 2);
+        Float alpha = pos - idx;
+
+        return (1-alpha) * m_table->sigmaT[idx]
+            + alpha * m_table->sigmaT[idx+1];
+    }
+
+    /**
+     * \brief Evaluate \sigma_t as a function of \cos\theta using
+     * the underlying series expansion
+     *
+     * This is used to build the table accessed by \ref sigmaT()
+     */
+    inline Float sigmaTSeries(Float cosTheta) const {
         Float sinTheta = std::sqrt(std::max(
                 (Float) 0, 1-cosTheta*cosTheta)),
               base = 1.0f, result = 0.0f;
@@ -252,29 +291,60 @@ public:
             / (2*m_stddev*m_stddev)) * m_normalization;
     }
 
+    /**
+     * \brief Sample a direction from the distribution given a uniformly
+     * distributed 2D sample
+     */
+    Vector sample(const Point2 &sample) const {
+        Float cosTheta = sampleCosTheta(sample.x),
+              sinTheta = std::sqrt(std::max((Float) 0, 1-cosTheta*cosTheta)),
+              phi = 2 * M_PI * sample.y,
+              sinPhi = std::sin(phi), cosPhi = std::cos(phi);
+
+        return Vector(sinTheta * cosPhi, sinTheta * sinPhi, cosTheta);
+    }
+
     /**
      * \brief Apply the inversion method to sample \cos\theta given
      * a uniformly distributed r.v. \xi on [0, 1]
+     *
+     * The longitudinal CDF is inverted in closed form using \ref math::erfinv().
      */
-    Vector sample(const Point2 &sample) const {
+    inline Float sampleCosTheta(Float xi) const {
+        Float cosTheta = SQRT_TWO * m_stddev * math::erfinv((1 - 2*xi) / m_c1);
+        return math::clamp(cosTheta, (Float) -1, (Float) 1);
+    }
+
+    /**
+     * \brief Sample \cos\theta by numerically inverting the
+     * longitudinal CDF using Brent's method
+     *
+     * This is much slower than \ref sampleCosTheta() and only kept as a
+     * reference implementation.
+     */
+    Float sampleCosThetaBrent(Float xi) const {
         BrentSolver brentSolver(100, 1e-6f);
         BrentSolver::Result result = brentSolver.solve(
             boost::bind(&GaussianFiberDistribution::cdfFunctor,
-                this, sample.x, _1), -1, 1);
+                this, xi, _1), -1, 1);
         SAssert(result.success);
 
         #if defined(MICROFLAKE_STATISTICS)
             avgBrentFunEvals.incrementBase();
         #endif
 
-        Float cosTheta = result.x,
-              sinTheta = std::sqrt(std::max((Float) 0, 1-cosTheta*cosTheta)),
-              phi = 2 * M_PI * sample.y,
-              sinPhi = std::sin(phi), cosPhi = std::cos(phi);
+        return result.x;
+    }
 
-        return Vector(sinTheta * cosPhi, sinTheta * sinPhi, cosTheta);
+    /// Evaluate the longitudinal CDF as a function of \cos\theta
+    inline Float cdf(Float cosTheta) const {
+        return 0.5f * (1.0f -
+            mts_erf(cosTheta / (SQRT_TWO * m_stddev)) * m_c1);
     }
 
+    /// Return the table shared by all distributions with this standard deviation
+    inline const GaussianFiberTable *getTable() const { return m_table.get(); }
+
     inline Float getStdDev() const { return m_stddev; }
 
     std::string toString() const {
@@ -284,10 +354,25 @@ public:
         return oss.str();
     }
 protected:
-    /// Evaluate the longitudinal CDF as a function of \cos\theta
-    inline Float cdf(Float cosTheta) const {
-        return 0.5f * (1.0f -
-            mts_erf(cosTheta / (SQRT_TWO * m_stddev)) * m_c1);
+    /// Look up (or create) the tabulated projected area for this standard deviation
+    boost::shared_ptr<const GaussianFiberTable> lookupTable() {
+        LockGuard lock(fiberTableMutex);
+        for (size_t i=0; i<fiberTables.size(); ++i) {
+            if (fiberTables[i]->stddev == m_stddev)
+                return fiberTables[i];
+        }
+
+        GaussianFiberTable *table = new GaussianFiberTable();
+        table->stddev = m_stddev;
+        for (int i=0; i<FIBERDIST_TABLE_RES; ++i) {
+            Float sinTheta = i / (Float) (FIBERDIST_TABLE_RES - 1);
+            table->sigmaT[i] = sigmaTSeries(
+                std::sqrt(std::max((Float) 0, 1-sinTheta*sinTheta)));
+        }
+
+        boost::shared_ptr<const GaussianFiberTable> result(table);
+        fiberTables.push_back(result);
+        return result;
     }
 
     Float cdfFunctor(Float xi, Float cosTheta) const {
@@ -302,6 +387,7 @@ protected:
     Float m_normalization;
     Float m_c1;
     Float m_coeffs[FIBERDIST_SIGMA_T_COEFFS];
+    boost::shared_ptr<const GaussianFiberTable> m_table;
 };
 
 MTS_NAMESPACE_END
@@ -134,6 +134,8 @@ public:
     ref<Sampler> clone() {
         ref<HammersleySampler> sampler = new HammersleySampler();
         sampler->m_sampleCount = m_sampleCount;
+        sampler->m_deterministic = m_deterministic;
+        sampler->m_seed = m_seed;
         sampler->m_samplesPerBatch = m_samplesPerBatch;
         sampler->m_factor = m_factor;
         sampler->m_sampleIndex = m_sampleIndex;
@@ -42,7 +42,9 @@ MTS_NAMESPACE_BEGIN
  * In theory, this sampler is initialized using a deterministic procedure, which means
  * that subsequent runs of Mitsuba should create the same image. In practice, when
  * rendering with multiple threads and/or machines, this is not true anymore, since the
- * ordering of samples is influenced by the operating system scheduler.
+ * ordering of samples is influenced by the operating system scheduler. Setting the
+ * \code{deterministic} parameter (see the introduction of this section) avoids this
+ * by seeding the generator separately for every image block.
  *
  * Note that the Metropolis-type integrators implemented in Mitsuba are incompatible with
  * the more sophisticated sample generators shown in this section. They \emph{require} this
@@ -71,6 +73,8 @@ public:
     ref<Sampler> clone() {
         ref<IndependentSampler> sampler = new IndependentSampler();
         sampler->m_sampleCount = m_sampleCount;
+        sampler->m_deterministic = m_deterministic;
+        sampler->m_seed = m_seed;
         sampler->m_random = new Random(m_random);
         for (size_t i=0; i<m_req1D.size(); ++i)
             sampler->request1DArray(m_req1D[i]);
@@ -79,6 +83,11 @@ public:
         return sampler.get();
     }
 
+    void seedBlock(const Point2i &offset) {
+        if (m_deterministic)
+            m_random->seed(getBlockSeed(offset));
+    }
+
     void generate(const Point2i &) {
         for (size_t i=0; i<m_req1D.size(); i++)
             for (size_t j=0; j<m_sampleCount * m_req1D[i]; ++j)
@@ -129,6 +129,8 @@ public:
         ref<LowDiscrepancySampler> sampler = new LowDiscrepancySampler();
 
         sampler->m_sampleCount = m_sampleCount;
+        sampler->m_deterministic = m_deterministic;
+        sampler->m_seed = m_seed;
         sampler->m_maxDimension = m_maxDimension;
         sampler->m_random = new Random(m_random);
         sampler->m_samples1D = new Float*[m_maxDimension];
@@ -182,6 +184,11 @@ public:
         m_random->shuffle(samples, samples + sampleCount);
     }
 
+    void seedBlock(const Point2i &offset) {
+        if (m_deterministic)
+            m_random->seed(getBlockSeed(offset));
+    }
+
     void generate(const Point2i &) {
         for (size_t i=0; i<m_maxDimension; ++i) {
             generate1D(m_samples1D[i], m_sampleCount);
@@ -128,6 +128,8 @@ public:
     ref<Sampler> clone() {
         ref<SobolSampler> sampler = new SobolSampler();
         sampler->m_sampleCount = m_sampleCount;
+        sampler->m_deterministic = m_deterministic;
+        sampler->m_seed = m_seed;
         sampler->m_sampleIndex = m_sampleIndex;
         sampler->m_sobolSampleIndex = m_sobolSampleIndex;
         sampler->m_dimension = m_dimension;
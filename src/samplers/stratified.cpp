@@ -125,6 +125,8 @@ public:
     ref<Sampler> clone() {
         ref<StratifiedSampler> sampler = new StratifiedSampler();
         sampler->m_sampleCount = m_sampleCount;
+        sampler->m_deterministic = m_deterministic;
+        sampler->m_seed = m_seed;
         sampler->m_maxDimension = m_maxDimension;
         sampler->m_resolution = m_resolution;
         sampler->m_invResolution = m_invResolution;
@@ -144,6 +146,11 @@ public:
         return sampler.get();
     }
 
+    void seedBlock(const Point2i &offset) {
+        if (m_deterministic)
+            m_random->seed(getBlockSeed(offset));
+    }
+
     void generate(const Point2i &) {
         for (int i=0; i<m_maxDimension; i++) {
             for (size_t j=0; j<m_sampleCount; j++)
@@ -297,6 +297,12 @@ public:
         return Spectrum(1.0f);
     }
 
+    void sampleRayBatch(RayBatch &batch, const Point2 *samplePositions,
+            const Point2 *apertureSamples, const Float *timeSamples, size_t count) const {
+        prepareRayBatch(batch, m_sampleToCamera, samplePositions, timeSamples, count);
+        finishRayBatch(batch);
+    }
+
     Spectrum samplePosition(PositionSamplingRecord &pRec,
             const Point2 &sample, const Point2 *extra) const {
         const Transform &trafo = m_worldTransform->eval(pRec.time);
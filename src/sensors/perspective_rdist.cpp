@@ -360,6 +360,21 @@ public:
         return Spectrum(1.0f);
     }
 
+    void sampleRayBatch(RayBatch &batch, const Point2 *samplePositions,
+            const Point2 *apertureSamples, const Float *timeSamples, size_t count) const {
+        prepareRayBatch(batch, m_sampleToCamera, samplePositions, timeSamples, count);
+
+        if (m_distortion) {
+            for (size_t i=0; i<count; ++i) {
+                Float correction = invertDistortion(Vector2(batch.dx[i] / batch.dz[i],
+                    batch.dy[i] / batch.dz[i]).length());
+                batch.dx[i] *= correction; batch.dy[i] *= correction;
+            }
+        }
+
+        finishRayBatch(batch);
+    }
+
     Spectrum samplePosition(PositionSamplingRecord &pRec,
             const Point2 &sample, const Point2 *extra) const {
         const Transform &trafo = m_worldTransform->eval(pRec.time);
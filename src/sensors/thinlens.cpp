@@ -360,6 +360,26 @@ public:
         return Spectrum(1.0f);
     }
 
+    void sampleRayBatch(RayBatch &batch, const Point2 *samplePositions,
+            const Point2 *apertureSamples, const Float *timeSamples, size_t count) const {
+        prepareRayBatch(batch, m_sampleToCamera, samplePositions, timeSamples, count);
+
+        /* Move the ray origins onto the aperture and aim
+           at the corresponding points on the focal plane */
+        for (size_t i=0; i<count; ++i) {
+            Point2 tmp = warp::squareToUniformDiskConcentric(apertureSamples[i])
+                * m_apertureRadius;
+            Float scale = m_focusDistance / batch.dz[i];
+            batch.ox[i] = tmp.x;
+            batch.oy[i] = tmp.y;
+            batch.dx[i] = batch.dx[i] * scale - tmp.x;
+            batch.dy[i] = batch.dy[i] * scale - tmp.y;
+            batch.dz[i] = batch.dz[i] * scale;
+        }
+
+        finishRayBatch(batch);
+    }
+
     Spectrum samplePosition(PositionSamplingRecord &pRec,
             const Point2 &sample, const Point2 *extra) const {
         const Transform &trafo = m_worldTransform->eval(pRec.time);
@@ -225,6 +225,7 @@ public:
             its.geoFrame.n *= -1;
         its.shFrame.n = its.geoFrame.n;
         its.hasUVPartials = false;
+        its.uvFootprint = 0.0f;
         its.instance = NULL;
         its.time = ray.time;
     }
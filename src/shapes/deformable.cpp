@@ -507,6 +507,7 @@ public:
 
         its.shape = m_kdtree->getMesh(0, cache->shapeIndex);
         its.hasUVPartials = false;
+        its.uvFootprint = 0.0f;
         its.primIndex = cache->primIndex;
         its.other = cache->shapeIndex;
         its.instance = this;
@@ -193,6 +193,7 @@ public:
         its.uv = Point2(r, phi * INV_TWOPI);
         its.p = ray(its.t);
         its.hasUVPartials = false;
+        its.uvFootprint = 0.0f;
         its.instance = NULL;
         its.time = ray.time;
     }
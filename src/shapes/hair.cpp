@@ -25,11 +25,278 @@
 #include <mitsuba/core/properties.h>
 #include <mitsuba/core/fstream.h>
 #include <mitsuba/core/fresolver.h>
+#include <mitsuba/core/mmap.h>
+#include <mitsuba/core/statistics.h>
+#include <mitsuba/core/timer.h>
 
 #define MTS_HAIR_USE_FANCY_CLIPPING 1
 
+#define MTS_HAIR_COMPACT_VERSION    1
+
+/* Hair files with more vertices than this are cached on disk by default */
+#define MTS_HAIR_CACHE_THRESHOLD    (1024*1024)
+
 MTS_NAMESPACE_BEGIN
 
+static MemoryCounter hairMemory("Hair");
+
+namespace {
+    /// Header of the compact (memory-mapped) hair format
+    struct HairFileHeader {
+        char identifier[12];
+        uint32_t version;
+        uint64_t timestamp;
+        uint32_t strandCount;
+        uint32_t vertexCount;
+    };
+
+    /// Unprocessed hair strands, either memory-mapped or loaded into memory
+    struct HairStrands {
+        /// XYZ coordinates of all vertices
+        const float *vertices;
+        /// Index of the first vertex of every strand (followed by the vertex count)
+        const uint32_t *offsets;
+        size_t strandCount;
+        size_t vertexCount;
+
+        /* Storage of files that are not memory-mapped */
+        std::vector<float> vertexStorage;
+        std::vector<uint32_t> offsetStorage;
+        ref<MemoryMappedFile> mmap;
+
+        inline HairStrands() : vertices(NULL), offsets(NULL),
+            strandCount(0), vertexCount(0) { }
+
+        /// Release the storage or mapping
+        void release() {
+            std::vector<float>().swap(vertexStorage);
+            std::vector<uint32_t>().swap(offsetStorage);
+            mmap = NULL;
+            vertices = NULL;
+            offsets = NULL;
+            strandCount = vertexCount = 0;
+        }
+
+        /// Point 'vertices' and 'offsets' to the in-memory storage
+        void finalize() {
+            offsetStorage.push_back((uint32_t) (vertexStorage.size() / 3));
+            vertices = vertexStorage.empty() ? NULL : &vertexStorage[0];
+            offsets = &offsetStorage[0];
+            strandCount = offsetStorage.size() - 1;
+            vertexCount = vertexStorage.size() / 3;
+        }
+    };
+
+    /// Read an unaligned little endian value
+    template <typename T> inline T readLittleEndian(const uint8_t *ptr) {
+        T value;
+        memcpy(&value, ptr, sizeof(T));
+        if (Stream::getHostByteOrder() != Stream::ELittleEndian)
+            value = endianness_swap(value);
+        return value;
+    }
+
+    /// Load the ASCII format (see the plugin documentation)
+    void loadASCII(const fs::path &path, HairStrands &strands) {
+        fs::ifstream is(path);
+        if (is.fail())
+            SLog(EError, "Could not open \"%s\"!", path.string().c_str());
+
+        std::string line;
+        bool newFiber = true;
+        while (std::getline(is, line)) {
+            if (line.length() > 0 && line[0] == '#') {
+                newFiber = true;
+                continue;
+            }
+            std::istringstream iss(line);
+            float x, y, z;
+            iss >> x >> y >> z;
+            if (iss.fail()) {
+                newFiber = true;
+                continue;
+            }
+            if (newFiber) {
+                strands.offsetStorage.push_back((uint32_t) (strands.vertexStorage.size() / 3));
+                newFiber = false;
+            }
+            strands.vertexStorage.push_back(x);
+            strands.vertexStorage.push_back(y);
+            strands.vertexStorage.push_back(z);
+        }
+        strands.finalize();
+    }
+
+    /// Load the original binary format, which starts with \c BINARY_HAIR
+    void loadBinary(const fs::path &path, HairStrands &strands) {
+        ref<MemoryMappedFile> mmap = new MemoryMappedFile(path);
+        const uint8_t *ptr = (const uint8_t *) mmap->getData(),
+                      *end = ptr + mmap->getSize();
+        ptr += 11;
+        if (ptr + sizeof(uint32_t) > end)
+            SLog(EError, "\"%s\": truncated hair file!", path.string().c_str());
+
+        size_t vertexCount = readLittleEndian<uint32_t>(ptr);
+        ptr += sizeof(uint32_t);
+        if (vertexCount * 3 * sizeof(float) > (size_t) (end - ptr))
+            SLog(EError, "\"%s\": truncated hair file!", path.string().c_str());
+        SLog(EInfo, "Loading " SIZE_T_FMT " hair vertices ..", vertexCount);
+        strands.vertexStorage.resize(vertexCount * 3);
+
+        /* The strand boundaries are only known after a linear scan */
+        bool newFiber = true;
+        for (size_t i=0; i<vertexCount; ++i) {
+            if (ptr + 3 * sizeof(float) > end)
+                SLog(EError, "\"%s\": truncated hair file!", path.string().c_str());
+            float value = readLittleEndian<float>(ptr);
+            if (std::isinf(value)) {
+                newFiber = true;
+                ptr += sizeof(float);
+                if (ptr + 3 * sizeof(float) > end)
+                    SLog(EError, "\"%s\": truncated hair file!", path.string().c_str());
+            }
+            if (newFiber) {
+                strands.offsetStorage.push_back((uint32_t) i);
+                newFiber = false;
+            }
+            for (int j=0; j<3; ++j) {
+                strands.vertexStorage[3*i + j] = readLittleEndian<float>(ptr);
+                ptr += sizeof(float);
+            }
+        }
+        strands.finalize();
+    }
+
+    /// Return the size of a compact hair file with the given contents
+    inline size_t getCompactSize(size_t strandCount, size_t vertexCount) {
+        return sizeof(HairFileHeader) + (strandCount + 1) * sizeof(uint32_t)
+            + vertexCount * 3 * sizeof(float);
+    }
+
+    /**
+     * \brief Map a file in the compact format into memory. When \c timestamp
+     * is nonzero, it must match the value stored in the file (cache files)
+     */
+    bool mapCompact(const fs::path &path, uint64_t timestamp, HairStrands &strands) {
+        ref<MemoryMappedFile> mmap;
+        try {
+            mmap = new MemoryMappedFile(path);
+        } catch (const std::exception &e) {
+            SLog(EWarn, "Unable to map the hair file \"%s\": %s",
+                path.string().c_str(), e.what());
+            return false;
+        }
+
+        if (mmap->getSize() < sizeof(HairFileHeader))
+            return false;
+
+        const HairFileHeader &header = *((const HairFileHeader *) mmap->getData());
+        if (memcmp(header.identifier, "COMPACT_HAIR", 12) != 0
+            || header.version != MTS_HAIR_COMPACT_VERSION
+            || (timestamp != 0 && header.timestamp != timestamp)
+            || mmap->getSize() != getCompactSize(header.strandCount, header.vertexCount))
+            return false;
+
+        /* The offsets must be monotonic, since they are used to compute
+           the vertex counts of the strands */
+        const uint32_t *offsets = (const uint32_t *) (&header + 1);
+        if (offsets[0] != 0 || offsets[header.strandCount] != header.vertexCount)
+            return false;
+        for (uint32_t i=0; i<header.strandCount; ++i) {
+            if (offsets[i] > offsets[i+1]) {
+                SLog(EWarn, "\"%s\": invalid strand offsets!", path.string().c_str());
+                return false;
+            }
+        }
+
+        strands.mmap = mmap;
+        strands.offsets = offsets;
+        strands.vertices = (const float *) (offsets + header.strandCount + 1);
+        strands.strandCount = header.strandCount;
+        strands.vertexCount = header.vertexCount;
+        return true;
+    }
+
+    /**
+     * \brief Write hair strands to a file in the compact format
+     *
+     * The data is written to a temporary file in the same directory, which
+     * is then renamed. Other processes thus never map an incomplete file.
+     */
+    void writeCompact(const fs::path &path, uint64_t timestamp, const HairStrands &strands) {
+        fs::path tempPath = path.parent_path() /
+            fs::unique_path(path.filename().string() + ".%%%%%%%%.tmp");
+
+        try {
+            ref<MemoryMappedFile> mmap = new MemoryMappedFile(tempPath,
+                getCompactSize(strands.strandCount, strands.vertexCount));
+
+            HairFileHeader &header = *((HairFileHeader *) mmap->getData());
+            uint32_t *offsets = (uint32_t *) (&header + 1);
+            memset(&header, 0, sizeof(HairFileHeader));
+            header.version = MTS_HAIR_COMPACT_VERSION;
+            header.timestamp = timestamp;
+            header.strandCount = (uint32_t) strands.strandCount;
+            header.vertexCount = (uint32_t) strands.vertexCount;
+            memcpy(header.identifier, "COMPACT_HAIR", 12);
+            memcpy(offsets, strands.offsets, (strands.strandCount + 1) * sizeof(uint32_t));
+            memcpy(offsets + strands.strandCount + 1, strands.vertices,
+                strands.vertexCount * 3 * sizeof(float));
+
+            /* Unmap before renaming (required on Windows) */
+            mmap = NULL;
+            fs::rename(tempPath, path);
+        } catch (const std::exception &e) {
+            SLog(EWarn, "Unable to create the hair cache file \"%s\": %s",
+                path.string().c_str(), e.what());
+            boost::system::error_code ec;
+            fs::remove(tempPath, ec);
+        }
+    }
+
+    /**
+     * \brief Transform the vertices of a strand and merge segments
+     * whose tangents are less than \c dpThresh apart
+     *
+     * Returns the number of vertices written to \c output.
+     */
+    size_t mergeStrand(const float *input, size_t count, const Transform &objectToWorld,
+            Float dpThresh, Point *output, size_t &nDegenerate, size_t &nSkipped) {
+        Vector tangent(0.0f);
+        Point lastP(0.0f);
+        size_t n = 0;
+
+        for (size_t i=0; i<count; ++i) {
+            Point p = objectToWorld(Point(input[3*i], input[3*i+1], input[3*i+2]));
+
+            if (n == 0) {
+                output[n++] = p;
+                lastP = p;
+            } else if (p == lastP) {
+                ++nDegenerate;
+            } else if (tangent.isZero()) {
+                output[n++] = p;
+                tangent = normalize(p - lastP);
+                lastP = p;
+            } else {
+                Vector nextTangent = normalize(p - lastP);
+                if (dot(nextTangent, tangent) > dpThresh) {
+                    /* Too small of a difference in the tangent value,
+                       just overwrite the previous vertex by the current one */
+                    tangent = normalize(p - output[n-2]);
+                    output[n-1] = p;
+                    ++nSkipped;
+                } else {
+                    output[n++] = p;
+                    tangent = nextTangent;
+                }
+                lastP = p;
+            }
+        }
+        return n;
+    }
+};
+
 /*!\plugin{hair}{Hair intersection shape}
  * \order{11}
  * \parameters{
@@ -54,6 +321,14 @@ MTS_NAMESPACE_BEGIN
  *       \cite{Cook2007Stochastic}). This parameter is convenient for fast
  *       previews. \default{0, i.e. all geometry is rendered}
  *     }
+ *     \parameter{cache}{\Boolean}{
+ *       When loading an ASCII or \code{BINARY\_HAIR} file, write the strands
+ *       to a file in the compact format with the extension \code{.hairc}
+ *       next to the input. Subsequent runs memory-map this file when it
+ *       is up to date instead of parsing the input again.
+ *       \default{automatic, i.e. \code{true} for files
+ *       with more than $2^{20}$ vertices}
+ *     }
  *     \parameter{toWorld}{\Transform}{
  *        Specifies an optional linear object-to-world transformation.
  *        Note that non-uniform scales are not permitted!
@@ -96,6 +371,18 @@ MTS_NAMESPACE_BEGIN
  * single-precision XYZ coordinates (again in little-endian byte ordering).
  * To mark the beginning of a new hair strand, a single $+\infty$ floating
  * point value can be inserted between the vertex data.
+ *
+ * Finally, the compact format is meant for very large data sets (e.g.
+ * groomed characters with millions of strands), since it can be mapped into
+ * memory and processed in parallel without any parsing. It starts
+ * with the identifier ``\texttt{COMPACT\_HAIR}'' (12 bytes), followed by
+ * a 32-bit format version (currently 1), a 64-bit timestamp (zero,
+ * except in cache files), the number of strands $n$ and the number of
+ * vertices $m$ (32-bit integers). Next are $n+1$ 32-bit integers
+ * holding the index of the first vertex of every strand followed by $m$, and
+ * the single-precision XYZ coordinates of all vertices. All values are stored
+ * using the byte order of the machine (i.e. little endian on x86 machines).
+ * The segments of each strand are indexed implicitly by this table.
  */
 
 class HairKDTree : public SAHKDTree3D<HairKDTree> {
@@ -105,23 +392,43 @@ public:
     using SAHKDTree3D<HairKDTree>::IndexType;
     using SAHKDTree3D<HairKDTree>::SizeType;
 
+    /**
+     * \brief Build a kd-tree over hair strands
+     *
+     * \param vertices
+     *     Vertex positions of all strands (taken over without copying)
+     * \param strandOffsets
+     *     Index of the first vertex of every strand, followed
+     *     by the total number of vertices
+     * \param radius
+     *     Radius of the hair segments
+     */
     HairKDTree(std::vector<Point> &vertices,
-            std::vector<bool> &vertexStartsFiber, Float radius)
+            const std::vector<IndexType> &strandOffsets, Float radius)
             : m_radius(radius) {
-        /* Take the supplied vertex & start fiber arrays (without copying) */
         m_vertices.swap(vertices);
-        m_vertexStartsFiber.swap(vertexStartsFiber);
-        m_hairCount = 0;
-
-        /* Compute the index of the first vertex in each segment. */
-        m_segIndex.reserve(m_vertices.size());
-        for (size_t i=0; i<m_vertices.size()-1; i++) {
-            if (m_vertexStartsFiber[i])
-                m_hairCount++;
-            if (!m_vertexStartsFiber[i+1])
-                m_segIndex.push_back((IndexType) i);
+        m_hairCount = strandOffsets.size() - 1;
+
+        /* Mark the first vertex of each strand (and the end of the last one).
+           Traversal uses these flags (one bit per vertex) to look up the
+           neighboring segments of a miter joint in constant time */
+        m_vertexStartsFiber.resize(m_vertices.size() + 1, false);
+        for (size_t i=0; i<strandOffsets.size(); ++i)
+            m_vertexStartsFiber[strandOffsets[i]] = true;
+
+        /* Each strand with n vertices has n-1 segments, hence the segments
+           of strand i start at index strandOffsets[i] - i. */
+        m_segmentCount = m_vertices.size() - m_hairCount;
+        m_segIndex.resize(m_segmentCount);
+
+        #if defined(MTS_OPENMP)
+            #pragma omp parallel for schedule(dynamic, 1024)
+        #endif
+        for (int i=0; i<(int) m_hairCount; ++i) {
+            IndexType *segIndex = &m_segIndex[0] + strandOffsets[i] - i;
+            for (IndexType iv = strandOffsets[i]; iv+1 < strandOffsets[i+1]; ++iv)
+                *segIndex++ = iv;
         }
-        m_segmentCount = m_segIndex.size();
 
         Log(EDebug, "Building a kd-tree for " SIZE_T_FMT " hair vertices, "
             SIZE_T_FMT " segments, " SIZE_T_FMT " hairs",
@@ -142,11 +449,12 @@ public:
 
         buildInternal();
 
+        m_vertexMemory = m_vertices.size() * sizeof(Point)
+            + m_vertexStartsFiber.size() / 8;
+        hairMemory.allocate(m_vertexMemory);
+
         Log(EDebug, "Total amount of storage (kd-tree & vertex data): %s",
-            memString(m_nodeCount * sizeof(KDNode)
-            + m_indexCount * sizeof(IndexType)
-            + vertices.size() * sizeof(Point)
-            + vertexStartsFiber.size() / 8).c_str());
+            memString(getMemoryUsage()).c_str());
 
         /* Optimization: replace all primitive indices by the
            associated vertex indices (this avoids an extra
@@ -158,6 +466,25 @@ public:
         std::vector<IndexType>().swap(m_segIndex);
     }
 
+    /// Return the amount of memory used by the kd-tree and vertex data
+    inline size_t getMemoryUsage() const {
+        return m_nodeCount * sizeof(KDNode) + m_indexCount * sizeof(IndexType)
+            + m_vertexMemory;
+    }
+
+    /**
+     * \brief Return the index of the first vertex of every strand,
+     * followed by the total number of vertices
+     */
+    std::vector<IndexType> getStrandOffsets() const {
+        std::vector<IndexType> offsets;
+        offsets.reserve(m_hairCount + 1);
+        for (size_t i=0; i<m_vertexStartsFiber.size(); ++i)
+            if (m_vertexStartsFiber[i])
+                offsets.push_back((IndexType) i);
+        return offsets;
+    }
+
     /// Return the AABB of the hair kd-tree
     inline const AABB &getAABB() const {
         return m_aabb;
@@ -598,15 +925,21 @@ public:
 
     MTS_DECLARE_CLASS()
 protected:
+    virtual ~HairKDTree() {
+        hairMemory.release(m_vertexMemory);
+    }
+
     std::vector<Point> m_vertices;
     std::vector<bool> m_vertexStartsFiber;
     std::vector<IndexType> m_segIndex;
     size_t m_segmentCount;
     size_t m_hairCount;
+    size_t m_vertexMemory;
     Float m_radius;
 };
 
 HairShape::HairShape(const Properties &props) : Shape(props) {
+    typedef HairKDTree::IndexType IndexType;
     fs::path path = Thread::getThread()->getFileResolver()->resolve(
         props.getString("filename"));
     Float radius = props.getFloat("radius", 0.025f);
@@ -636,181 +969,160 @@ HairShape::HairShape(const Properties &props) : Shape(props) {
     ref<Timer> timer = new Timer();
 
     ref<FileStream> binaryStream = new FileStream(path, FileStream::EReadOnly);
-    binaryStream->setByteOrder(Stream::ELittleEndian);
+    char header[12];
+    memset(header, 0, sizeof(header));
+    binaryStream->read(header, std::min(binaryStream->getSize(), sizeof(header)));
+    binaryStream->close();
+
+    HairStrands strands;
+    bool compact = memcmp(header, "COMPACT_HAIR", 12) == 0;
+    if (compact) {
+        if (!mapCompact(path, 0, strands))
+            Log(EError, "\"%s\": invalid compact hair file!", path.string().c_str());
+    } else {
+        bool cache = props.getBoolean("cache", true),
+             autoCache = !props.hasProperty("cache");
+
+        boost::system::error_code ec;
+        uint64_t timestamp = (uint64_t) fs::last_write_time(path, ec);
+        fs::path cacheFile = path;
+        cacheFile.replace_extension(".hairc");
+
+        if (cache && !ec.value() && fs::exists(cacheFile)
+                && mapCompact(cacheFile, timestamp, strands)) {
+            Log(EInfo, "Mapped hair cache file \"%s\" into memory (%s).",
+                cacheFile.filename().string().c_str(),
+                memString(strands.mmap->getSize()).c_str());
+        } else {
+            if (memcmp(header, "BINARY_HAIR", 11) == 0)
+                loadBinary(path, strands);
+            else
+                loadASCII(path, strands);
+
+            if (!ec.value() && (autoCache ?
+                    strands.vertexCount > MTS_HAIR_CACHE_THRESHOLD : cache)) {
+                Log(EInfo, "Generating hair cache file \"%s\" ..", cacheFile.string().c_str());
+                writeCompact(cacheFile, timestamp, strands);
+            }
+        }
+    }
 
-    const char *binaryHeader = "BINARY_HAIR";
-    char temp[11];
+    Log(EInfo, "Read " SIZE_T_FMT " strands with " SIZE_T_FMT " vertices (took %i ms)",
+        strands.strandCount, strands.vertexCount, timer->getMilliseconds());
+    timer->reset();
 
-    bool binaryFormat = true;
-    binaryStream->read(temp, 11);
-    if (memcmp(temp, binaryHeader, 11) != 0)
-        binaryFormat = false;
+    /* Decide which strands to cull (serially, so that the result is deterministic) */
+    std::vector<uint8_t> keep(strands.strandCount, 1);
+    if (reduction > 0) {
+        for (size_t i=0; i<strands.strandCount; ++i)
+            keep[i] = random->nextFloat() >= reduction;
+    }
 
-    std::vector<Point> vertices;
-    std::vector<bool> vertexStartsFiber;
-    Vector tangent(0.0f);
+    /* Transform and merge the strands in parallel. A first pass only counts
+       the merged vertices, so that the second pass can write them directly into
+       exactly sized storage without an intermediate copy of the whole data set */
+    std::vector<IndexType> counts(strands.strandCount);
     size_t nDegenerate = 0, nSkipped = 0;
-    Point p, lastP(0.0f);
-    bool ignore = false;
 
-    if (binaryFormat) {
-        size_t vertexCount = binaryStream->readUInt();
-        Log(EInfo, "Loading " SIZE_T_FMT " hair vertices ..", vertexCount);
-        vertices.reserve(vertexCount);
-        vertexStartsFiber.reserve(vertexCount);
-
-        bool newFiber = true;
-        size_t verticesRead = 0;
-
-        while (verticesRead != vertexCount) {
-            Float value = binaryStream->readSingle();
-            if (std::isinf(value)) {
-                p.x = binaryStream->readSingle();
-                p.y = binaryStream->readSingle();
-                p.z = binaryStream->readSingle();
-                newFiber = true;
-                if (reduction > 0)
-                    ignore = random->nextFloat() < reduction;
+    #if defined(MTS_OPENMP)
+        #pragma omp parallel
+    #endif
+    {
+        std::vector<Point> scratch;
+
+        #if defined(MTS_OPENMP)
+            #pragma omp for schedule(dynamic, 1024) reduction(+:nDegenerate, nSkipped)
+        #endif
+        for (int i=0; i<(int) strands.strandCount; ++i) {
+            IndexType offset = strands.offsets[i],
+                      count = strands.offsets[i+1] - offset;
+            size_t localDegenerate = 0, localSkipped = 0;
+
+            if (keep[i] && count > 0) {
+                if (scratch.size() < count)
+                    scratch.resize(count);
+                counts[i] = (IndexType) mergeStrand(strands.vertices + 3 * (size_t) offset,
+                    count, objectToWorld, dpThresh, &scratch[0],
+                    localDegenerate, localSkipped);
             } else {
-                p.x = value;
-                p.y = binaryStream->readSingle();
-                p.z = binaryStream->readSingle();
+                counts[i] = 0;
+                localSkipped = count;
             }
-            //cout << "Read " << verticesRead << " vertices (vs goal " << vertexCount << ") .." << endl;
-            p = objectToWorld(p);
-            verticesRead++;
-
-            if (ignore) {
-                // Do nothing
-                ++nSkipped;
-            } else if (newFiber) {
-                vertices.push_back(p);
-                vertexStartsFiber.push_back(newFiber);
-                lastP = p;
-                tangent = Vector(0.0f);
-            } else if (p != lastP) {
-                if (tangent.isZero()) {
-                    vertices.push_back(p);
-                    vertexStartsFiber.push_back(newFiber);
-                    tangent = normalize(p - lastP);
-                    lastP = p;
-                } else {
-                    Vector nextTangent = normalize(p - lastP);
-                    if (dot(nextTangent, tangent) > dpThresh) {
-                        /* Too small of a difference in the tangent value,
-                           just overwrite the previous vertex by the current one */
-                        tangent = normalize(p - vertices[vertices.size()-2]);
-                        vertices[vertices.size()-1] = p;
-                        ++nSkipped;
-                    } else {
-                        vertices.push_back(p);
-                        vertexStartsFiber.push_back(newFiber);
-                        tangent = nextTangent;
-                    }
-                    lastP = p;
-                }
-            } else {
-                nDegenerate++;
-            }
-            newFiber = false;
+            nDegenerate += localDegenerate;
+            nSkipped += localSkipped;
         }
-    } else {
-        std::string line;
-        bool newFiber = true;
+    }
 
-        fs::ifstream is(path);
-        if (is.fail())
-            Log(EError, "Could not open \"%s\"!", path.string().c_str());
-        while (is.good()) {
-            std::getline(is, line);
-            if (line.length() > 0 && line[0] == '#') {
-                newFiber = true;
-                continue;
-            }
-            std::istringstream iss(line);
-            iss >> p.x >> p.y >> p.z;
-            if (!iss.fail()) {
-                p = objectToWorld(p);
-                if (ignore) {
-                    // Do nothing
-                    ++nSkipped;
-                } else if (newFiber) {
-                    vertices.push_back(p);
-                    vertexStartsFiber.push_back(newFiber);
-                    lastP = p;
-                    tangent = Vector(0.0f);
-                } else if (p != lastP) {
-                    if (tangent.isZero()) {
-                        vertices.push_back(p);
-                        vertexStartsFiber.push_back(newFiber);
-                        tangent = normalize(p - lastP);
-                        lastP = p;
-                    } else {
-                        Vector nextTangent = normalize(p - lastP);
-                        if (dot(nextTangent, tangent) > dpThresh) {
-                            /* Too small of a difference in the tangent value,
-                               just overwrite the previous vertex by the current one */
-                            tangent = normalize(p - vertices[vertices.size()-2]);
-                            vertices[vertices.size()-1] = p;
-                            ++nSkipped;
-                        } else {
-                            vertices.push_back(p);
-                            vertexStartsFiber.push_back(newFiber);
-                            tangent = nextTangent;
-                        }
-                        lastP = p;
-                    }
-                } else {
-                    nDegenerate++;
-                }
-                newFiber = false;
-            } else {
-                newFiber = true;
-                if (reduction > 0)
-                    ignore = random->nextFloat() < reduction;
-            }
-        }
+    /* Compute the final position of each strand */
+    std::vector<IndexType> strandOffsets, strandIndices;
+    strandOffsets.reserve(strands.strandCount + 1);
+    strandIndices.reserve(strands.strandCount);
+    size_t vertexCount = 0;
+    for (size_t i=0; i<strands.strandCount; ++i) {
+        if (counts[i] == 0)
+            continue;
+        strandOffsets.push_back((IndexType) vertexCount);
+        strandIndices.push_back((IndexType) i);
+        vertexCount += counts[i];
+    }
+    strandOffsets.push_back((IndexType) vertexCount);
+
+    if (vertexCount == 0)
+        Log(EError, "\"%s\": the hair shape is empty!", path.string().c_str());
+
+    std::vector<Point> vertices(vertexCount);
+    #if defined(MTS_OPENMP)
+        #pragma omp parallel for schedule(dynamic, 1024)
+    #endif
+    for (int i=0; i<(int) strandIndices.size(); ++i) {
+        IndexType index = strandIndices[i],
+                  offset = strands.offsets[index];
+        size_t unused0 = 0, unused1 = 0;
+        mergeStrand(strands.vertices + 3 * (size_t) offset,
+            strands.offsets[index+1] - offset, objectToWorld, dpThresh,
+            &vertices[strandOffsets[i]], unused0, unused1);
     }
 
+    /* Release the input data (or its mapping) before building the kd-tree */
+    strands.release();
+
     if (nDegenerate > 0)
         Log(EInfo, "Encountered " SIZE_T_FMT
             " degenerate segments!", nDegenerate);
     if (nSkipped > 0)
         Log(EInfo, "Skipped " SIZE_T_FMT " segments.", nSkipped);
-    Log(EInfo, "Done (took %i ms)", timer->getMilliseconds());
 
-    vertexStartsFiber.push_back(true);
+    m_kdtree = new HairKDTree(vertices, strandOffsets, radius);
 
-    m_kdtree = new HairKDTree(vertices, vertexStartsFiber, radius);
+    Log(EInfo, "Done (took %i ms, uses %s of memory)", timer->getMilliseconds(),
+        memString(m_kdtree->getMemoryUsage()).c_str());
 }
 
 HairShape::HairShape(Stream *stream, InstanceManager *manager)
     : Shape(stream, manager) {
     Float radius = stream->readFloat();
     size_t vertexCount = stream->readSize();
+    size_t strandCount = stream->readSize();
 
     std::vector<Point> vertices(vertexCount);
-    std::vector<bool> vertexStartsFiber(vertexCount+1);
+    std::vector<HairKDTree::IndexType> strandOffsets(strandCount + 1);
     stream->readFloatArray((Float *) &vertices[0], vertexCount * 3);
+    stream->readUIntArray(&strandOffsets[0], strandCount + 1);
 
-    for (size_t i=0; i<vertexCount; ++i)
-        vertexStartsFiber[i] = stream->readBool();
-    vertexStartsFiber[vertexCount] = true;
-
-    m_kdtree = new HairKDTree(vertices, vertexStartsFiber, radius);
+    m_kdtree = new HairKDTree(vertices, strandOffsets, radius);
 }
 
 void HairShape::serialize(Stream *stream, InstanceManager *manager) const {
     Shape::serialize(stream, manager);
 
     const std::vector<Point> &vertices = m_kdtree->getVertices();
-    const std::vector<bool> &vertexStartsFiber = m_kdtree->getStartFiber();
+    std::vector<HairKDTree::IndexType> strandOffsets = m_kdtree->getStrandOffsets();
 
     stream->writeFloat(m_kdtree->getRadius());
     stream->writeSize(vertices.size());
-    stream->writeFloatArray((Float *) &vertices[0], vertices.size() * 3);
-    for (size_t i=0; i<vertices.size(); ++i)
-        stream->writeBool(vertexStartsFiber[i]);
+    stream->writeSize(strandOffsets.size() - 1);
+    stream->writeFloatArray((const Float *) &vertices[0], vertices.size() * 3);
+    stream->writeUIntArray(&strandOffsets[0], strandOffsets.size());
 }
 
 bool HairShape::rayIntersect(const Ray &ray, Float mint,
@@ -847,6 +1159,7 @@ void HairShape::fillIntersectionRecord(const Ray &ray,
 
     its.shFrame.n = its.geoFrame.n;
     its.hasUVPartials = false;
+    its.uvFootprint = 0.0f;
     its.instance = this;
     its.time = ray.time;
 }
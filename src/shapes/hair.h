@@ -30,7 +30,8 @@ class HairKDTree;
  * segments with miter joints. This class expects an ASCII file containing
  * a list of hairs made from segments. Each line should contain an X,
  * Y and Z coordinate separated by a space. An empty line indicates
- * the start of a new hair.
+ * the start of a new hair. Two binary formats are supported as well
+ * (see the plugin documentation), one of which can be memory-mapped.
  */
 class HairShape : public Shape {
 public:
@@ -27,29 +27,31 @@
 #include <mitsuba/core/bitmap.h>
 #include <mitsuba/core/fresolver.h>
 #include <mitsuba/core/fstream.h>
+#include <mitsuba/core/mmap.h>
 #include <mitsuba/core/statistics.h>
 #include <mitsuba/core/timer.h>
+#include <mitsuba/core/sse.h>
 
-#define MTS_QTREE_MAXDEPTH  50
+#define MTS_QTREE_MAXDEPTH  100
 #define MTS_QTREE_FASTSTART 1
 
-MTS_NAMESPACE_BEGIN
+/* Quantized height samples are stored in square tiles of 64x64 entries */
+#define MTS_HFIELD_TILE_SHIFT       6
+#define MTS_HFIELD_TILE_SIZE        (1 << MTS_HFIELD_TILE_SHIFT)
+#define MTS_HFIELD_TILE_MASK        (MTS_HFIELD_TILE_SIZE - 1)
 
-static StatsCounter numTraversals("Height field", "Traversal operations per query", EAverage);
+#define MTS_HFIELD_CACHE_VERSION    2
+#define MTS_HFIELD_CACHE_ALIGNMENT  64
 
-namespace {
-    /// Find the smallest t >= 0 such that a*t + b is a multiple of c
-    inline Float nextMultiple(Float a, Float b, Float c) {
-        Float tmp     = b/c,
-              rounded = (a > 0 ? std::ceil(tmp) : std::floor(tmp)) * c,
-              diff    = rounded - b;
+/* Height fields with more samples than this are cached on disk by default */
+#define MTS_HFIELD_CACHE_THRESHOLD  (4096*4096)
 
-        if (diff == 0)
-            diff = math::signum(a) * c;
+MTS_NAMESPACE_BEGIN
 
-        return diff / a;
-    }
+static StatsCounter numTraversals("Height field", "Traversal operations per query", EAverage);
+static MemoryCounter heightfieldMemory("Height fields");
 
+namespace {
     /// Temporary storage for patch-ray intersections
     struct PatchIntersectionRecord {
         Point p;
@@ -60,6 +62,55 @@ namespace {
     struct StackEntry {
         int level, x, y;
     };
+
+    /// Height range of a quadtree node, quantized relative to the global height range
+    struct QuantizedInterval {
+        uint16_t min, max;
+    };
+
+    /// Dequantization parameters of a tile of height samples
+    struct TileRange {
+        float base, scale;
+    };
+
+    /// Header of height field cache files
+    struct HeightfieldCacheHeader {
+        char identifier[3];
+        uint8_t version;
+        int width;
+        int height;
+        uint64_t timestamp;
+        float scale;
+        float zmin;
+        float zscale;
+        float surfaceArea;
+        uint64_t filterHash;
+    };
+
+    /// Round up to a multiple of the cache file alignment
+    inline size_t alignStorage(size_t size) {
+        return (size + MTS_HFIELD_CACHE_ALIGNMENT - 1)
+            & ~((size_t) MTS_HFIELD_CACHE_ALIGNMENT - 1);
+    }
+
+#if defined(SINGLE_PRECISION) && defined(MTS_SSE)
+    /// Clip four ray segments against a pair of slabs along one axis
+    inline void intersectSlab4(Float o, Float d, Float dRcp, __m128 lo, __m128 hi,
+            __m128 &nearT, __m128 &farT, __m128 &mask) {
+        __m128 origin = _mm_set1_ps(o);
+        if (d == 0) {
+            /* The ray is parallel to the planes */
+            mask = _mm_and_ps(mask, _mm_and_ps(
+                _mm_cmple_ps(lo, origin), _mm_cmple_ps(origin, hi)));
+        } else {
+            __m128 rcp = _mm_set1_ps(dRcp),
+                   t0  = _mm_mul_ps(_mm_sub_ps(lo, origin), rcp),
+                   t1  = _mm_mul_ps(_mm_sub_ps(hi, origin), rcp);
+            nearT = _mm_max_ps(nearT, _mm_min_ps(t0, t1));
+            farT  = _mm_min_ps(farT,  _mm_max_ps(t0, t1));
+        }
+    }
+#endif
 };
 
 /*!\plugin{heightfield}{Height field intersection shape}
@@ -96,6 +147,23 @@ namespace {
  *       In the latter case, it will be rasterized using the resolution specified
  *       by the \code{width} and \code{height} arguments.
  *     }
+ *     \parameter{quantize}{\Boolean}{
+ *       Store the height values using 16 bit per sample (relative to the
+ *       value range of each $64\times 64$ tile) and the min-max hierarchy
+ *       using 16-bit bounds. Shading normals are then computed on the fly.
+ *       This reduces the memory usage by roughly a factor of five.
+ *       \default{\code{false}}
+ *     }
+ *     \parameter{cache}{\Boolean}{
+ *       When the height field is loaded from a file, write the quantized
+ *       representation to a cache file with the extension \code{.hfc}
+ *       that is stored next to the input and memory-mapped during rendering.
+ *       Subsequent runs reuse this file when it is up to date. Setting
+ *       this parameter to \code{true} implies \code{quantize}.
+ *       \default{automatic, i.e. \code{true} for height fields
+ *       with more than $4096^2$ samples unless \code{quantize} is
+ *       explicitly set to \code{false}}
+ *     }
  * }
  *\vspace{-2mm}
  * \renderings{
@@ -111,6 +179,15 @@ namespace {
  * height fields using this specialized plugin rather than converting
  * them into triangle meshes.
  *
+ * Very large height fields (e.g. $16\text{K}^2$ terrain tiles) can be
+ * rendered using the \code{quantize} and \code{cache} parameters. In this
+ * case, the height samples are stored in tiles of $64\times 64$ entries, and
+ * the operating system only loads those tiles of the memory-mapped cache
+ * file that are actually touched by rays. Note that generating the cache
+ * file in the first run still requires the complete height field in memory
+ * (the decoded input image and one \code{float} per sample); only the
+ * subsequent renderings that reuse the cache avoid this cost.
+ *
  * \begin{xml}[caption={Declaring a height field from a monochromatic scaled bitmap texture}, label=lst:heightfield-bitmap]
  * <shape type="heightfield">
  *     <string name="filename" value="mountain_profile.exr"/>
@@ -121,7 +198,8 @@ namespace {
 
 class Heightfield : public Shape {
 public:
-    Heightfield(const Properties &props) : Shape(props), m_data(NULL), m_normals(NULL), m_minmax(NULL) {
+    Heightfield(const Properties &props) : Shape(props) {
+        initialize();
         m_sizeHint = Vector2i(
             props.getInteger("width", -1),
             props.getInteger("height", -1)
@@ -131,6 +209,11 @@ public:
         m_shadingNormals = props.getBoolean("shadingNormals", true);
         m_flipNormals = props.getBoolean("flipNormals", false);
         m_scale = props.getFloat("scale", 1);
+        m_quantize = props.getBoolean("quantize", false);
+        m_cache = props.getBoolean("cache", !props.hasProperty("quantize") || m_quantize);
+        m_autoCache = !props.hasProperty("cache");
+        if (m_cache && !m_autoCache)
+            m_quantize = true;
 
         m_filename = props.getString("filename", "");
         if (!m_filename.empty())
@@ -138,11 +221,14 @@ public:
     }
 
     Heightfield(Stream *stream, InstanceManager *manager)
-        : Shape(stream, manager), m_data(NULL), m_normals(NULL), m_minmax(NULL) {
+        : Shape(stream, manager) {
+        initialize();
 
         m_objectToWorld = Transform(stream);
         m_shadingNormals = stream->readBool();
         m_flipNormals = stream->readBool();
+        m_quantize = stream->readBool();
+        m_cache = m_autoCache = false;
         m_scale = stream->readFloat();
         m_filename = stream->readString();
         m_dataSize = Vector2i(stream);
@@ -159,13 +245,39 @@ public:
             for (int i=0; i<m_levelCount; ++i)
                 freeAligned(m_minmax[i]);
             delete[] m_minmax;
+        }
+        if (m_levelSize) {
             delete[] m_levelSize;
             delete[] m_numChildren;
             delete[] m_blockSize;
             delete[] m_blockSizeF;
         }
+        if (m_qminmax)
+            delete[] m_qminmax;
+        if (m_storage)
+            freeAligned(m_storage);
         if (m_normals)
             freeAligned(m_normals);
+        heightfieldMemory.release(m_memoryUsage);
+    }
+
+    void initialize() {
+        m_data = NULL;
+        m_normals = NULL;
+        m_minmax = NULL;
+        m_levelCount = 0;
+        m_levelSize = NULL;
+        m_numChildren = NULL;
+        m_blockSize = NULL;
+        m_blockSizeF = NULL;
+        m_tileRange = NULL;
+        m_qdata = NULL;
+        m_qminmax = NULL;
+        m_storage = NULL;
+        m_memoryUsage = 0;
+        m_surfaceArea = 0;
+        m_zmin = 0;
+        m_zscale = 1;
     }
 
     void serialize(Stream *stream, InstanceManager *manager) const {
@@ -173,10 +285,21 @@ public:
         m_objectToWorld.serialize(stream);
         stream->writeBool(m_shadingNormals);
         stream->writeBool(m_flipNormals);
+        stream->writeBool(m_quantize);
         stream->writeFloat(m_scale);
         stream->writeString(m_filename.string());
         m_dataSize.serialize(stream);
-        stream->writeFloatArray(m_data, (size_t) m_dataSize.x * (size_t) m_dataSize.y);
+        if (m_data) {
+            stream->writeFloatArray(m_data, (size_t) m_dataSize.x * (size_t) m_dataSize.y);
+        } else {
+            /* Send the dequantized heights; the receiver quantizes them again */
+            std::vector<Float> row(m_dataSize.x);
+            for (int y=0; y<m_dataSize.y; ++y) {
+                for (int x=0; x<m_dataSize.x; ++x)
+                    row[x] = getHeight(x, y);
+                stream->writeFloatArray(&row[0], row.size());
+            }
+        }
     }
 
     AABB getAABB() const {
@@ -199,13 +322,164 @@ public:
         return (size_t) m_levelSize[0].x * (size_t) m_levelSize[0].y;
     }
 
-    inline static int signumToInt(Float value) {
-        if (value < 0)
-            return -1;
-        else if (value > 0)
-            return 1;
-        else
-            return 0;
+    /// Return the height value at the given integer sample position
+    inline Float getHeight(int x, int y) const {
+        if (m_data)
+            return m_data[y * m_dataSize.x + x];
+
+        size_t tile = (size_t) (x >> MTS_HFIELD_TILE_SHIFT)
+            + (size_t) (y >> MTS_HFIELD_TILE_SHIFT) * m_tileCount.x;
+        const TileRange &range = m_tileRange[tile];
+        uint16_t value = m_qdata[(tile << (2*MTS_HFIELD_TILE_SHIFT))
+            + ((y & MTS_HFIELD_TILE_MASK) << MTS_HFIELD_TILE_SHIFT)
+            + (x & MTS_HFIELD_TILE_MASK)];
+
+        return range.base + range.scale * (Float) value;
+    }
+
+    /// Return the height bounds of a node of the min-max quadtree
+    inline Interval getBounds(int level, int x, int y) const {
+        if (m_minmax)
+            return m_minmax[level][x + y * m_levelSize[level].x];
+
+        if (level == 0) {
+            /* The lowest level is not stored in quantized mode */
+            Float f00 = getHeight(x, y),   f10 = getHeight(x+1, y),
+                  f01 = getHeight(x, y+1), f11 = getHeight(x+1, y+1);
+            return Interval(
+                std::min(std::min(f00, f01), std::min(f10, f11)),
+                std::max(std::max(f00, f01), std::max(f10, f11)));
+        }
+
+        const QuantizedInterval &bounds =
+            m_qminmax[level][x + y * m_levelSize[level].x];
+        return Interval(
+            m_zmin + bounds.min * m_zscale,
+            m_zmin + bounds.max * m_zscale);
+    }
+
+    /// Conservatively quantize a height interval relative to the global height range
+    inline QuantizedInterval quantizeBounds(Float min, Float max) const {
+        Float invScale = 1 / (Float) m_zscale;
+        int qmin = math::clamp(math::floorToInt((min - m_zmin) * invScale), 0, 0xFFFF),
+            qmax = math::clamp(math::ceilToInt ((max - m_zmin) * invScale), 0, 0xFFFF);
+
+        /* Guard against round-off: the dequantized interval must contain the input */
+        while (qmin > 0 && m_zmin + qmin * m_zscale > min)
+            --qmin;
+        while (qmax < 0xFFFF && m_zmin + qmax * m_zscale < max)
+            ++qmax;
+
+        QuantizedInterval result;
+        result.min = (uint16_t) qmin;
+        result.max = (uint16_t) qmax;
+        return result;
+    }
+
+    /**
+     * \brief Return the shading normal at the given integer sample position
+     *
+     * In quantized mode, this averages the normals of the adjacent patch
+     * corners on the fly (matching the precomputed normals otherwise).
+     */
+    inline Normal getVertexNormal(int x, int y) const {
+        if (m_normals)
+            return m_normals[y * m_dataSize.x + x];
+
+        bool left = x > 0, right = x < m_levelSize[0].x,
+             bottom = y > 0, top = y < m_levelSize[0].y;
+
+        Float h  = getHeight(x, y),
+              hl = left   ? getHeight(x-1, y) : 0,
+              hr = right  ? getHeight(x+1, y) : 0,
+              hb = bottom ? getHeight(x, y-1) : 0,
+              ht = top    ? getHeight(x, y+1) : 0;
+
+        Normal n(0.0f);
+        if (right && top)
+            n += normalize(Normal(h - hr, h - ht, 1));
+        if (left && top)
+            n += normalize(Normal(hl - h, h - ht, 1));
+        if (right && bottom)
+            n += normalize(Normal(h - hr, hb - h, 1));
+        if (left && bottom)
+            n += normalize(Normal(hl - h, hb - h, 1));
+        return normalize(n);
+    }
+
+    /**
+     * \brief Intersect a ray against the (up to 2x2) children of
+     * a quadtree node
+     *
+     * The ray is specified in the local coordinate system of the parent
+     * node, and \c x and \c y refer to the first child at level \c level.
+     * Returns a bit mask of the children that were hit and writes their
+     * entry distances to \c nearT.
+     */
+    inline int intersectChildren(const Ray &ray, int level, int x, int y,
+            const Vector2i &numChildren, Float mint, Float maxt, Float *nearT) const {
+        const Vector2 &size = m_blockSizeF[level];
+        int valid = 1;
+        Interval bounds[4];
+
+        bounds[0] = getBounds(level, x, y);
+        bounds[1] = bounds[2] = bounds[3] = bounds[0];
+        if (numChildren.x > 1) {
+            bounds[1] = getBounds(level, x+1, y);
+            valid |= 2;
+        }
+        if (numChildren.y > 1) {
+            bounds[2] = getBounds(level, x, y+1);
+            valid |= 4;
+        }
+        if (numChildren.x > 1 && numChildren.y > 1) {
+            bounds[3] = getBounds(level, x+1, y+1);
+            valid |= 8;
+        }
+
+#if defined(SINGLE_PRECISION) && defined(MTS_SSE)
+        /* Test all four child boxes at once */
+        __m128 near = _mm_set1_ps(mint),
+               far  = _mm_set1_ps(maxt),
+               mask = _mm_castsi128_ps(_mm_set1_epi32(-1));
+
+        intersectSlab4(ray.o.x, ray.d.x, ray.dRcp.x,
+            _mm_setr_ps(0, size.x, 0, size.x),
+            _mm_setr_ps(size.x, 2*size.x, size.x, 2*size.x), near, far, mask);
+        intersectSlab4(ray.o.y, ray.d.y, ray.dRcp.y,
+            _mm_setr_ps(0, 0, size.y, size.y),
+            _mm_setr_ps(size.y, size.y, 2*size.y, 2*size.y), near, far, mask);
+        intersectSlab4(ray.o.z, ray.d.z, ray.dRcp.z,
+            _mm_setr_ps(bounds[0].min, bounds[1].min, bounds[2].min, bounds[3].min),
+            _mm_setr_ps(bounds[0].max, bounds[1].max, bounds[2].max, bounds[3].max),
+            near, far, mask);
+
+        mask = _mm_and_ps(mask, _mm_cmple_ps(near, far));
+        _mm_storeu_ps(nearT, near);
+        return _mm_movemask_ps(mask) & valid;
+#else
+        int hit = 0;
+        for (int i=0; i<4; ++i) {
+            if (!(valid & (1 << i)))
+                continue;
+            Float offsetX = (i & 1) ? size.x : 0,
+                  offsetY = (i & 2) ? size.y : 0;
+            AABB aabb(
+                Point3(offsetX, offsetY, bounds[i].min),
+                Point3(offsetX + size.x, offsetY + size.y, bounds[i].max));
+
+            Float t0, t1;
+            if (!aabb.rayIntersect(ray, t0, t1))
+                continue;
+            t0 = std::max(t0, mint);
+            t1 = std::min(t1, maxt);
+            if (t0 <= t1) {
+                nearT[i] = t0;
+                hit |= 1 << i;
+            }
+        }
+        return hit;
+#endif
     }
 
     bool rayIntersect(const Ray &_ray, Float mint, Float maxt, Float &t, void *tmp) const {
@@ -215,14 +489,6 @@ public:
         Ray ray;
         m_objectToWorld.inverse()(_ray, ray);
 
-        /* Ray length to cross a single cell along the X or Y axis */
-        Float tDeltaXSingle = std::abs(ray.dRcp.x),
-              tDeltaYSingle = std::abs(ray.dRcp.y);
-
-        /* Cell coordinate increments for steps along the ray */
-        int iDeltaX = signumToInt(ray.d.x),
-            iDeltaY = signumToInt(ray.d.y);
-
         int stackIdx = 0;
 
         #if MTS_QTREE_FASTSTART
@@ -268,67 +534,65 @@ public:
         while (stackIdx >= 0) {
             ++nTraversals;
 
-            /* Pop a node from the stack and compute its bounding box */
+            /* Pop a node from the stack and move the ray into its local coordinates */
             StackEntry entry         = stack[stackIdx--];
-            const Interval &interval = m_minmax[entry.level][
-                entry.x + entry.y * m_levelSize[entry.level].x];
             const Vector2 &blockSize = m_blockSizeF[entry.level];
-            AABB aabb(
-                Point3(0, 0, interval.min),
-                Point3(blockSize.x, blockSize.y, interval.max)
-            );
-
-            /* Intersect the ray against the bounding box, in local coordinates */
             Ray localRay(Point(ray.o.x - entry.x*blockSize.x,
                                ray.o.y - entry.y*blockSize.y, ray.o.z), ray.d, 0);
-            Float nearT = mint, farT = maxt;
-            Point enterPt, exitPt;
-
-            if (!aabb.rayIntersect(localRay, nearT, farT, enterPt, exitPt)) {
-                /* The bounding box was not intersected -- skip */
-                continue;
-            }
-
-            Float tMax = farT - nearT;
 
             if (entry.level > 0) {
-                /* Inner node -- push child nodes in 2D DDA order */
+                /* Inner node -- test the bounding boxes of all children
+                   at once and push the ones that were hit so that they
+                   are visited in front-to-back order */
                 const Vector2i &numChildren = m_numChildren[entry.level];
-                const Vector2 &subBlockSize = m_blockSizeF[--entry.level];
-                entry.x *= numChildren.x; entry.y *= numChildren.y;
-
-                int x = (exitPt.x >= subBlockSize.x) ? numChildren.x-1 : 0;
-                int y = (exitPt.y >= subBlockSize.y) ? numChildren.y-1 : 0;
-
-                Float tDeltaX = tDeltaXSingle * subBlockSize.x,
-                      tDeltaY = tDeltaYSingle * subBlockSize.y,
-                      tNextX  = nextMultiple(-ray.d.x, exitPt.x, subBlockSize.x),
-                      tNextY  = nextMultiple(-ray.d.y, exitPt.y, subBlockSize.y),
-                      t       = 0;
-
-                while ((uint32_t) x < (uint32_t) numChildren.x &&
-                       (uint32_t) y < (uint32_t) numChildren.y && t <= tMax) {
-                    stack[++stackIdx].level = entry.level;
-                    stack[stackIdx].x = entry.x + x;
-                    stack[stackIdx].y = entry.y + y;
-
-                    if (tNextX < tNextY) {
-                        t = tNextX;
-                        tNextX += tDeltaX;
-                        x -= iDeltaX;
-                    } else {
-                        t = tNextY;
-                        tNextY += tDeltaY;
-                        y -= iDeltaY;
+                Float childNearT[4];
+                int hit = intersectChildren(localRay, entry.level - 1,
+                    entry.x * numChildren.x, entry.y * numChildren.y,
+                    numChildren, mint, maxt, childNearT);
+
+                if (!hit)
+                    continue;
+
+                /* Sort by decreasing entry distance (insertion sort) */
+                int order[4], count = 0;
+                for (int i=0; i<4; ++i) {
+                    if (!(hit & (1 << i)))
+                        continue;
+                    int j = count++;
+                    while (j > 0 && childNearT[order[j-1]] < childNearT[i]) {
+                        order[j] = order[j-1];
+                        --j;
                     }
+                    order[j] = i;
+                }
+
+                for (int i=0; i<count; ++i) {
+                    stack[++stackIdx].level = entry.level - 1;
+                    stack[stackIdx].x = entry.x * numChildren.x + (order[i] & 1);
+                    stack[stackIdx].y = entry.y * numChildren.y + (order[i] >> 1);
                 }
             } else {
+                /* Leaf node -- clip the ray against the patch bounds */
+                Interval interval = getBounds(0, entry.x, entry.y);
+                AABB aabb(
+                    Point3(0, 0, interval.min),
+                    Point3(1, 1, interval.max)
+                );
+
+                Float nearT = mint, farT = maxt;
+                Point enterPt, exitPt;
+
+                if (!aabb.rayIntersect(localRay, nearT, farT, enterPt, exitPt))
+                    continue;
+
+                Float tMax = farT - nearT;
+
                 /* Intersect the ray against a bilinear patch */
                 Float
-                    f00 = m_data[entry.y * m_dataSize.x + entry.x],
-                    f01 = m_data[(entry.y + 1) * m_dataSize.x + entry.x],
-                    f10 = m_data[entry.y * m_dataSize.x + entry.x + 1],
-                    f11 = m_data[(entry.y + 1) * m_dataSize.x + entry.x + 1];
+                    f00 = getHeight(entry.x,     entry.y),
+                    f01 = getHeight(entry.x,     entry.y + 1),
+                    f10 = getHeight(entry.x + 1, entry.y),
+                    f11 = getHeight(entry.x + 1, entry.y + 1);
 
                 Float A = ray.d.x * ray.d.y * (f00 - f01 - f10 + f11);
                 Float B = ray.d.y * (f01 - f00 + enterPt.x * (f00 - f01 - f10 + f11))
@@ -375,10 +639,10 @@ public:
 
         int x = temp.x, y = temp.y, width = m_dataSize.x;
         Float
-            f00 = m_data[y     * width + x],
-            f01 = m_data[(y+1) * width + x],
-            f10 = m_data[y     * width + x + 1],
-            f11 = m_data[(y+1) * width + x + 1];
+            f00 = getHeight(x,     y),
+            f01 = getHeight(x,     y + 1),
+            f10 = getHeight(x + 1, y),
+            f11 = getHeight(x + 1, y + 1);
 
         Point pLocal(temp.p.x + temp.x, temp.p.y + temp.y, temp.p.z);
         its.uv = Point2(pLocal.x * m_invSize.x, pLocal.y * m_invSize.y);
@@ -393,11 +657,11 @@ public:
         its.geoFrame.n = cross(its.geoFrame.s, its.geoFrame.t);
 
         if (m_shadingNormals) {
-            const Normal
-                &n00 = m_normals[y     * width + x],
-                &n01 = m_normals[(y+1) * width + x],
-                &n10 = m_normals[y     * width + x + 1],
-                &n11 = m_normals[(y+1) * width + x + 1];
+            Normal
+                n00 = getVertexNormal(x,     y),
+                n01 = getVertexNormal(x,     y + 1),
+                n10 = getVertexNormal(x + 1, y),
+                n11 = getVertexNormal(x + 1, y + 1);
 
             its.shFrame.n = normalize(m_objectToWorld(Normal(
                 (1 - temp.p.x) * ((1-temp.p.y) * n00 + temp.p.y * n01)
@@ -413,6 +677,7 @@ public:
 
         its.shape = this;
         its.hasUVPartials = false;
+        its.uvFootprint = 0.0f;
         its.instance = NULL;
         its.time = ray.time;
         its.primIndex = x + y*width;
@@ -435,11 +700,11 @@ public:
         Normal normal;
         if (shadingFrame && m_shadingNormals) {
             /* Derivatives for bilinear patch with interpolated shading normals */
-            const Normal
-                &n00 = m_normals[y     * width + x],
-                &n01 = m_normals[(y+1) * width + x],
-                &n10 = m_normals[y     * width + x + 1],
-                &n11 = m_normals[(y+1) * width + x + 1];
+            Normal
+                n00 = getVertexNormal(x,     y),
+                n01 = getVertexNormal(x,     y + 1),
+                n10 = getVertexNormal(x + 1, y),
+                n11 = getVertexNormal(x + 1, y + 1);
 
             normal = m_objectToWorld(Normal(
                 (1 - u) * ((1-v) * n00 + v * n01)
@@ -450,10 +715,10 @@ public:
         } else {
             /* Derivatives for bilinear patch with geometric normals */
             Float
-                f00 = m_data[y     * width + x],
-                f01 = m_data[(y+1) * width + x],
-                f10 = m_data[y     * width + x + 1],
-                f11 = m_data[(y+1) * width + x + 1];
+                f00 = getHeight(x,     y),
+                f01 = getHeight(x,     y + 1),
+                f10 = getHeight(x + 1, y),
+                f11 = getHeight(x + 1, y + 1);
 
             normal = m_objectToWorld(
                 Normal(f00 - f10 + (f01 + f10 - f00 - f11)*v,
@@ -494,48 +759,75 @@ public:
     void configure() {
         Shape::configure();
 
-        if (m_minmax)
+        if (m_levelSize)
             return;
 
-        if (!m_filename.empty()) {
+        fs::path cacheFile;
+        uint64_t timestamp = 0;
+        bool reuseCache = false, createCache = false;
+
+        /* Only apply the normalization transformation once (it is
+           already part of the transformation of unserialized instances) */
+        bool applyNormalization = m_data == NULL;
+
+        if (m_data == NULL && !m_filename.empty()) {
             if (m_bitmap.get())
                 Log(EError, "Cannot specify a file name and a nested texture at the same time!");
-            ref<FileStream> fs = new FileStream(m_filename, FileStream::EReadOnly);
-            m_bitmap = new Bitmap(Bitmap::EAuto, fs);
-        } else if (!m_bitmap.get()) {
-            Log(EError, "A height field texture must be specified (either as a nested texture, or using the 'filename' parameter)");
+
+            boost::system::error_code ec;
+            timestamp = (uint64_t) fs::last_write_time(m_filename, ec);
+            if (ec.value())
+                Log(EError, "Could not determine modification time of \"%s\"!", m_filename.string().c_str());
+
+            cacheFile = m_filename;
+            cacheFile.replace_extension(".hfc");
+
+            if (m_cache && fs::exists(cacheFile))
+                reuseCache = loadCache(cacheFile, timestamp);
         }
 
-        m_dataSize = m_bitmap->getSize();
-        if (m_dataSize.x < 2) m_dataSize.x = 2;
-        if (m_dataSize.y < 2) m_dataSize.y = 2;
-        if (!math::isPowerOfTwo(m_dataSize.x - 1)) m_dataSize.x = (int) math::roundToPowerOfTwo((uint32_t) m_dataSize.x - 1) + 1;
-        if (!math::isPowerOfTwo(m_dataSize.y - 1)) m_dataSize.y = (int) math::roundToPowerOfTwo((uint32_t) m_dataSize.y - 1) + 1;
+        if (m_data == NULL && !reuseCache) {
+            if (!m_filename.empty()) {
+                ref<FileStream> fs = new FileStream(m_filename, FileStream::EReadOnly);
+                m_bitmap = new Bitmap(Bitmap::EAuto, fs);
+            } else if (!m_bitmap.get()) {
+                Log(EError, "A height field texture must be specified (either as a nested texture, or using the 'filename' parameter)");
+            }
 
-        if (m_bitmap->getSize() != m_dataSize) {
-            m_bitmap = m_bitmap->convert(Bitmap::ELuminance, Bitmap::EFloat);
+            m_dataSize = m_bitmap->getSize();
+            if (m_dataSize.x < 2) m_dataSize.x = 2;
+            if (m_dataSize.y < 2) m_dataSize.y = 2;
+            if (!math::isPowerOfTwo(m_dataSize.x - 1)) m_dataSize.x = (int) math::roundToPowerOfTwo((uint32_t) m_dataSize.x - 1) + 1;
+            if (!math::isPowerOfTwo(m_dataSize.y - 1)) m_dataSize.y = (int) math::roundToPowerOfTwo((uint32_t) m_dataSize.y - 1) + 1;
 
-            Log(EInfo, "Resampling heightfield texture from %ix%i to %ix%i ..",
-                m_bitmap->getWidth(), m_bitmap->getHeight(), m_dataSize.x, m_dataSize.y);
+            if (m_bitmap->getSize() != m_dataSize) {
+                m_bitmap = m_bitmap->convert(Bitmap::ELuminance, Bitmap::EFloat);
 
-            m_bitmap = m_bitmap->resample(m_rfilter, ReconstructionFilter::EClamp,
-                ReconstructionFilter::EClamp, m_dataSize,
-                -std::numeric_limits<Float>::infinity(),
-                std::numeric_limits<Float>::infinity());
-        }
+                Log(EInfo, "Resampling heightfield texture from %ix%i to %ix%i ..",
+                    m_bitmap->getWidth(), m_bitmap->getHeight(), m_dataSize.x, m_dataSize.y);
 
-        size_t size = (size_t) m_dataSize.x * (size_t) m_dataSize.y * sizeof(Float);
-        m_data = (Float *) allocAligned(size);
-        m_bitmap->convert(m_data, Bitmap::ELuminance, Bitmap::EFloat, 1.0f, m_scale);
+                m_bitmap = m_bitmap->resample(m_rfilter, ReconstructionFilter::EClamp,
+                    ReconstructionFilter::EClamp, m_dataSize,
+                    -std::numeric_limits<Float>::infinity(),
+                    std::numeric_limits<Float>::infinity());
+            }
 
-        m_objectToWorld = m_objectToWorld * Transform::translate(Vector(-1, -1, 0)) * Transform::scale(Vector(
-            (Float) 2 / (m_dataSize.x-1),
-            (Float) 2 / (m_dataSize.y-1), 1));
+            size_t size = (size_t) m_dataSize.x * (size_t) m_dataSize.y * sizeof(Float);
+            m_data = (Float *) allocAligned(size);
+            m_bitmap->convert(m_data, Bitmap::ELuminance, Bitmap::EFloat, 1.0f, m_scale);
+            m_bitmap = NULL;
 
-        m_bitmap = NULL;
+            /* Potentially create a new cache file */
+            createCache = !cacheFile.empty() && m_cache && (!m_autoCache ||
+                (size_t) m_dataSize.x * (size_t) m_dataSize.y > MTS_HFIELD_CACHE_THRESHOLD);
+            if (createCache)
+                m_quantize = true;
+        }
 
-        size_t storageSize = (size_t) m_dataSize.x * (size_t) m_dataSize.y * sizeof(Float);
-        Log(EInfo, "Building acceleration data structure for %ix%i height field ..", m_dataSize.x, m_dataSize.y);
+        if (applyNormalization)
+            m_objectToWorld = m_objectToWorld * Transform::translate(Vector(-1, -1, 0)) * Transform::scale(Vector(
+                (Float) 2 / (m_dataSize.x-1),
+                (Float) 2 / (m_dataSize.y-1), 1));
 
         ref<Timer> timer = new Timer();
         m_levelCount = (int) std::max(math::log2i((uint32_t) m_dataSize.x-1), math::log2i((uint32_t) m_dataSize.y-1)) + 1;
@@ -544,16 +836,60 @@ public:
         m_numChildren = new Vector2i[m_levelCount];
         m_blockSize = new Vector2i[m_levelCount];
         m_blockSizeF = new Vector2[m_levelCount];
-        m_minmax = new Interval*[m_levelCount];
 
         m_levelSize[0]  = Vector2i(m_dataSize.x - 1, m_dataSize.y - 1);
         m_levelSize0f  = Vector2(m_levelSize[0]);
+        m_numChildren[0] = Vector2i(0, 0);
         m_blockSize[0] = Vector2i(1, 1);
         m_blockSizeF[0] = Vector2(1, 1);
         m_invSize = Vector2((Float) 1 / m_levelSize[0].x, (Float) 1 / m_levelSize[0].y);
+
+        for (int level=1; level<m_levelCount; ++level) {
+            Vector2i &cur  = m_levelSize[level],
+                     &prev = m_levelSize[level-1];
+
+            /* Calculate size of this layer */
+            cur.x = prev.x > 1 ? (prev.x / 2) : 1;
+            cur.y = prev.y > 1 ? (prev.y / 2) : 1;
+
+            m_numChildren[level].x = prev.x > 1 ? 2 : 1;
+            m_numChildren[level].y = prev.y > 1 ? 2 : 1;
+            m_blockSize[level] = Vector2i(
+                m_levelSize[0].x / cur.x,
+                m_levelSize[0].y / cur.y
+            );
+            m_blockSizeF[level] = Vector2(m_blockSize[level]);
+        }
+
+        if (reuseCache) {
+            Log(EInfo, "Mapped height field cache file \"%s\" into memory (%s).",
+                cacheFile.filename().string().c_str(), memString(m_mmap->getSize()).c_str());
+        } else if (m_quantize) {
+            Log(EInfo, "Building quantized acceleration data structure for %ix%i height field ..", m_dataSize.x, m_dataSize.y);
+            buildQuantized(createCache ? cacheFile : fs::path(), timestamp);
+        } else {
+            Log(EInfo, "Building acceleration data structure for %ix%i height field ..", m_dataSize.x, m_dataSize.y);
+            build();
+        }
+
+        if (!reuseCache)
+            Log(EInfo, "Done (took %i ms, uses %s of memory)", timer->getMilliseconds(),
+                memString(m_mmap ? m_mmap->getSize() : m_memoryUsage).c_str());
+
+        Interval bounds = getBounds(m_levelCount-1, 0, 0);
+        m_dataAABB = AABB(
+            Point3(0, 0, bounds.min),
+            Point3(m_levelSize0f.x, m_levelSize0f.y, bounds.max)
+        );
+    }
+
+    /// Build the full-precision min-max quadtree and shading normals
+    void build() {
+        size_t storageSize = (size_t) m_dataSize.x * (size_t) m_dataSize.y * sizeof(Float);
+        m_minmax = new Interval*[m_levelCount];
         m_surfaceArea = 0;
 
-        size = (size_t) m_levelSize[0].x * (size_t) m_levelSize[0].y * sizeof(Interval);
+        size_t size = (size_t) m_levelSize[0].x * (size_t) m_levelSize[0].y * sizeof(Interval);
         m_minmax[0] = (Interval *) allocAligned(size);
         storageSize += size;
 
@@ -577,20 +913,8 @@ public:
 
         /* Propagate height bounds upwards to the other layers */
         for (int level=1; level<m_levelCount; ++level) {
-            Vector2i &cur  = m_levelSize[level],
-                     &prev = m_levelSize[level-1];
-
-            /* Calculate size of this layer */
-            cur.x = prev.x > 1 ? (prev.x / 2) : 1;
-            cur.y = prev.y > 1 ? (prev.y / 2) : 1;
-
-            m_numChildren[level].x = prev.x > 1 ? 2 : 1;
-            m_numChildren[level].y = prev.y > 1 ? 2 : 1;
-            m_blockSize[level] = Vector2i(
-                m_levelSize[0].x / cur.x,
-                m_levelSize[0].y / cur.y
-            );
-            m_blockSizeF[level] = Vector2(m_blockSize[level]);
+            const Vector2i &cur  = m_levelSize[level],
+                           &prev = m_levelSize[level-1];
 
             /* Allocate memory for interval data */
             Interval *prevBounds = m_minmax[level-1], *curBounds;
@@ -653,13 +977,299 @@ public:
             }
         }
 
-        Log(EInfo, "Done (took %i ms, uses %s of memory)", timer->getMilliseconds(),
-                memString(storageSize).c_str());
+        m_memoryUsage = storageSize;
+        heightfieldMemory.allocate(m_memoryUsage);
+    }
 
-        m_dataAABB = AABB(
-            Point3(0, 0, m_minmax[m_levelCount-1][0].min),
-            Point3(m_levelSize0f.x, m_levelSize0f.y, m_minmax[m_levelCount-1][0].max)
-        );
+    /**
+     * \brief Compute the layout of the quantized storage: a cache file
+     * header, followed by the tile table, the tiles of height samples,
+     * and the levels 1..n of the min-max quadtree
+     */
+    static size_t getStorageLayout(const Vector2i &dataSize, std::vector<size_t> &offsets) {
+        Vector2i levelSize(dataSize.x - 1, dataSize.y - 1);
+        size_t tileCount =
+            (size_t) ((dataSize.x + MTS_HFIELD_TILE_MASK) >> MTS_HFIELD_TILE_SHIFT) *
+            (size_t) ((dataSize.y + MTS_HFIELD_TILE_MASK) >> MTS_HFIELD_TILE_SHIFT);
+
+        size_t offset = alignStorage(sizeof(HeightfieldCacheHeader));
+        offsets.clear();
+        offsets.push_back(offset);
+        offset += alignStorage(tileCount * sizeof(TileRange));
+        offsets.push_back(offset);
+        offset += alignStorage(tileCount * sizeof(uint16_t)
+            * MTS_HFIELD_TILE_SIZE * MTS_HFIELD_TILE_SIZE);
+
+        while (levelSize.x > 1 || levelSize.y > 1) {
+            levelSize.x = levelSize.x > 1 ? (levelSize.x / 2) : 1;
+            levelSize.y = levelSize.y > 1 ? (levelSize.y / 2) : 1;
+            offsets.push_back(offset);
+            offset += alignStorage((size_t) levelSize.x * (size_t) levelSize.y
+                * sizeof(QuantizedInterval));
+        }
+
+        return offset;
+    }
+
+    /// Set up the pointers into the quantized storage
+    void setStorage(uint8_t *base, const std::vector<size_t> &offsets) {
+        m_tileCount = Vector2i(
+            (m_dataSize.x + MTS_HFIELD_TILE_MASK) >> MTS_HFIELD_TILE_SHIFT,
+            (m_dataSize.y + MTS_HFIELD_TILE_MASK) >> MTS_HFIELD_TILE_SHIFT);
+        m_tileRange = (const TileRange *) (base + offsets[0]);
+        m_qdata = (const uint16_t *) (base + offsets[1]);
+        if (m_qminmax)
+            delete[] m_qminmax;
+        m_qminmax = new const QuantizedInterval*[offsets.size()];
+        m_qminmax[0] = NULL;
+        for (size_t i=2; i<offsets.size(); ++i)
+            m_qminmax[i-1] = (const QuantizedInterval *) (base + offsets[i]);
+    }
+
+    /// Fingerprint of the reconstruction filter used to resample the heights
+    uint64_t getFilterHash() const {
+        /* 64-bit FNV-1a hash of the filter description */
+        std::string desc = m_rfilter.get() ? m_rfilter->toString() : std::string("default");
+        uint64_t hash = 0xcbf29ce484222325ULL;
+        for (size_t i=0; i<desc.length(); ++i) {
+            hash ^= (uint8_t) desc[i];
+            hash *= 0x100000001b3ULL;
+        }
+        return hash;
+    }
+
+    /// Try to map an existing cache file into memory
+    bool loadCache(const fs::path &cacheFile, uint64_t timestamp) {
+        ref<MemoryMappedFile> mmap;
+        try {
+            mmap = new MemoryMappedFile(cacheFile);
+        } catch (const std::exception &e) {
+            Log(EWarn, "Unable to map the height field cache file \"%s\": %s",
+                cacheFile.string().c_str(), e.what());
+            return false;
+        }
+
+        if (mmap->getSize() < sizeof(HeightfieldCacheHeader))
+            return false;
+
+        const HeightfieldCacheHeader &header = *((const HeightfieldCacheHeader *) mmap->getData());
+        if (header.identifier[0] != 'H' || header.identifier[1] != 'F'
+            || header.identifier[2] != 'C' || header.version != MTS_HFIELD_CACHE_VERSION
+            || header.timestamp != timestamp || header.scale != (float) m_scale
+            || header.filterHash != getFilterHash()
+            || header.width < 2 || header.height < 2)
+            return false;
+
+        /* In automatic mode, small height fields are only quantized on request */
+        if (m_autoCache && !m_quantize && (size_t) header.width
+                * (size_t) header.height <= MTS_HFIELD_CACHE_THRESHOLD)
+            return false;
+
+        /* Sanity check on the expected file size */
+        Vector2i dataSize(header.width, header.height);
+        std::vector<size_t> offsets;
+        if (getStorageLayout(dataSize, offsets) != mmap->getSize())
+            return false;
+
+        m_mmap = mmap;
+        m_dataSize = dataSize;
+        m_zmin = header.zmin;
+        m_zscale = header.zscale;
+        m_surfaceArea = header.surfaceArea;
+        m_quantize = true;
+        setStorage((uint8_t *) m_mmap->getData(), offsets);
+        return true;
+    }
+
+    /**
+     * \brief Build the quantized tile storage and min-max quadtree from
+     * the full-precision heights, optionally writing them to a cache file
+     *
+     * The cache file is generated under a temporary name in the same
+     * directory and only renamed once it is complete, so that other
+     * processes never map a partially written (or truncated) file.
+     */
+    void buildQuantized(const fs::path &cacheFile, uint64_t timestamp) {
+        std::vector<size_t> offsets;
+        size_t storageSize = getStorageLayout(m_dataSize, offsets);
+        uint8_t *base = NULL;
+        fs::path tempFile;
+
+        if (!cacheFile.empty()) {
+            Log(EInfo, "Generating height field cache file \"%s\" ..", cacheFile.string().c_str());
+            try {
+                tempFile = cacheFile.parent_path() /
+                    fs::unique_path(cacheFile.filename().string() + ".%%%%%%%%.tmp");
+                m_mmap = new MemoryMappedFile(tempFile, storageSize);
+                base = (uint8_t *) m_mmap->getData();
+            } catch (const std::exception &e) {
+                Log(EWarn, "Unable to create the height field cache file \"%s\": %s",
+                    cacheFile.string().c_str(), e.what());
+                m_mmap = NULL;
+                tempFile = fs::path();
+            }
+        }
+
+        if (!base) {
+            m_storage = base = (uint8_t *) allocAligned(storageSize);
+            m_memoryUsage = storageSize;
+            heightfieldMemory.allocate(m_memoryUsage);
+        }
+
+        setStorage(base, offsets);
+        TileRange *tileRange = (TileRange *) (base + offsets[0]);
+        uint16_t *qdata = (uint16_t *) (base + offsets[1]);
+        int tileCount = m_tileCount.x * m_tileCount.y;
+
+        /* Quantize the height samples relative to the value range of each tile */
+        #if defined(MTS_OPENMP)
+            #pragma omp parallel for schedule(dynamic)
+        #endif
+        for (int tile=0; tile<tileCount; ++tile) {
+            int x0 = (tile % m_tileCount.x) << MTS_HFIELD_TILE_SHIFT,
+                y0 = (tile / m_tileCount.x) << MTS_HFIELD_TILE_SHIFT,
+                x1 = std::min(x0 + MTS_HFIELD_TILE_SIZE, m_dataSize.x),
+                y1 = std::min(y0 + MTS_HFIELD_TILE_SIZE, m_dataSize.y);
+
+            Float min = std::numeric_limits<Float>::infinity(),
+                  max = -std::numeric_limits<Float>::infinity();
+            for (int y=y0; y<y1; ++y) {
+                for (int x=x0; x<x1; ++x) {
+                    Float value = m_data[y * m_dataSize.x + x];
+                    min = std::min(min, value);
+                    max = std::max(max, value);
+                }
+            }
+
+            TileRange &range = tileRange[tile];
+            range.base = (float) min;
+            range.scale = (float) ((max - min) / 0xFFFF);
+            Float invScale = range.scale > 0 ? 1 / (Float) range.scale : (Float) 0;
+
+            /* Samples outside of the height field replicate the border */
+            uint16_t *target = qdata + ((size_t) tile << (2*MTS_HFIELD_TILE_SHIFT));
+            for (int y=0; y<MTS_HFIELD_TILE_SIZE; ++y) {
+                int py = std::min(y0 + y, m_dataSize.y - 1);
+                for (int x=0; x<MTS_HFIELD_TILE_SIZE; ++x) {
+                    int px = std::min(x0 + x, m_dataSize.x - 1);
+                    Float value = (m_data[py * m_dataSize.x + px] - range.base) * invScale;
+                    *target++ = (uint16_t) math::clamp((int) (value + (Float) 0.5f), 0, 0xFFFF);
+                }
+            }
+        }
+
+        freeAligned(m_data);
+        m_data = NULL;
+
+        /* Global height range that contains all dequantized samples */
+        Float zmin = std::numeric_limits<Float>::infinity(),
+              zmax = -std::numeric_limits<Float>::infinity();
+        for (int tile=0; tile<tileCount; ++tile) {
+            zmin = std::min(zmin, (Float) tileRange[tile].base);
+            zmax = std::max(zmax, tileRange[tile].base + tileRange[tile].scale * (Float) 0xFFFF);
+        }
+        m_zmin = (float) zmin;
+        m_zscale = (float) ((zmax - zmin) / (0xFFFF - 1));
+        if (!(m_zscale > 0))
+            m_zscale = 1.0f;
+
+        /* Estimate the total surface area (this is approximate) */
+        double surfaceArea = 0;
+        #if defined(MTS_OPENMP)
+            #pragma omp parallel for reduction(+:surfaceArea)
+        #endif
+        for (int y=0; y<m_levelSize[0].y; ++y) {
+            for (int x=0; x<m_levelSize[0].x; ++x) {
+                Float diff0 = getHeight(x, y+1) - getHeight(x+1, y),
+                      diff1 = getHeight(x, y)   - getHeight(x+1, y+1);
+                surfaceArea += std::sqrt(1.0f + .5f * (diff0*diff0 + diff1*diff1));
+            }
+        }
+        m_surfaceArea = (Float) surfaceArea;
+
+        /* Build the first level from the dequantized patches and
+           propagate the bounds upwards to the other levels */
+        for (int level=1; level<m_levelCount; ++level) {
+            const Vector2i &cur = m_levelSize[level], &numChildren = m_numChildren[level];
+            QuantizedInterval *curBounds = const_cast<QuantizedInterval *>(m_qminmax[level]);
+
+            #if defined(MTS_OPENMP)
+                #pragma omp parallel for
+            #endif
+            for (int y=0; y<cur.y; ++y) {
+                for (int x=0; x<cur.x; ++x) {
+                    QuantizedInterval result;
+                    if (level == 1) {
+                        Interval combined = getBounds(0, x * numChildren.x, y * numChildren.y);
+                        for (int i=0; i<numChildren.y; ++i)
+                            for (int j=0; j<numChildren.x; ++j)
+                                combined.expandBy(getBounds(0, x * numChildren.x + j, y * numChildren.y + i));
+                        result = quantizeBounds(combined.min, combined.max);
+                    } else {
+                        const Vector2i &prev = m_levelSize[level-1];
+                        const QuantizedInterval *prevBounds = m_qminmax[level-1];
+                        result = prevBounds[y * numChildren.y * prev.x + x * numChildren.x];
+                        for (int i=0; i<numChildren.y; ++i) {
+                            for (int j=0; j<numChildren.x; ++j) {
+                                const QuantizedInterval &child = prevBounds[
+                                    (y * numChildren.y + i) * prev.x + x * numChildren.x + j];
+                                result.min = std::min(result.min, child.min);
+                                result.max = std::max(result.max, child.max);
+                            }
+                        }
+                    }
+                    curBounds[y * cur.x + x] = result;
+                }
+            }
+        }
+
+        /* Finally, write the header (this also marks cache files as complete) */
+        HeightfieldCacheHeader &header = *((HeightfieldCacheHeader *) base);
+        memset(&header, 0, sizeof(HeightfieldCacheHeader));
+        header.width = m_dataSize.x;
+        header.height = m_dataSize.y;
+        header.timestamp = timestamp;
+        header.scale = (float) m_scale;
+        header.zmin = m_zmin;
+        header.zscale = m_zscale;
+        header.surfaceArea = (float) m_surfaceArea;
+        header.filterHash = getFilterHash();
+        header.version = MTS_HFIELD_CACHE_VERSION;
+        header.identifier[0] = 'H';
+        header.identifier[1] = 'F';
+        header.identifier[2] = 'C';
+
+        if (!tempFile.empty())
+            finalizeCache(tempFile, cacheFile, timestamp, storageSize, offsets);
+    }
+
+    /**
+     * \brief Move a completely written cache file into place and map it
+     * again. If this fails, the data is copied into memory instead.
+     */
+    void finalizeCache(const fs::path &tempFile, const fs::path &cacheFile,
+            uint64_t timestamp, size_t storageSize, const std::vector<size_t> &offsets) {
+        /* Unmap the file first (renaming mapped files fails on Windows) */
+        m_mmap = NULL;
+
+        boost::system::error_code ec;
+        fs::rename(tempFile, cacheFile, ec);
+        if (!ec.value() && loadCache(cacheFile, timestamp))
+            return;
+
+        const fs::path &source = ec.value() ? tempFile : cacheFile;
+        if (ec.value())
+            Log(EWarn, "Unable to move the height field cache file into place: %s",
+                ec.message().c_str());
+
+        ref<MemoryMappedFile> mmap = new MemoryMappedFile(source);
+        m_storage = (uint8_t *) allocAligned(storageSize);
+        memcpy(m_storage, mmap->getData(), storageSize);
+        m_memoryUsage = storageSize;
+        heightfieldMemory.allocate(m_memoryUsage);
+        setStorage(m_storage, offsets);
+        mmap = NULL;
+        fs::remove(source, ec);
     }
 
     ref<TriMesh> createTriMesh() {
@@ -693,7 +1303,7 @@ public:
                 int px = std::min((int) (scaleX * x), m_dataSize.x-1);
                 texcoords[vertexIdx] = Point2(x*dx, y*dy);
                 vertices[vertexIdx++] = m_objectToWorld(Point((Float) px, (Float) py,
-                    m_data[px + py*m_dataSize.x]));
+                    getHeight(px, py)));
             }
         }
         Assert(vertexIdx == numVertices);
@@ -730,6 +1340,7 @@ public:
             << "  size = " << m_dataSize.toString() << "," << endl
             << "  shadingNormals = " << m_shadingNormals << "," << endl
             << "  flipNormals = " << m_flipNormals << "," << endl
+            << "  quantize = " << m_quantize << "," << endl
             << "  objectToWorld = " << indent(m_objectToWorld.toString()) << "," << endl
             << "  aabb = " << indent(getAABB().toString()) << "," << endl
             << "  bsdf = " << indent(m_bsdf.toString()) << "," << endl;
@@ -754,6 +1365,8 @@ private:
     bool m_flipNormals;
     Float m_scale;
     fs::path m_filename;
+    bool m_quantize;
+    bool m_cache, m_autoCache;
 
     /* Height field data */
     Float *m_data;
@@ -761,6 +1374,16 @@ private:
     Vector2i m_dataSize;
     Vector2 m_invSize;
     Float m_surfaceArea;
+    size_t m_memoryUsage;
+
+    /* Quantized height field data (tile-major, possibly memory-mapped) */
+    Vector2i m_tileCount;
+    const TileRange *m_tileRange;
+    const uint16_t *m_qdata;
+    const QuantizedInterval **m_qminmax;
+    float m_zmin, m_zscale;
+    uint8_t *m_storage;
+    ref<MemoryMappedFile> m_mmap;
 
     /* Min-max quadtree data */
     int m_levelCount;
@@ -17,6 +17,9 @@
 */
 
 #include "instance.h"
+#if defined(MTS_HAS_COHERENT_RT)
+#include <mitsuba/core/ray_sse.h>
+#endif
 
 MTS_NAMESPACE_BEGIN
 
@@ -29,6 +32,14 @@ MTS_NAMESPACE_BEGIN
  *        Specifies an optional linear instance-to-world transformation.
  *        \default{none (i.e. instance space $=$ world space)}
  *     }
+ *     \parameter{timeBuckets}{\Integer}{
+ *        When the transformation is animated, pre-evaluate it at this
+ *        many uniformly spaced times over the animation and snap the time
+ *        of each ray to the nearest one. This avoids evaluating the
+ *        animation for every ray at the cost of a piecewise constant
+ *        approximation of the motion.
+ *        \default{\code{0}, i.e. evaluate the animation exactly}
+ *     }
  * }
  * \renderings{
  *    \rendering{Surface viewed from the top}{shape_instance_fractal_top}
@@ -56,23 +67,50 @@ MTS_NAMESPACE_BEGIN
 
 Instance::Instance(const Properties &props) : Shape(props) {
     m_transform = props.getAnimatedTransform("toWorld", Transform());
+    m_timeBuckets = props.getInteger("timeBuckets", 0);
+    if (m_timeBuckets < 0)
+        Log(EError, "The 'timeBuckets' parameter must be nonnegative!");
 }
 
 Instance::Instance(Stream *stream, InstanceManager *manager)
     : Shape(stream, manager) {
     m_shapeGroup = static_cast<ShapeGroup *>(manager->getInstance(stream));
     m_transform = new AnimatedTransform(stream);
+    m_timeBuckets = stream->readInt();
+    configure();
 }
 
 void Instance::serialize(Stream *stream, InstanceManager *manager) const {
     Shape::serialize(stream, manager);
     manager->serialize(stream, m_shapeGroup.get());
     m_transform->serialize(stream);
+    stream->writeInt(m_timeBuckets);
 }
 
 void Instance::configure() {
     if (!m_shapeGroup)
         Log(EError, "A reference to a 'shapegroup' must be specified!");
+
+    /* Precompute the matrices that are needed to move rays and
+       intersection records between world and instance space */
+    m_static = m_transform->isStatic();
+    m_buckets.clear();
+    m_timeMin = m_timeScale = 0;
+
+    if (m_static) {
+        m_staticTransform.set(m_transform->eval(0));
+    } else if (m_timeBuckets > 0) {
+        AABB1 bounds = m_transform->getTimeBounds();
+        Float timeMin = bounds.min.x, extents = bounds.max.x - bounds.min.x;
+        int count = extents > 0 ? std::max(m_timeBuckets, 2) : 1;
+
+        m_timeMin = timeMin;
+        m_timeScale = count > 1 ? (count - 1) / extents : 0;
+        m_buckets.resize(count);
+        for (int i=0; i<count; ++i)
+            m_buckets[i].set(m_transform->eval(count > 1
+                ? (timeMin + extents * i / (count - 1)) : timeMin));
+    }
 }
 
 AABB Instance::getAABB() const {
@@ -115,30 +153,116 @@ size_t Instance::getEffectivePrimitiveCount() const {
 bool Instance::rayIntersect(const Ray &_ray, Float mint,
         Float maxt, Float &t, void *temp) const {
     const ShapeKDTree *kdtree = m_shapeGroup->getKDTree();
-    const Transform &trafo = m_transform->eval(_ray.time);
+    InstanceTransform trafo;
     Ray ray;
-    trafo.inverse()(_ray, ray);
+    getTransform(_ray.time, trafo).toObject(_ray, ray);
     return kdtree->rayIntersect(ray, mint, maxt, t, temp);
 }
 
 bool Instance::rayIntersect(const Ray &_ray, Float mint, Float maxt) const {
     const ShapeKDTree *kdtree = m_shapeGroup->getKDTree();
+    InstanceTransform trafo;
     Ray ray;
-    const Transform &trafo = m_transform->eval(_ray.time);
-    trafo.inverse()(_ray, ray);
+    getTransform(_ray.time, trafo).toObject(_ray, ray);
     return kdtree->rayIntersect(ray, mint, maxt);
 }
 
+#if defined(MTS_HAS_COHERENT_RT)
+int Instance::rayIntersectPacket(const RayPacket4 &packet, const Float *mint,
+        const Float *maxt, int masked, Float *t, void * const *temp) const {
+    /* Packets don't carry a time value -- fall back to
+       the default implementation for animated instances */
+    if (!m_static)
+        return Shape::rayIntersectPacket(packet, mint, maxt, masked, t, temp);
+
+    /* Transform all four rays into instance space at once */
+    const AffineMatrix3x4 &m = m_staticTransform.toObject;
+    RayPacket4 MM_ALIGN16 local;
+    bool coherent = true;
+
+    for (int i=0; i<3; ++i) {
+        const __m128
+            m0 = _mm_set1_ps(m.m[i][0]), m1 = _mm_set1_ps(m.m[i][1]),
+            m2 = _mm_set1_ps(m.m[i][2]), m3 = _mm_set1_ps(m.m[i][3]);
+
+        local.o[i].ps = _mm_add_ps(
+            _mm_add_ps(_mm_mul_ps(m0, packet.o[0].ps), _mm_mul_ps(m1, packet.o[1].ps)),
+            _mm_add_ps(_mm_mul_ps(m2, packet.o[2].ps), m3));
+        local.d[i].ps = _mm_add_ps(
+            _mm_add_ps(_mm_mul_ps(m0, packet.d[0].ps), _mm_mul_ps(m1, packet.d[1].ps)),
+            _mm_mul_ps(m2, packet.d[2].ps));
+        local.dRcp[i].ps = _mm_div_ps(SSEConstants::one.ps, local.d[i].ps);
+    }
+
+    for (int axis=0; axis<3; ++axis) {
+        int signs = _mm_movemask_ps(_mm_cmplt_ps(local.d[axis].ps, SSEConstants::zero.ps));
+        for (int i=0; i<4; ++i)
+            local.signs[axis][i] = (signs >> i) & 1;
+        if (signs != 0 && signs != 0xF)
+            coherent = false;
+    }
+
+    RayInterval4 MM_ALIGN16 interval;
+    for (int i=0; i<4; ++i) {
+        interval.mint.f[i] = mint[i];
+        interval.maxt.f[i] = (masked & (1 << i))
+            ? -std::numeric_limits<Float>::infinity() : maxt[i];
+    }
+
+    /* Trace the packet through the kd-tree of the shape group */
+    const ShapeKDTree *kdtree = m_shapeGroup->getKDTree();
+    Intersection4 MM_ALIGN16 its;
+    uint8_t MM_ALIGN16 nestedTemp[4 * MTS_KD_INTERSECTION_TEMP];
+
+    if (coherent)
+        kdtree->rayIntersectPacket(local, interval, its, nestedTemp);
+    else
+        kdtree->rayIntersectPacketIncoherent(local, interval, its, nestedTemp);
+
+    /* Store the results in the same form as \ref rayIntersect() */
+    const size_t offset = 2 * sizeof(ShapeKDTree::IndexType);
+    int hit = 0;
+    for (int i=0; i<4; ++i) {
+        if ((masked & (1 << i)) || its.t.f[i] == std::numeric_limits<Float>::infinity())
+            continue;
+
+        ShapeKDTree::IntersectionCache *cache =
+            static_cast<ShapeKDTree::IntersectionCache *>(temp[i]);
+
+        if ((uint32_t) its.primIndex.i[i] == KNoTriangleFlag) {
+            /* Copy the temporary data of a nested non-triangle shape */
+            memcpy(static_cast<uint8_t *>(temp[i]) + offset,
+                nestedTemp + i * MTS_KD_INTERSECTION_TEMP + offset,
+                MTS_KD_INTERSECTION_TEMP - 2 * offset);
+        } else {
+            cache->u = its.u.f[i];
+            cache->v = its.v.f[i];
+        }
+        cache->shapeIndex = its.shapeIndex.i[i];
+        cache->primIndex = its.primIndex.i[i];
+        t[i] = its.t.f[i];
+        hit |= 1 << i;
+    }
+
+    return hit;
+}
+#endif
+
 void Instance::adjustTime(Intersection &its, Float time) const {
-    Transform trafo = m_transform->eval(its.time).inverse();
-    trafo = m_transform->eval(time) * trafo;
-
-    its.dpdu = trafo(its.dpdu);
-    its.dpdv = trafo(its.dpdv);
-    its.geoFrame = Frame(normalize(trafo(its.geoFrame.n)));
-    its.p = trafo(its.p);
-    computeShadingFrame(normalize(trafo(its.shFrame.n)), its.dpdu, its.shFrame);
-    its.wi = normalize(trafo(its.wi));
+    InstanceTransform tmp0, tmp1;
+    const InstanceTransform
+        &from = getTransform(its.time, tmp0),
+        &to   = getTransform(time, tmp1);
+
+    /* Normals are transformed by the inverse transpose of each matrix */
+    its.dpdu = to.toWorld(from.toObject(its.dpdu));
+    its.dpdv = to.toWorld(from.toObject(its.dpdv));
+    its.geoFrame = Frame(normalize(to.toObject.transformTransposed(
+        from.toWorld.transformTransposed(its.geoFrame.n))));
+    its.p = to.toWorld(from.toObject(its.p));
+    computeShadingFrame(normalize(to.toObject.transformTransposed(
+        from.toWorld.transformTransposed(its.shFrame.n))), its.dpdu, its.shFrame);
+    its.wi = normalize(to.toWorld(from.toObject(its.wi)));
     its.instance = this;
     its.time = time;
 }
@@ -146,41 +270,43 @@ void Instance::adjustTime(Intersection &its, Float time) const {
 void Instance::fillIntersectionRecord(const Ray &_ray,
     const void *temp, Intersection &its) const {
     const ShapeKDTree *kdtree = m_shapeGroup->getKDTree();
-    const Transform &trafo = m_transform->eval(_ray.time);
+    InstanceTransform tmp;
+    const InstanceTransform &trafo = getTransform(_ray.time, tmp);
     Ray ray;
-    trafo.inverse()(_ray, ray);
+    trafo.toObject(_ray, ray);
     kdtree->fillIntersectionRecord<false>(ray, temp, its);
 
-    its.shFrame.n = normalize(trafo(its.shFrame.n));
-    its.geoFrame = Frame(normalize(trafo(its.geoFrame.n)));
-    its.dpdu = trafo(its.dpdu);
-    its.dpdv = trafo(its.dpdv);
-    its.p = trafo(its.p);
+    its.shFrame.n = normalize(trafo.toObject.transformTransposed(its.shFrame.n));
+    its.geoFrame = Frame(normalize(trafo.toObject.transformTransposed(its.geoFrame.n)));
+    its.dpdu = trafo.toWorld(its.dpdu);
+    its.dpdv = trafo.toWorld(its.dpdv);
+    its.p = trafo.toWorld(its.p);
     its.instance = this;
 }
 
 void Instance::getNormalDerivative(const Intersection &its,
         Vector &dndu, Vector &dndv, bool shadingFrame) const {
-    const Transform &trafo = m_transform->eval(its.time);
-    const Transform invTrafo = trafo.inverse();
+    InstanceTransform tmp;
+    const InstanceTransform &trafo = getTransform(its.time, tmp);
 
     /* The following is really super-inefficient, but it's
        needed to be able to deal with general transformations */
     Intersection temp(its);
-    temp.p = invTrafo(its.p);
-    temp.dpdu = invTrafo(its.dpdu);
-    temp.dpdv = invTrafo(its.dpdv);
+    temp.p = trafo.toObject(its.p);
+    temp.dpdu = trafo.toObject(its.dpdu);
+    temp.dpdv = trafo.toObject(its.dpdv);
 
     /* Determine the length of the transformed normal
        *before* it was re-normalized */
-    Normal tn = trafo(normalize(invTrafo(its.shFrame.n)));
+    Normal tn = trafo.toObject.transformTransposed(
+        normalize(trafo.toWorld.transformTransposed(its.shFrame.n)));
     Float invLen = 1 / tn.length();
     tn *= invLen;
 
     its.shape->getNormalDerivative(temp, dndu, dndv, shadingFrame);
 
-    dndu = trafo(Normal(dndu)) * invLen;
-    dndv = trafo(Normal(dndv)) * invLen;
+    dndu = trafo.toObject.transformTransposed(Normal(dndu)) * invLen;
+    dndv = trafo.toObject.transformTransposed(Normal(dndv)) * invLen;
 
     dndu -= tn * dot(tn, dndu);
     dndv -= tn * dot(tn, dndv);
@@ -20,6 +20,80 @@
 
 MTS_NAMESPACE_BEGIN
 
+/**
+ * \brief Compact affine 3x4 matrix (the last row is implicitly
+ * <tt>[0, 0, 0, 1]</tt>) used to quickly move rays and intersection
+ * records between world and instance space
+ */
+struct AffineMatrix3x4 {
+    Float m[3][4];
+
+    /// Initialize with the upper 3x4 part of a 4x4 matrix
+    inline void set(const Matrix4x4 &mat) {
+        for (int i=0; i<3; ++i)
+            for (int j=0; j<4; ++j)
+                m[i][j] = mat.m[i][j];
+    }
+
+    /// Transform a point
+    inline Point operator()(const Point &p) const {
+        return Point(
+            m[0][0] * p.x + m[0][1] * p.y + m[0][2] * p.z + m[0][3],
+            m[1][0] * p.x + m[1][1] * p.y + m[1][2] * p.z + m[1][3],
+            m[2][0] * p.x + m[2][1] * p.y + m[2][2] * p.z + m[2][3]);
+    }
+
+    /// Transform a vector
+    inline Vector operator()(const Vector &v) const {
+        return Vector(
+            m[0][0] * v.x + m[0][1] * v.y + m[0][2] * v.z,
+            m[1][0] * v.x + m[1][1] * v.y + m[1][2] * v.z,
+            m[2][0] * v.x + m[2][1] * v.y + m[2][2] * v.z);
+    }
+
+    /**
+     * \brief Transform a normal by the transpose of this matrix
+     *
+     * When applied to the world-to-instance matrix, this
+     * transforms normals from instance to world space
+     */
+    inline Normal transformTransposed(const Normal &n) const {
+        return Normal(
+            m[0][0] * n.x + m[1][0] * n.y + m[2][0] * n.z,
+            m[0][1] * n.x + m[1][1] * n.y + m[2][1] * n.z,
+            m[0][2] * n.x + m[1][2] * n.y + m[2][2] * n.z);
+    }
+
+    /// Transform a ray (no temporaries)
+    inline void operator()(const Ray &a, Ray &b) const {
+        b.o = operator()(a.o);
+        b.d = operator()(a.d);
+        b.mint = a.mint;
+        b.maxt = a.maxt;
+        b.time = a.time;
+#ifdef MTS_DEBUG_FP
+        bool state = disableFPExceptions();
+#endif
+        b.dRcp.x = 1.0f / b.d.x;
+        b.dRcp.y = 1.0f / b.d.y;
+        b.dRcp.z = 1.0f / b.d.z;
+#ifdef MTS_DEBUG_FP
+        restoreFPExceptions(state);
+#endif
+    }
+};
+
+/// Pair of instance-to-world and world-to-instance matrices
+struct InstanceTransform {
+    AffineMatrix3x4 toWorld;
+    AffineMatrix3x4 toObject;
+
+    inline void set(const Transform &trafo) {
+        toWorld.set(trafo.getMatrix());
+        toObject.set(trafo.getInverseMatrix());
+    }
+};
+
 /**
  * \brief Geometry instancing support (to be used in conjunction
  * with the \c shapegroup plugin)
@@ -77,13 +151,43 @@ public:
 
     void adjustTime(Intersection &its, Float time) const;
 
+#if defined(MTS_HAS_COHERENT_RT)
+    int rayIntersectPacket(const RayPacket4 &packet, const Float *mint,
+        const Float *maxt, int masked, Float *t, void * const *temp) const;
+#endif
+
     //! @}
     // =============================================================
 
     MTS_DECLARE_CLASS()
 private:
+    /**
+     * \brief Return the instance transformation at the given time
+     *
+     * Static transformations and time buckets are precomputed; other
+     * animated transformations are evaluated into \c temp.
+     */
+    inline const InstanceTransform &getTransform(Float time, InstanceTransform &temp) const {
+        if (EXPECT_TAKEN(m_static))
+            return m_staticTransform;
+
+        if (!m_buckets.empty()) {
+            int idx = math::clamp(math::roundToInt((time - m_timeMin) * m_timeScale),
+                0, (int) m_buckets.size() - 1);
+            return m_buckets[idx];
+        }
+
+        temp.set(m_transform->eval(time));
+        return temp;
+    }
+
     ref<ShapeGroup> m_shapeGroup;
     ref<const AnimatedTransform> m_transform;
+    InstanceTransform m_staticTransform;
+    std::vector<InstanceTransform> m_buckets;
+    Float m_timeMin, m_timeScale;
+    int m_timeBuckets;
+    bool m_static;
 };
 
 MTS_NAMESPACE_END
@@ -163,6 +163,7 @@ public:
         its.uv = Point2(0.5f * (data[0]+1), 0.5f * (data[1]+1));
         its.p = ray(its.t);
         its.hasUVPartials = false;
+        its.uvFootprint = 0.0f;
         its.instance = NULL;
         its.time = ray.time;
     }
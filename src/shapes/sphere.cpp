@@ -250,6 +250,7 @@ public:
 
         its.shFrame.n = its.geoFrame.n;
         its.hasUVPartials = false;
+        its.uvFootprint = 0.0f;
         its.instance = NULL;
         its.time = ray.time;
     }
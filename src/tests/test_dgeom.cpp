@@ -30,6 +30,9 @@ public:
     MTS_DECLARE_TEST(test03_trimesh_3);
     MTS_DECLARE_TEST(test04_sphere);
     MTS_DECLARE_TEST(test05_cylinder);
+    MTS_DECLARE_TEST(test06_trimesh_curvature);
+    MTS_DECLARE_TEST(test07_ray_cone_footprint);
+    MTS_DECLARE_TEST(test08_footprint_reset);
     MTS_END_TESTCASE()
 
     void test01_trimesh_1() {
@@ -265,6 +268,114 @@ public:
         assertEqualsEpsilon(K, 0.0f, Epsilon);
         assertEqualsEpsilon(H, -1.0f / (2*radius), Epsilon);
     }
+
+    void test06_trimesh_curvature() {
+        Properties props("sphere");
+        Float radius = 2.0f;
+        props.setFloat("radius", radius);
+        ref<Shape> sphere = static_cast<Shape *>(PluginManager::getInstance()->createObject(props));
+        sphere->configure();
+
+        ref<TriMesh> trimesh = sphere->createTriMesh();
+        trimesh->computeCurvature();
+        assertTrue(trimesh->hasVertexCurvatures());
+
+        /* Precomputed values at the vertices */
+        const Vector2 *curvatures = trimesh->getVertexCurvatures();
+        for (size_t i=0; i<trimesh->getVertexCount(); ++i) {
+            assertEqualsEpsilon(curvatures[i].x, -1.0f / radius, 1e-2f);
+            assertEqualsEpsilon(curvatures[i].y, 1.0f / (radius*radius), 1e-2f);
+        }
+
+        ref<ShapeKDTree> kdtree = new ShapeKDTree();
+        kdtree->addShape(trimesh);
+        kdtree->build();
+
+        Ray ray(Point(3, 3, 3), normalize(Vector(-1, -1, -1)), 0.0f);
+        Intersection its;
+        assertTrue(kdtree->rayIntersect(ray, its));
+
+        /* Interpolated values vs. evaluation from the shading normals */
+        Float H, K, Href, Kref;
+        trimesh->lookupCurvature(its, H, K);
+        its.shape->getCurvature(its, Href, Kref);
+        assertEqualsEpsilon(H, Href, 1e-2f);
+        assertEqualsEpsilon(K, Kref, 1e-2f);
+    }
+
+    void test07_ray_cone_footprint() {
+        /* One unit in UV space corresponds to two units on the surface */
+        ref<TriMesh> trimesh = new TriMesh("", 1, 3, false, true);
+        Triangle &tri = trimesh->getTriangles()[0];
+        tri.idx[0] = 0; tri.idx[1] = 1; tri.idx[2] = 2;
+        Point *vertices = trimesh->getVertexPositions();
+        Point2 *uv = trimesh->getVertexTexcoords();
+        vertices[0] = Point(0, 0, 0);
+        vertices[1] = Point(2, 0, 0);
+        vertices[2] = Point(0, 2, 0);
+        uv[0] = Point2(0, 0);
+        uv[1] = Point2(1, 0);
+        uv[2] = Point2(0, 1);
+        trimesh->configure();
+
+        ref<ShapeKDTree> kdtree = new ShapeKDTree();
+        kdtree->addShape(trimesh);
+        kdtree->build();
+
+        /* Perpendicular incidence at distance 5: the cone is 0.02 units
+           wide, which covers 0.01 units in UV space */
+        RayCone cone(0.01f, 0.002f);
+        Ray ray(Point(0.2f, 0.3f, -5.0f), Vector(0, 0, 1), 0.0f);
+        Intersection its;
+        assertTrue(kdtree->rayIntersect(ray, its));
+        assertEqualsEpsilon(its.t, 5.0f, Epsilon);
+        its.computeFootprint(cone);
+        assertEqualsEpsilon(its.uvFootprint, 0.01f, 1e-5f);
+
+        /* At 60 degrees, the footprint is stretched by 1/cos(theta) = 2 */
+        ray = Ray(Point(0.2f, 0.3f - 5 * std::sqrt((Float) 3), -5.0f),
+            normalize(Vector(0, std::sqrt((Float) 3), 1)), 0.0f);
+        assertTrue(kdtree->rayIntersect(ray, its));
+        assertEqualsEpsilon(its.t, 10.0f, 1e-4f);
+        its.computeFootprint(cone);
+        assertEqualsEpsilon(its.uvFootprint,
+            cone.getWidth(its.t) / std::sqrt((Float) 2), 1e-5f);
+
+        /* A degenerate cone has no footprint */
+        its.computeFootprint(RayCone());
+        assertEquals(its.uvFootprint, 0.0f);
+    }
+
+    void test08_footprint_reset() {
+        /* A footprint computed at a previous vertex must not leak into the
+           intersection record of the next one (non-triangle shape) */
+        Properties props("sphere");
+        props.setFloat("radius", 2.0f);
+        ref<Shape> sphere = static_cast<Shape *>(PluginManager::getInstance()->createObject(props));
+        sphere->configure();
+
+        ref<ShapeKDTree> kdtree = new ShapeKDTree();
+        kdtree->addShape(sphere);
+        kdtree->build();
+
+        Ray ray(Point(0.0f, 0.0f, -5.0f), Vector(0, 0, 1), 0.0f);
+        Intersection its;
+        assertTrue(kdtree->rayIntersect(ray, its));
+        its.computeFootprint(RayCone(0.01f, 0.002f));
+        assertTrue(its.uvFootprint > 0);
+
+        assertTrue(kdtree->rayIntersect(ray, its));
+        assertEquals(its.uvFootprint, 0.0f);
+
+        /* The same must hold when the shape fills in the record directly */
+        uint8_t temp[MTS_KD_INTERSECTION_TEMP];
+        Float t;
+        its.uvFootprint = 1.0f;
+        assertTrue(sphere->rayIntersect(ray, ray.mint, ray.maxt, t, temp));
+        its.t = t;
+        sphere->fillIntersectionRecord(ray, temp, its);
+        assertEquals(its.uvFootprint, 0.0f);
+    }
 };
 
 MTS_EXPORT_TESTCASE(TestDGeom, "Differential geometry testcase")
@@ -0,0 +1,177 @@
+/*
+    This file is part of Mitsuba, a physically based rendering system.
+
+    Copyright (c) 2007-2014 by Wenzel Jakob and others.
+
+    Mitsuba is free software; you can redistribute it and/or modify
+    it under the terms of the GNU General Public License Version 3
+    as published by the Free Software Foundation.
+
+    Mitsuba is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program. If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include <mitsuba/core/plugin.h>
+#include <mitsuba/core/fstream.h>
+#include <mitsuba/render/testcase.h>
+#include <mitsuba/render/skdtree.h>
+#include <boost/filesystem/fstream.hpp>
+#include <iomanip>
+
+MTS_NAMESPACE_BEGIN
+
+class TestHair : public TestCase {
+public:
+    MTS_BEGIN_TESTCASE()
+    MTS_DECLARE_TEST(test01_formats)
+    MTS_DECLARE_TEST(test02_cache)
+    MTS_END_TESTCASE()
+
+    typedef std::vector<std::vector<Point3f> > StrandList;
+
+    /// Generate a set of curly strands
+    void generateStrands(StrandList &strands) {
+        ref<Random> random = new Random();
+        strands.resize(50);
+        for (size_t i=0; i<strands.size(); ++i) {
+            Point3f base(random->nextFloat() * 10, random->nextFloat() * 10, 0.0f);
+            for (int j=0; j<20; ++j)
+                strands[i].push_back(base + Vector3f(
+                    std::cos(j * 0.5f), std::sin(j * 0.5f), j * 0.2f));
+        }
+    }
+
+    void writeASCII(const fs::path &path, const StrandList &strands) {
+        fs::ofstream os(path);
+        os << std::setprecision(9); /* Round-trip exactly */
+        for (size_t i=0; i<strands.size(); ++i) {
+            for (size_t j=0; j<strands[i].size(); ++j)
+                os << strands[i][j].x << " " << strands[i][j].y << " " << strands[i][j].z << endl;
+            os << endl;
+        }
+    }
+
+    void writeBinary(const fs::path &path, const StrandList &strands) {
+        ref<FileStream> fs = new FileStream(path, FileStream::ETruncReadWrite);
+        fs->setByteOrder(Stream::ELittleEndian);
+        fs->write("BINARY_HAIR", 11);
+
+        size_t vertexCount = 0;
+        for (size_t i=0; i<strands.size(); ++i)
+            vertexCount += strands[i].size();
+        fs->writeUInt((uint32_t) vertexCount);
+
+        for (size_t i=0; i<strands.size(); ++i) {
+            if (i > 0)
+                fs->writeSingle(std::numeric_limits<float>::infinity());
+            fs->writeSingleArray(&strands[i][0].x, strands[i].size() * 3);
+        }
+    }
+
+    void writeCompact(const fs::path &path, const StrandList &strands) {
+        ref<FileStream> fs = new FileStream(path, FileStream::ETruncReadWrite);
+        fs->setByteOrder(Stream::getHostByteOrder());
+        fs->write("COMPACT_HAIR", 12);
+        fs->writeUInt(1);
+        fs->writeULong(0);
+
+        size_t vertexCount = 0;
+        for (size_t i=0; i<strands.size(); ++i)
+            vertexCount += strands[i].size();
+        fs->writeUInt((uint32_t) strands.size());
+        fs->writeUInt((uint32_t) vertexCount);
+
+        vertexCount = 0;
+        for (size_t i=0; i<strands.size(); ++i) {
+            fs->writeUInt((uint32_t) vertexCount);
+            vertexCount += strands[i].size();
+        }
+        fs->writeUInt((uint32_t) vertexCount);
+
+        for (size_t i=0; i<strands.size(); ++i)
+            fs->writeSingleArray(&strands[i][0].x, strands[i].size() * 3);
+    }
+
+    ref<Shape> loadHair(const fs::path &path, bool cache) {
+        Properties props("hair");
+        props.setString("filename", path.string());
+        props.setBoolean("cache", cache);
+        ref<Shape> shape = static_cast<Shape *> (PluginManager::getInstance()->
+                createObject(MTS_CLASS(Shape), props));
+        shape->configure();
+        return shape;
+    }
+
+    /// Check that two hair shapes contain the same geometry
+    void compare(const Shape *shape1, const Shape *shape2) {
+        assertEquals((int) shape1->getPrimitiveCount(), (int) shape2->getPrimitiveCount());
+        AABB aabb1 = shape1->getAABB(), aabb2 = shape2->getAABB();
+        assertEquals(aabb1.min, aabb2.min);
+        assertEquals(aabb1.max, aabb2.max);
+
+        ref<Random> random = new Random();
+        uint8_t temp[MTS_KD_INTERSECTION_TEMP];
+        for (int i=0; i<1000; ++i) {
+            Point o = aabb1.getCenter() + Vector(0, 0, 20.0f);
+            Point target(
+                aabb1.min.x + random->nextFloat() * (aabb1.max.x - aabb1.min.x),
+                aabb1.min.y + random->nextFloat() * (aabb1.max.y - aabb1.min.y),
+                aabb1.min.z + random->nextFloat() * (aabb1.max.z - aabb1.min.z));
+            Ray ray(o, normalize(target - o), 0.0f);
+
+            Float t1 = 0, t2 = 0;
+            bool hit1 = shape1->rayIntersect(ray, 0, std::numeric_limits<Float>::infinity(), t1, temp);
+            bool hit2 = shape2->rayIntersect(ray, 0, std::numeric_limits<Float>::infinity(), t2, temp);
+            assertTrue(hit1 == hit2);
+            if (hit1)
+                assertEquals(t1, t2);
+        }
+    }
+
+    void test01_formats() {
+        fs::path dir = fs::temp_directory_path() / fs::unique_path("mitsuba-hair-%%%%%%%%");
+        fs::create_directories(dir);
+
+        StrandList strands;
+        generateStrands(strands);
+        writeASCII(dir / "hair.txt", strands);
+        writeBinary(dir / "hair.bin", strands);
+        writeCompact(dir / "hair.hairc", strands);
+
+        ref<Shape> ascii = loadHair(dir / "hair.txt", false),
+                   binary = loadHair(dir / "hair.bin", false),
+                   compact = loadHair(dir / "hair.hairc", false);
+
+        assertEquals((int) ascii->getPrimitiveCount(), (int) strands.size());
+        compare(ascii, binary);
+        compare(ascii, compact);
+
+        fs::remove_all(dir);
+    }
+
+    void test02_cache() {
+        fs::path dir = fs::temp_directory_path() / fs::unique_path("mitsuba-hair-%%%%%%%%");
+        fs::create_directories(dir);
+
+        StrandList strands;
+        generateStrands(strands);
+        writeASCII(dir / "hair.txt", strands);
+
+        /* The first run creates the cache, the second one maps it */
+        ref<Shape> parsed = loadHair(dir / "hair.txt", true);
+        assertTrue(fs::exists(dir / "hair.hairc"));
+        ref<Shape> mapped = loadHair(dir / "hair.txt", true);
+        compare(parsed, mapped);
+
+        fs::remove_all(dir);
+    }
+};
+
+MTS_EXPORT_TESTCASE(TestHair, "Testcase for loading hair geometry")
+
+MTS_NAMESPACE_END
@@ -0,0 +1,170 @@
+/*
+    This file is part of Mitsuba, a physically based rendering system.
+
+    Copyright (c) 2007-2014 by Wenzel Jakob and others.
+
+    Mitsuba is free software; you can redistribute it and/or modify
+    it under the terms of the GNU General Public License Version 3
+    as published by the Free Software Foundation.
+
+    Mitsuba is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program. If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include <mitsuba/core/plugin.h>
+#include <mitsuba/render/testcase.h>
+#include <mitsuba/render/medium.h>
+#include <mitsuba/render/scene.h>
+
+MTS_NAMESPACE_BEGIN
+
+class TestMedium : public TestCase {
+public:
+    MTS_BEGIN_TESTCASE()
+    MTS_DECLARE_TEST(test01_homogeneousTransmittance)
+    MTS_DECLARE_TEST(test02_homogeneousBatch)
+    MTS_DECLARE_TEST(test03_equiangularMIS)
+    MTS_END_TESTCASE()
+
+    ref<Medium> createHomogeneous(const Spectrum &sigmaA, const Spectrum &sigmaS) {
+        Properties props("homogeneous");
+        props.setSpectrum("sigmaA", sigmaA);
+        props.setSpectrum("sigmaS", sigmaS);
+        ref<Medium> medium = static_cast<Medium *> (PluginManager::getInstance()->
+                createObject(MTS_CLASS(Medium), props));
+        medium->configure();
+        return medium;
+    }
+
+    void test01_homogeneousTransmittance() {
+        Spectrum sigmaA, sigmaS;
+        for (int i=0; i<SPECTRUM_SAMPLES; ++i) {
+            sigmaA[i] = 0.1f * i;
+            sigmaS[i] = i == 0 ? 0.0f : 0.5f;
+        }
+
+        /* Spectrally varying medium with a non-extinguishing channel */
+        ref<Medium> medium = createHomogeneous(sigmaA, sigmaS);
+        Spectrum sigmaT = sigmaA + sigmaS;
+        const Float distances[] = { 0.0f, 0.01f, 1.0f, 10.0f, 100.0f };
+
+        for (int i=0; i<5; ++i) {
+            Ray ray(Point(0.0f), Vector(0, 0, 1), 0, distances[i], 0);
+            Spectrum expected = (sigmaT * (-distances[i])).exp();
+            assertEqualsEpsilon(medium->evalTransmittance(ray), expected, 1e-5f);
+
+            MediumSamplingRecord mRec;
+            medium->eval(ray, mRec);
+            assertEqualsEpsilon(mRec.transmittance, expected, 1e-5f);
+        }
+
+        Ray ray(Point(0.0f), Vector(0, 0, 1), 0, std::numeric_limits<Float>::infinity(), 0);
+        assertEquals(medium->evalTransmittance(ray)[0], (Float) 1.0f);
+    }
+
+    void test02_homogeneousBatch() {
+        const size_t count = 103;
+        ref<Random> random = new Random();
+        std::vector<Ray> rays(count);
+        std::vector<Spectrum> result(count);
+
+        for (size_t i=0; i<count; ++i) {
+            Float mint = random->nextFloat(), maxt = mint + 5 * random->nextFloat();
+            rays[i] = Ray(Point(0.0f), Vector(1, 0, 0), mint, maxt, 0);
+        }
+
+        Spectrum sigmaS;
+        for (int i=0; i<SPECTRUM_SAMPLES; ++i)
+            sigmaS[i] = 0.2f + 0.1f * i;
+
+        /* Grey (e.g. haze) and spectrally varying media */
+        ref<Medium> media[] = {
+            createHomogeneous(Spectrum(0.05f), Spectrum(0.3f)),
+            createHomogeneous(Spectrum(0.05f), sigmaS)
+        };
+
+        for (int j=0; j<2; ++j) {
+            media[j]->evalTransmittanceBatch(&rays[0], count, &result[0]);
+            for (size_t i=0; i<count; ++i) {
+                Spectrum expected = (media[j]->getSigmaT()
+                    * (rays[i].mint - rays[i].maxt)).exp();
+                assertEqualsEpsilon(result[i], expected, 1e-5f);
+            }
+        }
+    }
+
+    ref<SamplingIntegrator> createVolPath(bool equiangular) {
+        Properties props("volpath");
+        props.setInteger("maxDepth", 2);
+        props.setBoolean("equiangular", equiangular);
+        props.setInteger("equiangularSamples", 2);
+        ref<SamplingIntegrator> integrator = static_cast<SamplingIntegrator *> (
+            PluginManager::getInstance()->createObject(MTS_CLASS(Integrator), props));
+        integrator->configure();
+        return integrator;
+    }
+
+    void test03_equiangularMIS() {
+        /* Single scattering from a point light in an unbounded medium */
+        const Float sigmaA = 0.1f, sigmaS = 0.5f, intensity = 10.0f, D = 1.0f;
+        ref<Medium> medium = createHomogeneous(Spectrum(sigmaA), Spectrum(sigmaS));
+
+        Properties emitterProps("point");
+        emitterProps.setPoint("position", Point(0, D, 1));
+        emitterProps.setSpectrum("intensity", Spectrum(intensity));
+        ref<Emitter> emitter = static_cast<Emitter *> (PluginManager::getInstance()->
+                createObject(MTS_CLASS(Emitter), emitterProps));
+        emitter->configure();
+
+        ref<Scene> scene = new Scene(Properties());
+        scene->addChild(emitter);
+        scene->addChild(createVolPath(false));
+        scene->configure();
+        scene->initialize();
+
+        /* Reference: with the equi-angular parameterization t = 1 + D tan(theta),
+           dt / r^2 = dtheta / D, and the remaining integrand is smooth */
+        const double sigmaT = sigmaA + sigmaS, thetaA = std::atan(-1.0 / D);
+        const int steps = 100000;
+        double integral = 0;
+        for (int i=0; i<steps; ++i) {
+            double theta = thetaA + (0.5 * M_PI - thetaA) * (i + 0.5) / steps,
+                   t = 1 + D * std::tan(theta), r = D / std::cos(theta);
+            integral += std::exp(-sigmaT * (t + r));
+        }
+        integral *= (0.5 * M_PI - thetaA) / steps;
+        Float reference = (Float) (sigmaS * intensity * integral * INV_FOURPI / D);
+
+        /* Distance sampling alone and combined with equi-angular sampling
+           must both converge to the reference */
+        ref<Sampler> sampler = static_cast<Sampler *> (PluginManager::getInstance()->
+                createObject(MTS_CLASS(Sampler), Properties("independent")));
+        sampler->configure();
+        RayDifferential ray(Point(0.0f), Vector(0, 0, 1), 0);
+        const size_t count = 100000;
+
+        for (int j=0; j<2; ++j) {
+            ref<SamplingIntegrator> integrator = createVolPath(j == 1);
+            double sum = 0;
+            for (size_t i=0; i<count; ++i) {
+                RadianceQueryRecord rRec(scene, sampler);
+                rRec.newQuery(RadianceQueryRecord::ERadiance, medium);
+                sum += integrator->Li(ray, rRec)[0];
+            }
+            Float estimate = (Float) (sum / count);
+            Log(EDebug, "Single scattering (%s): %f, reference: %f", j == 1
+                ? "distance + equi-angular sampling" : "distance sampling",
+                estimate, reference);
+            assertEqualsEpsilon(estimate, reference, 0.02f * reference);
+        }
+    }
+};
+
+MTS_EXPORT_TESTCASE(TestMedium, "Testcase for participating media")
+
+MTS_NAMESPACE_END
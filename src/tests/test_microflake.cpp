@@ -0,0 +1,69 @@
+/*
+    This file is part of Mitsuba, a physically based rendering system.
+
+    Copyright (c) 2007-2014 by Wenzel Jakob and others.
+
+    Mitsuba is free software; you can redistribute it and/or modify
+    it under the terms of the GNU General Public License Version 3
+    as published by the Free Software Foundation.
+
+    Mitsuba is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program. If not, see <http://www.gnu.org/licenses/>.
+*/
+
+
+#include <mitsuba/render/testcase.h>
+#include "../phase/microflake_fiber.h"
+
+MTS_NAMESPACE_BEGIN
+
+class TestMicroflake : public TestCase {
+public:
+    MTS_BEGIN_TESTCASE()
+    MTS_DECLARE_TEST(test01_sigmaT)
+    MTS_DECLARE_TEST(test02_sampleCosTheta)
+    MTS_DECLARE_TEST(test03_sharedTables)
+    MTS_END_TESTCASE()
+
+    void test01_sigmaT() {
+        const Float stddevs[] = { 0.005f, 0.02f, 0.1f, 0.5f, 2.0f };
+
+        for (int i=0; i<5; ++i) {
+            GaussianFiberDistribution distr(stddevs[i]);
+            for (int j=0; j<=1000; ++j) {
+                Float cosTheta = 2 * j / (Float) 1000 - 1;
+                assertEqualsEpsilon(distr.sigmaT(cosTheta),
+                    distr.sigmaTSeries(cosTheta), 1e-4f);
+            }
+        }
+    }
+
+    void test02_sampleCosTheta() {
+        const Float stddevs[] = { 0.005f, 0.02f, 0.1f, 0.5f, 2.0f };
+
+        for (int i=0; i<5; ++i) {
+            GaussianFiberDistribution distr(stddevs[i]);
+            for (int j=1; j<100; ++j) {
+                Float xi = j / (Float) 100,
+                      cosTheta = distr.sampleCosTheta(xi);
+                assertEqualsEpsilon(cosTheta, distr.sampleCosThetaBrent(xi), 1e-4f);
+                assertEqualsEpsilon(distr.cdf(cosTheta), xi, 1e-4f);
+            }
+        }
+    }
+
+    void test03_sharedTables() {
+        GaussianFiberDistribution a(0.1f), b(0.1f), c(0.2f);
+        assertTrue(a.getTable() == b.getTable());
+        assertTrue(a.getTable() != c.getTable());
+    }
+};
+
+MTS_EXPORT_TESTCASE(TestMicroflake, "Testcase for the tabulated micro-flake distribution")
+
+MTS_NAMESPACE_END
@@ -0,0 +1,100 @@
+/*
+    This file is part of Mitsuba, a physically based rendering system.
+
+    Copyright (c) 2007-2014 by Wenzel Jakob and others.
+
+    Mitsuba is free software; you can redistribute it and/or modify
+    it under the terms of the GNU General Public License Version 3
+    as published by the Free Software Foundation.
+
+    Mitsuba is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program. If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include <mitsuba/core/plugin.h>
+#include <mitsuba/core/random.h>
+#include <mitsuba/render/testcase.h>
+#include <mitsuba/render/mipmap.h>
+
+MTS_NAMESPACE_BEGIN
+
+class TestMIPMap : public TestCase {
+public:
+    MTS_BEGIN_TESTCASE()
+    MTS_DECLARE_TEST(test01_lod_level);
+    MTS_DECLARE_TEST(test02_lod_vs_differentials);
+    MTS_END_TESTCASE()
+
+    typedef TMIPMap<Color3, Color3> MIPMap3;
+
+    /// Create a trilinearly filtered MIP map of a 64x64 noise texture
+    ref<MIPMap3> createMIPMap() {
+        ref<Bitmap> bitmap = new Bitmap(Bitmap::ERGB, Bitmap::EFloat, Vector2i(64));
+        ref<Random> random = new Random();
+        Float *data = bitmap->getFloatData();
+        for (size_t i=0; i<bitmap->getPixelCount() * 3; ++i)
+            data[i] = random->nextFloat();
+
+        Properties rfilterProps("lanczos");
+        rfilterProps.setInteger("lobes", 2);
+        ref<ReconstructionFilter> rfilter = static_cast<ReconstructionFilter *> (
+            PluginManager::getInstance()->createObject(
+            MTS_CLASS(ReconstructionFilter), rfilterProps));
+        rfilter->configure();
+
+        return new MIPMap3(bitmap, Bitmap::ERGB, Bitmap::EFloat, rfilter,
+            ReconstructionFilter::ERepeat, ReconstructionFilter::ERepeat,
+            ETrilinear);
+    }
+
+    void assertEqualsColor(const Color3 &actual, const Color3 &expected, Float epsilon) {
+        for (int i=0; i<3; ++i)
+            assertEqualsEpsilon(actual[i], expected[i], epsilon);
+    }
+
+    void test01_lod_level() {
+        ref<MIPMap3> mipmap = createMIPMap();
+        assertEquals(mipmap->getLevels(), 7);
+        Point2 uv(0.3f, 0.7f);
+
+        /* A footprint of 4 texels selects level 2 */
+        assertEqualsColor(mipmap->evalLOD(uv, 4.0f / 64),
+            mipmap->evalBilinear(2, uv), 1e-6f);
+
+        /* Half-way between levels 3 and 4 in log space */
+        Float level = 3.5f;
+        assertEqualsColor(mipmap->evalLOD(uv, std::pow((Float) 2, level) / 64),
+            mipmap->evalBilinear(3, uv) * 0.5f + mipmap->evalBilinear(4, uv) * 0.5f, 1e-4f);
+
+        /* Footprints smaller than a texel use the full resolution */
+        assertEqualsColor(mipmap->evalLOD(uv, 0.1f / 64),
+            mipmap->evalBilinear(0, uv), 1e-6f);
+
+        /* Footprints larger than the texture use the coarsest level */
+        assertEqualsColor(mipmap->evalLOD(uv, 4.0f),
+            mipmap->evalBox(mipmap->getLevels()-1, uv), 1e-6f);
+    }
+
+    void test02_lod_vs_differentials() {
+        ref<MIPMap3> mipmap = createMIPMap();
+        ref<Random> random = new Random();
+
+        /* For an isotropic footprint, the ray cone lookup must select
+           the same level as the lookup based on UV partials */
+        for (int i=0; i<100; ++i) {
+            Point2 uv(random->nextFloat(), random->nextFloat());
+            Float width = std::pow((Float) 2, 8 * random->nextFloat() - 8);
+
+            assertEqualsColor(mipmap->evalLOD(uv, width),
+                mipmap->eval(uv, Vector2(width, 0), Vector2(0, width)), 1e-4f);
+        }
+    }
+};
+
+MTS_EXPORT_TESTCASE(TestMIPMap, "Testcase for ray cone MIP map lookups")
+MTS_NAMESPACE_END
@@ -32,6 +32,7 @@ public:
     MTS_DECLARE_TEST(test05_gaussLegendre_odd)
     MTS_DECLARE_TEST(test06_gaussLobatto_even)
     MTS_DECLARE_TEST(test07_gaussLobatto_odd)
+    MTS_DECLARE_TEST(test08_nD_parallel)
     MTS_END_TESTCASE()
 
     Float testF(Float t) const {
@@ -61,6 +62,13 @@ public:
         }
     }
 
+    void testF4(const Float *in, Float *out) const {
+        Float tmp[2];
+        testF3(1, in, tmp);
+        out[0] = tmp[0];
+        out[1] = tmp[1];
+    }
+
     void test01_quad() {
         GaussLobattoIntegrator quad(1024, 0, 1e-5f);
         size_t evals;
@@ -162,6 +170,18 @@ public:
         assertEqualsEpsilon(weights[3], (Float) (49.0/90.0), 1e-8f);
         assertEqualsEpsilon(weights[4], (Float) (1.0/10.0), 1e-8f);
     }
+
+    void test08_nD_parallel() {
+        NDIntegrator quad(2, 3, 1000000, 0, 1e-5f);
+        size_t evals;
+        Float min[3] = { -1, -1, -1 } , max[3] = { 1, 1, 1 }, result[2], err[2];
+        assertTrue(quad.integrateParallel(boost::bind(
+            &TestQuadrature::testF4, this, _1, _2), min, max, result, err, &evals) == NDIntegrator::ESuccess);
+        Log(EInfo, "test08_nD_parallel(): used " SIZE_T_FMT " function evaluations, "
+                "error=[%f, %f]", evals, err[0], err[1]);
+        assertEqualsEpsilon(result[0], 1.0f, 1e-5f);
+        assertEqualsEpsilon(result[1], 1.0f, 1e-5f);
+    }
 };
 
 MTS_EXPORT_TESTCASE(TestQuadrature, "Testcase for quadrature routines")
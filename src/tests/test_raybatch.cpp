@@ -0,0 +1,94 @@
+/*
+    This file is part of Mitsuba, a physically based rendering system.
+
+    Copyright (c) 2007-2014 by Wenzel Jakob and others.
+
+    Mitsuba is free software; you can redistribute it and/or modify
+    it under the terms of the GNU General Public License Version 3
+    as published by the Free Software Foundation.
+
+    Mitsuba is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program. If not, see <http://www.gnu.org/licenses/>.
+*/
+
+
+#include <mitsuba/core/plugin.h>
+#include <mitsuba/render/testcase.h>
+#include <mitsuba/render/sensor.h>
+
+MTS_NAMESPACE_BEGIN
+
+class TestRayBatch : public TestCase {
+public:
+    MTS_BEGIN_TESTCASE()
+    MTS_DECLARE_TEST(test01_perspective)
+    MTS_DECLARE_TEST(test02_thinlens)
+    MTS_DECLARE_TEST(test03_perspective_rdist)
+    MTS_END_TESTCASE()
+
+    /// Check that sampleRayBatch() matches individual calls to sampleRay()
+    void testSensor(Properties props) {
+        props.setTransform("toWorld", Transform::lookAt(
+            Point(1, 2, 3), Point(0, 0, 0), Vector(0, 1, 0)));
+        ref<Sensor> sensor = static_cast<Sensor *> (PluginManager::getInstance()->
+            createObject(MTS_CLASS(Sensor), props));
+        sensor->configure();
+
+        /* An odd count also exercises the scalar remainder of SIMD implementations */
+        const size_t count = 1023;
+        Vector2 size(sensor->getFilm()->getCropSize());
+        std::vector<Point2> samplePositions(count), apertureSamples(count);
+        std::vector<Float> timeSamples(count);
+        ref<Random> random = new Random();
+        for (size_t i=0; i<count; ++i) {
+            samplePositions[i] = Point2(random->nextFloat() * size.x,
+                random->nextFloat() * size.y);
+            apertureSamples[i] = Point2(random->nextFloat(), random->nextFloat());
+            timeSamples[i] = random->nextFloat();
+        }
+
+        RayBatch batch(count);
+        sensor->sampleRayBatch(batch, &samplePositions[0],
+            &apertureSamples[0], &timeSamples[0], count);
+        assertTrue(batch.size == count);
+
+        for (size_t i=0; i<count; ++i) {
+            Ray ray;
+            Spectrum value = sensor->sampleRay(ray, samplePositions[i],
+                apertureSamples[i], timeSamples[i]);
+            Ray batchRay = batch.getRay(i);
+            assertEqualsEpsilon(batchRay.o, ray.o, 1e-5f);
+            assertEqualsEpsilon(batchRay.d, ray.d, 1e-5f);
+            assertEqualsEpsilon(batchRay.mint, ray.mint, 1e-5f * ray.mint);
+            assertEqualsEpsilon(batchRay.maxt, ray.maxt, 1e-5f * ray.maxt);
+            assertEqualsEpsilon(batchRay.time, ray.time, 1e-6f);
+            assertEquals(batch.weight[i], value);
+        }
+    }
+
+    void test01_perspective() {
+        testSensor(Properties("perspective"));
+    }
+
+    void test02_thinlens() {
+        Properties props("thinlens");
+        props.setFloat("apertureRadius", 0.1f);
+        props.setFloat("focusDistance", 4.0f);
+        testSensor(props);
+    }
+
+    void test03_perspective_rdist() {
+        Properties props("perspective_rdist");
+        props.setString("kc", "0.1, 0.02");
+        testSensor(props);
+    }
+};
+
+MTS_EXPORT_TESTCASE(TestRayBatch, "Testcase for batched primary ray generation")
+
+MTS_NAMESPACE_END
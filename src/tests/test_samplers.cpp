@@ -28,6 +28,7 @@ public:
     MTS_DECLARE_TEST(test01_Halton)
     MTS_DECLARE_TEST(test02_Hammersley)
     MTS_DECLARE_TEST(test03_radicalInverseIncr)
+    MTS_DECLARE_TEST(test04_deterministic)
     MTS_END_TESTCASE()
 
     void test01_Halton() {
@@ -84,6 +85,57 @@ public:
             x = radicalInverseIncremental(2, x);
         }
     }
+
+    void test04_deterministic() {
+        const char *names[] = { "independent", "stratified", "ldsampler" };
+
+        for (int i=0; i<3; ++i) {
+            Properties props(names[i]);
+            props.setInteger("sampleCount", 16);
+            props.setBoolean("deterministic", true);
+            props.setInteger("seed", 7);
+
+            ref<Sampler> sampler = static_cast<Sampler *> (PluginManager::getInstance()->
+                    createObject(MTS_CLASS(Sampler), props));
+            sampler->configure();
+            ref<Sampler> clone1 = sampler->clone(), clone2 = sampler->clone();
+            assertTrue(clone1->isDeterministic() && clone1->getSeed() == 7);
+
+            /* The samples of a block must not depend on previously rendered blocks */
+            clone2->seedBlock(Point2i(32, 0));
+            clone2->generate(Point2i(40, 7));
+            clone2->next2D();
+            clone1->seedBlock(Point2i(0, 32));
+            clone2->seedBlock(Point2i(0, 32));
+            for (int p=0; p<2; ++p) {
+                clone1->generate(Point2i(3, 32 + p));
+                clone2->generate(Point2i(3, 32 + p));
+                for (int j=0; j<16; ++j) {
+                    for (int k=0; k<4; ++k)
+                        assertEquals(clone1->next1D(), clone2->next1D());
+                    assertEquals(Vector2(clone1->next2D()), Vector2(clone2->next2D()));
+                    clone1->advance();
+                    clone2->advance();
+                }
+            }
+
+            /* Repeated passes over the same pixel (e.g. progressive photon
+               mapping) must still receive fresh samples */
+            clone1->seedBlock(Point2i(0, 32));
+            clone1->generate(Point2i(3, 32));
+            Float first = clone1->next1D();
+            clone1->generate(Point2i(3, 32));
+            assertTrue(clone1->next1D() != first);
+
+            /* .. and the samples should change with the seed */
+            clone2->setDeterministic(true, 8);
+            clone1->seedBlock(Point2i(0, 32));
+            clone2->seedBlock(Point2i(0, 32));
+            clone1->generate(Point2i(3, 32));
+            clone2->generate(Point2i(3, 32));
+            assertTrue(clone1->next1D() != clone2->next1D());
+        }
+    }
 };
 
 MTS_EXPORT_TESTCASE(TestSamplers, "Testcase for sampling-related code")
@@ -16,16 +16,12 @@
     along with this program. If not, see <http://www.gnu.org/licenses/>.
 */
 
-#ifndef MTS_TESTCASE
-# define MTS_TESTCASE 1
-#endif
-
 #include <mitsuba/core/platform.h>
 #include <mitsuba/core/plugin.h>
 #include <mitsuba/render/testcase.h>
 
 #if MTS_SSE
-#include "simdtonemap.h"
+#include <mitsuba/core/simdtonemap.h>
 
 #include <mitsuba/core/matrix.h>
 #include <mitsuba/core/bitmap.h>
@@ -117,13 +113,13 @@ struct TonemapReinhard
         using mitsuba::Matrix3x3;
         using mitsuba::Vector3f;
 
-        const mat3 RGB2XYZ(0.412453f, 0.212671f, 0.019334f,
-                           0.357580f, 0.715160f, 0.119193f,
-                           0.180423f, 0.072169f, 0.950227f);
+        const mat3 RGB2XYZ(0.412453f, 0.357580f, 0.180423f,
+                           0.212671f, 0.715160f, 0.072169f,
+                           0.019334f, 0.119193f, 0.950227f);
 
-        const mat3 XYZ2RGB(3.240479f, -0.969256f,  0.055648f,
-                          -1.537150f,  1.875991f, -0.204043f,
-                          -0.498535f,  0.041556f,  1.057311f);
+        const mat3 XYZ2RGB( 3.240479f, -1.537150f, -0.498535f,
+                           -0.969256f,  1.875991f,  0.041556f,
+                            0.055648f, -0.204043f,  1.057311f);
 
         vec3 XYZ = RGB2XYZ * vec3(src.r, src.g, src.b) * multiplier;
         float normalization = 1.0f / (XYZ.x + XYZ.y + XYZ.z);
@@ -269,6 +265,7 @@ public:
     MTS_DECLARE_TEST(testLuminance);
     MTS_DECLARE_TEST(testGamma);
     MTS_DECLARE_TEST(testReinhard);
+    MTS_DECLARE_TEST(testBitmap);
     MTS_END_TESTCASE()
 
     virtual void init();
@@ -283,6 +280,9 @@ public:
     void testReinhard(int numImageSizes = 5, int runsPerImage = 2,
         int paramsPerImage = 10);
 
+    /// Compare against Bitmap::tonemapReinhard() and Bitmap::convert()
+    void testBitmap();
+
 private:
 
     static inline float pow2(float x) {
@@ -480,7 +480,7 @@ void TestTonemapperSSE::testLuminance(Bitmap *hdr, TonemapCPU *tmo) {
     m_timerRef->stop();
 
     m_timerSIMD->start();
-    tmo->setLuminanceInfo(hdr, tmo->multiplier());
+    tmo->setLuminanceInfo(hdr, tmo->multiplier(), true);
     m_timerSIMD->stop();
 
     float errMax = std::abs(maxAvgLum - tmo->maxLuminance());
@@ -664,6 +664,52 @@ void TestTonemapperSSE::testBasic() {
     testBasic(pixel, params, delta);
 }
 
+void TestTonemapperSSE::testBitmap() {
+    const Vector2i size(301, 203);
+    ref<Bitmap> hdr = new Bitmap(Bitmap::ERGBA, Bitmap::EFloat32, size);
+    ref<Bitmap> ldr = new Bitmap(Bitmap::ERGBA, Bitmap::EUInt8, size);
+    fill(hdr);
+
+    for (int run = 0; run < 2; ++run) {
+        const bool reinhard = run == 1;
+        ref<Bitmap> expected = hdr->clone();
+        ref<TonemapCPU> tmo = new TonemapCPU;
+        tmo->setGamma(-1);
+
+        if (reinhard) {
+            Float logAvgLuminance = 0, maxLuminance = 0;
+            expected->tonemapReinhard(logAvgLuminance, maxLuminance, 0.18f, 0.1f);
+            tmo->setLuminanceInfo(hdr);
+            tmo->setReinhardParameters(0.18f, 0.1f);
+            tmo->reinhardTonemap(hdr, ldr);
+            assertEqualsEpsilon(tmo->maxLuminance(), maxLuminance, 1e-4f * maxLuminance);
+            assertEqualsEpsilon(tmo->logAvgLuminance(), logAvgLuminance, 1e-3f * logAvgLuminance);
+        } else {
+            expected = expected->convert(Bitmap::ERGBA, Bitmap::EFloat32, 1.0f, 2.0f);
+            tmo->setInvWhitePoint(2.0f);
+            tmo->gammaTonemap(hdr, ldr);
+        }
+        expected = expected->convert(Bitmap::ERGBA, Bitmap::EUInt8, -1);
+
+        m_variance.reset();
+        updateVariance(ldr, expected);
+        Log(EInfo, "%s: error - mean: %g, max: %g", reinhard ? "Reinhard" : "Gamma",
+            m_variance.mean(), m_variance.max());
+        assertTrue(m_variance.max() <= 2);
+        assertTrue(m_variance.mean() < 0.1);
+
+        /* RGB output must match the color channels of the RGBA output */
+        Float logAvgLuminance = 0, maxLuminance = 0;
+        ref<Bitmap> rgb = TonemapCPU::develop(hdr, Bitmap::ERGB, -1, 2.0f,
+            reinhard ? 0.18f : -1, 0.1f, logAvgLuminance, maxLuminance);
+        assertTrue(rgb->getPixelFormat() == Bitmap::ERGB);
+        const uint8_t *rgbData = rgb->getUInt8Data(), *rgbaData = ldr->getUInt8Data();
+        for (size_t i = 0; i < rgb->getPixelCount(); ++i)
+            for (int j = 0; j < 3; ++j)
+                assertEquals((int) rgbData[3*i+j], (int) rgbaData[4*i+j]);
+    }
+}
+
 #else
 
 MTS_NAMESPACE_BEGIN
@@ -683,6 +729,6 @@ public:
 
 
 MTS_EXPORT_TESTCASE(TestTonemapperSSE,
-    "Testcase for the SSE Tonemapper used by mtsgui")
+    "Testcase for the SIMD tone mapper")
 
 MTS_NAMESPACE_END
@@ -0,0 +1,119 @@
+/*
+    This file is part of Mitsuba, a physically based rendering system.
+
+    Copyright (c) 2007-2014 by Wenzel Jakob and others.
+
+    Mitsuba is free software; you can redistribute it and/or modify
+    it under the terms of the GNU General Public License Version 3
+    as published by the Free Software Foundation.
+
+    Mitsuba is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program. If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include <mitsuba/core/plugin.h>
+#include <mitsuba/render/testcase.h>
+#include <mitsuba/render/texgraph.h>
+#include <mitsuba/render/shape.h>
+#include <mitsuba/hw/basicshader.h>
+
+MTS_NAMESPACE_BEGIN
+
+class TestTextureGraph : public TestCase {
+public:
+    MTS_BEGIN_TESTCASE()
+    MTS_DECLARE_TEST(test01_constantFolding)
+    MTS_DECLARE_TEST(test02_scaleMerging)
+    MTS_DECLARE_TEST(test03_equivalence)
+    MTS_END_TESTCASE()
+
+    ref<Texture> createTexture(const Properties &props, Texture *nested = NULL) {
+        ref<Texture> texture = static_cast<Texture *> (PluginManager::getInstance()->
+                createObject(MTS_CLASS(Texture), props));
+        if (nested)
+            texture->addChild("", nested);
+        texture->configure();
+        return texture;
+    }
+
+    ref<Texture> createScale(Texture *nested, Float scale) {
+        Properties props("scale");
+        props.setFloat("scale", scale);
+        return createTexture(props, nested);
+    }
+
+    ref<Texture> createCheckerboard(Float uvscale) {
+        Properties props("checkerboard");
+        props.setFloat("uvscale", uvscale);
+        props.setSpectrum("color0", Spectrum(0.8f));
+        props.setSpectrum("color1", Spectrum(0.1f));
+        return createTexture(props);
+    }
+
+    void test01_constantFolding() {
+        ref<Texture> a = new ConstantSpectrumTexture(Spectrum(0.5f));
+        ref<Texture> b = createScale(new ConstantFloatTexture(2.0f), 3.0f);
+        ref<Texture> product = new SpectrumProductTexture(a, b);
+
+        ref<TextureProgram> program = new TextureProgram(product);
+        assertTrue(program->isConstant());
+        assertEquals(program->eval(Intersection()), Spectrum(3.0f));
+
+        /* A checkerboard with identical colors is constant as well */
+        Properties props("checkerboard");
+        props.setSpectrum("color0", Spectrum(0.3f));
+        props.setSpectrum("color1", Spectrum(0.3f));
+        program = new TextureProgram(createTexture(props));
+        assertTrue(program->isConstant());
+    }
+
+    void test02_scaleMerging() {
+        ref<Texture> texture = createCheckerboard(4.0f);
+        for (int i=0; i<20; ++i)
+            texture = createScale(texture, 1.1f);
+        texture = new SpectrumProductTexture(texture,
+            new ConstantSpectrumTexture(Spectrum(0.5f)));
+
+        /* All scale factors end up in the colors of the pattern */
+        ref<TextureProgram> program = new TextureProgram(texture);
+        assertEquals((int) program->getInstructionCount(), 1);
+        assertEquals(program->getRegisterCount(), 1);
+    }
+
+    void test03_equivalence() {
+        Properties props("gridtexture");
+        props.setFloat("uvscale", 3.0f);
+        props.setSpectrum("color0", Spectrum(0.2f));
+        props.setSpectrum("color1", Spectrum(0.9f));
+        ref<Texture> grid = createTexture(props);
+        ref<Texture> checker1 = createCheckerboard(2.0f);
+        ref<Texture> checker2 = createCheckerboard(5.0f);
+
+        /* A network with a shared subgraph and a constant branch */
+        ref<Texture> shared = new SpectrumProductTexture(checker1, grid);
+        ref<Texture> texture = new SpectrumAdditionTexture(
+            createScale(shared, 0.5f),
+            new SpectrumSubtractionTexture(
+                new SpectrumProductTexture(shared, checker2),
+                createScale(new ConstantSpectrumTexture(Spectrum(0.25f)), 2.0f)));
+
+        ref<TextureProgram> program = new TextureProgram(texture);
+        Log(EDebug, "%s", program->toString().c_str());
+
+        ref<Random> random = new Random();
+        for (size_t i=0; i<1000; ++i) {
+            Intersection its;
+            its.uv = Point2(random->nextFloat(), random->nextFloat());
+            assertEqualsEpsilon(program->eval(its), texture->eval(its), 1e-5f);
+        }
+    }
+};
+
+MTS_EXPORT_TESTCASE(TestTextureGraph, "Testcase for compiled texture networks")
+
+MTS_NAMESPACE_END
@@ -0,0 +1,126 @@
+/*
+    This file is part of Mitsuba, a physically based rendering system.
+
+    Copyright (c) 2007-2014 by Wenzel Jakob and others.
+
+    Mitsuba is free software; you can redistribute it and/or modify
+    it under the terms of the GNU General Public License Version 3
+    as published by the Free Software Foundation.
+
+    Mitsuba is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program. If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include <mitsuba/render/testcase.h>
+#include <mitsuba/core/warp.h>
+#include <mitsuba/core/random.h>
+#if MTS_SSE
+#include <mitsuba/core/ssemath.h>
+#endif
+
+MTS_NAMESPACE_BEGIN
+
+/* Odd sample count, which exercises both the SIMD and the scalar tail path */
+#define SAMPLE_COUNT 1023
+
+class TestWarp : public TestCase {
+public:
+    MTS_BEGIN_TESTCASE()
+    MTS_DECLARE_TEST(test01_sphere)
+    MTS_DECLARE_TEST(test02_plane)
+    MTS_DECLARE_TEST(test03_ssemath)
+    MTS_END_TESTCASE()
+
+    void init() {
+        ref<Random> random = new Random();
+        m_samples.resize(SAMPLE_COUNT);
+        for (size_t i=0; i<SAMPLE_COUNT; ++i)
+            m_samples[i] = Point2(random->nextFloat(), random->nextFloat());
+        /* Corner cases of the concentric mapping */
+        m_samples[0] = Point2(0.5f, 0.5f);
+        m_samples[1] = Point2(0.0f, 0.0f);
+        m_samples[2] = Point2(0.5f, 0.0f);
+    }
+
+    void test01_sphere() {
+        std::vector<Vector> result(SAMPLE_COUNT);
+        const Point2 *samples = &m_samples[0];
+
+        warp::squareToUniformSphere(samples, &result[0], SAMPLE_COUNT);
+        for (size_t i=0; i<SAMPLE_COUNT; ++i)
+            assertEqualsEpsilon(result[i], warp::squareToUniformSphere(samples[i]), 1e-4f);
+
+        warp::squareToUniformHemisphere(samples, &result[0], SAMPLE_COUNT);
+        for (size_t i=0; i<SAMPLE_COUNT; ++i)
+            assertEqualsEpsilon(result[i], warp::squareToUniformHemisphere(samples[i]), 1e-4f);
+
+        /* Slightly looser, since the square root amplifies errors near the horizon */
+        warp::squareToCosineHemisphere(samples, &result[0], SAMPLE_COUNT);
+        for (size_t i=0; i<SAMPLE_COUNT; ++i)
+            assertEqualsEpsilon(result[i], warp::squareToCosineHemisphere(samples[i]), 1e-3f);
+
+        warp::squareToUniformCone(0.3f, samples, &result[0], SAMPLE_COUNT);
+        for (size_t i=0; i<SAMPLE_COUNT; ++i)
+            assertEqualsEpsilon(result[i], warp::squareToUniformCone(0.3f, samples[i]), 1e-4f);
+    }
+
+    void test02_plane() {
+        std::vector<Point2> result(SAMPLE_COUNT);
+        const Point2 *samples = &m_samples[0];
+
+        warp::squareToUniformDisk(samples, &result[0], SAMPLE_COUNT);
+        for (size_t i=0; i<SAMPLE_COUNT; ++i)
+            assertEqualsEpsilon(result[i], warp::squareToUniformDisk(samples[i]), 1e-4f);
+
+        warp::squareToUniformDiskConcentric(samples, &result[0], SAMPLE_COUNT);
+        for (size_t i=0; i<SAMPLE_COUNT; ++i)
+            assertEqualsEpsilon(result[i], warp::squareToUniformDiskConcentric(samples[i]), 1e-4f);
+
+        warp::squareToUniformTriangle(samples, &result[0], SAMPLE_COUNT);
+        for (size_t i=0; i<SAMPLE_COUNT; ++i)
+            assertEqualsEpsilon(result[i], warp::squareToUniformTriangle(samples[i]), 1e-4f);
+
+        /* The SIMD path uses a lower-precision logarithm; compare relative to the radius */
+        warp::squareToStdNormal(samples, &result[0], SAMPLE_COUNT);
+        for (size_t i=0; i<SAMPLE_COUNT; ++i) {
+            Point2 ref = warp::squareToStdNormal(samples[i]);
+            Float scale = std::max((Float) 1, Vector2(ref).length());
+            assertEqualsEpsilon(result[i], ref, 2e-3f * scale);
+        }
+    }
+
+    void test03_ssemath() {
+#if MTS_SSE
+        for (size_t i=0; i<SAMPLE_COUNT; ++i) {
+            float x = (float) (20 * (m_samples[i].x - 0.5f));
+            float y = (float) (10 * m_samples[i].y + 1e-3f);
+            __m128 vx = _mm_set1_ps(x), vy = _mm_set1_ps(y), s, c;
+
+            math::sincos_ps(vx, &s, &c);
+            assertEqualsEpsilon(_mm_cvtss_f32(math::sin_ps(vx)), std::sin(x), 1e-5f);
+            assertEqualsEpsilon(_mm_cvtss_f32(math::cos_ps(vx)), std::cos(x), 1e-5f);
+            assertEqualsEpsilon(_mm_cvtss_f32(s), std::sin(x), 1e-5f);
+            assertEqualsEpsilon(_mm_cvtss_f32(c), std::cos(x), 1e-5f);
+            assertEqualsEpsilon(_mm_cvtss_f32(math::log_ps(vy)), std::log(y), 1e-5f);
+            assertEqualsEpsilon(_mm_cvtss_f32(math::exp_ps(vx)), std::exp(x), 1e-5f * std::exp(x));
+
+            /* The fast approximations provide about 10-11 mantissa bits */
+            assertEqualsEpsilon(_mm_cvtss_f32(math::fastexp_ps(vx)), std::exp(x), 1e-3f * std::exp(x));
+            assertEqualsEpsilon(_mm_cvtss_f32(math::fastlog_ps(vy)), std::log(y), 1e-3f);
+        }
+#else
+        Log(EWarn, "Skipping test (Mitsuba was compiled without SSE support)");
+#endif
+    }
+
+private:
+    std::vector<Point2> m_samples;
+};
+
+MTS_EXPORT_TESTCASE(TestWarp, "Testcase for batched and SIMD warping routines")
+MTS_NAMESPACE_END
@@ -498,6 +498,21 @@ public:
         return result;
     }
 
+    Spectrum evalLOD(const Point2 &uv, Float width) const {
+        stats::filteredLookups.incrementBase();
+        ++stats::filteredLookups;
+
+        Spectrum result;
+        if (m_mipmap3.get()) {
+            Color3 value = m_mipmap3->evalLOD(uv, width);
+            result.fromLinearRGB(value[0], value[1], value[2]);
+        } else {
+            Color1 value = m_mipmap1->evalLOD(uv, width);
+            result = Spectrum(value[0]);
+        }
+        return result;
+    }
+
     Spectrum getAverage() const {
         Spectrum result;
         if (m_mipmap3.get()) {
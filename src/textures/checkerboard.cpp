@@ -18,6 +18,7 @@
 
 #include <mitsuba/render/texture.h>
 #include <mitsuba/render/shape.h>
+#include <mitsuba/render/texgraph.h>
 #include <mitsuba/core/properties.h>
 #include <mitsuba/hw/gpuprogram.h>
 
@@ -105,6 +106,10 @@ public:
         return false;
     }
 
+    int compile(TextureProgram *program) const {
+        return program->checkerboard(m_uvOffset, m_uvScale, m_color0, m_color1);
+    }
+
     bool isMonochromatic() const {
         return Spectrum(m_color0[0]) == m_color0
             && Spectrum(m_color1[0]) == m_color1;
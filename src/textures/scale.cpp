@@ -18,6 +18,7 @@
 
 #include <mitsuba/render/texture.h>
 #include <mitsuba/render/shape.h>
+#include <mitsuba/render/texgraph.h>
 #include <mitsuba/hw/basicshader.h>
 
 MTS_NAMESPACE_BEGIN
@@ -108,6 +109,10 @@ public:
         return m_nested->isConstant();
     }
 
+    int compile(TextureProgram *program) const {
+        return program->scale(program->compile(m_nested.get()), m_scale);
+    }
+
     ref<Bitmap> getBitmap(const Vector2i &sizeHint) const {
         ref<Bitmap> result = m_nested->getBitmap(sizeHint);
 
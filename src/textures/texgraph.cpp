@@ -0,0 +1,169 @@
+/*
+    This file is part of Mitsuba, a physically based rendering system.
+
+    Copyright (c) 2007-2014 by Wenzel Jakob and others.
+
+    Mitsuba is free software; you can redistribute it and/or modify
+    it under the terms of the GNU General Public License Version 3
+    as published by the Free Software Foundation.
+
+    Mitsuba is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program. If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include <mitsuba/render/texgraph.h>
+#include <mitsuba/render/shape.h>
+#include <mitsuba/hw/basicshader.h>
+
+MTS_NAMESPACE_BEGIN
+
+/*!\plugin{texgraph}{Compiled texture network}
+ * \order{8}
+ * \parameters{
+ *     \parameter{\Unnamed}{\Texture}{
+ *       Root of the texture network that should be compiled
+ *     }
+ * }
+ *
+ * Texture networks built from nested plugins are normally evaluated
+ * through a chain of virtual function calls, one per node. For deep
+ * networks, this overhead can dominate the cost of shading. This plugin
+ * flattens the network below it into a compact program that is executed
+ * by a small interpreter loop.
+ *
+ * While doing so, constant subgraphs are replaced by their value,
+ * products with constants are merged, and nodes that are referenced several
+ * times are only evaluated once. The \pluginref{scale}, \pluginref{checkerboard}
+ * and \pluginref{gridtexture} plugins as well as the sums and products created
+ * by other plugins are translated into instructions, while all remaining
+ * textures (e.g. \pluginref{bitmap}) are evaluated through their regular
+ * implementation. The rendered result is unaffected.
+ *
+ * \begin{xml}[caption=Compiling a scaled checkerboard]
+ * <texture type="texgraph">
+ *     <texture type="scale">
+ *         <float name="scale" value="0.5"/>
+ *
+ *         <texture type="checkerboard">
+ *             <float name="uscale" value="4"/>
+ *             <float name="vscale" value="4"/>
+ *         </texture>
+ *     </texture>
+ * </texture>
+ * \end{xml}
+ */
+class TextureGraph : public Texture {
+public:
+    TextureGraph(const Properties &props) : Texture(props) { }
+
+    TextureGraph(Stream *stream, InstanceManager *manager)
+        : Texture(stream, manager) {
+        m_nested = static_cast<Texture *>(manager->getInstance(stream));
+        configure();
+    }
+
+    void configure() {
+        if (m_nested == NULL)
+            Log(EError, "The texgraph plugin needs a nested texture!");
+
+        m_program = new TextureProgram(m_nested.get());
+        Log(EDebug, "Compiled a texture network with " SIZE_T_FMT " nodes into "
+            SIZE_T_FMT " instructions using %i registers", m_program->getNodeCount(),
+            m_program->getInstructionCount(), m_program->getRegisterCount());
+    }
+
+    void addChild(const std::string &name, ConfigurableObject *child) {
+        if (child->getClass()->derivesFrom(MTS_CLASS(Texture)))
+            m_nested = static_cast<Texture *>(child);
+        else
+            Texture::addChild(name, child);
+    }
+
+    Spectrum eval(const Intersection &its, bool filter) const {
+        return m_program->eval(its, filter);
+    }
+
+    void evalGradient(const Intersection &its, Spectrum *gradient) const {
+        m_nested->evalGradient(its, gradient);
+    }
+
+    ref<Texture> expand() {
+        /* Nothing to gain when the network folded into a constant or a single texture */
+        if (m_program->isConstant())
+            return new ConstantSpectrumTexture(m_program->eval(Intersection()));
+
+        const Texture *passthrough = m_program->getPassthrough();
+        if (passthrough)
+            return const_cast<Texture *>(passthrough);
+
+        return this;
+    }
+
+    int compile(TextureProgram *program) const {
+        return program->compile(m_nested.get());
+    }
+
+    Spectrum getAverage() const {
+        return m_nested->getAverage();
+    }
+
+    Spectrum getMaximum() const {
+        return m_nested->getMaximum();
+    }
+
+    Spectrum getMinimum() const {
+        return m_nested->getMinimum();
+    }
+
+    Vector3i getResolution() const {
+        return m_nested->getResolution();
+    }
+
+    bool isConstant() const {
+        return m_nested->isConstant();
+    }
+
+    bool isMonochromatic() const {
+        return m_nested->isMonochromatic();
+    }
+
+    bool usesRayDifferentials() const {
+        return m_nested->usesRayDifferentials();
+    }
+
+    ref<Bitmap> getBitmap(const Vector2i &sizeHint) const {
+        return m_nested->getBitmap(sizeHint);
+    }
+
+    Shader *createShader(Renderer *renderer) const {
+        return m_nested->createShader(renderer);
+    }
+
+    void serialize(Stream *stream, InstanceManager *manager) const {
+        Texture::serialize(stream, manager);
+        manager->serialize(stream, m_nested.get());
+    }
+
+    std::string toString() const {
+        std::ostringstream oss;
+        oss << "TextureGraph[" << endl
+            << "  nested = " << indent(m_nested->toString()) << "," << endl
+            << "  program = " << indent(m_program->toString()) << endl
+            << "]";
+        return oss.str();
+    }
+
+    MTS_DECLARE_CLASS()
+protected:
+    ref<const Texture> m_nested;
+    ref<TextureProgram> m_program;
+};
+
+MTS_IMPLEMENT_CLASS_S(TextureGraph, false, Texture)
+MTS_EXPORT_PLUGIN(TextureGraph, "Compiled texture network");
+MTS_NAMESPACE_END
@@ -19,88 +19,125 @@
 #include <mitsuba/core/plugin.h>
 #include <mitsuba/core/bitmap.h>
 #include <mitsuba/core/fstream.h>
+#include <mitsuba/core/timer.h>
 #include <mitsuba/render/util.h>
+#if MTS_SSE
+#include <mitsuba/core/sse.h>
+#endif
+
+/* Number of scanlines that are kept in memory per input image */
+#define MTS_ADDIMAGES_BAND_SIZE 64
 
 MTS_NAMESPACE_BEGIN
 
 class AddImages : public Utility {
 public:
+    void help() {
+        cout << "Add the weighted pixel values of several EXR images to produce a new one" << endl;
+        cout << "Syntax: mtsutil addimages <weight 1> <image 1.exr> <weight 2> <image 2.exr> [.. <weight N> <image N.exr>] <target.exr>" << endl;
+        cout << "The images are processed in bands of scanlines, hence they need not fit into memory." << endl;
+    }
+
+    /**
+     * Compute the clamped linear combination max(0, sum_i weights[i]*sources[i])
+     * of \c count consecutive entries
+     */
+    static void combine(float *target, const std::vector<const float *> &sources,
+            const std::vector<float> &weights, size_t count) {
+        size_t i = 0;
+        const size_t n = sources.size();
+#if MTS_SSE
+        const __m128 zero = _mm_setzero_ps();
+        for (; i + 4 <= count; i += 4) {
+            __m128 acc = _mm_mul_ps(_mm_set1_ps(weights[0]),
+                _mm_loadu_ps(sources[0] + i));
+            for (size_t j=1; j<n; ++j)
+                acc = _mm_add_ps(acc, _mm_mul_ps(_mm_set1_ps(weights[j]),
+                    _mm_loadu_ps(sources[j] + i)));
+            _mm_storeu_ps(target + i, _mm_max_ps(acc, zero));
+        }
+#endif
+        for (; i < count; ++i) {
+            float acc = weights[0] * sources[0][i];
+            for (size_t j=1; j<n; ++j)
+                acc += weights[j] * sources[j][i];
+            target[i] = std::max(0.0f, acc);
+        }
+    }
+
     int run(int argc, char **argv) {
-        if (argc != 6) {
-            cout << "Add the weighted pixel values of two EXR images to produce a new one" << endl;
-            cout << "Syntax: mtsutil addimages <weight 1> <image 1.exr> <weight 2> <image 2.exr> <target.exr>" << endl;
+        if (argc < 6 || argc % 2 != 0) {
+            help();
             return -1;
         }
-        char *end_ptr = NULL;
-        Float weight1 = (Float) strtod(argv[1], &end_ptr);
-        if (*end_ptr != '\0')
-            SLog(EError, "Could not parse floating point value");
-        Float weight2 = (Float) strtod(argv[3], &end_ptr);
-        if (*end_ptr != '\0')
-            SLog(EError, "Could not parse floating point value");
-
-        ref<FileStream> aFile   = new FileStream(argv[2], FileStream::EReadOnly);
-        ref<FileStream> bFile   = new FileStream(argv[4], FileStream::EReadOnly);
-        ref<FileStream> outFile = new FileStream(argv[5], FileStream::ETruncReadWrite);
-
-        ref<Bitmap> aBitmap = new Bitmap(Bitmap::EOpenEXR, aFile);
-        ref<Bitmap> bBitmap = new Bitmap(Bitmap::EOpenEXR, bFile);
-
-        /* A few sanity checks */
-        if (aBitmap->getPixelFormat() != bBitmap->getPixelFormat())
-            Log(EError, "Error: Input bitmaps have a different pixel format!");
-        if (aBitmap->getComponentFormat() != bBitmap->getComponentFormat())
-            Log(EError, "Error: Input bitmaps have a different component format!");
-        if (aBitmap->getSize() != bBitmap->getSize())
-            Log(EError, "Error: Input bitmaps have a different size!");
-
-        ref<Bitmap> outBitmap = new Bitmap(aBitmap->getPixelFormat(),
-                aBitmap->getComponentFormat(), aBitmap->getSize());
-
-        size_t nEntries =
-            (size_t) aBitmap->getSize().x *
-            (size_t) aBitmap->getSize().y *
-            aBitmap->getChannelCount();
-
-        switch (aBitmap->getComponentFormat()) {
-            case Bitmap::EFloat16: {
-                    half *aData = aBitmap->getFloat16Data();
-                    half *bData = bBitmap->getFloat16Data();
-                    half *outData = outBitmap->getFloat16Data();
-                    for (size_t i=0; i<nEntries; ++i)
-                        *outData++ = (half) ((float) std::max((Float) 0,
-                                weight1 * (Float) (*aData++) +
-                                weight2 * (Float) (*bData++)));
-                }
-                break;
-
-            case Bitmap::EFloat32: {
-                    float *aData = aBitmap->getFloat32Data();
-                    float *bData = bBitmap->getFloat32Data();
-                    float *outData = outBitmap->getFloat32Data();
-                    for (size_t i=0; i<nEntries; ++i)
-                        *outData++ = (float) std::max((Float) 0,
-                                weight1 * (Float) (*aData++) +
-                                weight2 * (Float) (*bData++));
-                }
-                break;
-
-            case Bitmap::EUInt32: {
-                    uint32_t *aData = aBitmap->getUInt32Data();
-                    uint32_t *bData = bBitmap->getUInt32Data();
-                    uint32_t *outData = outBitmap->getUInt32Data();
-                    for (size_t i=0; i<nEntries; ++i)
-                        *outData++ = (uint32_t) std::max((Float) 0,
-                                weight1 * (Float) (*aData++) +
-                                weight2 * (Float) (*bData++));
-                }
-                break;
-
-            default:
-                Log(EError, "Unsupported component format!");
+
+        int nImages = (argc - 2) / 2;
+        std::vector<float> weights(nImages);
+        std::vector<ref<FileStream> > files(nImages);
+        ref_vector<EXRScanlineReader> readers(nImages);
+        size_t inputSize = 0;
+
+        for (int i=0; i<nImages; ++i) {
+            char *end_ptr = NULL;
+            weights[i] = (float) strtod(argv[1+2*i], &end_ptr);
+            if (*end_ptr != '\0')
+                SLog(EError, "Could not parse floating point value");
+            files[i] = new FileStream(argv[2+2*i], FileStream::EReadOnly);
+            inputSize += files[i]->getSize();
+            readers[i] = new EXRScanlineReader(files[i]);
+
+            /* A few sanity checks */
+            if (readers[i]->getSize() != readers[0]->getSize())
+                Log(EError, "Error: Input bitmaps have a different size!");
+            if (readers[i]->getChannelNames() != readers[0]->getChannelNames())
+                Log(EError, "Error: Input bitmaps have different channels!");
+        }
+
+        const Vector2i size = readers[0]->getSize();
+        const int channels = readers[0]->getChannelCount();
+        const int bandRows = std::min(size.y, MTS_ADDIMAGES_BAND_SIZE);
+        const size_t rowEntries = (size_t) size.x * channels;
+
+        ref<FileStream> outFile = new FileStream(argv[argc-1], FileStream::ETruncReadWrite);
+        ref<EXRScanlineWriter> writer = new EXRScanlineWriter(outFile, size,
+            readers[0]->getChannelNames(), readers[0]->getComponentFormat());
+
+        ref_vector<Bitmap> bands(nImages);
+        std::vector<const float *> sources(nImages);
+        for (int i=0; i<nImages; ++i) {
+            bands[i] = new Bitmap(Bitmap::EMultiChannel, Bitmap::EFloat32,
+                Vector2i(size.x, bandRows), channels);
+            sources[i] = bands[i]->getFloat32Data();
+        }
+        ref<Bitmap> outBand = new Bitmap(Bitmap::EMultiChannel, Bitmap::EFloat32,
+            Vector2i(size.x, bandRows), channels);
+        float *target = outBand->getFloat32Data();
+
+        ref<Timer> timer = new Timer();
+        while (writer->getPosition() < size.y) {
+            int rows = 0;
+            for (int i=0; i<nImages; ++i)
+                rows = readers[i]->read(bands[i]);
+
+            /* Process the scanlines of the band in parallel */
+            #pragma omp parallel for schedule(static)
+            for (int y=0; y<rows; ++y) {
+                size_t offset = (size_t) y * rowEntries;
+                std::vector<const float *> rowSources(nImages);
+                for (int i=0; i<nImages; ++i)
+                    rowSources[i] = sources[i] + offset;
+                combine(target + offset, rowSources, weights, rowEntries);
+            }
+
+            writer->write(outBand, rows);
         }
+        writer = NULL;
 
-        outBitmap->write(Bitmap::EOpenEXR, outFile);
+        Float time = std::max((Float) 1e-3f, timer->getMilliseconds() / (Float) 1000);
+        Log(EInfo, "Combined %i images (%ix%i, %i channels) in %.3f s (%.1f MPixel/s, "
+            "%.1f MiB/s of input data)", nImages, size.x, size.y, channels, time,
+            (Float) size.x * size.y / (time * 1e6f),
+            inputSize / (time * 1024 * 1024));
         return 0;
     }
 
@@ -19,33 +19,96 @@
 #include <mitsuba/render/util.h>
 #include <mitsuba/core/bitmap.h>
 #include <mitsuba/core/fstream.h>
+#include <mitsuba/core/timer.h>
+
+/* Number of scanlines that are kept in memory per input image */
+#define MTS_JOINRGB_BAND_SIZE 64
 
 MTS_NAMESPACE_BEGIN
 
 class JoinRGB : public Utility {
 public:
+    /**
+     * Return the index of the channel that holds the monochromatic image
+     * data. The reader sorts channels alphabetically, hence the luminance
+     * or red channel is looked up by name (matching \ref Bitmap::readOpenEXR())
+     */
+    int findChannel(const EXRScanlineReader *reader, const std::string &filename) {
+        const std::vector<std::string> &names = reader->getChannelNames();
+        const char *candidates[] = { "Y", "R" };
+        for (int i=0; i<2; ++i) {
+            std::vector<std::string>::const_iterator it =
+                std::find(names.begin(), names.end(), candidates[i]);
+            if (it != names.end())
+                return (int) (it - names.begin());
+        }
+        Log(EWarn, "\"%s\": no luminance or red channel found, using channel \"%s\"",
+            filename.c_str(), names[0].c_str());
+        return 0;
+    }
+
     void joinRGB(const std::string &s1, const std::string &s2, const std::string &s3, const std::string &s4) {
-        ref<FileStream> rFile   = new FileStream(s1, FileStream::EReadOnly);
-        ref<FileStream> gFile   = new FileStream(s2, FileStream::EReadOnly);
-        ref<FileStream> bFile   = new FileStream(s3, FileStream::EReadOnly);
-
-        ref<Bitmap> rBitmap = new Bitmap(Bitmap::EOpenEXR, rFile);
-        ref<Bitmap> gBitmap = new Bitmap(Bitmap::EOpenEXR, gFile);
-        ref<Bitmap> bBitmap = new Bitmap(Bitmap::EOpenEXR, bFile);
-        rBitmap = rBitmap->extractChannel(0);
-        gBitmap = gBitmap->extractChannel(0);
-        bBitmap = bBitmap->extractChannel(0);
-
-        std::vector<Bitmap *> sourceBitmaps;
-        sourceBitmaps.push_back(rBitmap);
-        sourceBitmaps.push_back(gBitmap);
-        sourceBitmaps.push_back(bBitmap);
-
-        ref<Bitmap> result = Bitmap::join(Bitmap::ERGBA, sourceBitmaps);
+        const std::string sources[3] = { s1, s2, s3 };
+        ref<EXRScanlineReader> readers[3];
+        ref<Bitmap> bands[3];
+        int channels[3];
+        size_t inputSize = 0;
+
+        for (int i=0; i<3; ++i) {
+            ref<FileStream> file = new FileStream(sources[i], FileStream::EReadOnly);
+            inputSize += file->getSize();
+            readers[i] = new EXRScanlineReader(file);
+            if (readers[i]->getSize() != readers[0]->getSize())
+                Log(EError, "Error: Input bitmaps have a different size!");
+            channels[i] = findChannel(readers[i], sources[i]);
+        }
+
+        const Vector2i size = readers[0]->getSize();
+        const int bandRows = std::min(size.y, MTS_JOINRGB_BAND_SIZE);
+        for (int i=0; i<3; ++i)
+            bands[i] = new Bitmap(Bitmap::EMultiChannel, Bitmap::EFloat32,
+                Vector2i(size.x, bandRows), readers[i]->getChannelCount());
+
+        std::vector<std::string> channelNames;
+        channelNames.push_back("R");
+        channelNames.push_back("G");
+        channelNames.push_back("B");
+
         ref<FileStream> outFile = new FileStream(s4, FileStream::ETruncReadWrite);
-        result->write(Bitmap::EOpenEXR, outFile);
-    }
+        ref<EXRScanlineWriter> writer = new EXRScanlineWriter(outFile, size,
+            channelNames, readers[0]->getComponentFormat(),
+            readers[0]->getMetadata());
+        ref<Bitmap> outBand = new Bitmap(Bitmap::EMultiChannel, Bitmap::EFloat32,
+            Vector2i(size.x, bandRows), 3);
+
+        ref<Timer> timer = new Timer();
+        while (writer->getPosition() < size.y) {
+            int rows = 0;
+            for (int i=0; i<3; ++i)
+                rows = readers[i]->read(bands[i]);
 
+            /* Interleave the selected channel of each input, one scanline per iteration */
+            #pragma omp parallel for schedule(static)
+            for (int y=0; y<rows; ++y) {
+                float *target = outBand->getFloat32Data() + (size_t) y * size.x * 3;
+                for (int i=0; i<3; ++i) {
+                    const int stride = bands[i]->getChannelCount();
+                    const float *source = bands[i]->getFloat32Data()
+                        + (size_t) y * size.x * stride + channels[i];
+                    for (int x=0; x<size.x; ++x)
+                        target[3*x+i] = source[stride*x];
+                }
+            }
+
+            writer->write(outBand, rows);
+        }
+        writer = NULL;
+
+        Float time = std::max((Float) 1e-3f, timer->getMilliseconds() / (Float) 1000);
+        Log(EInfo, "Joined %ix%i pixels in %.3f s (%.1f MPixel/s, %.1f MiB/s of input data)",
+            size.x, size.y, time, (Float) size.x * size.y / (time * 1e6f),
+            inputSize / (time * 1024 * 1024));
+    }
     int run(int argc, char **argv) {
         if (argc < 5) {
             cout << "Join three monochromatic images into a RGB-valued EXR file" << endl;
@@ -0,0 +1,467 @@
+/*
+    This file is part of Mitsuba, a physically based rendering system.
+
+    Copyright (c) 2007-2014 by Wenzel Jakob and others.
+
+    Mitsuba is free software; you can redistribute it and/or modify
+    it under the terms of the GNU General Public License Version 3
+    as published by the Free Software Foundation.
+
+    Mitsuba is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program. If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include <mitsuba/render/util.h>
+#include <mitsuba/render/renderjob.h>
+#include <mitsuba/core/timer.h>
+#include <mitsuba/core/fresolver.h>
+#include <mitsuba/core/fstream.h>
+#include <mitsuba/core/statistics.h>
+#include <mitsuba/core/version.h>
+#if defined(MTS_HAS_COHERENT_RT)
+#include <mitsuba/core/ray_sse.h>
+#endif
+#include <boost/algorithm/string.hpp>
+#include <fstream>
+#include <ctime>
+#if defined(WIN32)
+#include <mitsuba/core/getopt.h>
+#endif
+
+MTS_NAMESPACE_BEGIN
+
+/// Result of benchmarking a single scene
+struct BenchmarkResult {
+    std::string name, integrator, status;
+    Vector2i size;
+    size_t sampleCount;
+    Float loadTime, renderTime, samplesPerSecond, raysPerSecond;
+    Float packetTime, packetRaysPerSecond;
+    Float rmse, relativeRmse;
+    uint64_t rayCount;
+    bool hasReference;
+
+    BenchmarkResult() : size(0), sampleCount(0), loadTime(0), renderTime(0),
+        samplesPerSecond(0), raysPerSecond(0), packetTime(0),
+        packetRaysPerSecond(0), rmse(0), relativeRmse(0),
+        rayCount(0), hasReference(false) { }
+};
+
+class RBench : public Utility {
+public:
+    void help() {
+        cout << endl;
+        cout << "Synopsis: Render-time regression suite. Renders a set of small reference" << endl;
+        cout << "scenes in deterministic mode, measures the wall-clock time, the number of" << endl;
+        cout << "samples and rays per second, compares the result against stored reference images" << endl;
+        cout << "and writes a JSON report that can be compared between builds (see the" << endl;
+        cout << "script data/scripts/rbenchcompare.py)." << endl;
+        cout << endl;
+        cout << "Usage: mtsutil rbench [options] [Suite file]" << endl;
+        cout << "Options/Arguments:" << endl;
+        cout << "   -h             Display this help text" << endl << endl;
+        cout << "   -o file        Write the JSON report to 'file' (default: rbench.json)" << endl << endl;
+        cout << "   -r dir         Directory containing the reference images (default:" << endl;
+        cout << "                  the 'references' subdirectory next to the suite file)" << endl << endl;
+        cout << "   -u             Update the reference images instead of comparing to them" << endl << endl;
+        cout << "   -n count       Number of repetitions, the fastest one is reported (default: 1)" << endl << endl;
+        cout << "   -s seed        Random seed used for all scenes (default: 1)" << endl << endl;
+        cout << "   -f name        Only run scenes whose name contains 'name'" << endl << endl;
+        cout << "   -t threshold   Fail if the relative RMSE of any scene exceeds 'threshold'" << endl << endl;
+        cout << "   -p             Additionally trace the primary rays of every scene as SSE" << endl;
+        cout << "                  ray packets and report their throughput" << endl << endl;
+        cout << " The suite file lists one scene per line (relative to the suite file). When" << endl;
+        cout << " omitted, the default suite \"data/tests/bench/suite.txt\" is used." << endl << endl;
+    }
+
+    /// Return the number of rays (including shadow rays) traced so far
+    static uint64_t getRayCount() {
+        Statistics *statistics = Statistics::getInstance();
+        const StatsCounter
+            *rays = statistics->getCounter("General", "Normal rays traced"),
+            *shadowRays = statistics->getCounter("General", "Shadow rays traced");
+        return (rays ? rays->getValue() : 0)
+            + (shadowRays ? shadowRays->getValue() : 0);
+    }
+
+    /// Render a scene once and return the developed image
+    ref<Bitmap> render(Scene *scene, BenchmarkResult &result) {
+        ref<RenderQueue> queue = new RenderQueue();
+        ref<RenderJob> job = new RenderJob("rbench", scene, queue,
+            -1, -1, -1, false);
+
+        uint64_t rayCount = getRayCount();
+        ref<Timer> timer = new Timer();
+        job->start();
+        bool success = job->wait();
+        Float time = timer->getMilliseconds() / (Float) 1000;
+        queue->join();
+        rayCount = getRayCount() - rayCount;
+
+        if (!success) {
+            result.status = "failed";
+            return NULL;
+        }
+
+        if (result.renderTime == 0 || time < result.renderTime) {
+            result.renderTime = time;
+            result.rayCount = rayCount;
+        }
+
+        Film *film = scene->getFilm();
+        ref<Bitmap> bitmap = new Bitmap(Bitmap::ERGB, Bitmap::EFloat32,
+            film->getCropSize());
+        if (!film->develop(Point2i(0), film->getCropSize(), Point2i(0), bitmap)) {
+            result.status = "unsupported film";
+            return NULL;
+        }
+        return bitmap;
+    }
+
+#if defined(MTS_HAS_COHERENT_RT)
+    /**
+     * Trace one primary ray per pixel through the kd-tree of an already
+     * rendered scene using the SSE packet traversal, which none of the
+     * integrators use. The rays are generated in 8x8 pixel tiles so that
+     * the packets are coherent.
+     */
+    void tracePackets(const Scene *scene, BenchmarkResult &result) {
+        const Sensor *sensor = scene->getSensor();
+        const ShapeKDTree *kdtree = scene->getKDTree();
+        Vector2i size = scene->getFilm()->getCropSize();
+        Point2i offset = scene->getFilm()->getCropOffset();
+        const int tileSize = 8;
+
+        const size_t count = (size_t) size.x * size.y;
+        std::vector<Point2> samplePositions, apertureSamples(count, Point2(0.5f));
+        std::vector<Float> timeSamples(count, 0.5f);
+        samplePositions.reserve(count);
+        for (int ty=0; ty<size.y; ty += tileSize)
+            for (int tx=0; tx<size.x; tx += tileSize)
+                for (int y=ty; y<std::min(ty+tileSize, size.y); ++y)
+                    for (int x=tx; x<std::min(tx+tileSize, size.x); ++x)
+                        samplePositions.push_back(Point2(offset.x + x + 0.5f,
+                            offset.y + y + 0.5f));
+
+        RayBatch batch(count);
+        sensor->sampleRayBatch(batch, &samplePositions[0],
+            sensor->needsApertureSample() ? &apertureSamples[0] : NULL,
+            sensor->needsTimeSample() ? &timeSamples[0] : NULL, count);
+
+        uint8_t MM_ALIGN16 temp[4 * MTS_KD_INTERSECTION_TEMP];
+        RayPacket4 MM_ALIGN16 packet;
+        RayInterval4 MM_ALIGN16 interval;
+        Intersection4 MM_ALIGN16 its;
+        size_t packets = (count + 3) / 4, hits = 0;
+
+        /* Repeat the image often enough to get a stable timing */
+        size_t passes = std::max((size_t) 1, (size_t) 1000000 / count);
+        ref<Timer> timer = new Timer();
+        for (size_t j=0; j<passes; ++j) {
+            for (size_t i=0; i<packets; ++i) {
+                its = Intersection4();
+                if (batch.getPacket(i, packet, interval))
+                    kdtree->rayIntersectPacket(packet, interval, its, temp);
+                else
+                    kdtree->rayIntersectPacketIncoherent(packet, interval, its, temp);
+                for (int k=0; k<4 && 4*i+k < count; ++k)
+                    if (its.t.f[k] != std::numeric_limits<float>::infinity())
+                        ++hits;
+            }
+        }
+        Float time = timer->getMilliseconds() / (Float) 1000;
+        Float rate = (Float) ((double) passes * count / std::max(time, (Float) 1e-3f));
+        if (result.packetTime == 0 || time < result.packetTime) {
+            result.packetTime = time;
+            result.packetRaysPerSecond = rate;
+        }
+        Log(EDebug, "Traced " SIZE_T_FMT " passes of " SIZE_T_FMT " packets ("
+            SIZE_T_FMT " hits per pass)", passes, packets, hits / passes);
+    }
+#endif
+
+    /// Compute the RMSE (absolute and relative to the mean reference value)
+    void compare(const Bitmap *bitmap, const Bitmap *reference, BenchmarkResult &result) {
+        size_t nEntries = (size_t) bitmap->getPixelCount() * 3;
+        const float *a = bitmap->getFloat32Data(), *b = reference->getFloat32Data();
+        double error = 0, mean = 0;
+        for (size_t i=0; i<nEntries; ++i) {
+            double diff = (double) a[i] - (double) b[i];
+            error += diff * diff;
+            mean += b[i];
+        }
+        error = std::sqrt(error / nEntries);
+        mean /= nEntries;
+
+        result.rmse = (Float) error;
+        result.relativeRmse = (Float) (mean > 0 ? error / mean : 0);
+        result.hasReference = true;
+    }
+
+    void benchmark(const fs::path &scenePath, const fs::path &refDir, int iterations,
+            uint32_t seed, bool update, bool packets, BenchmarkResult &result) {
+        ref<FileResolver> fileResolver = Thread::getThread()->getFileResolver();
+        ref<FileResolver> frClone = fileResolver->clone();
+        frClone->prependPath(fs::absolute(scenePath).parent_path());
+        Thread::getThread()->setFileResolver(frClone);
+
+        ref<Bitmap> bitmap;
+        result.status = "ok";
+        for (int i=0; i<iterations && result.status == "ok"; ++i) {
+            /* Load the scene from scratch, since some integrators keep state */
+            ref<Timer> timer = new Timer();
+            ref<Scene> scene = loadScene(scenePath);
+            Float loadTime = timer->getMilliseconds() / (Float) 1000;
+            if (result.loadTime == 0 || loadTime < result.loadTime)
+                result.loadTime = loadTime;
+
+            scene->setSourceFile(scenePath);
+            scene->setDestinationFile(fs::path());
+            scene->getSampler()->setDeterministic(true, seed);
+            result.integrator = scene->getIntegrator()->getProperties().getPluginName();
+            result.size = scene->getFilm()->getCropSize();
+            result.sampleCount = scene->getSampler()->getSampleCount();
+
+            bitmap = render(scene, result);
+#if defined(MTS_HAS_COHERENT_RT)
+            if (packets && bitmap)
+                tracePackets(scene, result);
+#endif
+            Statistics::getInstance()->resetAll();
+        }
+        Thread::getThread()->setFileResolver(fileResolver);
+
+        if (!bitmap)
+            return;
+
+        result.samplesPerSecond = (Float) ((double) result.size.x * result.size.y
+            * result.sampleCount / std::max(result.renderTime, (Float) 1e-3f));
+        result.raysPerSecond = (Float) ((double) result.rayCount
+            / std::max(result.renderTime, (Float) 1e-3f));
+
+        fs::path refPath = refDir / (result.name + ".exr");
+        if (update) {
+            if (!fs::exists(refDir))
+                fs::create_directories(refDir);
+            ref<FileStream> stream = new FileStream(refPath, FileStream::ETruncReadWrite);
+            bitmap->write(Bitmap::EOpenEXR, stream);
+            Log(EInfo, "Wrote the reference image \"%s\"", refPath.string().c_str());
+        } else if (fs::exists(refPath)) {
+            ref<FileStream> stream = new FileStream(refPath, FileStream::EReadOnly);
+            ref<Bitmap> reference = new Bitmap(Bitmap::EOpenEXR, stream);
+            reference = reference->convert(Bitmap::ERGB, Bitmap::EFloat32);
+            if (reference->getSize() != bitmap->getSize()) {
+                Log(EWarn, "The reference image \"%s\" has the wrong size!",
+                    refPath.string().c_str());
+                result.status = "reference mismatch";
+                return;
+            }
+            compare(bitmap, reference, result);
+        } else {
+            Log(EWarn, "No reference image found for scene \"%s\"", result.name.c_str());
+        }
+    }
+
+    static std::string jsonString(const std::string &str) {
+        std::ostringstream oss;
+        oss << '"';
+        for (size_t i=0; i<str.length(); ++i) {
+            char c = str[i];
+            if (c == '"' || c == '\\')
+                oss << '\\' << c;
+            else if (c == '\n')
+                oss << "\\n";
+            else
+                oss << c;
+        }
+        oss << '"';
+        return oss.str();
+    }
+
+    void writeReport(std::ostream &os, const std::vector<BenchmarkResult> &results,
+            uint32_t seed, int iterations) {
+        char date[64];
+        time_t t = std::time(NULL);
+        strftime(date, sizeof(date), "%Y-%m-%dT%H:%M:%S", std::localtime(&t));
+
+        os << "{" << endl
+           << "  \"version\": " << jsonString(Version(MTS_VERSION).toStringComplete()) << "," << endl
+           << "  \"date\": " << jsonString(date) << "," << endl
+           << "  \"host\": " << jsonString(getHostName()) << "," << endl
+           << "  \"cores\": " << Scheduler::getInstance()->getCoreCount() << "," << endl
+#if defined(SINGLE_PRECISION)
+           << "  \"precision\": \"single\"," << endl
+#else
+           << "  \"precision\": \"double\"," << endl
+#endif
+           << "  \"spectrumSamples\": " << SPECTRUM_SAMPLES << "," << endl
+#if MTS_SSE
+           << "  \"sse\": true," << endl
+#else
+           << "  \"sse\": false," << endl
+#endif
+           << "  \"seed\": " << seed << "," << endl
+           << "  \"repetitions\": " << iterations << "," << endl
+           << "  \"scenes\": [" << endl;
+
+        for (size_t i=0; i<results.size(); ++i) {
+            const BenchmarkResult &r = results[i];
+            os << "    {" << endl
+               << "      \"name\": " << jsonString(r.name) << "," << endl
+               << "      \"integrator\": " << jsonString(r.integrator) << "," << endl
+               << "      \"status\": " << jsonString(r.status) << "," << endl
+               << "      \"width\": " << r.size.x << "," << endl
+               << "      \"height\": " << r.size.y << "," << endl
+               << "      \"sampleCount\": " << r.sampleCount << "," << endl
+               << "      \"loadTime\": " << r.loadTime << "," << endl
+               << "      \"renderTime\": " << r.renderTime << "," << endl
+               << "      \"samplesPerSecond\": " << r.samplesPerSecond << "," << endl
+               << "      \"rayCount\": " << r.rayCount << "," << endl
+               << "      \"raysPerSecond\": " << r.raysPerSecond << "," << endl;
+            if (r.packetRaysPerSecond > 0)
+                os << "      \"packetRaysPerSecond\": " << r.packetRaysPerSecond << "," << endl;
+            else
+                os << "      \"packetRaysPerSecond\": null," << endl;
+            if (r.hasReference)
+                os << "      \"rmse\": " << r.rmse << "," << endl
+                   << "      \"relativeRmse\": " << r.relativeRmse << endl;
+            else
+                os << "      \"rmse\": null," << endl
+                   << "      \"relativeRmse\": null" << endl;
+            os << "    }" << (i+1 < results.size() ? "," : "") << endl;
+        }
+        os << "  ]" << endl << "}" << endl;
+    }
+
+    int run(int argc, char **argv) {
+        ref<FileResolver> fileResolver = Thread::getThread()->getFileResolver();
+        int optchar, iterations = 1;
+        uint32_t seed = 1;
+        bool update = false, packets = false;
+        Float threshold = -1;
+        std::string reportFile = "rbench.json", filter;
+        fs::path refDir;
+        char *end_ptr = NULL;
+        optind = 1;
+
+        /* Parse command-line arguments */
+        while ((optchar = getopt(argc, argv, "o:r:n:s:f:t:uph")) != -1) {
+            switch (optchar) {
+                case 'h': {
+                        help();
+                        return 0;
+                    }
+                    break;
+                case 'o':
+                    reportFile = optarg;
+                    break;
+                case 'r':
+                    refDir = optarg;
+                    break;
+                case 'u':
+                    update = true;
+                    break;
+                case 'p':
+                    packets = true;
+                    break;
+                case 'n':
+                    iterations = strtol(optarg, &end_ptr, 10);
+                    if (*end_ptr != '\0' || iterations <= 0)
+                        SLog(EError, "Could not parse the repetition count!");
+                    break;
+                case 's':
+                    seed = (uint32_t) strtoul(optarg, &end_ptr, 10);
+                    if (*end_ptr != '\0')
+                        SLog(EError, "Could not parse the random seed!");
+                    break;
+                case 'f':
+                    filter = optarg;
+                    break;
+                case 't':
+                    threshold = (Float) strtod(optarg, &end_ptr);
+                    if (*end_ptr != '\0' || threshold < 0)
+                        SLog(EError, "Could not parse the error threshold!");
+                    break;
+            };
+        }
+
+        if (optind+1 < argc) {
+            help();
+            return 0;
+        }
+
+#if !defined(MTS_HAS_COHERENT_RT)
+        if (packets) {
+            Log(EWarn, "This build does not support coherent ray tracing, ignoring -p");
+            packets = false;
+        }
+#endif
+
+        fs::path suiteFile = fileResolver->resolve(optind < argc ?
+            fs::path(argv[optind]) : fs::path("data/tests/bench/suite.txt"));
+        std::ifstream is(suiteFile.string().c_str());
+        if (is.fail())
+            SLog(EError, "Could not open the suite file \"%s\"!", suiteFile.string().c_str());
+        fs::path suiteDir = fs::absolute(suiteFile).parent_path();
+        if (refDir.empty())
+            refDir = suiteDir / "references";
+
+        std::vector<BenchmarkResult> results;
+        std::string line;
+        bool failed = false;
+        while (std::getline(is, line)) {
+            boost::trim(line);
+            if (line.empty() || line[0] == '#')
+                continue;
+
+            BenchmarkResult result;
+            fs::path scenePath = suiteDir / line;
+            result.name = scenePath.stem().string();
+            if (!filter.empty() && result.name.find(filter) == std::string::npos)
+                continue;
+
+            Log(EInfo, "Benchmarking \"%s\" ..", result.name.c_str());
+            try {
+                benchmark(scenePath, refDir, iterations, seed, update, packets, result);
+            } catch (const std::exception &e) {
+                Log(EWarn, "Scene \"%s\" failed: %s", result.name.c_str(), e.what());
+                result.status = "failed";
+            }
+
+            if (result.status != "ok") {
+                failed = true;
+            } else {
+                Log(EInfo, "%s: %.3f s, %.2f MSamples/s, %.2f MRays/s, relative RMSE %s",
+                    result.name.c_str(), result.renderTime, result.samplesPerSecond * 1e-6f,
+                    result.raysPerSecond * 1e-6f,
+                    result.hasReference ? formatString("%.5f", result.relativeRmse).c_str() : "n/a");
+                if (result.packetRaysPerSecond > 0)
+                    Log(EInfo, "%s: packet tracing of the primary rays at %.2f MRays/s",
+                        result.name.c_str(), result.packetRaysPerSecond * 1e-6f);
+                if (threshold >= 0 && result.hasReference && result.relativeRmse > threshold) {
+                    Log(EWarn, "Scene \"%s\" exceeds the error threshold!", result.name.c_str());
+                    failed = true;
+                }
+            }
+            results.push_back(result);
+        }
+
+        std::ofstream os(reportFile.c_str());
+        if (os.fail())
+            SLog(EError, "Could not write the report \"%s\"!", reportFile.c_str());
+        writeReport(os, results, seed, iterations);
+        Log(EInfo, "Wrote the benchmark report \"%s\"", reportFile.c_str());
+
+        return failed ? -1 : 0;
+    }
+
+    MTS_DECLARE_UTILITY()
+};
+
+MTS_EXPORT_UTILITY(RBench, "Render-time regression suite")
+MTS_NAMESPACE_END
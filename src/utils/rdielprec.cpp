@@ -37,28 +37,26 @@
 
 MTS_NAMESPACE_BEGIN
 
-void transmittanceIntegrand(const BSDF *bsdf, const Vector &wi, size_t nPts, const Float *in, Float *out) {
+/* Both integrands are evaluated concurrently by NDIntegrator::integrateParallel()
+   and therefore must not throw exceptions */
+void transmittanceIntegrand(const BSDF *bsdf, const Vector &wi, const Float *in, Float *out) {
     Intersection its;
-
-    #pragma omp parallel for
-    for (int i=0; i<(int) nPts; ++i) {
-        BSDFSamplingRecord bRec(its, wi, Vector(), EImportance);
-        bRec.typeMask = BSDF::ETransmission;
-        Point2 sample(in[2*i], in[2*i+1]);
-        if (sample.x == 1)
-            sample.x = 1-Epsilon;
-        if (sample.y == 1)
-            sample.y = 1-Epsilon;
-        out[i] = bsdf->sample(bRec, sample)[0];
-        if (std::isnan(out[i]))
-            SLog(EError, "%s\n\nNaN!", bRec.toString().c_str());
+    BSDFSamplingRecord bRec(its, wi, Vector(), EImportance);
+    bRec.typeMask = BSDF::ETransmission;
+    Point2 sample(in[0], in[1]);
+    if (sample.x == 1)
+        sample.x = 1-Epsilon;
+    if (sample.y == 1)
+        sample.y = 1-Epsilon;
+    out[0] = bsdf->sample(bRec, sample)[0];
+    if (std::isnan(out[0])) {
+        SLog(EWarn, "%s\n\nNaN!", bRec.toString().c_str());
+        out[0] = 0;
     }
 }
 
-void diffTransmittanceIntegrand(Float *data, size_t resolution, size_t nPts, const Float *in, Float *out) {
-    #pragma omp parallel for
-    for (int i=0; i<(int) nPts; ++i)
-        out[i] = 2 * in[i] * interpCubic1D(std::pow(in[i], (Float) 0.25f), data, 0, 1, resolution);
+void diffTransmittanceIntegrand(Float *data, size_t resolution, const Float *in, Float *out) {
+    out[0] = 2 * in[0] * interpCubic1D(std::pow(in[0], (Float) 0.25f), data, 0, 1, resolution);
 }
 
 class PrecomputeTransmittance : public Utility {
@@ -95,14 +93,14 @@ public:
             Vector wi(math::safe_sqrt(1-cosTheta*cosTheta), 0, cosTheta);
 
             Float min[2] = {0, 0}, max[2] = {1, 1};
-            intTransmittance.integrateVectorized(
-                boost::bind(&transmittanceIntegrand, bsdf, wi, _1, _2, _3),
+            intTransmittance.integrateParallel(
+                boost::bind(&transmittanceIntegrand, bsdf, wi, _1, _2),
                 min, max, &transmittances[i], &error, NULL);
         }
 
         Float min[1] = { 0 }, max[1] = { 1 };
-        intDiffTransmittance.integrateVectorized(
-            boost::bind(&diffTransmittanceIntegrand, transmittances, resolution, _1, _2, _3),
+        intDiffTransmittance.integrateParallel(
+            boost::bind(&diffTransmittanceIntegrand, transmittances, resolution, _1, _2),
             min, max, &diffTrans, &error, NULL);
 
         if (alpha == 0.0f)
@@ -0,0 +1,769 @@
+/*
+    This file is part of Mitsuba, a physically based rendering system.
+
+    Copyright (c) 2007-2014 by Wenzel Jakob and others.
+
+    Mitsuba is free software; you can redistribute it and/or modify
+    it under the terms of the GNU General Public License Version 3
+    as published by the Free Software Foundation.
+
+    Mitsuba is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program. If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#if defined(Assert)
+# undef Assert
+#endif
+#include <mitsuba/render/util.h>
+#include <mitsuba/render/renderjob.h>
+#include <mitsuba/render/renderqueue.h>
+#include <mitsuba/render/scenehandler.h>
+#include <mitsuba/core/sched_remote.h>
+#include <mitsuba/core/sstream.h>
+#include <mitsuba/core/mstream.h>
+#include <mitsuba/core/fresolver.h>
+#include <mitsuba/core/bitmap.h>
+#include <mitsuba/core/timer.h>
+#include <mitsuba/core/statistics.h>
+#include <boost/algorithm/string.hpp>
+#include <list>
+
+#if defined(__WINDOWS__)
+#include <mitsuba/core/getopt.h>
+#include <ws2tcpip.h>
+#else
+#include <unistd.h>
+#include <errno.h>
+#include <sys/types.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <netinet/in.h>
+#include <netdb.h>
+#include <signal.h>
+#define INVALID_SOCKET -1
+#define SOCKET int
+#define closesocket close
+#endif
+
+/* Default TCP port of the render service (one above the mtssrv port) */
+#define MTS_RENDERD_DEFAULT_PORT (MTS_DEFAULT_PORT + 1)
+
+/* How many clients are allowed to wait for a connection at a time */
+#define CONN_BACKLOG 5
+
+/* How many finished jobs are remembered for status queries */
+#define MTS_RENDERD_JOB_HISTORY 100
+
+MTS_NAMESPACE_BEGIN
+
+/// Bookkeeping information about a job that was submitted to the service
+class ServiceJob : public Object {
+public:
+    enum EState {
+        EQueued = 0,
+        ELoading,
+        ERendering,
+        EFinished,
+        EFailed,
+        ECancelled
+    };
+
+    int id, priority;
+    fs::path filename, destination;
+    SceneHandler::ParameterMap params;
+    EState state;
+    std::string error;
+    ref<Scene> scene;
+    ref<RenderJob> renderJob;
+    int blocksDone, blocksTotal;
+    Float renderTime;
+    bool cancelRequested;
+
+    ServiceJob(int id, int priority) : id(id), priority(priority),
+        state(EQueued), blocksDone(0), blocksTotal(0), renderTime(0),
+        cancelRequested(false) { }
+
+    inline bool isDone() const { return state >= EFinished; }
+
+    static const char *getStateName(EState state) {
+        switch (state) {
+            case EQueued: return "queued";
+            case ELoading: return "loading";
+            case ERendering: return "rendering";
+            case EFinished: return "finished";
+            case EFailed: return "failed";
+            case ECancelled: return "cancelled";
+            default: return "unknown";
+        }
+    }
+
+    MTS_DECLARE_CLASS()
+protected:
+    virtual ~ServiceJob() { }
+};
+
+/**
+ * Job queue of the render service. Submitted jobs are rendered one at a time
+ * in the order of their priority (each job is parallelized over all workers
+ * of the scheduler). All scenes are loaded through a shared object cache and
+ * the most recently rendered ones are kept in memory, hence resubmitting a
+ * scene only pays for parsing the XML description and for the resources
+ * that have actually changed; the kd-tree is reused when the geometry is
+ * unchanged. Only the most recent finished jobs can be queried.
+ */
+class RenderService : public RenderListener {
+public:
+    RenderService(size_t warmScenes, int blockSize) : m_warmScenes(warmScenes),
+            m_blockSize(blockSize), m_nextID(1), m_loadCount(0), m_running(true) {
+        m_mutex = new Mutex();
+        m_cond = new ConditionVariable(m_mutex);
+        m_cache = new SceneObjectCache();
+        m_queue = new RenderQueue();
+        m_queue->registerListener(this);
+        m_resolver = Thread::getThread()->getFileResolver();
+    }
+
+    /// Enqueue a new job and return its ID
+    int submit(int priority, const fs::path &filename, const fs::path &destination,
+            const SceneHandler::ParameterMap &params) {
+        LockGuard lock(m_mutex);
+        ref<ServiceJob> job = new ServiceJob(m_nextID++, priority);
+        job->filename = m_resolver->resolve(filename);
+        job->destination = destination;
+        job->params = params;
+        m_jobs[job->id] = job;
+        m_pending.push_back(job);
+        m_cond->broadcast();
+        Log(EInfo, "Job %i: queued \"%s\" with priority %i", job->id,
+            job->filename.string().c_str(), priority);
+        return job->id;
+    }
+
+    /// Return a one-line status report of a job
+    std::string getStatus(int id) {
+        LockGuard lock(m_mutex);
+        return statusString(findJob(id));
+    }
+
+    /// Return status reports of all known jobs
+    std::vector<std::string> getStatusList() {
+        LockGuard lock(m_mutex);
+        std::vector<std::string> result;
+        for (std::map<int, ref<ServiceJob> >::const_iterator it = m_jobs.begin();
+                it != m_jobs.end(); ++it)
+            result.push_back(statusString(it->second.get()));
+        return result;
+    }
+
+    /// Check whether a job has finished (successfully or not)
+    bool isDone(int id) {
+        LockGuard lock(m_mutex);
+        return findJob(id)->isDone();
+    }
+
+    /// Cancel a queued or running job
+    void cancel(int id) {
+        ref<RenderJob> renderJob;
+        {
+            LockGuard lock(m_mutex);
+            ServiceJob *job = findJob(id);
+            if (job->isDone())
+                return;
+            job->cancelRequested = true;
+            if (job->state == ServiceJob::EQueued) {
+                removePending(job);
+                job->state = ServiceJob::ECancelled;
+                pruneJobs();
+                m_cond->broadcast();
+            }
+            renderJob = job->renderJob;
+        }
+        /* Cancel without holding the lock, since workers report to the listener */
+        if (renderJob)
+            renderJob->cancel();
+    }
+
+    /// Develop the partially rendered image of a running job
+    ref<Bitmap> preview(int id) {
+        ref<Scene> scene;
+        {
+            LockGuard lock(m_mutex);
+            ServiceJob *job = findJob(id);
+            if (job->state != ServiceJob::ERendering)
+                Log(EError, "Job %i is %s, a preview is only available while "
+                    "it is being rendered", id, ServiceJob::getStateName(job->state));
+            scene = job->scene;
+        }
+        Film *film = scene->getFilm();
+        ref<Bitmap> bitmap = new Bitmap(Bitmap::ERGBA, Bitmap::EFloat32,
+            film->getCropSize());
+        if (!film->develop(Point2i(0), bitmap->getSize(), Point2i(0), bitmap))
+            Log(EError, "Job %i: the film does not support previews", id);
+        return bitmap;
+    }
+
+    /// Release all cached scenes and resources
+    void flush() {
+        LockGuard lock(m_mutex);
+        m_warm.clear();
+        m_cache->clear();
+        m_loadCount = 0;
+    }
+
+    /// Return a summary of the service state
+    std::string getStats() {
+        LockGuard lock(m_mutex);
+        return formatString("stats %i %i " SIZE_T_FMT " " SIZE_T_FMT,
+            (int) m_pending.size(), (int) m_warm.size(),
+            m_cache->getHitCount(), m_cache->getMissCount());
+    }
+
+    /// Stop the dispatcher and cancel the current job
+    void shutdown() {
+        std::vector<int> ids;
+        {
+            LockGuard lock(m_mutex);
+            m_running = false;
+            for (std::map<int, ref<ServiceJob> >::iterator it = m_jobs.begin();
+                    it != m_jobs.end(); ++it)
+                ids.push_back(it->first);
+            m_cond->broadcast();
+        }
+        for (size_t i=0; i<ids.size(); ++i)
+            cancel(ids[i]);
+    }
+
+    inline bool isRunning() const { return m_running; }
+
+    /// Main loop of the dispatcher thread
+    void dispatch() {
+        while (true) {
+            ref<ServiceJob> job;
+            {
+                LockGuard lock(m_mutex);
+                while (m_running && m_pending.empty())
+                    m_cond->wait();
+                if (!m_running)
+                    break;
+                job = m_pending.front();
+                for (size_t i=1; i<m_pending.size(); ++i) {
+                    if (m_pending[i]->priority > job->priority)
+                        job = m_pending[i];
+                }
+                removePending(job);
+                job->state = ServiceJob::ELoading;
+            }
+
+            try {
+                ref<Scene> scene = load(job);
+                ref<RenderJob> renderJob = new RenderJob(
+                    formatString("ren%i", job->id), scene, m_queue,
+                    -1, -1, -1, false, false);
+                {
+                    LockGuard lock(m_mutex);
+                    /* There is nothing to cancel yet if this was requested
+                       while loading, hence don't start rendering at all */
+                    if (job->cancelRequested) {
+                        job->state = ServiceJob::ECancelled;
+                        pruneJobs();
+                        m_cond->broadcast();
+                        continue;
+                    }
+                    job->scene = scene;
+                    job->renderJob = renderJob;
+                    job->state = ServiceJob::ERendering;
+                }
+                Log(EInfo, "Job %i: rendering \"%s\" ..", job->id,
+                    job->filename.string().c_str());
+                renderJob->start();
+                bool success = renderJob->wait();
+                m_queue->waitLeft(0);
+
+                LockGuard lock(m_mutex);
+                job->state = success ? ServiceJob::EFinished : (job->cancelRequested
+                    ? ServiceJob::ECancelled : ServiceJob::EFailed);
+                if (!success && !job->cancelRequested)
+                    job->error = "rendering did not complete successfully";
+                job->renderJob = NULL;
+                job->scene = NULL;
+                pruneJobs();
+            } catch (const std::exception &e) {
+                LockGuard lock(m_mutex);
+                job->state = ServiceJob::EFailed;
+                job->error = e.what();
+                job->renderJob = NULL;
+                job->scene = NULL;
+                pruneJobs();
+                Log(EWarn, "Job %i failed: %s", job->id, e.what());
+            }
+            m_cond->broadcast();
+        }
+    }
+
+    /* RenderListener interface */
+    void workEndEvent(const RenderJob *renderJob, const ImageBlock *wr, bool cancelled) {
+        LockGuard lock(m_mutex);
+        ServiceJob *job = findRunningJob(renderJob);
+        if (job && !cancelled)
+            ++job->blocksDone;
+    }
+
+    void finishJobEvent(const RenderJob *renderJob, bool cancelled) {
+        LockGuard lock(m_mutex);
+        ServiceJob *job = findRunningJob(renderJob);
+        if (job)
+            job->renderTime = renderJob->getRenderTime();
+    }
+
+    MTS_DECLARE_CLASS()
+protected:
+    virtual ~RenderService() {
+        m_queue->unregisterListener(this);
+    }
+
+    /// Load the scene of a job, reusing cached resources when possible
+    ref<Scene> load(ServiceJob *job) {
+        ref<FileResolver> resolver = m_resolver->clone();
+        resolver->prependPath(fs::absolute(job->filename).parent_path());
+        Thread::getThread()->setFileResolver(resolver);
+
+        ref<Timer> timer = new Timer();
+        ref<Scene> scene = SceneHandler::loadScene(job->filename, job->params, m_cache);
+        scene->setSourceFile(job->filename);
+        scene->setDestinationFile(job->destination);
+        scene->setBlockSize(m_blockSize);
+
+        LockGuard lock(m_mutex);
+        /* Look for a warm scene with the same geometry */
+        for (std::list<ref<Scene> >::iterator it = m_warm.begin(); it != m_warm.end(); ++it) {
+            if ((*it)->getSourceFile() == job->filename) {
+                if (scene->reuseKDTree(*it))
+                    Log(EInfo, "Job %i: geometry is unchanged, reusing the kd-tree", job->id);
+                m_warm.erase(it);
+                break;
+            }
+        }
+        m_warm.push_front(scene);
+        if (m_warm.size() > m_warmScenes)
+            m_warm.pop_back();
+
+        /* Drop cached objects that were not needed by any of the last few loads */
+        if (++m_loadCount >= m_warmScenes) {
+            m_cache->purge();
+            m_loadCount = 0;
+        }
+
+        Vector2i size = scene->getFilm()->getCropSize();
+        int bs = (int) m_blockSize;
+        job->blocksTotal = ((size.x + bs - 1) / bs) * ((size.y + bs - 1) / bs);
+
+        Log(EInfo, "Job %i: loaded \"%s\" in %i ms (object cache: " SIZE_T_FMT
+            " hits, " SIZE_T_FMT " misses)", job->id, job->filename.string().c_str(),
+            timer->getMilliseconds(), m_cache->getHitCount(), m_cache->getMissCount());
+        return scene;
+    }
+
+    ServiceJob *findJob(int id) {
+        std::map<int, ref<ServiceJob> >::iterator it = m_jobs.find(id);
+        if (it == m_jobs.end())
+            Log(EError, "Unknown job %i", id);
+        return it->second;
+    }
+
+    ServiceJob *findRunningJob(const RenderJob *renderJob) {
+        for (std::map<int, ref<ServiceJob> >::iterator it = m_jobs.begin();
+                it != m_jobs.end(); ++it) {
+            if (it->second->renderJob.get() == renderJob)
+                return it->second;
+        }
+        return NULL;
+    }
+
+    /// Forget the oldest finished jobs (the lock must be held)
+    void pruneJobs() {
+        size_t finished = 0;
+        for (std::map<int, ref<ServiceJob> >::iterator it = m_jobs.begin();
+                it != m_jobs.end(); ++it) {
+            if (it->second->isDone())
+                ++finished;
+        }
+
+        std::map<int, ref<ServiceJob> >::iterator it = m_jobs.begin();
+        while (finished > MTS_RENDERD_JOB_HISTORY && it != m_jobs.end()) {
+            if (it->second->isDone()) {
+                m_jobs.erase(it++);
+                --finished;
+            } else {
+                ++it;
+            }
+        }
+    }
+
+    void removePending(ServiceJob *job) {
+        for (std::vector<ref<ServiceJob> >::iterator it = m_pending.begin();
+                it != m_pending.end(); ++it) {
+            if (it->get() == job) {
+                m_pending.erase(it);
+                break;
+            }
+        }
+    }
+
+    static std::string statusString(const ServiceJob *job) {
+        std::string result = formatString("status %i %s %i %i %.3f", job->id,
+            ServiceJob::getStateName(job->state), job->blocksDone,
+            job->blocksTotal, job->renderTime);
+        if (!job->error.empty())
+            result += " " + job->error;
+        return result;
+    }
+
+private:
+    ref<Mutex> m_mutex;
+    ref<ConditionVariable> m_cond;
+    ref<SceneObjectCache> m_cache;
+    ref<RenderQueue> m_queue;
+    ref<FileResolver> m_resolver;
+    std::map<int, ref<ServiceJob> > m_jobs;
+    std::vector<ref<ServiceJob> > m_pending;
+    std::list<ref<Scene> > m_warm;
+    size_t m_warmScenes;
+    uint32_t m_blockSize;
+    int m_nextID;
+    size_t m_loadCount;
+    bool m_running;
+};
+
+/// Runs the dispatch loop of the render service
+class DispatchThread : public Thread {
+public:
+    DispatchThread(RenderService *service) : Thread("disp"), m_service(service) { }
+
+    void run() {
+        m_service->dispatch();
+    }
+private:
+    ref<RenderService> m_service;
+};
+
+/**
+ * Serves the commands of a single client. The protocol is line-based; every
+ * command is answered with one or more lines, and errors are reported as
+ * "error <message>".
+ */
+class ServiceConnection : public Thread {
+public:
+    ServiceConnection(const std::string &name, RenderService *service,
+            Stream *stream, SOCKET listenSocket) : Thread(name),
+            m_service(service), m_stream(stream), m_listenSocket(listenSocket) {
+        setCritical(false);
+    }
+
+    void run() {
+        try {
+            while (m_service->isRunning()) {
+                std::string line = boost::trim_copy(m_stream->readLine());
+                if (line.empty())
+                    continue;
+                std::vector<std::string> args = tokenize(line, " \t");
+                std::string command = boost::to_lower_copy(args[0]);
+                if (command == "quit")
+                    break;
+                try {
+                    if (!handle(command, args))
+                        break;
+                } catch (const std::exception &e) {
+                    m_stream->writeLine(std::string("error ") + e.what());
+                }
+                m_stream->flush();
+            }
+        } catch (const std::exception &) {
+            /* The connection was closed by the client */
+        }
+        Log(EDebug, "Closing connection to %s", m_stream->toString().c_str());
+    }
+
+protected:
+    int parseID(const std::vector<std::string> &args) {
+        char *end_ptr = NULL;
+        if (args.size() != 2)
+            Log(EError, "Expected a job ID");
+        int id = strtol(args[1].c_str(), &end_ptr, 10);
+        if (*end_ptr != '\0')
+            Log(EError, "Could not parse the job ID");
+        return id;
+    }
+
+    bool handle(const std::string &command, const std::vector<std::string> &args) {
+        if (command == "submit") {
+            if (args.size() < 4)
+                Log(EError, "Syntax: submit <priority> <scene.xml> <destination> [name=value ..]");
+            char *end_ptr = NULL;
+            int priority = strtol(args[1].c_str(), &end_ptr, 10);
+            if (*end_ptr != '\0')
+                Log(EError, "Could not parse the priority");
+            SceneHandler::ParameterMap params;
+            for (size_t i=4; i<args.size(); ++i) {
+                std::vector<std::string> param = tokenize(args[i], "=");
+                if (param.size() != 2)
+                    Log(EError, "Invalid parameter specification \"%s\"", args[i].c_str());
+                params[param[0]] = param[1];
+            }
+            int id = m_service->submit(priority, args[2], args[3], params);
+            m_stream->writeLine(formatString("ok %i", id));
+        } else if (command == "status") {
+            m_stream->writeLine(m_service->getStatus(parseID(args)));
+        } else if (command == "list") {
+            std::vector<std::string> status = m_service->getStatusList();
+            for (size_t i=0; i<status.size(); ++i)
+                m_stream->writeLine(status[i]);
+            m_stream->writeLine("end");
+        } else if (command == "wait") {
+            /* Stream progress updates until the job is done */
+            int id = parseID(args);
+            std::string last;
+            while (!m_service->isDone(id) && m_service->isRunning()) {
+                std::string status = m_service->getStatus(id);
+                if (status != last) {
+                    m_stream->writeLine("progress" + status.substr(6));
+                    m_stream->flush();
+                    last = status;
+                }
+                Thread::sleep(500);
+            }
+            m_stream->writeLine(m_service->getStatus(id));
+        } else if (command == "cancel") {
+            m_service->cancel(parseID(args));
+            m_stream->writeLine("ok");
+        } else if (command == "preview") {
+            /* Send the partially rendered image as an OpenEXR file */
+            int id = parseID(args);
+            ref<Bitmap> bitmap = m_service->preview(id);
+            ref<MemoryStream> mstream = new MemoryStream();
+            bitmap->write(Bitmap::EOpenEXR, mstream);
+            m_stream->writeLine(formatString("image %i " SIZE_T_FMT, id, mstream->getSize()));
+            m_stream->write(mstream->getData(), mstream->getSize());
+        } else if (command == "stats") {
+            m_stream->writeLine(m_service->getStats());
+        } else if (command == "memory") {
+            Statistics *stats = Statistics::getInstance();
+            std::vector<const MemoryCounter *> counters = stats->getMemoryCounters();
+            counters.push_back(stats->getTotalMemory());
+            for (size_t i=0; i<counters.size(); ++i)
+                m_stream->writeLine(formatString("memory %llu %llu %s",
+                    (unsigned long long) counters[i]->getCurrent(),
+                    (unsigned long long) counters[i]->getPeak(),
+                    counters[i]->getName().c_str()));
+            m_stream->writeLine("end");
+        } else if (command == "flush") {
+            m_service->flush();
+            m_stream->writeLine("ok");
+        } else if (command == "shutdown") {
+            m_stream->writeLine("ok");
+            m_stream->flush();
+            m_service->shutdown();
+            /* Wake up the accept() call of the main thread */
+#if defined(__WINDOWS__)
+            closesocket(m_listenSocket);
+#else
+            ::shutdown(m_listenSocket, SHUT_RDWR);
+#endif
+            return false;
+        } else {
+            Log(EError, "Unknown command \"%s\"", command.c_str());
+        }
+        return true;
+    }
+
+private:
+    ref<RenderService> m_service;
+    ref<Stream> m_stream;
+    SOCKET m_listenSocket;
+};
+
+class RenderDaemon : public Utility {
+public:
+    void help() {
+        cout << endl;
+        cout << "Synopsis: Headless render service. Accepts render jobs over a local socket," << endl;
+        cout << "keeps recently used scenes and their resources in memory, and renders the" << endl;
+        cout << "jobs in the order of their priority." << endl;
+        cout << endl;
+        cout << "Usage: mtsutil renderd [options]" << endl;
+        cout << "Options/Arguments:" << endl;
+        cout << "   -h             Display this help text" << endl << endl;
+        cout << "   -l port        Listen on a TCP port of the loopback interface (default: "
+             << MTS_RENDERD_DEFAULT_PORT << ")" << endl << endl;
+#if !defined(__WINDOWS__)
+        cout << "   -u path        Listen on a UNIX domain socket instead" << endl << endl;
+#endif
+        cout << "   -k count       Number of recently used scenes kept in memory (default: 4)" << endl << endl;
+        cout << "   -b res         Specify the block resolution used to split images into parallel" << endl;
+        cout << "                  workloads (default: 32). Only applies to some integrators." << endl << endl;
+        cout << "Protocol (one command per line):" << endl;
+        cout << "   submit <priority> <scene.xml> <destination> [name=value ..]" << endl;
+        cout << "                  Queue a job, answers \"ok <id>\". Jobs with a higher priority" << endl;
+        cout << "                  are started first." << endl;
+        cout << "   status <id>    Answers \"status <id> <state> <blocks done> <blocks total> <time>\"" << endl;
+        cout << "   list           Status of all jobs, terminated by \"end\"" << endl;
+        cout << "   wait <id>      Stream \"progress\" lines until the job is done, then its status" << endl;
+        cout << "   cancel <id>    Cancel a queued or running job" << endl;
+        cout << "   preview <id>   Answers \"image <id> <bytes>\" followed by the partially" << endl;
+        cout << "                  rendered image in OpenEXR format" << endl;
+        cout << "   stats          Answers \"stats <queued> <warm scenes> <cache hits> <cache misses>\"" << endl;
+        cout << "   memory         Current and peak memory usage per subsystem as lines of the" << endl;
+        cout << "                  form \"memory <current> <peak> <name>\", terminated by \"end\"" << endl;
+        cout << "   flush          Release all cached scenes and resources" << endl;
+        cout << "   quit           Close the connection" << endl;
+        cout << "   shutdown       Cancel the current job and stop the service" << endl << endl;
+    }
+
+    int run(int argc, char **argv) {
+        int optchar, listenPort = MTS_RENDERD_DEFAULT_PORT, warmScenes = 4, blockSize = 32;
+        std::string socketPath;
+        char *end_ptr = NULL;
+        optind = 1;
+
+        /* Parse command-line arguments */
+        while ((optchar = getopt(argc, argv, "l:u:k:b:h")) != -1) {
+            switch (optchar) {
+                case 'h': {
+                        help();
+                        return 0;
+                    }
+                    break;
+                case 'l':
+                    listenPort = strtol(optarg, &end_ptr, 10);
+                    if (*end_ptr != '\0')
+                        Log(EError, "Could not parse the port number");
+                    break;
+                case 'u':
+                    socketPath = optarg;
+                    break;
+                case 'k':
+                    warmScenes = strtol(optarg, &end_ptr, 10);
+                    if (*end_ptr != '\0' || warmScenes < 1)
+                        Log(EError, "Could not parse the scene count");
+                    break;
+                case 'b':
+                    blockSize = strtol(optarg, &end_ptr, 10);
+                    if (*end_ptr != '\0' || blockSize <= 0)
+                        Log(EError, "Could not parse the block size!");
+                    break;
+            };
+        }
+
+        SOCKET sock = listenSocket(listenPort, socketPath);
+
+        ref<RenderService> service = new RenderService(warmScenes, blockSize);
+        ref<DispatchThread> dispatcher = new DispatchThread(service);
+        dispatcher->start();
+
+        int connectionIndex = 0;
+        while (service->isRunning()) {
+            SOCKET newSocket = accept(sock, NULL, NULL);
+            if (newSocket == INVALID_SOCKET) {
+                if (!service->isRunning())
+                    break;
+#if !defined(__WINDOWS__)
+                if (errno == EINTR)
+                    continue;
+#endif
+                SocketStream::handleError("none", "accept", EWarn);
+                continue;
+            }
+
+            ref<ServiceConnection> connection = new ServiceConnection(
+                formatString("con%i", connectionIndex++), service,
+                new SocketStream(newSocket), sock);
+            connection->start();
+        }
+
+        Log(EInfo, "Shutting down the render service ..");
+        closesocket(sock);
+#if !defined(__WINDOWS__)
+        if (!socketPath.empty())
+            unlink(socketPath.c_str());
+#endif
+        dispatcher->join();
+        return 0;
+    }
+
+protected:
+    /// Create a socket that listens on the loopback interface or a UNIX domain socket
+    SOCKET listenSocket(int listenPort, const std::string &socketPath) {
+        SOCKET sock = INVALID_SOCKET;
+#if !defined(__WINDOWS__)
+        /* Ignore SIGPIPE (raised when clients disconnect during a reply) */
+        signal(SIGPIPE, SIG_IGN);
+
+        if (!socketPath.empty()) {
+            struct sockaddr_un addr;
+            memset(&addr, 0, sizeof(addr));
+            addr.sun_family = AF_UNIX;
+            if (socketPath.length() >= sizeof(addr.sun_path))
+                Log(EError, "The socket path \"%s\" is too long!", socketPath.c_str());
+            strncpy(addr.sun_path, socketPath.c_str(), sizeof(addr.sun_path) - 1);
+            unlink(socketPath.c_str());
+
+            sock = socket(AF_UNIX, SOCK_STREAM, 0);
+            if (sock == INVALID_SOCKET)
+                SocketStream::handleError("none", "socket");
+            if (bind(sock, (struct sockaddr *) &addr, sizeof(addr)) == -1)
+                SocketStream::handleError("none", formatString("bind(%s)", socketPath.c_str()));
+            if (listen(sock, CONN_BACKLOG) == -1)
+                SocketStream::handleError("none", "listen");
+            Log(EInfo, "Render service listening on \"%s\"", socketPath.c_str());
+            return sock;
+        }
+#endif
+        struct addrinfo hints, *servinfo, *p = NULL;
+        memset(&hints, 0, sizeof(struct addrinfo));
+        hints.ai_family = AF_UNSPEC;
+        hints.ai_socktype = SOCK_STREAM;
+        char portName[8];
+        int rv, one = 1;
+
+        /* Only accept connections from the local machine */
+        snprintf(portName, sizeof(portName), "%i", listenPort);
+        if ((rv = getaddrinfo("localhost", portName, &hints, &servinfo)) != 0)
+            Log(EError, "Error in getaddrinfo(localhost:%i): %s", listenPort, gai_strerror(rv));
+
+        for (p = servinfo; p != NULL; p = p->ai_next) {
+            sock = socket(p->ai_family, p->ai_socktype, p->ai_protocol);
+            if (sock == INVALID_SOCKET)
+                SocketStream::handleError("none", "socket");
+
+            /* Avoid "bind: socket already in use" */
+            if (setsockopt(sock, SOL_SOCKET, SO_REUSEADDR, (char *) &one, sizeof(int)) < 0)
+                SocketStream::handleError("none", "setsockopt");
+
+            if (bind(sock, p->ai_addr, (socklen_t) p->ai_addrlen) == -1) {
+                SocketStream::handleError("none", formatString("bind(localhost:%i)", listenPort), EWarn);
+                closesocket(sock);
+                continue;
+            }
+            break;
+        }
+        freeaddrinfo(servinfo);
+
+        if (p == NULL)
+            Log(EError, "Failed to bind to port %i!", listenPort);
+        if (listen(sock, CONN_BACKLOG) == -1)
+            SocketStream::handleError("none", "listen");
+        Log(EInfo, "Render service listening on localhost:%i", listenPort);
+        return sock;
+    }
+
+    MTS_DECLARE_UTILITY()
+};
+
+MTS_IMPLEMENT_CLASS(ServiceJob, false, Object)
+MTS_IMPLEMENT_CLASS(RenderService, false, RenderListener)
+MTS_EXPORT_UTILITY(RenderDaemon, "Headless render service with a job queue")
+MTS_NAMESPACE_END
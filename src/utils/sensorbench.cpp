@@ -0,0 +1,248 @@
+/*
+    This file is part of Mitsuba, a physically based rendering system.
+
+    Copyright (c) 2007-2014 by Wenzel Jakob and others.
+
+    Mitsuba is free software; you can redistribute it and/or modify
+    it under the terms of the GNU General Public License Version 3
+    as published by the Free Software Foundation.
+
+    Mitsuba is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program. If not, see <http://www.gnu.org/licenses/>.
+*/
+
+
+#include <mitsuba/render/util.h>
+#include <mitsuba/render/scene.h>
+#include <mitsuba/core/timer.h>
+#include <mitsuba/core/fresolver.h>
+#include <mitsuba/core/plugin.h>
+#if defined(MTS_HAS_COHERENT_RT)
+#include <mitsuba/core/ray_sse.h>
+#endif
+#if defined(WIN32)
+#include <mitsuba/core/getopt.h>
+#endif
+
+MTS_NAMESPACE_BEGIN
+
+class SensorBench : public Utility {
+public:
+    void help() {
+        cout << endl;
+        cout << "Synopsis: Primary ray generation benchmark. Generates the camera rays of" << endl;
+        cout << "a number of image blocks, both one at a time and using the batched" << endl;
+        cout << "interface of the sensor, and reports the resulting number of primary rays" << endl;
+        cout << "per second. When a scene is specified, its sensor is benchmarked and the" << endl;
+        cout << "rays are additionally traced through the scene (using ray packets in the" << endl;
+        cout << "batched case). Otherwise, the perspective, thinlens and perspective_rdist" << endl;
+        cout << "sensors are compared using their default parameters." << endl;
+        cout << endl;
+        cout << "Usage: mtsutil sensorbench [options] [Scene XML file]" << endl;
+        cout << "Options/Arguments:" << endl;
+        cout << "   -h             Display this help text" << endl << endl;
+        cout << "   -n count       Number of rays per measurement (default: 4194304)" << endl << endl;
+        cout << "   -b size        Side length of the image blocks (default: 32)" << endl << endl;
+        cout << "   -s count       Samples per pixel (default: 4)" << endl << endl;
+    }
+
+    int run(int argc, char **argv) {
+        ref<FileResolver> fileResolver = Thread::getThread()->getFileResolver();
+        int optchar;
+        char *end_ptr = NULL;
+        size_t rayCount = 4194304;
+        int blockSize = 32, sampleCount = 4;
+        optind = 1;
+
+        /* Parse command-line arguments */
+        while ((optchar = getopt(argc, argv, "n:b:s:h")) != -1) {
+            switch (optchar) {
+                case 'h': {
+                        help();
+                        return 0;
+                    }
+                    break;
+                case 'n':
+                    rayCount = (size_t) strtoul(optarg, &end_ptr, 10);
+                    if (*end_ptr != '\0')
+                        SLog(EError, "Could not parse the ray count!");
+                    break;
+                case 'b':
+                    blockSize = strtol(optarg, &end_ptr, 10);
+                    if (*end_ptr != '\0' || blockSize <= 0)
+                        SLog(EError, "Could not parse the block size!");
+                    break;
+                case 's':
+                    sampleCount = strtol(optarg, &end_ptr, 10);
+                    if (*end_ptr != '\0' || sampleCount <= 0)
+                        SLog(EError, "Could not parse the sample count!");
+                    break;
+            };
+        }
+
+        if (optind+1 < argc) {
+            help();
+            return 0;
+        }
+
+        if (optind < argc) {
+            fs::path
+                filename = fileResolver->resolve(argv[optind]),
+                filePath = fs::absolute(filename).parent_path();
+            ref<FileResolver> frClone = fileResolver->clone();
+            frClone->prependPath(filePath);
+            Thread::getThread()->setFileResolver(frClone);
+
+            ref<Scene> scene = loadScene(argv[optind]);
+            scene->initialize();
+            benchmark(scene->getSensor(), scene->getKDTree(),
+                blockSize, sampleCount, rayCount);
+        } else {
+            const char *plugins[] = { "perspective", "thinlens", "perspective_rdist" };
+            for (int i=0; i<3; ++i) {
+                Properties props(plugins[i]);
+                if (strcmp(plugins[i], "thinlens") == 0) {
+                    props.setFloat("apertureRadius", 0.05f);
+                    props.setFloat("focusDistance", 5.0f);
+                } else if (strcmp(plugins[i], "perspective_rdist") == 0) {
+                    props.setString("kc", "0.1, 0.02");
+                }
+                ref<Sensor> sensor = static_cast<Sensor *> (PluginManager::getInstance()->
+                    createObject(MTS_CLASS(Sensor), props));
+                sensor->configure();
+                benchmark(sensor, NULL, blockSize, sampleCount, rayCount);
+            }
+        }
+
+        return 0;
+    }
+
+    void benchmark(const Sensor *sensor, const ShapeKDTree *kdtree,
+            int blockSize, int sampleCount, size_t rayCount) {
+        /* Generate the samples of one image block */
+        const size_t count = (size_t) blockSize * blockSize * sampleCount;
+        std::vector<Point2> samplePositions(count), apertureSamples(count);
+        std::vector<Float> timeSamples(count);
+        Vector2i size = sensor->getFilm()->getCropSize();
+        Point2i offset(std::max(0, (size.x - blockSize) / 2),
+                       std::max(0, (size.y - blockSize) / 2));
+        ref<Random> random = new Random();
+
+        for (size_t i=0; i<count; ++i) {
+            int pixel = (int) (i / sampleCount);
+            samplePositions[i] = Point2(
+                offset.x + pixel % blockSize + random->nextFloat(),
+                offset.y + pixel / blockSize + random->nextFloat());
+            apertureSamples[i] = Point2(random->nextFloat(), random->nextFloat());
+            timeSamples[i] = random->nextFloat();
+        }
+
+        const Point2 *apertureArray = sensor->needsApertureSample() ? &apertureSamples[0] : NULL;
+        const Float *timeArray = sensor->needsTimeSample() ? &timeSamples[0] : NULL;
+        size_t blocks = std::max((size_t) 1, rayCount / count);
+        Float checksum = 0;
+
+        Log(EInfo, "Benchmarking \"%s\" (" SIZE_T_FMT " blocks of " SIZE_T_FMT " rays) ..",
+            sensor->getProperties().getPluginName().c_str(), blocks, count);
+
+        /* Scalar ray generation */
+        ref<Timer> timer = new Timer();
+        Ray ray;
+        for (size_t j=0; j<blocks; ++j) {
+            for (size_t i=0; i<count; ++i) {
+                sensor->sampleRay(ray, samplePositions[i],
+                    apertureSamples[i], timeSamples[i]);
+                checksum += ray.d.x;
+            }
+        }
+        Float scalarRate = rate(blocks * count, timer->getMilliseconds());
+
+        RayDifferential rayDiff;
+        timer->reset();
+        for (size_t j=0; j<blocks; ++j) {
+            for (size_t i=0; i<count; ++i) {
+                sensor->sampleRayDifferential(rayDiff, samplePositions[i],
+                    apertureSamples[i], timeSamples[i]);
+                checksum += rayDiff.d.x;
+            }
+        }
+        Float differentialRate = rate(blocks * count, timer->getMilliseconds());
+
+        /* Batched ray generation */
+        RayBatch batch(count);
+        timer->reset();
+        for (size_t j=0; j<blocks; ++j) {
+            sensor->sampleRayBatch(batch, &samplePositions[0],
+                apertureArray, timeArray, count);
+            checksum += batch.dx[j % count];
+        }
+        Float batchRate = rate(blocks * count, timer->getMilliseconds());
+
+        Log(EInfo, "   sampleRay()             : %.3f MRays/s", scalarRate);
+        Log(EInfo, "   sampleRayDifferential() : %.3f MRays/s", differentialRate);
+        Log(EInfo, "   sampleRayBatch()        : %.3f MRays/s (%.2fx)",
+            batchRate, batchRate / scalarRate);
+
+        if (kdtree) {
+            /* Trace the rays of the last batch, one at a time and as packets */
+            size_t hits = 0;
+            timer->reset();
+            for (size_t j=0; j<blocks; ++j) {
+                for (size_t i=0; i<count; ++i) {
+                    Float t;
+                    ConstShapePtr shape;
+                    Normal n;
+                    Point2 uv;
+                    if (kdtree->rayIntersect(batch.getRay(i), t, shape, n, uv))
+                        ++hits;
+                }
+            }
+            Float traceRate = rate(blocks * count, timer->getMilliseconds());
+            Log(EInfo, "   single ray tracing      : %.3f MRays/s (" SIZE_T_FMT " hits)",
+                traceRate, hits / blocks);
+
+#if defined(MTS_HAS_COHERENT_RT)
+            uint8_t MM_ALIGN16 temp[4 * MTS_KD_INTERSECTION_TEMP];
+            RayPacket4 MM_ALIGN16 packet;
+            RayInterval4 MM_ALIGN16 interval;
+            Intersection4 MM_ALIGN16 its;
+            size_t packets = (count + 3) / 4;
+
+            hits = 0;
+            timer->reset();
+            for (size_t j=0; j<blocks; ++j) {
+                for (size_t i=0; i<packets; ++i) {
+                    its = Intersection4();
+                    if (batch.getPacket(i, packet, interval))
+                        kdtree->rayIntersectPacket(packet, interval, its, temp);
+                    else
+                        kdtree->rayIntersectPacketIncoherent(packet, interval, its, temp);
+                    for (int k=0; k<4 && 4*i+k < count; ++k)
+                        if (its.t.f[k] != std::numeric_limits<float>::infinity())
+                            ++hits;
+                }
+            }
+            Float packetRate = rate(blocks * count, timer->getMilliseconds());
+            Log(EInfo, "   packet tracing          : %.3f MRays/s (" SIZE_T_FMT " hits)",
+                packetRate, hits / blocks);
+#endif
+        }
+
+        Log(EDebug, "Checksum: %f", checksum);
+        Log(EInfo, "");
+    }
+
+    inline Float rate(size_t rays, unsigned int milliseconds) const {
+        return rays / (std::max(milliseconds, 1u) * (Float) 1000);
+    }
+
+    MTS_DECLARE_UTILITY()
+};
+
+MTS_EXPORT_UTILITY(SensorBench, "Primary ray generation benchmark")
+MTS_NAMESPACE_END
@@ -0,0 +1,145 @@
+/*
+    This file is part of Mitsuba, a physically based rendering system.
+
+    Copyright (c) 2007-2014 by Wenzel Jakob and others.
+
+    Mitsuba is free software; you can redistribute it and/or modify
+    it under the terms of the GNU General Public License Version 3
+    as published by the Free Software Foundation.
+
+    Mitsuba is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program. If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include <mitsuba/render/util.h>
+#include <mitsuba/render/scene.h>
+#include <mitsuba/core/timer.h>
+#include <mitsuba/core/fresolver.h>
+#include <mitsuba/core/mstream.h>
+#include <mitsuba/core/zstream.h>
+#if defined(WIN32)
+#include <mitsuba/core/getopt.h>
+#endif
+
+MTS_NAMESPACE_BEGIN
+
+class SerBench : public Utility {
+public:
+    void help() {
+        cout << endl;
+        cout << "Synopsis: Serialization throughput benchmark. Loads a scene, serializes it" << endl;
+        cout << "into memory (as done when sending it to remote workers) and unserializes" << endl;
+        cout << "it again, reporting the throughput of both directions." << endl;
+        cout << endl;
+        cout << "Usage: mtsutil serbench [options] <Scene XML file>" << endl;
+        cout << "Options/Arguments:" << endl;
+        cout << "   -h             Display this help text" << endl << endl;
+        cout << "   -n count       Number of repetitions (default: 3)" << endl << endl;
+        cout << "   -z level       Pass the data through a streaming zlib compressor" << endl;
+        cout << "                  with the given compression level (1-9)" << endl << endl;
+        cout << "   -s             Swap the byte order of the serialized data" << endl << endl;
+    }
+
+    int run(int argc, char **argv) {
+        ref<FileResolver> fileResolver = Thread::getThread()->getFileResolver();
+        int optchar, iterations = 3, level = -1;
+        bool swapByteOrder = false;
+        char *end_ptr = NULL;
+        optind = 1;
+
+        /* Parse command-line arguments */
+        while ((optchar = getopt(argc, argv, "n:z:sh")) != -1) {
+            switch (optchar) {
+                case 'h': {
+                        help();
+                        return 0;
+                    }
+                    break;
+                case 'n':
+                    iterations = strtol(optarg, &end_ptr, 10);
+                    if (*end_ptr != '\0' || iterations <= 0)
+                        SLog(EError, "Could not parse the repetition count!");
+                    break;
+                case 'z':
+                    level = strtol(optarg, &end_ptr, 10);
+                    if (*end_ptr != '\0' || level < 1 || level > 9)
+                        SLog(EError, "Could not parse the compression level!");
+                    break;
+                case 's':
+                    swapByteOrder = true;
+                    break;
+            };
+        }
+
+        if (optind == argc || optind+1 < argc) {
+            help();
+            return 0;
+        }
+
+        fs::path
+            filename = fileResolver->resolve(argv[optind]),
+            filePath = fs::absolute(filename).parent_path();
+        ref<FileResolver> frClone = fileResolver->clone();
+        frClone->prependPath(filePath);
+        Thread::getThread()->setFileResolver(frClone);
+        ref<Scene> scene = loadScene(argv[optind]);
+        scene->initialize();
+
+        Stream::EByteOrder byteOrder = Stream::getHostByteOrder();
+        if (swapByteOrder)
+            byteOrder = byteOrder == Stream::ELittleEndian
+                ? Stream::EBigEndian : Stream::ELittleEndian;
+
+        Float bestWrite = 0, bestRead = 0;
+        for (int i=0; i<iterations; ++i) {
+            ref<MemoryStream> mstream = new MemoryStream();
+            ref<Stream> stream = mstream.get();
+            if (level > 0)
+                stream = new ZStream(mstream, ZStream::EDeflateStream, level);
+            stream->setByteOrder(byteOrder);
+
+            ref<Timer> timer = new Timer();
+            ref<InstanceManager> manager = new InstanceManager();
+            manager->serialize(stream, scene);
+            stream->flush();
+            /* Releasing the compressor terminates the deflate stream (Z_FINISH) */
+            stream = NULL;
+            Float writeTime = std::max((Float) 1e-3f, timer->getMilliseconds() / (Float) 1000);
+            size_t size = mstream->getSize();
+
+            mstream->seek(0);
+            stream = mstream.get();
+            if (level > 0)
+                stream = new ZStream(mstream);
+            stream->setByteOrder(byteOrder);
+
+            timer->reset();
+            manager = new InstanceManager();
+            ref<SerializableObject> result = manager->getInstance(stream);
+            Float readTime = std::max((Float) 1e-3f, timer->getMilliseconds() / (Float) 1000);
+
+            Float writeRate = size / (writeTime * 1024 * 1024),
+                  readRate = size / (readTime * 1024 * 1024);
+            Log(EInfo, "Pass %i: %s serialized in %.3f s (%.1f MiB/s), "
+                "unserialized in %.3f s (%.1f MiB/s)", i+1,
+                memString(size).c_str(), writeTime, writeRate,
+                readTime, readRate);
+            bestWrite = std::max(bestWrite, writeRate);
+            bestRead = std::max(bestRead, readRate);
+        }
+
+        Log(EInfo, "Best of %i: serialization %.1f MiB/s, unserialization %.1f MiB/s%s",
+            iterations, bestWrite, bestRead, level > 0 ? " (compressed size)" : "");
+        return 0;
+    }
+
+    MTS_DECLARE_UTILITY()
+};
+
+MTS_EXPORT_UTILITY(SerBench, "Serialization throughput benchmark")
+MTS_NAMESPACE_END
@@ -21,6 +21,7 @@
 #include <mitsuba/core/fresolver.h>
 #include <mitsuba/core/fstream.h>
 #include <mitsuba/core/bitmap.h>
+#include <mitsuba/core/simdtonemap.h>
 #include <mitsuba/core/plugin.h>
 #include <boost/algorithm/string.hpp>
 #if defined(WIN32)
@@ -70,6 +71,14 @@ public:
         int r[5];
     } Rect;
 
+    /// Log the time spent tonemapping an image along with the resulting throughput
+    void reportThroughput(const Bitmap *output, const Timer *timer) {
+        Float time = std::max((Float) 1e-3f, timer->getMilliseconds() / (Float) 1000);
+        size_t pixels = (size_t) output->getWidth() * output->getHeight();
+        Log(EInfo, "Tonemapped %ix%i pixels in %.3f s (%.1f MPixel/s)",
+            output->getWidth(), output->getHeight(), time, pixels / (time * 1e6f));
+    }
+
     /**
      * Computes a bloom filter based on
      *
@@ -110,6 +119,44 @@ public:
         return bitmap;
     }
 
+    /**
+     * Tonemaps an image into an 8-bit bitmap with the requested pixel format.
+     * Color output is produced by the parallel SIMD tone mapper, while other
+     * pixel formats go through \ref Bitmap::tonemapReinhard() and
+     * \ref Bitmap::convert(). When the luminance arguments are nonzero, they
+     * are used in place of the statistics of the image.
+     */
+    ref<Bitmap> develop(Bitmap *input, Bitmap::EPixelFormat pixelFormat, Float gamma,
+            Float multiplier, const Float *tonemapper, Float &logAvgLuminance,
+            Float &maxLuminance) {
+        bool reinhard = tonemapper[0] != -1;
+        Bitmap::EPixelFormat inputFormat = input->getPixelFormat();
+
+        /* TonemapCPU::develop() does not support a multiplier in combination
+           with the Reinhard operator; use the generic implementation then */
+        bool simd = (pixelFormat == Bitmap::ERGB || pixelFormat == Bitmap::ERGBA)
+            && (inputFormat == Bitmap::ERGB || inputFormat == Bitmap::ERGBA ||
+                inputFormat == Bitmap::ELuminance || inputFormat == Bitmap::ELuminanceAlpha)
+            && !(reinhard && multiplier != 1);
+
+        if (!simd) {
+            if (reinhard) {
+                input->tonemapReinhard(logAvgLuminance, maxLuminance, tonemapper[0], tonemapper[1]);
+                Log(EInfo, "Tonemapper reports: log-average luminance = %f, max. luminance = %f",
+                    logAvgLuminance, maxLuminance);
+            }
+            return input->convert(pixelFormat, Bitmap::EUInt8, gamma, multiplier);
+        }
+
+        ref<Bitmap> output = TonemapCPU::develop(input, pixelFormat, gamma, multiplier,
+            reinhard ? tonemapper[0] : -1, tonemapper[1], logAvgLuminance, maxLuminance);
+
+        if (reinhard)
+            Log(EInfo, "Tonemapper reports: log-average luminance = %f, max. luminance = %f",
+                logAvgLuminance, maxLuminance);
+        return output;
+    }
+
     int run(int argc, char **argv) {
         ref<FileResolver> fileResolver = Thread::getThread()->getFileResolver();
         int optchar;
@@ -330,14 +377,11 @@ public:
                     if (cbal[0] != 1 || cbal[1] != 1 || cbal[2] != 1)
                         input->colorBalance(cbal[0], cbal[1], cbal[2]);
 
-                    if (tonemapper[0] != -1) {
-                        Float logAvgLuminance = 0, maxLuminance = 0;
-                        input->tonemapReinhard(logAvgLuminance, maxLuminance, tonemapper[0], tonemapper[1]);
-                        Log(EInfo, "Tonemapper reports: log-average luminance = %f, max. luminance = %f",
-                            logAvgLuminance, maxLuminance);
-                    }
-
-                    ref<Bitmap> output = input->convert(pixelFormat, Bitmap::EUInt8, gamma, multiplier);
+                    Float logAvgLuminance = 0, maxLuminance = 0;
+                    ref<Timer> timer = new Timer();
+                    ref<Bitmap> output = develop(input, pixelFormat, gamma, multiplier,
+                        tonemapper, logAvgLuminance, maxLuminance);
+                    reportThroughput(output, timer);
 
                     for (size_t i=0; i<rects.size(); ++i) {
                         int *r = rects[i].r;
@@ -399,17 +443,15 @@ public:
                 if (cbal[0] != 1 || cbal[1] != 1 || cbal[2] != 1)
                     input->colorBalance(cbal[0], cbal[1], cbal[2]);
 
-                if (tonemapper[0] != -1) {
-                    input->tonemapReinhard(logAvgLuminance, maxLuminance, tonemapper[0], tonemapper[1]);
-                    Log(EInfo, "Tonemapper reports: log-average luminance = %f, max. luminance = %f",
-                        logAvgLuminance, maxLuminance);
-                    if (!temporalCoherence) {
-                        logAvgLuminance = 0;
-                        maxLuminance = 0;
-                    }
-                }
+                ref<Timer> timer = new Timer();
+                ref<Bitmap> output = develop(input, pixelFormat, gamma, multiplier,
+                    tonemapper, logAvgLuminance, maxLuminance);
+                reportThroughput(output, timer);
 
-                ref<Bitmap> output = input->convert(pixelFormat, Bitmap::EUInt8, gamma, multiplier);
+                if (!temporalCoherence) {
+                    logAvgLuminance = 0;
+                    maxLuminance = 0;
+                }
 
                 for (size_t i=0; i<rects.size(); ++i) {
                     int *r = rects[i].r;
@@ -141,6 +141,7 @@ public:
             size_t volumeSize = getVolumeSize();
             m_data = new uint8_t[volumeSize];
             stream->read(m_data, volumeSize);
+            stats::volumeMemory.allocate(volumeSize);
         } else {
             fs::path filename = stream->readString();
             loadFromFile(filename);
@@ -149,8 +150,11 @@ public:
     }
 
     virtual ~GridDataSource() {
-        if (!m_mmap)
+        /* Memory-mapped grids are paged in by the OS and not counted */
+        if (!m_mmap) {
+            stats::volumeMemory.release(getVolumeSize());
             delete[] m_data;
+        }
     }
 
     size_t getVolumeSize() const {
@@ -28,6 +28,7 @@ MTS_NAMESPACE_BEGIN
 static StatsCounter statsHitRate("Volume cache", "Cache hit rate", EPercentage);
 static StatsCounter statsCreate("Volume cache", "Block creations");
 static StatsCounter statsDestruct("Volume cache", "Block destructions");
+static MemoryCounter blockMemory("Volume block cache");
 static StatsCounter statsEmpty("Volume cache", "Empty blocks", EPercentage);
 
 /* Lexicographic ordering for Vector3i */
@@ -304,6 +305,7 @@ public:
         statsEmpty.incrementBase();
 
         if (nonempty) {
+            blockMemory.allocate(sizeof(float) * m_blockRes*m_blockRes*m_blockRes);
             return result;
         } else {
             ++statsEmpty;
@@ -314,6 +316,8 @@ public:
 
     void destroyBlock(float *ptr) const {
         ++statsDestruct;
+        if (ptr)
+            blockMemory.release(sizeof(float) * m_blockRes*m_blockRes*m_blockRes);
         delete[] ptr;
     }
 